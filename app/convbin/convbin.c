@@ -25,6 +25,8 @@
 *           2013/05/19 1.8 support auto format for file path with wild-card
 *           2014/02/08 1.9 add option -span -trace -mask
 *           2014/08/26 1.10 add Trimble RT17 support
+*           2026/10/19 1.11 support multiple input files
+*                          add option -j
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,13 +38,33 @@ static const char rcsid[]="$Id: convbin.c,v 1.1 2008/07/17 22:13:04 ttaka Exp $"
 
 #define PRGNAME   "CONVBIN"
 #define TRACEFILE "convbin.trace"
+#define MAXINFILE 4096              /* max number of input files */
+#define MAXJOBS   64                /* max number of parallel conversions */
+
+/* type definitions ----------------------------------------------------------*/
+typedef struct {                    /* conversion job type */
+    int format;                     /* input format */
+    rnxopt_t opt;                   /* rinex options */
+    const char *ifile;              /* input file */
+    int stat;                       /* status (0:ok,-1:error) */
+} job_t;
+
+typedef struct {                    /* conversion jobs type */
+    job_t *job;                     /* jobs */
+    int n,next;                     /* number of jobs and next job */
+    char **ofile,*dir;              /* output files and directory */
+    lock_t lock;                    /* lock flag */
+} jobs_t;
+
+static int quiet=0;                 /* suppress progress messages */
+static lock_t lock_msg;             /* lock flag for messages */
 
 /* help text -----------------------------------------------------------------*/
 static const char *help[]={
 "",
 " Synopsys",
 "",
-" convbin [option ...] file", 
+" convbin [option ...] file [file ...]", 
 "",
 " Description",
 "",
@@ -71,7 +93,7 @@ static const char *help[]={
 "",
 " Options [default]",
 "",
-"     file         input receiver binary log file",
+"     file         input receiver binary log file(s)",
 "     -ts y/m/d h:m:s  start time [all]",
 "     -te y/m/d h:m:s  end time [all]",
 "     -tr y/m/d h:m:s  approximated time for rtcm messages",
@@ -122,11 +144,17 @@ static const char *help[]={
 "     -l lfile     output RINEX LNAV file",
 "     -s sfile     output SBAS message file",
 "     -trace level output trace level [off]",
+"     -j jobs      number of input files converted in parallel [1]",
 "",
 " If any output file specified, default output files (<file>.obs,",
 " <file>.nav, <file>.gnav, <file>.hnav, <file>.qnav, <file>.lnav and",
 " <file>.sbs) are used.",
 "",
+" If multiple input files are specified, each file is converted separately.",
+" Output files -o, -n, -g, -h, -q, -l and -s must include keywords (%r,",
+" %y,...) in this case. With option -j, files are converted in parallel and",
+" progress messages are suppressed.",
+"",
 " If receiver type is not specified, type is recognized by the input",
 " file extension as follows.",
 "     *.rtcm2       RTCM 2",
@@ -152,6 +180,9 @@ static void printhelp(void)
 extern int showmsg(char *format, ...)
 {
     va_list arg;
+    
+    if (quiet) return 0;
+    
     va_start(arg,format); vfprintf(stderr,format,arg); va_end(arg);
     fprintf(stderr,*format?"\r":"\n");
     return 0;
@@ -241,6 +272,7 @@ static int convbin(int format, rnxopt_t *opt, const char *ifile, char **file,
         else strcpy(work,ofile[i]);
         sprintf(ofile[i],"%s%c%s",dir,FILEPATHSEP,work);
     }
+    lock(&lock_msg);
     fprintf(stderr,"input file  : %s (%s)\n",ifile,formatstrs[format]);
     
     if (*ofile[0]) fprintf(stderr,"->rinex obs : %s\n",ofile[0]);
@@ -250,22 +282,74 @@ static int convbin(int format, rnxopt_t *opt, const char *ifile, char **file,
     if (*ofile[4]) fprintf(stderr,"->rinex qnav: %s\n",ofile[4]);
     if (*ofile[5]) fprintf(stderr,"->rinex lnav: %s\n",ofile[5]);
     if (*ofile[6]) fprintf(stderr,"->sbas log  : %s\n",ofile[6]);
+    unlock(&lock_msg);
     
     if (!convrnx(format,opt,ifile,ofile)) {
-        fprintf(stderr,"\n");
+        if (quiet) fprintf(stderr,"convert error: %s\n",ifile);
+        else fprintf(stderr,"\n");
         return -1;
     }
-    fprintf(stderr,"\n");
+    if (!quiet) fprintf(stderr,"\n");
+    return 0;
+}
+/* conversion thread ---------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI convthread(void *arg)
+#else
+static void *convthread(void *arg)
+#endif
+{
+    jobs_t *jobs=(jobs_t *)arg;
+    job_t *job;
+    
+    for (;;) {
+        lock(&jobs->lock);
+        job=jobs->next<jobs->n?jobs->job+jobs->next++:NULL;
+        unlock(&jobs->lock);
+        
+        if (!job) break;
+        
+        job->stat=convbin(job->format,&job->opt,job->ifile,jobs->ofile,
+                          jobs->dir);
+    }
     return 0;
 }
+/* convert input files by parallel threads -----------------------------------*/
+static void convjobs(jobs_t *jobs, int njob)
+{
+    thread_t thread[MAXJOBS];
+    int i,n=0;
+    
+    initlock(&jobs->lock);
+    jobs->next=0;
+    
+    for (i=0;i<njob&&i<MAXJOBS&&i<jobs->n;i++,n++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,convthread,jobs,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,convthread,jobs)) break;
+#endif
+    }
+    if (n<=0) convthread(jobs); /* convert inline without thread */
+    
+    for (i=0;i<n;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+}
 /* parse command line options ------------------------------------------------*/
-static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
-                   char **ofile, char **dir, int *trace)
+static void cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
+                    int *nfile, char **ofile, char **dir, char **fmt,
+                    int *trace, int *njob)
 {
     double eps[]={1980,1,1,0,0,0},epe[]={2037,12,31,0,0,0};
     double epr[]={2010,1,1,0,0,0},span=0.0;
-    int i,j,k,sat,code,nf=2,nc=2,format=-1;
-    char *p,*sys,*fmt="",*paths[1],path[1024],buff[1024];
+    int i,j,k,sat,code,nf=2,nc=2;
+    char *p,*sys,buff[1024];
     
     opt->rnxver=2.11;
     opt->obstype=OBSTYPE_PR|OBSTYPE_CP;
@@ -296,7 +380,7 @@ static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
             span=atof(argv[++i]);
         }
         else if (!strcmp(argv[i],"-r" )&&i+1<argc) {
-            fmt=argv[++i];
+            *fmt=argv[++i];
         }
         else if (!strcmp(argv[i],"-ro")&&i+1<argc) {
             strcpy(opt->rcvopt,argv[++i]);
@@ -407,9 +491,12 @@ static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
         else if (!strcmp(argv[i],"-trace" )&&i+1<argc) {
             *trace=atoi(argv[++i]);
         }
+        else if (!strcmp(argv[i],"-j" )&&i+1<argc) {
+            *njob=atoi(argv[++i]);
+        }
         else if (!strncmp(argv[i],"-",1)) printhelp();
         
-        else *ifile=argv[i];
+        else if (*nfile<MAXINFILE) ifile[(*nfile)++]=argv[i];
     }
     if (span>0.0&&opt->ts.time) {
         opt->te=timeadd(opt->ts,span*3600.0-1e-3);
@@ -420,6 +507,12 @@ static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
     if (nf>=4) opt->freqtype|=FREQTYPE_L6;
     if (nf>=5) opt->freqtype|=FREQTYPE_L7;
     if (nf>=6) opt->freqtype|=FREQTYPE_L8;
+}
+/* input format by format option or file extension ---------------------------*/
+static int getformat(const char *fmt, const char *ifile)
+{
+    int format=-1;
+    char *p,*paths[1],path[1024];
     
     if (*fmt) {
         if      (!strcmp(fmt,"rtcm2")) format=STRFMT_RTCM2;
@@ -438,7 +531,7 @@ static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
     }
     else {
         paths[0]=path;
-        if (!expath(*ifile,paths,1)||!(p=strrchr(path,'.'))) return -1;
+        if (!expath(ifile,paths,1)||!(p=strrchr(path,'.'))) return -1;
         if      (!strcmp(p,".rtcm2"))  format=STRFMT_RTCM2;
         else if (!strcmp(p,".rtcm3"))  format=STRFMT_RTCM3;
         else if (!strcmp(p,".gps"  ))  format=STRFMT_OEM4;
@@ -459,34 +552,68 @@ static int cmdopts(int argc, char **argv, rnxopt_t *opt, char **ifile,
 /* main ----------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
+    static char *ifile[MAXINFILE];
     rnxopt_t opt={{0}};
-    int format,trace=0,stat;
-    char *ifile="",*ofile[7]={0},*dir="";
+    jobs_t jobs={0};
+    int i,trace=0,stat=0,nfile=0,njob=1;
+    char *ofile[7]={0},*dir="",*fmt="";
     
     /* parse command line options */
-    format=cmdopts(argc,argv,&opt,&ifile,ofile,&dir,&trace);
+    cmdopts(argc,argv,&opt,ifile,&nfile,ofile,&dir,&fmt,&trace,&njob);
     
-    if (!*ifile) {
+    if (nfile<=0) {
         fprintf(stderr,"no input file\n");
         return -1;
     }
-    if (format<0) {
-        fprintf(stderr,"input format can not be recognized\n");
+    for (i=0;i<7&&nfile>1;i++) {
+        if (!ofile[i]||strchr(ofile[i],'%')) continue;
+        fprintf(stderr,"no keyword in output file for multiple input files\n");
+        return -1;
+    }
+    if (!(jobs.job=(job_t *)malloc(sizeof(job_t)*nfile))) {
+        fprintf(stderr,"memory allocation error\n");
         return -1;
     }
-    sprintf(opt.prog,"%s %s",PRGNAME,VER_RTKLIB);
-    sprintf(opt.comment[0],"log: %-55.55s",ifile);
-    sprintf(opt.comment[1],"format: %s",formatstrs[format]);
-    if (*opt.rcvopt) {
-        strcat(opt.comment[1],", option: ");
-        strcat(opt.comment[1],opt.rcvopt);
+    for (i=0;i<nfile;i++) {
+        if ((jobs.job[i].format=getformat(fmt,ifile[i]))<0) {
+            fprintf(stderr,"input format can not be recognized: %s\n",ifile[i]);
+            free(jobs.job);
+            return -1;
+        }
+        jobs.job[i].opt=opt;
+        jobs.job[i].ifile=ifile[i];
+        jobs.job[i].stat=0;
+        sprintf(jobs.job[i].opt.prog,"%s %s",PRGNAME,VER_RTKLIB);
+        sprintf(jobs.job[i].opt.comment[0],"log: %-55.55s",ifile[i]);
+        sprintf(jobs.job[i].opt.comment[1],"format: %s",
+                formatstrs[jobs.job[i].format]);
+        if (*opt.rcvopt) {
+            strcat(jobs.job[i].opt.comment[1],", option: ");
+            strcat(jobs.job[i].opt.comment[1],opt.rcvopt);
+        }
     }
+    jobs.n=nfile;
+    jobs.ofile=ofile;
+    jobs.dir=dir;
+    initlock(&lock_msg);
+    
     if (trace>0) {
         traceopen(TRACEFILE);
         tracelevel(trace);
     }
-    stat=convbin(format,&opt,ifile,ofile,dir);
+    if (njob>1&&nfile>1) {
+        quiet=1;
+        convjobs(&jobs,njob);
+    }
+    else {
+        for (i=0;i<nfile;i++) {
+            jobs.job[i].stat=convbin(jobs.job[i].format,&jobs.job[i].opt,
+                                     ifile[i],ofile,dir);
+        }
+    }
+    for (i=0;i<nfile;i++) if (jobs.job[i].stat) stat=-1;
     
+    free(jobs.job);
     traceclose();
     
     return stat;
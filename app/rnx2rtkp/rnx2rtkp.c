@@ -13,6 +13,7 @@
 *           2010/01/28  1.5 add option -k
 *           2010/08/12  1.6 add option -y implementation (2.4.0_p1)
 *           2014/01/27  1.7 fix bug on default output time format
+*           2026/10/19  1.8 add option -j
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
 #include "rtklib.h"
@@ -66,6 +67,7 @@ static const char *help[]={
 " -r x y z  reference (base) receiver ecef pos (m) [average of single pos]",
 " -l lat lon hgt reference (base) receiver latitude/longitude/height (deg/m)",
 " -y level  output soltion status (0:off,1:states,2:residuals) [0]",
+" -j nthr   number of threads of batch single point positioning (0:off) [0]",
 " -x level  debug trace level (0:off) [0]"
 };
 /* show message --------------------------------------------------------------*/
@@ -155,6 +157,7 @@ int main(int argc, char **argv)
         }
         else if (!strcmp(argv[i],"-y")&&i+1<argc) solopt.sstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-x")&&i+1<argc) solopt.trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-j")&&i+1<argc) setbatchthr(atoi(argv[++i]));
         else if (*argv[i]=='-') printhelp();
         else if (n<MAXFILE) infile[n++]=argv[i];
     }
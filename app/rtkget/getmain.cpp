@@ -289,6 +289,8 @@ void __fastcall TMainForm::BtnDownloadClick(TObject *Sender)
         reppath(LogFile.c_str(),path,utc2gpst(timeget()),"","");
         fp=fopen(path,LogAppend?"a":"w");
     }
+    dl_setopt(NJob,NHost,NRetry,StateFile.c_str());
+    
     abortf=0;
     PanelEnable(0);
     BtnDownload->Enabled=true;
@@ -555,6 +557,10 @@ void __fastcall TMainForm::LoadOpt(void)
     HidePasswd->Checked=ini->ReadInteger("opt","hidepasswd",       0);
     HoldErr            =ini->ReadInteger("opt","holderr",          0);
     HoldList           =ini->ReadInteger("opt","holdlist",         0);
+    NJob               =ini->ReadInteger("opt","njob",             1);
+    NHost              =ini->ReadInteger("opt","nhost",            0);
+    NRetry             =ini->ReadInteger("opt","nretry",           0);
+    StateFile          =ini->ReadString ("opt","statefile",       "");
     NCol               =ini->ReadInteger("opt","ncol",            35);
     LogAppend          =ini->ReadInteger("opt","logappend",        0);
     DateFormat         =ini->ReadInteger("opt","dateformat",       0);
@@ -602,6 +608,10 @@ void __fastcall TMainForm::SaveOpt(void)
     ini->WriteInteger("opt","hidepasswd", HidePasswd->Checked);
     ini->WriteInteger("opt","holderr",    HoldErr            );
     ini->WriteInteger("opt","holdlist",   HoldList           );
+    ini->WriteInteger("opt","njob",       NJob               );
+    ini->WriteInteger("opt","nhost",      NHost              );
+    ini->WriteInteger("opt","nretry",     NRetry             );
+    ini->WriteString ("opt","statefile",  StateFile          );
     ini->WriteInteger("opt","ncol",       NCol               );
     ini->WriteInteger("opt","logappend",  LogAppend          );
     ini->WriteInteger("opt","dateformat", DateFormat         );
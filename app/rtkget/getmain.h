@@ -156,9 +156,13 @@ public:
 	AnsiString LogFile;
 	AnsiString Stations;
 	AnsiString ProxyAddr;
+	AnsiString StateFile;
 	int HoldErr;
 	int HoldList;
 	int NCol;
+	int NJob;
+	int NHost;
+	int NRetry;
 	int DateFormat;
 	int TraceLevel;
 	int LogAppend;
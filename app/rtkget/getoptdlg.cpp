@@ -30,11 +30,23 @@ void __fastcall TDownOptDialog::BtnLogFileClick(TObject *Sender)
     LogFile->Text=SaveDialog->FileName;
 }
 //---------------------------------------------------------------------------
+void __fastcall TDownOptDialog::BtnStateFileClick(TObject *Sender)
+{
+    SaveDialog->Title="Download State File";
+    SaveDialog->FileName="";
+    if (!SaveDialog->Execute()) return;
+    StateFile->Text=SaveDialog->FileName;
+}
+//---------------------------------------------------------------------------
 void __fastcall TDownOptDialog::FormShow(TObject *Sender)
 {
 	HoldErr  ->Checked=MainForm->HoldErr;
 	HoldList ->Checked=MainForm->HoldList;
 	NCol     ->Text   =UnicodeString(MainForm->NCol);
+	NJob     ->Text   =UnicodeString(MainForm->NJob);
+	NHost    ->Text   =UnicodeString(MainForm->NHost);
+	NRetry   ->Text   =UnicodeString(MainForm->NRetry);
+	StateFile->Text   =MainForm->StateFile;
 	Proxy    ->Text   =MainForm->ProxyAddr;
 	UrlFile  ->Text   =MainForm->UrlFile;
 	LogFile  ->Text   =MainForm->LogFile;
@@ -48,6 +60,10 @@ void __fastcall TDownOptDialog::BtnOkClick(TObject *Sender)
 	MainForm->HoldErr  =HoldErr  ->Checked;
 	MainForm->HoldList =HoldList ->Checked;
 	MainForm->NCol     =NCol     ->Text.ToInt();
+	MainForm->NJob     =NJob     ->Text.ToInt();
+	MainForm->NHost    =NHost    ->Text.ToInt();
+	MainForm->NRetry   =NRetry   ->Text.ToInt();
+	MainForm->StateFile=StateFile->Text;
 	MainForm->ProxyAddr=Proxy    ->Text;
 	MainForm->UrlFile  =UrlFile  ->Text;
 	MainForm->LogFile  =LogFile  ->Text;
@@ -34,10 +34,20 @@ __published:
 	TComboBox *DateFormat;
 	TLabel *Label6;
 	TEdit *NCol;
+	TLabel *Label7;
+	TEdit *NJob;
+	TLabel *Label8;
+	TEdit *NHost;
+	TLabel *Label9;
+	TEdit *NRetry;
+	TLabel *Label10;
+	TEdit *StateFile;
+	TButton *BtnStateFile;
 	void __fastcall FormShow(TObject *Sender);
 	void __fastcall BtnOkClick(TObject *Sender);
 	void __fastcall BtnUrlFileClick(TObject *Sender);
 	void __fastcall BtnLogFileClick(TObject *Sender);
+	void __fastcall BtnStateFileClick(TObject *Sender);
 private:
 public:
 	__fastcall TDownOptDialog(TComponent* Owner);
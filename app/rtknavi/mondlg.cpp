@@ -389,9 +389,9 @@ void __fastcall TMonitorDialog::ShowRtk(void)
 		rt[0]=floor(runtime/3600.0); runtime-=rt[0]*3600.0;
 		rt[1]=floor(runtime/60.0); rt[2]=runtime-rt[1]*60.0;
 	}
-	if ((ne=rtksvr.nav.ne)>0) {
-		time2str(rtksvr.nav.peph[   0].time,s1,0);
-		time2str(rtksvr.nav.peph[ne-1].time,s2,0);
+	if ((ne=rtksvr.nav.pephs.n)>0) {
+		time2str(rtksvr.nav.pephs.time[   0],s1,0);
+		time2str(rtksvr.nav.pephs.time[ne-1],s2,0);
 		time2str(rtksvr.ftime[2],s3,0);
 	}
 	strcpy(file,rtksvr.files[2]);
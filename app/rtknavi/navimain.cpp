@@ -953,7 +953,7 @@ void __fastcall TMainForm::SvrStart(void)
         for (i=0;i<3;i++) PrcOpt.antdel[1][i]=RefAntDel[i];
     }
     if (RovAntPcvF||RefAntPcvF) {
-        free(pcvr.pcv);
+        freepcv(&pcvr);
     }
     if (PrcOpt.sateph==EPHOPT_PREC||PrcOpt.sateph==EPHOPT_SSRCOM) {
         if (!readpcv(SatPcvFileF.c_str(),&pcvs)) {
@@ -965,7 +965,7 @@ void __fastcall TMainForm::SvrStart(void)
             if (!(pcv=searchpcv(i+1,"",time,&pcvs))) continue;
             rtksvr.nav.pcvs[i]=*pcv;
         }
-        free(pcvs.pcv);
+        freepcv(&pcvs);
     }
     if (BaselineC) {
         PrcOpt.baseline[0]=Baseline[0];
@@ -1102,7 +1102,7 @@ void __fastcall TOptDialog::ReadAntList(void)
 	RovAnt->Items=list;
 	RefAnt->Items=list;
 	
-	free(pcvs.pcv);
+	freepcv(&pcvs);
 }
 //---------------------------------------------------------------------------
 
@@ -23,6 +23,8 @@
 *                           change file paths of solution status and debug trace
 *           2015/01/10 1.11 add line editting and command history
 *                           separate codes for virtual console to vt.c
+*           2026/10/19 1.12 add command timing
+*                           binary antex cache in directory of file options
 *-----------------------------------------------------------------------------*/
 #include <signal.h>
 #include "rtklib.h"
@@ -99,6 +101,7 @@ static const char *helptxt[]={
     " restart          : restart rtk sever",
     " solution [cycle] : show solution",
     " status [cycle]   : show rtk status",
+    " timing [cycle|reset]: show timing of processing stages",
     " satellite [-n] [cycle]: show satellite status",
     " observ [-n] [cycle]   : show observation data",
     " navidata [cycle] : show navigation data",
@@ -118,7 +121,7 @@ static const char *helptxt[]={
 static const char *pathopts[]={         /* path options help */
     "stream path formats",
     " serial   : port[:bit_rate[:byte[:parity(n|o|e)[:stopb[:fctr(off|on)]]]]]",
-    " file     : path[::T[::+offset][::xspeed]]",
+    " file     : path[::T[::+offset][::xspeed|::xmax]]",
     " tcpsvr   : :port",
     " tcpcli   : addr:port",
     " ntripsvr : user:passwd@addr:port/mntpnt[:str]",
@@ -135,7 +138,7 @@ static const char *pathopts[]={         /* path options help */
 #define OSTOPT  "0:off,1:serial,2:file,3:tcpsvr,4:tcpcli,6:ntripsvr"
 #define FMTOPT  "0:rtcm2,1:rtcm3,2:oem4,3:oem3,4:ubx,5:ss2,6:hemis,7:skytraq,8:gw10,9:javad,10:nvs,11:binex,12:rt17,15:sp3"
 #define NMEOPT  "0:off,1:latlon,2:single"
-#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea"
+#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea,5:bin"
 #define MSGOPT  "0:all,1:rover,2:base,3:corr"
 
 static opt_t rcvopts[]={
@@ -307,6 +310,8 @@ static void readant(vt_t *vt, prcopt_t *opt, nav_t *nav)
     opt->pcvr[0]=opt->pcvr[1]=pcv0;
     if (!*filopt.rcvantp) return;
     
+    setpcvcache(filopt.pcvdir);
+    
     if (readpcv(filopt.rcvantp,&pcvr)) {
         for (i=0;i<2;i++) {
             if (!*opt->anttype[i]) continue;
@@ -327,7 +332,7 @@ static void readant(vt_t *vt, prcopt_t *opt, nav_t *nav)
     }
     else vt_printf(vt,"antenna file open error %s",filopt.satantp);
     
-    free(pcvr.pcv); free(pcvs.pcv);
+    freepcv(&pcvr); freepcv(&pcvs);
 }
 /* start rtk server ----------------------------------------------------------*/
 static int startsvr(vt_t *vt)
@@ -834,6 +839,29 @@ static void prerror(vt_t *vt)
     }
     rtksvrunlock(&svr);
 }
+/* print timing --------------------------------------------------------------*/
+static void prtiming(vt_t *vt)
+{
+    const char *stage[]={
+        "rtkpos","pntpos","satposs","zdres","ddres","filter","resamb",
+        "valpos","pppos","outsol"
+    };
+    prof_t prof[NPROF];
+    double stat[4];
+    int i;
+    
+    trace(4,"prtiming:\n");
+    
+    rtksvrprof(&svr,prof,0);
+    
+    vt_printf(vt,"\n%s%-12s %10s %10s %10s %10s %10s%s\n",ESC_BOLD,"stage","count",
+              "min(ms)","mean(ms)","p99(ms)","max(ms)",ESC_RESET);
+    for (i=0;i<NPROF;i++) {
+        profstat(prof+i,stat);
+        vt_printf(vt,"%-12s %10u %10.3f %10.3f %10.3f %10.3f\n",stage[i],
+                  prof[i].n,stat[0]*1E3,stat[1]*1E3,stat[2]*1E3,stat[3]*1E3);
+    }
+}
 /* print stream --------------------------------------------------------------*/
 static void prstream(vt_t *vt)
 {
@@ -930,6 +958,26 @@ static void cmd_status(char **args, int narg, vt_t *vt)
     }
     vt_printf(vt,"\n");
 }
+/* timing command ------------------------------------------------------------*/
+static void cmd_timing(char **args, int narg, vt_t *vt)
+{
+    int cycle=0;
+    
+    trace(3,"cmd_timing:\n");
+    
+    if (narg>1&&!strcmp(args[1],"reset")) {
+        rtksvrprof(&svr,NULL,1);
+        return;
+    }
+    if (narg>1) cycle=(int)(atof(args[1])*1000.0);
+    
+    while (!vt_chkbrk(vt)) {
+        if (cycle>0) vt_printf(vt,ESC_CLEAR);
+        prtiming(vt);
+        if (cycle>0) sleepms(cycle); else return;
+    }
+    vt_printf(vt,"\n");
+}
 /* satellite command ---------------------------------------------------------*/
 static void cmd_satellite(char **args, int narg, vt_t *vt)
 {
@@ -1201,7 +1249,7 @@ static void cmdshell(vt_t *vt)
     const char *cmds[]={
         "start","stop","restart","solution","status","satellite","observ",
         "navidata","stream","error","option","set","load","save","log","help",
-        "?","exit","shutdown",""
+        "?","exit","shutdown","timing",""
     };
     int i,j,narg;
     char buff[MAXCMD],*args[MAXARG],*p;
@@ -1254,6 +1302,7 @@ static void cmdshell(vt_t *vt)
                 if (!vt_gets(vt,buff,sizeof(buff))||vt->brk) continue;
                 if (toupper((int)buff[0])=='Y') intflg=1;
                 break;
+            case 19: cmd_timing   (args,narg,vt); break;
             default:
                 vt_printf(vt,"unknown command: %s.\n",args[0]);
                 break;
@@ -1306,6 +1355,11 @@ static void cmdshell(vt_t *vt)
 *     status [cycle]
 *       Show RTK status. Use option cycle for cyclic display.
 *
+*     timing [cycle|reset]
+*       Show processing time (ms) (min/mean/p99/max) of processing stages by
+*       wall-clock. Use option cycle for cyclic display. Option reset clears
+*       the timing counters.
+*
 *     satellite [-n] [cycle]
 *       Show satellite status. Use option cycle for cyclic display. Option -n
 *       specify number of frequencies.
@@ -18,6 +18,7 @@
 *           2014/11/08  1.8  add option -a, -i and -o
 *           2015/03/23  1.9  fix bug on parsing of command line options
 *           2018/01/29  1.10 fix bug on invalid sta position by option -p (#126)
+*           2026/10/19  1.11 add option -q and -qs
 *-----------------------------------------------------------------------------*/
 #include <signal.h>
 #include <unistd.h>
@@ -60,7 +61,7 @@ static const char *help[]={
 "    tcp client   : tcpcli://addr[:port]",
 "    ntrip client : ntrip://[user[:passwd]@]addr[:port][/mntpnt]",
 "    ntrip server : ntrips://[:passwd@]addr[:port][/mntpnt[:str]] (only out)",
-"    file         : [file://]path[::T][::+start][::xseppd][::S=swap]",
+"    file         : [file://]path[::T][::+start][::xseppd|::xmax][::S=swap][::B]",
 "",
 "  format",
 "    rtcm2        : RTCM 2 (only in)",
@@ -85,6 +86,8 @@ static const char *help[]={
 " -r  msec          reconnect interval (ms) [10000]",
 " -n  msec          nmea request cycle (m) [0]",
 " -f  sec           file swap margin (s) [30]",
+" -q  policy        output queue policy if full (block,dropold,dropnew) [block]",
+" -qs bytes         output queue size (bytes) [16 x buffer size]",
 " -c  file          receiver commands file [no]",
 " -p  lat lon hgt   station position (latitude/longitude/height) (deg,m)",
 " -a  antinfo       antenna info (separated by ,)",
@@ -193,7 +196,8 @@ int main(int argc, char **argv)
     char *ant[]={"","",""},*rcv[]={"","",""};
     int i,j,n=0,dispint=5000,trlevel=0,opts[]={10000,10000,2000,32768,10,0,30};
     int types[MAXSTR]={STR_FILE,STR_FILE},stat[MAXSTR]={0},byte[MAXSTR]={0};
-    int bps[MAXSTR]={0},fmts[MAXSTR]={0},sta=0;
+    int bps[MAXSTR]={0},fmts[MAXSTR]={0},sta=0,lag[MAXSTR]={0};
+    int drop[MAXSTR]={0},qpol=STRQ_BLOCK,qsize=0;
     
     for (i=0;i<MAXSTR;i++) paths[i]=s[i];
     
@@ -224,6 +228,13 @@ int main(int argc, char **argv)
         else if (!strcmp(argv[i],"-r"  )&&i+1<argc) opts[1]=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-n"  )&&i+1<argc) opts[5]=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-f"  )&&i+1<argc) opts[6]=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-q"  )&&i+1<argc) {
+            if      (!strcmp(argv[++i],"block"  )) qpol=STRQ_BLOCK;
+            else if (!strcmp(argv[  i],"dropold")) qpol=STRQ_DROPOLD;
+            else if (!strcmp(argv[  i],"dropnew")) qpol=STRQ_DROPNEW;
+            else printhelp();
+        }
+        else if (!strcmp(argv[i],"-qs" )&&i+1<argc) qsize=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-c"  )&&i+1<argc) cmdfile=argv[++i];
         else if (!strcmp(argv[i],"-a"  )&&i+1<argc) antinfo=argv[++i];
         else if (!strcmp(argv[i],"-i"  )&&i+1<argc) rcvinfo=argv[++i];
@@ -268,6 +279,8 @@ int main(int argc, char **argv)
     
     strsvrinit(&strsvr,n+1);
     
+    for (i=1;i<=n;i++) strsvrsetq(&strsvr,i,qpol,qsize);
+    
     if (trlevel>0) {
         traceopen(TRFILE);
         tracelevel(trlevel);
@@ -287,7 +300,7 @@ int main(int argc, char **argv)
     for (intrflg=0;!intrflg;) {
         
         /* get stream server status */
-        strsvrstat(&strsvr,stat,byte,bps,strmsg);
+        strsvrstat(&strsvr,stat,byte,bps,lag,drop,strmsg);
         
         /* show stream server status */
         for (i=0,p=buff;i<MAXSTR;i++) p+=sprintf(p,"%c",ss[stat[i]+1]);
@@ -295,6 +308,12 @@ int main(int argc, char **argv)
         fprintf(stderr,"%s [%s] %10d B %7d bps %s\n",
                 time_str(utc2gpst(timeget()),0),buff,byte[0],bps[0],strmsg);
         
+        for (i=1;i<=n;i++) {
+            if (lag[i]<dispint&&drop[i]<=0) continue;
+            fprintf(stderr,"  (%d) output lag %6d ms dropped %10d B\n",i,
+                    lag[i],drop[i]);
+        }
+        
         sleepms(dispint);
     }
     if (*cmdfile) readcmd(cmdfile,cmd,1);
@@ -399,7 +399,7 @@ void __fastcall TMainForm::Timer1Timer(TObject *Sender)
     char msg[MAXSTRMSG*4]="",s1[256],s2[256];
     double ctime,t[4];
     
-    strsvrstat(&strsvr,stat,byte,bps,msg);
+    strsvrstat(&strsvr,stat,byte,bps,NULL,NULL,msg);
     for (int i=0;i<4;i++) {
         num2cnum(byte[i],s1);
         num2cnum(bps[i],s2);
@@ -17,6 +17,7 @@
 *           2009/01/19  1.3  fix bug on display mark with by-q-flag option
 *           2010/05/10  1.4  support api readsolt() change
 *           2010/08/14  1.5  fix bug on readsolt() (2.4.0_p3)
+*           2026/10/19  1.6  get geoid heights of all solutions by geoidh_n()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -32,10 +33,10 @@ static const char rcsid[]="$Id: convkml.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $"
 #define MARKICON "http://maps.google.com/mapfiles/kml/pal2/icon18.png"
 
 /* output track --------------------------------------------------------------*/
-static void outtrack(FILE *f, const solbuf_t *solbuf, const char *color,
-                     int outalt, int outtime)
+static void outtrack(FILE *f, const solbuf_t *solbuf, const double *pos,
+                     const double *geoh, const char *color, int outalt,
+                     int outtime)
 {
-    double pos[3];
     int i;
     
     fprintf(f,"<Placemark>\n");
@@ -49,17 +50,15 @@ static void outtrack(FILE *f, const solbuf_t *solbuf, const char *color,
     if (outalt) fprintf(f,"<altitudeMode>absolute</altitudeMode>\n");
     fprintf(f,"<coordinates>\n");
     for (i=0;i<solbuf->n;i++) {
-        ecef2pos(solbuf->data[i].rr,pos);
-        if      (outalt==0) pos[2]=0.0;
-        else if (outalt==2) pos[2]-=geoidh(pos);
-        fprintf(f,"%13.9f,%12.9f,%5.3f\n",pos[1]*R2D,pos[0]*R2D,pos[2]);
+        fprintf(f,"%13.9f,%12.9f,%5.3f\n",pos[i*3+1]*R2D,pos[i*3]*R2D,
+                outalt==0?0.0:pos[i*3+2]-geoh[i]);
     }
     fprintf(f,"</coordinates>\n");
     fprintf(f,"</LineString>\n");
     fprintf(f,"</Placemark>\n");
 }
 /* output point --------------------------------------------------------------*/
-static void outpoint(FILE *fp, gtime_t time, const double *pos,
+static void outpoint(FILE *fp, gtime_t time, const double *pos, double geoh,
                      const char *label, int style, int outalt, int outtime)
 {
     double ep[6],alt=0.0;
@@ -84,7 +83,7 @@ static void outpoint(FILE *fp, gtime_t time, const double *pos,
     if (outalt) {
         fprintf(fp,"<extrude>1</extrude>\n");
         fprintf(fp,"<altitudeMode>absolute</altitudeMode>\n");
-        alt=pos[2]-(outalt==2?geoidh(pos):0.0);
+        alt=pos[2]-geoh;
     }
     fprintf(fp,"<coordinates>%13.9f,%12.9f,%5.3f</coordinates>\n",pos[1]*R2D,
             pos[0]*R2D,alt);
@@ -96,13 +95,25 @@ static int savekml(const char *file, const solbuf_t *solbuf, int tcolor,
                    int pcolor, int outalt, int outtime)
 {
     FILE *fp;
-    double pos[3];
+    double *pos,*geoh,rb[3];
     int i,qcolor[]={0,1,2,5,4,3,0};
     char *color[]={
         "ffffffff","ff008800","ff00aaff","ff0000ff","ff00ffff","ffff00ff"
     };
+    if (!(pos=(double *)malloc(sizeof(double)*3*solbuf->n))||
+        !(geoh=(double *)calloc(solbuf->n,sizeof(double)))) {
+        free(pos);
+        return 0;
+    }
+    /* geodetic positions and geoid heights of solutions */
+    for (i=0;i<solbuf->n;i++) {
+        ecef2pos(solbuf->data[i].rr,pos+i*3);
+    }
+    if (outalt==2) geoidh_n(pos,solbuf->n,geoh);
+    
     if (!(fp=fopen(file,"w"))) {
         fprintf(stderr,"file open error : %s\n",file);
+        free(pos); free(geoh);
         return 0;
     }
     fprintf(fp,"%s\n%s\n",HEADKML1,HEADKML2);
@@ -117,25 +128,26 @@ static int savekml(const char *file, const solbuf_t *solbuf, int tcolor,
         fprintf(fp,"</Style>\n");
     }
     if (tcolor>0) {
-        outtrack(fp,solbuf,color[tcolor-1],outalt,outtime);
+        outtrack(fp,solbuf,pos,geoh,color[tcolor-1],outalt,outtime);
     }
     if (pcolor>0) {
         fprintf(fp,"<Folder>\n");
         fprintf(fp,"  <name>Rover Position</name>\n");
         for (i=0;i<solbuf->n;i++) {
-            ecef2pos(solbuf->data[i].rr,pos);
-            outpoint(fp,solbuf->data[i].time,pos,"",
+            outpoint(fp,solbuf->data[i].time,pos+i*3,geoh[i],"",
                      pcolor==5?qcolor[solbuf->data[i].stat]:pcolor-1,outalt,outtime);
         }
         fprintf(fp,"</Folder>\n");
     }
     if (norm(solbuf->rb,3)>0.0) {
-        ecef2pos(solbuf->rb,pos);
-        outpoint(fp,solbuf->data[0].time,pos,"Reference Position",0,outalt,0);
+        ecef2pos(solbuf->rb,rb);
+        outpoint(fp,solbuf->data[0].time,rb,outalt==2?geoidh(rb):0.0,
+                 "Reference Position",0,outalt,0);
     }
     fprintf(fp,"</Document>\n");
     fprintf(fp,"</kml>\n");
     fclose(fp);
+    free(pos); free(geoh);
     return 1;
 }
 /* convert to google earth kml file --------------------------------------------
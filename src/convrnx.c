@@ -25,6 +25,9 @@
 *                           add approx position in rinex obs header if blank
 *           2014/05/24 1.8  support beidou B1
 *           2014/08/26 1.9  support input format rt17
+*           2026/10/19 1.10 single-pass scan of obs types with obs spool
+*                           format rinex obs by pipeline thread
+*                           wait pipeline blocks by condition variable
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -32,6 +35,8 @@ static const char rcsid[]="$Id:$";
 
 #define NOUTFILE        7       /* number of output files */
 #define TSTARTMARGIN    60.0    /* time margin for file name replacement */
+#define NPIPEBLK        4       /* number of blocks of obs output pipeline */
+#define PIPEBLKOBS      2048    /* number of obs data in a pipeline block */
 
 /* type definition -----------------------------------------------------------*/
 
@@ -47,6 +52,23 @@ typedef struct {                /* stream file type */
     FILE   *fp;                 /* file pointer */
 } strfile_t;
 
+typedef struct {                /* obs output pipeline block type */
+    obsd_t *data;               /* obs data */
+    int    nobs,nepoch;         /* number of obs data and epochs */
+    int    n[PIPEBLKOBS];       /* number of obs data of each epoch */
+} obsblk_t;
+
+typedef struct {                /* obs output pipeline type */
+    FILE   *fp;                 /* rinex obs file */
+    const rnxopt_t *opt;        /* rinex options */
+    obsblk_t blk[NPIPEBLK];     /* obs data blocks (ring buffer) */
+    int    wp,rp;               /* block pointers {write,read} */
+    int    state;               /* state (0:inline,1:running,2:closing) */
+    thread_t thread;            /* rinex obs formatting thread */
+    lock_t lock;                /* lock flag */
+    cond_t cond;                /* condition of block pointers or state */
+} obspipe_t;
+
 /* global variables ----------------------------------------------------------*/
 static const int navsys[]={     /* system codes */
     SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP,0
@@ -393,6 +415,57 @@ static void setopt_obstype(const unsigned char *codes,
         }
     }
 }
+/* scan codes and types in obs data -----------------------------------------*/
+static void scan_obs(const obs_t *obs, unsigned char codes[][33],
+                     unsigned char types[][33], int *n)
+{
+    int i,j,k,l,sys;
+    
+    for (i=0;i<obs->n;i++) {
+        sys=satsys(obs->data[i].sat,NULL);
+        for (l=0;navsys[l];l++) if (navsys[l]==sys) break;
+        if (!navsys[l]) continue;
+        
+        for (j=0;j<NFREQ+NEXOBS;j++) {
+            if (!obs->data[i].code[j]) continue;
+            
+            for (k=0;k<n[l];k++) {
+                if (codes[l][k]==obs->data[i].code[j]) break;
+            }
+            if (k>=n[l]&&n[l]<32) {
+                codes[l][n[l]++]=obs->data[i].code[j];
+            }
+            if (k<n[l]) {
+                if (obs->data[i].P[j]!=0.0) types[l][k]|=1;
+                if (obs->data[i].L[j]!=0.0) types[l][k]|=2;
+                if (obs->data[i].D[j]!=0.0) types[l][k]|=4;
+                if (obs->data[i].SNR[j]!=0) types[l][k]|=8;
+            }
+        }
+    }
+}
+/* set scanned observation types in rinex option -----------------------------*/
+static void set_scantype(unsigned char codes[][33], unsigned char types[][33],
+                         const int *n, rnxopt_t *opt)
+{
+    int i,j;
+    
+    for (i=0;i<6;i++) for (j=0;j<n[i];j++) {
+        trace(2,"scan_obstype: sys=%d code=%s type=%d\n",i,code2obs(codes[i][j],NULL),types[i][j]);
+    }
+    for (i=0;i<6;i++) {
+        
+        /* sort codes */
+        sort_codes(codes[i],types[i],n[i]);
+        
+        /* set observation types in rinex option */
+        setopt_obstype(codes[i],types[i],i,opt);
+        
+        for (j=0;j<n[i];j++) {
+            trace(3,"scan_obstype: sys=%d code=%s\n",i,code2obs(codes[i][j],NULL));
+        }
+    }
+}
 /* scan observation types ----------------------------------------------------*/
 static int scan_obstype(int format, const char *file, rnxopt_t *opt,
                         gtime_t *time)
@@ -401,7 +474,7 @@ static int scan_obstype(int format, const char *file, rnxopt_t *opt,
     unsigned char codes[6][33]={{0}};
     unsigned char types[6][33]={{0}};
     char msg[128];
-    int i,j,k,l,c=0,type,sys,abort=0,n[6]={0};
+    int c=0,type,abort=0,n[6]={0};
     
     trace(3,"scan_obstype: file=%s, opt=%s\n",file,opt);
     
@@ -417,29 +490,9 @@ static int scan_obstype(int format, const char *file, rnxopt_t *opt,
         if (type!=1||str->obs->n<=0) continue;
         
         if (!opt->ts.time||timediff(str->obs->data[0].time,opt->ts)>=0.001) {
-             
-            for (i=0;i<str->obs->n;i++) {
-                sys=satsys(str->obs->data[i].sat,NULL);
-                for (l=0;navsys[l];l++) if (navsys[l]==sys) break;
-                if (!navsys[l]) continue;
-                
-                for (j=0;j<NFREQ+NEXOBS;j++) {
-                    if (!str->obs->data[i].code[j]) continue;
-                    
-                    for (k=0;k<n[l];k++) {
-                        if (codes[l][k]==str->obs->data[i].code[j]) break;
-                    }
-                    if (k>=n[l]&&n[l]<32) {
-                        codes[l][n[l]++]=str->obs->data[i].code[j];
-                    }
-                    if (k<n[l]) {
-                        if (str->obs->data[i].P[j]!=0.0) types[l][k]|=1;
-                        if (str->obs->data[i].L[j]!=0.0) types[l][k]|=2;
-                        if (str->obs->data[i].D[j]!=0.0) types[l][k]|=4;
-                        if (str->obs->data[i].SNR[j]!=0) types[l][k]|=8;
-                    }
-                }
-            }
+            
+            scan_obs(str->obs,codes,types,n);
+            
             if (!time->time) *time=str->obs->data[0].time;
         }
         if (opt->te.time&&timediff(str->obs->data[0].time,opt->te)>10.0) break;
@@ -460,20 +513,27 @@ static int scan_obstype(int format, const char *file, rnxopt_t *opt,
         trace(2,"aborted in scan\n");
         return 0;
     }
-    for (i=0;i<6;i++) for (j=0;j<n[i];j++) {
-        trace(2,"scan_obstype: sys=%d code=%s type=%d\n",i,code2obs(codes[i][j],NULL),types[i][j]);
-    }
-    for (i=0;i<6;i++) {
-        
-        /* sort codes */
-        sort_codes(codes[i],types[i],n[i]);
-        
-        /* set observation types in rinex option */
-        setopt_obstype(codes[i],types[i],i,opt);
-        
-        for (j=0;j<n[i];j++) {
-            trace(3,"scan_obstype: sys=%d code=%s\n",i,code2obs(codes[i][j],NULL));
-        }
+    set_scantype(codes,types,n,opt);
+    return 1;
+}
+/* test single-pass scan of observation types ----------------------------------
+* obs types can be scanned in the conversion pass if the decoder and the output
+* paths do not depend on the first obs time found by the scan
+*-----------------------------------------------------------------------------*/
+static int scan_single(int format, const rnxopt_t *opt, char **ofile,
+                       gtime_t time)
+{
+    gtime_t t0={0};
+    char path[1024];
+    int i;
+    
+    if (time.time||opt->ts.time) return 1;
+    
+    /* rtcm week is resolved by first obs time of scan without approx time */
+    if (format==STRFMT_RTCM2||format==STRFMT_RTCM3) return 0;
+    
+    for (i=0;i<NOUTFILE;i++) {
+        if (reppath(ofile[i],path,t0,"","")<0) return 0;
     }
     return 1;
 }
@@ -587,7 +647,7 @@ static void restslips(unsigned char slips[][NFREQ+NEXOBS], obsd_t *data, int n)
 }
 /* open output files ---------------------------------------------------------*/
 static int openfile(FILE **ofp, char *files[], const char *file,
-                    const rnxopt_t *opt, nav_t *nav)
+                    const rnxopt_t *opt, nav_t *nav, int spool)
 {
     char path[1024];
     int i;
@@ -613,7 +673,7 @@ static int openfile(FILE **ofp, char *files[], const char *file,
         }
         /* write header to file */
         switch (i) {
-            case 0: outrnxobsh (ofp[0],opt,nav); break;
+            case 0: if (!spool) outrnxobsh(ofp[0],opt,nav); break;
             case 1: outrnxnavh (ofp[1],opt,nav); break;
             case 2: outrnxgnavh(ofp[2],opt,nav); break;
             case 3: outrnxhnavh(ofp[3],opt,nav); break;
@@ -647,9 +707,167 @@ static void closefile(FILE **ofp, const rnxopt_t *opt, nav_t *nav)
         fclose(ofp[i]);
     }
 }
+/* format obs data blocks of pipeline ----------------------------------------*/
+static void outpipeblk(obspipe_t *pipe, obsblk_t *blk)
+{
+    int i,j;
+    
+    for (i=j=0;i<blk->nepoch;j+=blk->n[i++]) {
+        outrnxobsb(pipe->fp,pipe->opt,blk->data+j,blk->n[i],0);
+    }
+    blk->nobs=blk->nepoch=0;
+}
+/* obs output pipeline thread ------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI pipethread(void *arg)
+#else
+static void *pipethread(void *arg)
+#endif
+{
+    obspipe_t *pipe=(obspipe_t *)arg;
+    int rp;
+    
+    trace(3,"pipethread:\n");
+    
+    lock(&pipe->lock);
+    for (;;) {
+        while (pipe->rp==pipe->wp&&pipe->state!=2) {
+            waitcond(&pipe->cond,&pipe->lock);
+        }
+        if (pipe->rp==pipe->wp) break; /* closing and no block */
+        rp=pipe->rp;
+        unlock(&pipe->lock);
+        
+        outpipeblk(pipe,pipe->blk+rp);
+        
+        lock(&pipe->lock);
+        pipe->rp=(rp+1)%NPIPEBLK;
+        signalcond(&pipe->cond);
+    }
+    unlock(&pipe->lock);
+    return 0;
+}
+/* open obs output pipeline ----------------------------------------------------
+* rinex obs records are formatted by a pipeline thread while the next messages
+* are decoded. the obs data are formatted inline if the thread is not started
+*-----------------------------------------------------------------------------*/
+static void open_pipe(obspipe_t *pipe, FILE *fp, const rnxopt_t *opt)
+{
+    int i;
+    
+    trace(3,"open_pipe:\n");
+    
+    pipe->fp=fp;
+    pipe->opt=opt;
+    pipe->wp=pipe->rp=pipe->state=0;
+    initlock(&pipe->lock);
+    initcond(&pipe->cond);
+    
+    for (i=0;i<NPIPEBLK;i++) {
+        pipe->blk[i].nobs=pipe->blk[i].nepoch=0;
+        pipe->blk[i].data=(obsd_t *)malloc(sizeof(obsd_t)*PIPEBLKOBS);
+    }
+    for (i=0;i<NPIPEBLK;i++) if (!pipe->blk[i].data) return;
+    
+    pipe->state=1;
+#ifdef WIN32
+    if (!(pipe->thread=CreateThread(NULL,0,pipethread,pipe,0,NULL))) {
+#else
+    if (pthread_create(&pipe->thread,NULL,pipethread,pipe)) {
+#endif
+        trace(2,"obs output pipeline thread error\n");
+        pipe->state=0;
+    }
+}
+/* pass filled block to pipeline thread --------------------------------------*/
+static void sendpipeblk(obspipe_t *pipe)
+{
+    if (pipe->blk[pipe->wp].nepoch<=0) return;
+    
+    lock(&pipe->lock);
+    
+    /* wait for free block */
+    while ((pipe->wp+1)%NPIPEBLK==pipe->rp) {
+        waitcond(&pipe->cond,&pipe->lock);
+    }
+    pipe->wp=(pipe->wp+1)%NPIPEBLK;
+    signalcond(&pipe->cond);
+    unlock(&pipe->lock);
+}
+/* output obs data to pipeline -----------------------------------------------*/
+static void put_pipe(obspipe_t *pipe, const obsd_t *data, int n)
+{
+    obsblk_t *blk;
+    
+    if (n>MAXOBS) n=MAXOBS;
+    
+    if (pipe->state!=1) {
+        outrnxobsb(pipe->fp,pipe->opt,data,n,0);
+        return;
+    }
+    if (pipe->blk[pipe->wp].nobs+n>PIPEBLKOBS) sendpipeblk(pipe);
+    
+    blk=pipe->blk+pipe->wp;
+    memcpy(blk->data+blk->nobs,data,sizeof(obsd_t)*n);
+    blk->nobs+=n;
+    blk->n[blk->nepoch++]=n;
+}
+/* close obs output pipeline -------------------------------------------------*/
+static void close_pipe(obspipe_t *pipe)
+{
+    int i;
+    
+    trace(3,"close_pipe:\n");
+    
+    if (pipe->state==1) {
+        sendpipeblk(pipe);
+        lock(&pipe->lock);
+        pipe->state=2;
+        signalcond(&pipe->cond);
+        unlock(&pipe->lock);
+#ifdef WIN32
+        WaitForSingleObject(pipe->thread,INFINITE);
+        CloseHandle(pipe->thread);
+#else
+        pthread_join(pipe->thread,NULL);
+#endif
+    }
+    pipe->state=0;
+    
+    for (i=0;i<NPIPEBLK;i++) {
+        free(pipe->blk[i].data); pipe->blk[i].data=NULL;
+    }
+}
+/* spool obs data ------------------------------------------------------------*/
+static void spoolobs(FILE *fp, const obsd_t *data, int n)
+{
+    if (n>MAXOBS) n=MAXOBS;
+    
+    if (fwrite(&n,sizeof(int),1,fp)!=1||
+        fwrite(data,sizeof(obsd_t),n,fp)!=(size_t)n) {
+        trace(1,"obs spool write error\n");
+    }
+}
+/* output spooled obs data to pipeline ---------------------------------------*/
+static void unspoolobs(FILE *fp, obspipe_t *pipe)
+{
+    obsd_t *data;
+    int n;
+    
+    trace(3,"unspoolobs:\n");
+    
+    if (!(data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) return;
+    
+    rewind(fp);
+    while (fread(&n,sizeof(int),1,fp)==1&&0<n&&n<=MAXOBS) {
+        if (fread(data,sizeof(obsd_t),n,fp)!=(size_t)n) break;
+        put_pipe(pipe,data,n);
+    }
+    free(data);
+}
 /* convert obs message -------------------------------------------------------*/
-static void convobs(FILE **ofp, rnxopt_t *opt, strfile_t *str, int *n,
-                    unsigned char slips[][NFREQ+NEXOBS])
+static void convobs(FILE **ofp, obspipe_t *pipe, FILE *fp_spool, rnxopt_t *opt,
+                    strfile_t *str, int *n, unsigned char slips[][NFREQ+NEXOBS])
 {
     gtime_t time;
     
@@ -667,8 +885,9 @@ static void convobs(FILE **ofp, rnxopt_t *opt, strfile_t *str, int *n,
     /* restore slips */
     restslips(slips,str->obs->data,str->obs->n);
     
-    /* output rinex obs */
-    outrnxobsb(ofp[0],opt,str->obs->data,str->obs->n,0);
+    /* output rinex obs or spool obs data for single-pass scan */
+    if (fp_spool) spoolobs(fp_spool,str->obs->data,str->obs->n);
+    else put_pipe(pipe,str->obs->data,str->obs->n);
     
     if (opt->tstart.time==0) opt->tstart=time;
     opt->tend=time;
@@ -884,11 +1103,13 @@ static int showstat(int sess, gtime_t ts, gtime_t te, int *n)
 static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
                      char **ofile)
 {
-    FILE *ofp[NOUTFILE]={NULL};
+    FILE *ofp[NOUTFILE]={NULL},*fp_spool=NULL;
+    obspipe_t pipe;
     strfile_t *str;
     gtime_t ts={0},te={0},tend={0},time={0};
     unsigned char slips[MAXSAT][NFREQ+NEXOBS]={{0}};
-    int i,j,nf,type,n[NOUTFILE+1]={0},abort=0;
+    unsigned char codes[6][33]={{0}},types[6][33]={{0}};
+    int i,j,nf,type,n[NOUTFILE+1]={0},nc[6]={0},abort=0;
     char path[1024],*paths[NOUTFILE],s[NOUTFILE][1024];
     char *epath[MAXEXFILE]={0},*staid=*opt->staid?opt->staid:"0000";
     
@@ -913,7 +1134,12 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
     if (format==STRFMT_RTCM2||format==STRFMT_RTCM3||format==STRFMT_RT17) {
         time=opt->trtcm;
     }
-    if (opt->scanobs) {
+    if (opt->scanobs&&*ofile[0]&&scan_single(format,opt,ofile,time)) {
+        
+        /* spool obs data to scan observation types in single-pass */
+        if (!(fp_spool=tmpfile())) trace(2,"obs spool open error\n");
+    }
+    if (opt->scanobs&&!fp_spool) {
         
         /* scan observation types */
         if (!scan_obstype(format,epath[0],opt,&time)) return 0;
@@ -924,6 +1150,7 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
     }
     if (!(str=gen_strfile(format,opt->rcvopt,time))) {
         for (i=0;i<MAXEXFILE;i++) free(epath[i]);
+        if (fp_spool) fclose(fp_spool);
         return 0;
     }
     time=opt->ts.time?opt->ts:(time.time?timeadd(time,TSTARTMARGIN):time);
@@ -934,16 +1161,21 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
         if (reppath(ofile[i],paths[i],time,staid,"")<0) {
             showmsg("no time for output path: %s",ofile[i]);
             for (i=0;i<MAXEXFILE;i++) free(epath[i]);
+            if (fp_spool) fclose(fp_spool);
             free_strfile(str);
             return 0;
         }
     }
     /* open output files */
-    if (!openfile(ofp,paths,path,opt,str->nav)) {
+    if (!openfile(ofp,paths,path,opt,str->nav,fp_spool!=NULL)) {
         for (i=0;i<MAXEXFILE;i++) free(epath[i]);
+        if (fp_spool) fclose(fp_spool);
         free_strfile(str);
         return 0;
     }
+    /* open obs output pipeline */
+    if (ofp[0]&&!fp_spool) open_pipe(&pipe,ofp[0],opt);
+    
     for (i=0;i<nf&&!abort;i++) {
         
         /* open stream file */
@@ -957,9 +1189,14 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
             /* avioid duplicated if overlapped data */
             if (tend.time&&timediff(str->time,tend)<=0.0) continue;
             
+            /* scan observation types */
+            if (fp_spool&&type==1&&str->obs->n>0&&(!opt->ts.time||
+                timediff(str->obs->data[0].time,opt->ts)>=0.001)) {
+                scan_obs(str->obs,codes,types,nc);
+            }
             /* convert message */
             switch (type) {
-                case  1: convobs(ofp,opt,str,n,slips); break;
+                case  1: convobs(ofp,&pipe,fp_spool,opt,str,n,slips); break;
                 case  2: convnav(ofp,opt,str,n);       break;
                 case  3: convsbs(ofp,opt,str,n);       break;
                 case 31: convlex(ofp,opt,str,n);       break;
@@ -978,6 +1215,9 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
         
         tend=te; /* end time of a file */
     }
+    /* close obs output pipeline */
+    if (ofp[0]&&!fp_spool) close_pipe(&pipe);
+    
     /* set receiver and antenna information to option */
     if (format==STRFMT_RTCM2||format==STRFMT_RTCM3) {
         rtcm2opt(&str->rtcm,opt);
@@ -985,6 +1225,17 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
     else if (format==STRFMT_RINEX) {
         rnx2opt(&str->rnx,opt);
     }
+    /* output spooled obs data with scanned observation types */
+    if (fp_spool) {
+        set_scantype(codes,types,nc,opt);
+        if (ofp[0]) {
+            outrnxobsh(ofp[0],opt,str->nav);
+            open_pipe(&pipe,ofp[0],opt);
+            unspoolobs(fp_spool,&pipe);
+            close_pipe(&pipe);
+        }
+        fclose(fp_spool);
+    }
     /* close output files */
     closefile(ofp,opt,str->nav);
     
@@ -1023,6 +1274,10 @@ static int convrnx_s(int sess, int format, rnxopt_t *opt, const char *file,
 *          keywords in ofile[] are replaced by first obs date/time and station
 *          id (%r)
 *          the order of wild-card expanded files must be in-order by time
+*          if opt->scanobs is set, obs data are spooled to a temporary file
+*          and obs types are scanned in the conversion pass. the input file
+*          is scanned in a separate pass only if rtcm week or time keywords
+*          in ofile[] need the first obs time without opt->ts or opt->trtcm
 *-----------------------------------------------------------------------------*/
 extern int convrnx(int format, rnxopt_t *opt, const char *file, char **ofile)
 {
@@ -6,6 +6,13 @@
 * version : $Revision:$ $Date:$
 * history : 2012/12/28  1.0  new
 *           2013/06/02  1.1  replace S_IREAD by S_IRUSR
+*           2026/10/19  1.2  concurrent download by worker threads
+*                            add per-host concurrency limit, retry, state file
+*                            pipeline uncompression after download
+*                            add file:// (local mirror) url
+*                            add api dl_setopt()
+*           2026/10/19  1.3  wait threads by condition instead of polling
+*                            ignore state file with DLOPT_FORCE
 *-----------------------------------------------------------------------------*/
 #include <errno.h>
 #include <sys/stat.h>
@@ -25,12 +32,16 @@ static const char rcsid[]="$Id:$";
 #define FTP_NOFILE  2048            /* ftp error no file */
 #define HTTP_NOFILE 1               /* http error no file */
 #define FTP_RETRY   3               /* ftp number of retry */
+#define MAXDLJOB    32              /* max number of download threads */
+#define DL_BACKOFF  2000            /* retry backoff base interval (ms) */
+#define DL_WINDOW   1024            /* scheduling window of paths */
 
 /* type definition -----------------------------------------------------------*/
 
 typedef struct {                    /* download path type */
     char *remot;                    /* remote path */
     char *local;                    /* local path */
+    int stat;                       /* status (0:wait,1:run,2:uncomp,else:STAT) */
 } path_t;
 
 typedef struct {                    /* download paths type */
@@ -38,6 +49,37 @@ typedef struct {                    /* download paths type */
     int n,nmax;                     /* number and max number of paths */
 } paths_t;
 
+typedef struct {                    /* download scheduler type */
+    paths_t *paths;                 /* download paths */
+    const char *usr,*pwd,*proxy;    /* login user, password and proxy */
+    int opts;                       /* download options */
+    int next;                       /* first path index not scheduled */
+    int n[4];                       /* number of ok,no_file,skip,error */
+    int abort;                      /* abort flag */
+    int nrun;                       /* number of running download threads */
+    int *fin,nfin;                  /* indices of finished paths */
+    int *cmpq,ncmp,icmp;            /* uncompression queue */
+    char host[MAXDLJOB][256];       /* hosts of running downloads */
+    char remot_p[1024];             /* remote path of listing */
+    char **done;                    /* downloaded paths in state file */
+    int ndone;                      /* number of downloaded paths */
+    FILE *fp,*fp_stat;              /* log and state file pointers */
+    lock_t lock;                    /* lock flag */
+    lock_t lock_list;               /* lock flag of listing file */
+    cond_t cond;                    /* condition of scheduler state */
+} dlsch_t;
+
+typedef struct {                    /* download thread type */
+    dlsch_t *sch;                   /* download scheduler */
+    int id;                         /* thread id */
+    thread_t thread;                /* thread */
+} dljob_t;
+
+static int dl_njob=1;               /* number of download threads */
+static int dl_nhost=0;              /* max downloads per host (0:no limit) */
+static int dl_nretry=0;             /* number of retry on download error */
+static char dl_state[1024]="";      /* download state file */
+
 /* execute command with test timeout -----------------------------------------*/
 extern int execcmd_to(const char *cmd)
 {
@@ -189,6 +231,7 @@ static int add_path(paths_t *paths, const char *remot, const char *dir)
     remot2local(remot,dir,local);
     
     paths->path[paths->n].remot=paths->path[paths->n].local=NULL;
+    paths->path[paths->n].stat=0;
     
     if (!(paths->path[paths->n].remot=(char *)malloc(strlen(remot)+1))||
         !(paths->path[paths->n].local=(char *)malloc(strlen(local)+1))) {
@@ -254,20 +297,40 @@ static int gen_paths(gtime_t time, gtime_t time_p, int seqnos, int seqnoe,
     }
     return 1;
 }
-/* compact download paths ----------------------------------------------------*/
+/* compare download paths ---------------------------------------------------*/
+static int cmp_path(const void *p1, const void *p2)
+{
+    path_t *q1=*(path_t **)p1,*q2=*(path_t **)p2;
+    int stat=strcmp(q1->remot,q2->remot);
+    return stat?stat:(q1<q2?-1:(q1>q2?1:0));
+}
+/* compact download paths ------------------------------------------------------
+* remove duplicated remote paths keeping first ones in order
+*-----------------------------------------------------------------------------*/
 static void compact_paths(paths_t *paths)
 {
-    int i,j,k;
+    path_t **index;
+    int i,j;
     
-    for (i=0;i<paths->n;i++) {
-        for (j=i+1;j<paths->n;j++) {
-            if (strcmp(paths->path[i].remot,paths->path[j].remot)) continue;
-            free(paths->path[j].remot);
-            free(paths->path[j].local);
-            for (k=j;k<paths->n-1;k++) paths->path[k]=paths->path[k+1];
-            paths->n--; j--;
-        }
+    if (paths->n<=1) return;
+    
+    if (!(index=(path_t **)malloc(sizeof(path_t *)*paths->n))) return;
+    
+    for (i=0;i<paths->n;i++) index[i]=paths->path+i;
+    qsort(index,paths->n,sizeof(path_t *),cmp_path);
+    
+    for (i=1;i<paths->n;i++) {
+        if (strcmp(index[i]->remot,index[i-1]->remot)) continue;
+        free(index[i]->remot);
+        free(index[i]->local);
+        index[i]->remot=NULL;
+    }
+    free(index);
+    
+    for (i=j=0;i<paths->n;i++) {
+        if (paths->path[i].remot) paths->path[j++]=paths->path[i];
     }
+    paths->n=j;
 }
 /* generate local directory recursively --------------------------------------*/
 static int mkdir_r(const char *dir)
@@ -375,14 +438,69 @@ static int test_list(const path_t *path)
     fclose(fp);
     return 0;
 }
-/* execute download ----------------------------------------------------------*/
-static int exec_down(const path_t *path, char *remot_p, const char *usr,
-                     const char *pwd, const char *proxy, int opts, int *n,
-                     FILE *fp)
+/* host name of url ----------------------------------------------------------*/
+static void url_host(const char *remot, char *host)
+{
+    const char *p,*q;
+    
+    if ((p=strstr(remot,"://"))) p+=3; else p=remot;
+    if (!(q=strchr(p,'/'))) q=p+strlen(p);
+    if (q-p>255) q=p+255;
+    strncpy(host,p,q-p);
+    host[q-p]='\0';
+}
+/* test compressed file ------------------------------------------------------*/
+static int test_comp(const char *file)
+{
+    const char *p;
+    
+    return (p=strrchr(file,'.'))&&
+           (!strcmp(p,".z")||!strcmp(p,".gz")||!strcmp(p,".zip")||
+            !strcmp(p,".Z")||!strcmp(p,".GZ")||!strcmp(p,".ZIP"));
+}
+/* copy file of local mirror -------------------------------------------------*/
+static int copy_file(const char *remot, const char *local)
 {
-    char dir[1024],errfile[1024],tmpfile[1024],cmd[4096],env[1024]="";
+    FILE *ifp,*ofp;
+    const char *file=remot+7; /* file://path */
+    char buff[32768];
+    size_t n;
+    int stat=0;
+    
+#ifdef WIN32
+    if (file[0]=='/'&&file[1]&&file[2]==':') file++; /* file:///c:/path */
+#endif
+    if (!(ifp=fopen(file,"rb"))) return FTP_NOFILE;
+    
+    if (!(ofp=fopen(local,"wb"))) {
+        fclose(ifp);
+        return -1;
+    }
+    while ((n=fread(buff,1,sizeof(buff),ifp))>0) {
+        if (fwrite(buff,1,n,ofp)<n) {
+            stat=-1;
+            break;
+        }
+    }
+    if (ferror(ifp)) stat=-1;
+    fclose(ifp);
+    if (fclose(ofp)) stat=-1;
+    return stat;
+}
+/* execute download ------------------------------------------------------------
+* download a file by wget or copy of local mirror
+* args   : dlsch_t *sch     IO  download scheduler
+*          path_t *path     I   download path
+*          char   *msg      O   log message
+* return : status ('o':ok,'z':ok and compressed,'x':no file,'.':skip,
+*                  'X':error,'I':invalid path)
+*-----------------------------------------------------------------------------*/
+static int exec_down(dlsch_t *sch, const path_t *path, char *msg)
+{
+    const char *usr=sch->usr,*pwd=sch->pwd,*proxy=sch->proxy;
+    char dir[1024],errfile[1024],cmd[4096],env[1024]="";
     char opt[1024]="",*opt2="",*p;
-    int ret,proto;
+    int ret,proto,nofile=0;
     
 #ifndef WIN32
     opt2=" 2> /dev/null";
@@ -392,43 +510,58 @@ static int exec_down(const path_t *path, char *remot_p, const char *usr,
     
     if      (!strncmp(path->remot,"ftp://" ,6)) proto=0;
     else if (!strncmp(path->remot,"http://",7)) proto=1;
+    else if (!strncmp(path->remot,"file://",7)) proto=2;
     else {
         trace(2,"exec_down: invalid path %s\n",path->remot);
-        showmsg("STAT=X");
-        if (fp) fprintf(fp,"%s ERROR (INVALID PATH)\n",path->remot);
-        n[1]++;
-        return 0;
+        sprintf(msg,"%s ERROR (INVALID PATH)\n",path->remot);
+        return 'I';
     }
     /* test local file existence */
-    if (!(opts&DLOPT_FORCE)&&test_file(path->local)) {
-        showmsg("STAT=.");
-        if (fp) fprintf(fp,"%s in %s\n",path->remot,dir);
-        n[2]++;
-        return 0;
+    if (!(sch->opts&DLOPT_FORCE)&&test_file(path->local)) {
+        sprintf(msg,"%s in %s\n",path->remot,dir);
+        return '.';
     }
-    showmsg("STAT=_");
-    
-    /* get remote file list */
-    if ((p=strrchr(path->remot,'/'))&&
-        strncmp(path->remot,remot_p,p-path->remot)) {
+    if (proto<=1) {
+        lock(&sch->lock_list);
         
-        if (get_list(path,usr,pwd,proxy)) {
-            strcpy(remot_p,path->remot);
+        /* get remote file list */
+        if ((p=strrchr(path->remot,'/'))&&
+            strncmp(path->remot,sch->remot_p,p-path->remot)) {
+            
+            if (get_list(path,usr,pwd,proxy)) {
+                strcpy(sch->remot_p,path->remot);
+            }
         }
+        /* test file in listing */
+        if (proto==0&&!test_list(path)) nofile=1;
+        
+        unlock(&sch->lock_list);
     }
-    /* test file in listing */
-    if (proto==0&&!test_list(path)) {
-        showmsg("STAT=x");
-        if (fp) fprintf(fp,"%s NO_FILE\n",path->remot);
-        n[1]++;
-        return 0;
+    if (nofile) {
+        sprintf(msg,"%s NO_FILE\n",path->remot);
+        return 'x';
     }
     /* generate local directory recursively */
     if (!mkdir_r(dir)) {
-        showmsg("STAT=X");
-        if (fp) fprintf(fp,"%s -> %s ERROR (LOCAL DIR)\n",path->remot,dir);
-        n[3]++;
-        return 0;
+        sprintf(msg,"%s -> %s ERROR (LOCAL DIR)\n",path->remot,dir);
+        return 'X';
+    }
+    p=msg+sprintf(msg,"%s -> %s",path->remot,dir);
+    
+    /* copy file of local mirror */
+    if (proto==2) {
+        if ((ret=copy_file(path->remot,path->local))) {
+            if (ret==FTP_NOFILE) {
+                sprintf(p," NO_FILE\n");
+                return 'x';
+            }
+            remove(path->local);
+            sprintf(p," ERROR (COPY)\n");
+            return 'X';
+        }
+        if (!(sch->opts&DLOPT_KEEPCMP)&&test_comp(path->local)) return 'z';
+        sprintf(p," OK\n");
+        return 'o';
     }
     /* proxy option */
     if (*proxy) {
@@ -451,49 +584,212 @@ static int exec_down(const path_t *path, char *remot_p, const char *usr,
         sprintf(cmd,"%s%s %s %s-t %d -T %d -O \"%s\" -o \"%s\"%s\n",env,FTP_CMD,
                 path->remot,opt,FTP_RETRY,FTP_TIMEOUT,path->local,errfile,opt2);
     }
-    if (fp) fprintf(fp,"%s -> %s",path->remot,dir);
-    
     /* execute download command */
     if ((ret=execcmd_to(cmd))) {
+        remove(path->local);
+        if (!(sch->opts&DLOPT_HOLDERR)) {
+            remove(errfile);
+        }
         if ((proto==0&&ret==FTP_NOFILE)||
             (proto==1&&ret==HTTP_NOFILE)) {
-            showmsg("STAT=x");
-            if (fp) fprintf(fp," NO_FILE\n");
-            n[1]++;
-        }
-        else {
-            trace(2,"exec_down: %s error %d\n",proto==0?"ftp":"http",ret);
-            showmsg("STAT=X");
-            if (fp) fprintf(fp," ERROR (%d)\n",ret);
-            n[3]++;
+            sprintf(p," NO_FILE\n");
+            return 'x';
         }
+        trace(2,"exec_down: %s error %d\n",proto==0?"ftp":"http",ret);
+        sprintf(p," ERROR (%d)\n",ret);
+        if (ret==2) sch->abort=1;
+        return 'X';
+    }
+    remove(errfile);
+    
+    if (!(sch->opts&DLOPT_KEEPCMP)&&test_comp(path->local)) return 'z';
+    
+    sprintf(p," OK\n");
+    return 'o';
+}
+/* uncompress download file --------------------------------------------------*/
+static int exec_uncomp(const path_t *path, char *msg)
+{
+    char dir[1024],tmpfile[1024],*p;
+    
+    strcpy(dir,path->local);
+    if ((p=strrchr(dir,FILEPATHSEP))) *p='\0';
+    
+    p=msg+sprintf(msg,"%s -> %s",path->remot,dir);
+    
+    if (uncompress(path->local,tmpfile)>0) {
         remove(path->local);
-        if (!(opts&DLOPT_HOLDERR)) {
-            remove(errfile);
+        sprintf(p," OK\n");
+        return 'o';
+    }
+    trace(2,"exec_uncomp: uncompress error\n");
+    sprintf(p," ERROR (UNCOMP)\n");
+    return 'C';
+}
+/* finish download path (called with lock) -----------------------------------*/
+static void fin_path(dlsch_t *sch, int i, int stat, const char *msg)
+{
+    sch->paths->path[i].stat=stat=='I'?'X':stat;
+    
+    switch (stat) {
+        case 'o': sch->n[0]++; break;
+        case 'I':
+        case 'x': sch->n[1]++; break;
+        case '.': sch->n[2]++; break;
+        default : sch->n[3]++; break;
+    }
+    if (sch->fp) fputs(msg,sch->fp);
+    
+    if (stat=='o'&&sch->fp_stat) {
+        fprintf(sch->fp_stat,"%s\n",sch->paths->path[i].remot);
+        fflush(sch->fp_stat);
+    }
+    sch->fin[sch->nfin++]=i;
+}
+/* compare strings -----------------------------------------------------------*/
+static int cmp_remot(const void *p1, const void *p2)
+{
+    return strcmp(*(char **)p1,*(char **)p2);
+}
+/* read download state file --------------------------------------------------*/
+static void read_state(dlsch_t *sch, const char *file)
+{
+    FILE *fp;
+    char buff[2048],**done,*p;
+    int nmax=0;
+    
+    if (!(fp=fopen(file,"r"))) return;
+    
+    while (fgets(buff,sizeof(buff),fp)) {
+        if ((p=strchr(buff,'\n'))) *p='\0'; else continue; /* partial line */
+        if ((p=strchr(buff,'\r'))) *p='\0';
+        if (!*buff) continue;
+        
+        if (sch->ndone>=nmax) {
+            nmax=nmax<=0?1024:nmax*2;
+            if (!(done=(char **)realloc(sch->done,sizeof(char *)*nmax))) break;
+            sch->done=done;
         }
-        return ret==2;
+        if (!(sch->done[sch->ndone]=(char *)malloc(strlen(buff)+1))) break;
+        strcpy(sch->done[sch->ndone++],buff);
     }
-    remove(errfile);
+    fclose(fp);
     
-    /* uncompress download file */
-    if (!(opts&DLOPT_KEEPCMP)&&(p=strrchr(path->local,'.'))&&
-        (!strcmp(p,".z")||!strcmp(p,".gz")||!strcmp(p,".zip")||
-         !strcmp(p,".Z")||!strcmp(p,".GZ")||!strcmp(p,".ZIP"))) {
+    if (sch->ndone>1) qsort(sch->done,sch->ndone,sizeof(char *),cmp_remot);
+}
+/* test path downloaded in state file ----------------------------------------*/
+static int test_state(const dlsch_t *sch, const char *remot)
+{
+    return sch->ndone>0&&
+           bsearch(&remot,sch->done,sch->ndone,sizeof(char *),cmp_remot);
+}
+/* select next download path (called with lock) ------------------------------*/
+static int next_path(dlsch_t *sch, int id)
+{
+    path_t *path=sch->paths->path;
+    char host[256];
+    int i,j,n;
+    
+    while (sch->next<sch->paths->n&&path[sch->next].stat) sch->next++;
+    
+    for (i=sch->next;i<sch->paths->n&&i<sch->next+DL_WINDOW;i++) {
+        if (path[i].stat) continue;
         
-        if (uncompress(path->local,tmpfile)) {
-            remove(path->local);
+        /* limit concurrent downloads per host */
+        if (dl_nhost>0) {
+            url_host(path[i].remot,host);
+            for (j=n=0;*host&&j<MAXDLJOB;j++) {
+                if (!strcmp(sch->host[j],host)) n++;
+            }
+            if (n>=dl_nhost) continue;
+            strcpy(sch->host[id],host);
+        }
+        path[i].stat=1;
+        return i;
+    }
+    return -1;
+}
+/* download thread -----------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI dlthread(void *arg)
+#else
+static void *dlthread(void *arg)
+#endif
+{
+    dljob_t *job=(dljob_t *)arg;
+    dlsch_t *sch=job->sch;
+    char msg[4096];
+    int i,k,stat;
+    
+    lock(&sch->lock);
+    for (;;) {
+        if (sch->abort) break;
+        
+        /* wait for end of download on same host */
+        if ((i=next_path(sch,job->id))<0) {
+            if (sch->next>=sch->paths->n) break;
+            waitcond(&sch->cond,&sch->lock);
+            continue;
+        }
+        unlock(&sch->lock);
+        
+        if (sch->ndone>0&&test_state(sch,sch->paths->path[i].remot)) {
+            sprintf(msg,"%s in %s\n",sch->paths->path[i].remot,dl_state);
+            stat='.';
         }
         else {
-            trace(2,"exec_down: uncompress error\n");
-            showmsg("STAT=C");
-            if (fp) fprintf(fp," ERROR (UNCOMP)\n");
-            n[3]++;
-            return 0;
+            for (k=0;;k++) {
+                stat=exec_down(sch,sch->paths->path+i,msg);
+                if (stat!='X'||k>=dl_nretry||sch->abort) break;
+                
+                trace(2,"dlthread: retry %s (%d)\n",sch->paths->path[i].remot,
+                      k+1);
+                sleepms(DL_BACKOFF<<(k<4?k:4)); /* exponential backoff */
+            }
+        }
+        lock(&sch->lock);
+        sch->host[job->id][0]='\0';
+        
+        if (stat=='z') { /* pipeline to uncompression */
+            sch->paths->path[i].stat=2;
+            sch->cmpq[sch->ncmp++]=i;
         }
+        else fin_path(sch,i,stat,msg);
+        signalcond(&sch->cond);
     }
-    showmsg("STAT=o");
-    if (fp) fprintf(fp," OK\n");
-    n[0]++;
+    sch->nrun--;
+    signalcond(&sch->cond);
+    unlock(&sch->lock);
+    return 0;
+}
+/* uncompression thread ------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI cmpthread(void *arg)
+#else
+static void *cmpthread(void *arg)
+#endif
+{
+    dlsch_t *sch=(dlsch_t *)arg;
+    char msg[4096];
+    int i,stat;
+    
+    lock(&sch->lock);
+    for (;;) {
+        if (sch->icmp>=sch->ncmp) {
+            if (sch->nrun<=0) break;
+            waitcond(&sch->cond,&sch->lock);
+            continue;
+        }
+        i=sch->cmpq[sch->icmp++];
+        unlock(&sch->lock);
+        
+        stat=exec_uncomp(sch->paths->path+i,msg);
+        
+        lock(&sch->lock);
+        fin_path(sch,i,stat,msg);
+        signalcond(&sch->cond);
+    }
+    unlock(&sch->lock);
     return 0;
 }
 /* test local file -----------------------------------------------------------*/
@@ -586,8 +882,9 @@ static int print_total(const url_t *url, char **stas, int nsta, int *nc,
 *    (2) strings after # in a line are treated as comments
 *    (3) url_address should be:
 *
-*        ftp://host_address/file_path or
-*        http://host_address/file_path
+*        ftp://host_address/file_path,
+*        http://host_address/file_path or
+*        file://local_mirror_path (copy from local directory)
 *
 *    (4) the field url_address or default_local_directory can include the
 *        follwing keywords replaced by date, time, station names and environment
@@ -701,6 +998,8 @@ extern int dl_readstas(const char *file, char **stas, int nmax)
 *          FILE   *fp       IO  log file pointer (NULL: no output log)
 * return : status (1:ok,0:error,-1:aborted)
 * notes  : urls should be read by using dl_readurl()
+*          files are downloaded by concurrent threads set by dl_setopt(). the
+*          downloaded files are uncompressed by another thread.
 *-----------------------------------------------------------------------------*/
 extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
                    const url_t *urls, int nurl, char **stas, int nsta,
@@ -709,8 +1008,11 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
 {
     paths_t paths={0};
     gtime_t ts_p={0};
-    char str[2048],remot_p[1024]="";
-    int i,n[4]={0};
+    dlsch_t sch={0};
+    dljob_t job[MAXDLJOB]={{0}};
+    thread_t cmp;
+    char str[2048];
+    int i,j,k,n,njob,ncmp=0,end;
     unsigned int tick=tickget();
     
     showmsg("STAT=_");
@@ -733,27 +1035,127 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
         sprintf(msg,"no download data");
         return 0;
     }
-    for (i=0;i<paths.n;i++) {
+    sch.paths=&paths;
+    sch.usr=usr; sch.pwd=pwd; sch.proxy=proxy;
+    sch.opts=opts;
+    sch.fp=fp;
+    initlock(&sch.lock);
+    initlock(&sch.lock_list);
+    initcond(&sch.cond);
+    
+    if (!(sch.fin=imat(paths.n,1))||!(sch.cmpq=imat(paths.n,1))) {
+        free(sch.fin);
+        free_path(&paths);
+        sprintf(msg,"memory allocation error");
+        return 0;
+    }
+    /* read and open download state file */
+    if (*dl_state) {
+        if (!(opts&DLOPT_FORCE)) read_state(&sch,dl_state);
+        if (!(sch.fp_stat=fopen(dl_state,"a"))) {
+            trace(2,"dl_exec: state file open error %s\n",dl_state);
+        }
+    }
+    njob=dl_njob<1?1:(dl_njob>MAXDLJOB?MAXDLJOB:dl_njob);
+    if (njob>paths.n) njob=paths.n;
+    sch.nrun=njob;
+    
+    /* start uncompression and download threads */
+#ifdef WIN32
+    ncmp=(cmp=CreateThread(NULL,0,cmpthread,&sch,0,NULL))!=NULL;
+#else
+    ncmp=!pthread_create(&cmp,NULL,cmpthread,&sch);
+#endif
+    for (i=n=0;i<njob;i++) {
+        job[i].sch=&sch;
+        job[i].id=i;
+#ifdef WIN32
+        if (!(job[i].thread=CreateThread(NULL,0,dlthread,job+i,0,NULL))) break;
+#else
+        if (pthread_create(&job[i].thread,NULL,dlthread,job+i)) break;
+#endif
+        n++;
+    }
+    if (n<njob) {
+        lock(&sch.lock);
+        sch.nrun-=njob-n-(n==0);
+        unlock(&sch.lock);
+        if (n==0) dlthread(job); /* no thread */
+    }
+    for (k=0;;) {
+        lock(&sch.lock);
         
-        sprintf(str,"%s->%s (%d/%d)",paths.path[i].remot,paths.path[i].local,i+1,
-                paths.n);
-        if (showmsg(str)) break;
+        /* wait for finished paths with timeout to poll abort */
+        if (k>=sch.nfin&&!(sch.nrun<=0&&(!ncmp||sch.icmp>=sch.ncmp))) {
+            waitcondms(&sch.cond,&sch.lock,100);
+        }
+        j=sch.nfin;
+        end=sch.nrun<=0&&(!ncmp||sch.icmp>=sch.ncmp);
+        unlock(&sch.lock);
         
-        /* execute download */
-        if (exec_down(paths.path+i,remot_p,usr,pwd,proxy,opts,n,fp)) {
-            break;
+        for (;k<j;k++) {
+            i=sch.fin[k];
+            sprintf(str,"%s->%s (%d/%d)",paths.path[i].remot,
+                    paths.path[i].local,k+1,paths.n);
+            if (showmsg(str)) sch.abort=1;
+            showmsg("STAT=%c",paths.path[i].stat);
         }
+        if (end) break;
+        
+        if (showmsg("")) sch.abort=1;
+    }
+    for (i=0;i<n;i++) {
+#ifdef WIN32
+        WaitForSingleObject(job[i].thread,INFINITE);
+        CloseHandle(job[i].thread);
+#else
+        pthread_join(job[i].thread,NULL);
+#endif
+    }
+    if (ncmp) {
+#ifdef WIN32
+        WaitForSingleObject(cmp,INFINITE);
+        CloseHandle(cmp);
+#else
+        pthread_join(cmp,NULL);
+#endif
     }
+    else cmpthread(&sch); /* uncompress without thread */
+    
     if (!(opts&DLOPT_HOLDLST)) {
         remove(FTP_LISTING);
     }
-    sprintf(msg,"OK=%d No_File=%d Skip=%d Error=%d (Time=%.1f s)",n[0],n[1],n[2],
-            n[3],(tickget()-tick)*0.001);
+    sprintf(msg,"OK=%d No_File=%d Skip=%d Error=%d (Time=%.1f s)",sch.n[0],
+            sch.n[1],sch.n[2],sch.n[3],(tickget()-tick)*0.001);
     
+    if (sch.fp_stat) fclose(sch.fp_stat);
+    for (i=0;i<sch.ndone;i++) free(sch.done[i]);
+    free(sch.done);
+    free(sch.fin);
+    free(sch.cmpq);
     free_path(&paths);
     
     return 1;
 }
+/* set download options --------------------------------------------------------
+* set options of concurrent download by dl_exec()
+* args   : int    njob      I   number of download threads (1-32)
+*          int    nhost     I   max concurrent downloads per host (0:no limit)
+*          int    nretry    I   number of retry on download error
+*          char   *state    I   download state file ("":no state file)
+* return : none
+* notes  : paths of downloaded files are appended to the state file. the paths
+*          recorded in the state file are skipped by the following dl_exec()
+*          to resume aborted download. the state file is not read by dl_exec()
+*          with option DLOPT_FORCE.
+*-----------------------------------------------------------------------------*/
+extern void dl_setopt(int njob, int nhost, int nretry, const char *state)
+{
+    dl_njob=njob<1?1:(njob>MAXDLJOB?MAXDLJOB:njob);
+    dl_nhost=nhost<0?0:nhost;
+    dl_nretry=nretry<0?0:nretry;
+    strcpy(dl_state,state?state:"");
+}
 /* execute local file test -----------------------------------------------------
 * execute local file test
 * args   : gtime_t ts,te    I   time start and end
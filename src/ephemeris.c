@@ -51,6 +51,8 @@
 *           2014/10/24 1.9  fix bug on return of var_uraeph() if ura<0||15<ura
 *           2014/12/07 1.10 modify MAXDTOE for qzss,gal and bds
 *                           test max number of iteration for Kepler
+*           2026/10/19 1.11 add api satstates()
+*                           select ephemeris by satellite states of epoch
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -118,7 +120,7 @@ extern void alm2pos(gtime_t time, const alm_t *alm, double *rs, double *dts)
 {
     double tk,M,E,Ek,sinE,cosE,u,r,i,O,x,y,sinO,cosO,cosi,mu;
     
-    trace(4,"alm2pos : time=%s sat=%2d\n",time_str(time,3),alm->sat);
+    if (TRACEON(4)) trace(4,"alm2pos : time=%s sat=%2d\n",time_str(time,3),alm->sat);
     
     tk=timediff(time,alm->toa);
     
@@ -156,7 +158,7 @@ extern double eph2clk(gtime_t time, const eph_t *eph)
     double t;
     int i;
     
-    trace(4,"eph2clk : time=%s sat=%2d\n",time_str(time,3),eph->sat);
+    if (TRACEON(4)) trace(4,"eph2clk : time=%s sat=%2d\n",time_str(time,3),eph->sat);
     
     t=timediff(time,eph->toc);
     
@@ -185,7 +187,7 @@ extern void eph2pos(gtime_t time, const eph_t *eph, double *rs, double *dts,
     double xg,yg,zg,sino,coso;
     int n,sys,prn;
     
-    trace(4,"eph2pos : time=%s sat=%2d\n",time_str(time,3),eph->sat);
+    if (TRACEON(4)) trace(4,"eph2pos : time=%s sat=%2d\n",time_str(time,3),eph->sat);
     
     if (eph->A<=0.0) {
         rs[0]=rs[1]=rs[2]=*dts=*var=0.0;
@@ -290,7 +292,7 @@ extern double geph2clk(gtime_t time, const geph_t *geph)
     double t;
     int i;
     
-    trace(4,"geph2clk: time=%s sat=%2d\n",time_str(time,3),geph->sat);
+    if (TRACEON(4)) trace(4,"geph2clk: time=%s sat=%2d\n",time_str(time,3),geph->sat);
     
     t=timediff(time,geph->toe);
     
@@ -315,7 +317,7 @@ extern void geph2pos(gtime_t time, const geph_t *geph, double *rs, double *dts,
     double t,tt,x[6];
     int i;
     
-    trace(4,"geph2pos: time=%s sat=%2d\n",time_str(time,3),geph->sat);
+    if (TRACEON(4)) trace(4,"geph2pos: time=%s sat=%2d\n",time_str(time,3),geph->sat);
     
     t=timediff(time,geph->toe);
     
@@ -345,7 +347,7 @@ extern double seph2clk(gtime_t time, const seph_t *seph)
     double t;
     int i;
     
-    trace(4,"seph2clk: time=%s sat=%2d\n",time_str(time,3),seph->sat);
+    if (TRACEON(4)) trace(4,"seph2clk: time=%s sat=%2d\n",time_str(time,3),seph->sat);
     
     t=timediff(time,seph->t0);
     
@@ -370,7 +372,7 @@ extern void seph2pos(gtime_t time, const seph_t *seph, double *rs, double *dts,
     double t;
     int i;
     
-    trace(4,"seph2pos: time=%s sat=%2d\n",time_str(time,3),seph->sat);
+    if (TRACEON(4)) trace(4,"seph2pos: time=%s sat=%2d\n",time_str(time,3),seph->sat);
     
     t=timediff(time,seph->t0);
     
@@ -381,13 +383,28 @@ extern void seph2pos(gtime_t time, const seph_t *seph, double *rs, double *dts,
     
     *var=var_uraeph(seph->sva);
 }
+/* ephemeris selected by satellite states of epoch ---------------------------*/
+static int stseph(gtime_t time, int sat, const nav_t *nav, int *ieph)
+{
+    const satst_t *st;
+    
+    if (!nav->sats||sat<=0||MAXSAT<sat||timediff(time,nav->sats->time)!=0.0) {
+        return 0;
+    }
+    st=nav->sats->sat+sat-1;
+    if (!st->stat) return 0;
+    *ieph=st->ieph;
+    return 1;
+}
 /* select ephememeris --------------------------------------------------------*/
 static eph_t *seleph(gtime_t time, int sat, int iode, const nav_t *nav)
 {
     double t,tmax,tmin;
     int i,j=-1;
     
-    trace(4,"seleph  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
+    if (TRACEON(4)) trace(4,"seleph  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
+    
+    if (iode<0&&stseph(time,sat,nav,&j)) return j<0?NULL:nav->eph+j;
     
     switch (satsys(sat,NULL)) {
         case SYS_QZS: tmax=MAXDTOE_QZS+1.0; break;
@@ -417,7 +434,9 @@ static geph_t *selgeph(gtime_t time, int sat, int iode, const nav_t *nav)
     double t,tmax=MAXDTOE_GLO,tmin=tmax+1.0;
     int i,j=-1;
     
-    trace(4,"selgeph : time=%s sat=%2d iode=%2d\n",time_str(time,3),sat,iode);
+    if (TRACEON(4)) trace(4,"selgeph : time=%s sat=%2d iode=%2d\n",time_str(time,3),sat,iode);
+    
+    if (iode<0&&stseph(time,sat,nav,&j)) return j<0?NULL:nav->geph+j;
     
     for (i=0;i<nav->ng;i++) {
         if (nav->geph[i].sat!=sat) continue;
@@ -439,7 +458,9 @@ static seph_t *selseph(gtime_t time, int sat, const nav_t *nav)
     double t,tmax=MAXDTOE_SBS,tmin=tmax+1.0;
     int i,j=-1;
     
-    trace(4,"selseph : time=%s sat=%2d\n",time_str(time,3),sat);
+    if (TRACEON(4)) trace(4,"selseph : time=%s sat=%2d\n",time_str(time,3),sat);
+    
+    if (stseph(time,sat,nav,&j)) return j<0?NULL:nav->seph+j;
     
     for (i=0;i<nav->ns;i++) {
         if (nav->seph[i].sat!=sat) continue;
@@ -447,7 +468,7 @@ static seph_t *selseph(gtime_t time, int sat, const nav_t *nav)
         if (t<=tmin) {j=i; tmin=t;} /* toe closest to time */
     }
     if (j<0) {
-        trace(3,"no sbas ephemeris     : %s sat=%2d\n",time_str(time,0),sat);
+        if (TRACEON(3)) trace(3,"no sbas ephemeris     : %s sat=%2d\n",time_str(time,0),sat);
         return NULL;
     }
     return nav->seph+j;
@@ -461,7 +482,7 @@ static int ephclk(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     seph_t *seph;
     int sys;
     
-    trace(4,"ephclk  : time=%s sat=%2d\n",time_str(time,3),sat);
+    if (TRACEON(4)) trace(4,"ephclk  : time=%s sat=%2d\n",time_str(time,3),sat);
     
     sys=satsys(sat,NULL);
     
@@ -491,7 +512,7 @@ static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     double rst[3],dtst[1],tt=1E-3;
     int i,sys;
     
-    trace(4,"ephpos  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
+    if (TRACEON(4)) trace(4,"ephpos  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
     
     sys=satsys(sat,NULL);
     
@@ -535,7 +556,7 @@ static int satpos_sbas(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     const sbssatp_t *sbs;
     int i;
     
-    trace(4,"satpos_sbas: time=%s sat=%2d\n",time_str(time,3),sat);
+    if (TRACEON(4)) trace(4,"satpos_sbas: time=%s sat=%2d\n",time_str(time,3),sat);
     
     /* search sbas satellite correciton */
     for (i=0;i<nav->sbssat.nsat;i++) {
@@ -543,7 +564,7 @@ static int satpos_sbas(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
         if (sbs->sat==sat) break;
     }
     if (i>=nav->sbssat.nsat) {
-        trace(2,"no sbas correction for orbit: %s sat=%2d\n",time_str(time,0),sat);
+        if (TRACEON(2)) trace(2,"no sbas correction for orbit: %s sat=%2d\n",time_str(time,0),sat);
         ephpos(time,teph,sat,nav,-1,rs,dts,var,svh);
         *svh=-1;
         return 0;
@@ -565,16 +586,16 @@ static int satpos_ssr(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     double t1,t2,t3,er[3],ea[3],ec[3],rc[3],deph[3],dclk,dant[3]={0},tk;
     int i,sys;
     
-    trace(4,"satpos_ssr: time=%s sat=%2d\n",time_str(time,3),sat);
+    if (TRACEON(4)) trace(4,"satpos_ssr: time=%s sat=%2d\n",time_str(time,3),sat);
     
     ssr=nav->ssr+sat-1;
     
     if (!ssr->t0[0].time) {
-        trace(2,"no ssr orbit correction: %s sat=%2d\n",time_str(time,0),sat);
+        if (TRACEON(2)) trace(2,"no ssr orbit correction: %s sat=%2d\n",time_str(time,0),sat);
         return 0;
     }
     if (!ssr->t0[1].time) {
-        trace(2,"no ssr clock correction: %s sat=%2d\n",time_str(time,0),sat);
+        if (TRACEON(2)) trace(2,"no ssr clock correction: %s sat=%2d\n",time_str(time,0),sat);
         return 0;
     }
     /* inconsistency between orbit and clock correction */
@@ -674,7 +695,7 @@ extern int satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
                   const nav_t *nav, double *rs, double *dts, double *var,
                   int *svh)
 {
-    trace(4,"satpos  : time=%s sat=%2d ephopt=%d\n",time_str(time,3),sat,ephopt);
+    if (TRACEON(4)) trace(4,"satpos  : time=%s sat=%2d ephopt=%d\n",time_str(time,3),sat,ephopt);
     
     *svh=0;
     
@@ -691,6 +712,62 @@ extern int satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
     *svh=-1;
     return 0;
 }
+/* satellite states of epoch ---------------------------------------------------
+* select broadcast ephemerides of satellites of an epoch to be shared by
+* satposs() of multiple receivers
+* args   : gtime_t time     I   epoch time (gpst)
+*          obsd_t *obs      I   observation data of receivers
+*          int    n         I   number of observation data
+*          nav_t  *nav      I   navigation data
+*          satsts_t *sats   IO  satellite states of epoch
+* return : number of satellites selected
+* notes  : satellite states are reset if the epoch time is changed.
+*          seleph(),selgeph() and selseph() use the states instead of searching
+*          navigation data if nav->sats is set to sats and the time to select
+*          ephemeris equals to the epoch time. the selection depends only on
+*          the time and the satellite, so the results of satposs() are the
+*          same as those without the states.
+*-----------------------------------------------------------------------------*/
+extern int satstates(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
+                     satsts_t *sats)
+{
+    satst_t *st;
+    eph_t *eph;
+    geph_t *geph;
+    seph_t *seph;
+    int i,sys,ns=0;
+    
+    if (TRACEON(3)) trace(3,"satstates: time=%s n=%d\n",time_str(time,3),n);
+    
+    if (sats->time.time==0||timediff(time,sats->time)!=0.0) {
+        for (i=0;i<MAXSAT;i++) sats->sat[i].stat=0;
+        sats->time=time;
+    }
+    for (i=0;i<n;i++) {
+        if (obs[i].sat<=0||MAXSAT<obs[i].sat) continue;
+        st=sats->sat+obs[i].sat-1;
+        if (st->stat) continue;
+        
+        sys=satsys(obs[i].sat,NULL);
+        if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS||sys==SYS_CMP) {
+            eph=seleph(time,obs[i].sat,-1,nav);
+            st->ieph=eph?(int)(eph-nav->eph):-1;
+        }
+        else if (sys==SYS_GLO) {
+            geph=selgeph(time,obs[i].sat,-1,nav);
+            st->ieph=geph?(int)(geph-nav->geph):-1;
+        }
+        else if (sys==SYS_SBS) {
+            seph=selseph(time,obs[i].sat,nav);
+            st->ieph=seph?(int)(seph-nav->seph):-1;
+        }
+        else continue;
+        
+        st->stat=1;
+        ns++;
+    }
+    return ns;
+}
 /* satellite positions and clocks ----------------------------------------------
 * compute satellite positions, velocities and clocks
 * args   : gtime_t teph     I   time to select ephemeris (gpst)
@@ -722,7 +799,7 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
     double dt,pr;
     int i,j;
     
-    trace(3,"satposs : teph=%s n=%d ephopt=%d\n",time_str(teph,3),n,ephopt);
+    if (TRACEON(3)) trace(3,"satposs : teph=%s n=%d ephopt=%d\n",time_str(teph,3),n,ephopt);
     
     for (i=0;i<n&&i<MAXOBS;i++) {
         for (j=0;j<6;j++) rs [j+i*6]=0.0;
@@ -733,7 +810,7 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
         for (j=0,pr=0.0;j<NFREQ;j++) if ((pr=obs[i].P[j])!=0.0) break;
         
         if (j>=NFREQ) {
-            trace(2,"no pseudorange %s sat=%2d\n",time_str(obs[i].time,3),obs[i].sat);
+            if (TRACEON(2)) trace(2,"no pseudorange %s sat=%2d\n",time_str(obs[i].time,3),obs[i].sat);
             continue;
         }
         /* transmission time by satellite clock */
@@ -741,7 +818,7 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
         
         /* satellite clock bias by broadcast ephemeris */
         if (!ephclk(time[i],teph,obs[i].sat,nav,&dt)) {
-            trace(2,"no broadcast clock %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
+            if (TRACEON(2)) trace(2,"no broadcast clock %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
             continue;
         }
         time[i]=timeadd(time[i],-dt);
@@ -749,7 +826,7 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
         /* satellite position and clock at transmission time */
         if (!satpos(time[i],teph,obs[i].sat,ephopt,nav,rs+i*6,dts+i*2,var+i,
                     svh+i)) {
-            trace(2,"no ephemeris %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
+            if (TRACEON(2)) trace(2,"no ephemeris %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
             continue;
         }
         /* if no precise clock available, use broadcast clock instead */
@@ -12,14 +12,31 @@
 *           2009/09/04 1.1  replace geoid data by global model
 *           2009/12/05 1.2  added api:
 *                               opengeoid(),closegeoid()
+*           2026/10/19 1.3  map geoid model file to memory instead of fseek()
+*                           and fread() for each grid value
+*                           added api:
+*                               geoidh_n()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 static const char rcsid[]="$Id: geoid.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $";
 
+typedef struct {                    /* geoid grid cell type */
+    long i,j;                       /* grid index of south-west corner */
+    double y[4];                    /* geoid heights of cell corners (m) */
+} gcell_t;
+
 static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg) */
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
-static FILE *fp_geoid=NULL;         /* geoid file pointer */
+static const unsigned char *map_geoid=NULL; /* geoid file image */
+static size_t size_geoid=0;         /* geoid file image size (bytes) */
+static int mem_geoid=0;             /* geoid file image (0:mapped,1:allocated) */
 static int model_geoid=GEOID_EMBEDDED; /* geoid model */
 
 /* bilinear interpolation ----------------------------------------------------*/
@@ -48,54 +65,63 @@ static double geoidh_emb(const double *pos)
     y[3]=geoid[i2][j2];
     return interpb(y,a,b);
 }
-/* get 2 byte signed integer from file ---------------------------------------*/
-static short fget2b(FILE *fp, long off)
+/* get 2 byte signed integer from file image ---------------------------------*/
+static short fget2b(long off)
 {
-    unsigned char v[2];
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(v,2,1,fp)<1) {
+    const unsigned char *v;
+    
+    if (off<0||(size_t)off+2>size_geoid) {
         trace(2,"geoid data file range error: off=%ld\n",off);
+        return 0;
     }
+    v=map_geoid+off;
     return ((short)v[0]<<8)+v[1]; /* big-endian */
 }
 /* egm96 15x15" model --------------------------------------------------------*/
-static double geoidh_egm96(const double *pos)
+static double geoidh_egm96(const double *pos, gcell_t *c)
 {
     const double lon0=0.0,lat0=90.0,dlon=15.0/60.0,dlat=-15.0/60.0;
     const int nlon=1440,nlat=721;
-    double a,b,y[4];
+    double a,b;
     long i1,i2,j1,j2;
     
-    if (!fp_geoid) return 0.0;
+    if (!map_geoid) return 0.0;
     
     a=(pos[1]-lon0)/dlon;
     b=(pos[0]-lat0)/dlat;
     i1=(long)a; a-=i1; i2=i1<nlon-1?i1+1:0;
     j1=(long)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fget2b(fp_geoid,2L*(i1+j1*nlon))*0.01;
-    y[1]=fget2b(fp_geoid,2L*(i2+j1*nlon))*0.01;
-    y[2]=fget2b(fp_geoid,2L*(i1+j2*nlon))*0.01;
-    y[3]=fget2b(fp_geoid,2L*(i2+j2*nlon))*0.01;
-    return interpb(y,a,b);
+    if (c->i!=i1||c->j!=j1) {
+        c->y[0]=fget2b(2L*(i1+j1*nlon))*0.01;
+        c->y[1]=fget2b(2L*(i2+j1*nlon))*0.01;
+        c->y[2]=fget2b(2L*(i1+j2*nlon))*0.01;
+        c->y[3]=fget2b(2L*(i2+j2*nlon))*0.01;
+        c->i=i1; c->j=j1;
+    }
+    return interpb(c->y,a,b);
 }
-/* get 4byte float from file -------------------------------------------------*/
-static float fget4f(FILE *fp, long off)
+/* get 4byte float from file image -------------------------------------------*/
+static float fget4f(long off)
 {
     float v=0.0;
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(&v,4,1,fp)<1) {
+    
+    if (off<0||(size_t)off+4>size_geoid) {
         trace(2,"geoid data file range error: off=%ld\n",off);
+        return v;
     }
+    memcpy(&v,map_geoid+off,4);
     return v; /* small-endian */
 }
 /* egm2008 model -------------------------------------------------------------*/
-static double geoidh_egm08(const double *pos, int model)
+static double geoidh_egm08(const double *pos, int model, gcell_t *c)
 {
     const double lon0=0.0,lat0=90.0;
     double dlon,dlat;
-    double a,b,y[4];
+    double a,b;
     long i1,i2,j1,j2;
     int nlon,nlat;
     
-    if (!fp_geoid) return 0.0;
+    if (!map_geoid) return 0.0;
     
     if (model==GEOID_EGM2008_M25) { /* 2.5 x 2.5" grid */
         dlon= 2.5/60.0;
@@ -114,6 +140,8 @@ static double geoidh_egm08(const double *pos, int model)
     i1=(long)a; a-=i1; i2=i1<nlon-1?i1+1:0;
     j1=(long)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
     
+    if (c->i==i1&&c->j==j1) return interpb(c->y,a,b);
+    
     /* notes: 4byte-zeros are inserted at first and last field of a record */
     /*        for current geid data files */
     /* http://earth-info.nga.mil/GandG/wgs84/gravitymod/egm2008/egm08_wgs84.html */
@@ -121,31 +149,33 @@ static double geoidh_egm08(const double *pos, int model)
     /* (2) Und_min2.5x2.5_egm2008_isw=82_WGS84_TideFree_SE.gz */
 #if 0
     /* not zero-inserted */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon)));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon)));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon)));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon)));
+    c->y[0]=fget4f(4L*(i1+j1*(nlon)));
+    c->y[1]=fget4f(4L*(i2+j1*(nlon)));
+    c->y[2]=fget4f(4L*(i1+j2*(nlon)));
+    c->y[3]=fget4f(4L*(i2+j2*(nlon)));
 #else
     /* zero-inserted version (2009/12/10) */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon+2)+1));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon+2)+1));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon+2)+1));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon+2)+1));
+    c->y[0]=fget4f(4L*(i1+j1*(nlon+2)+1));
+    c->y[1]=fget4f(4L*(i2+j1*(nlon+2)+1));
+    c->y[2]=fget4f(4L*(i1+j2*(nlon+2)+1));
+    c->y[3]=fget4f(4L*(i2+j2*(nlon+2)+1));
 #endif
-    return interpb(y,a,b);
+    c->i=i1; c->j=j1;
+    return interpb(c->y,a,b);
 }
 /* get gsi geoid data --------------------------------------------------------*/
-static double fgetgsi(FILE *fp, int nlon, int nlat, int i, int j)
+static double fgetgsi(int nlon, int nlat, int i, int j)
 {
     const int nf=28,wf=9,nl=nf*wf+2,nr=(nlon-1)/nf+1;
     double v;
     long off=nl+j*nr*nl+i/nf*nl+i%nf*wf;
     char buff[16]="";
     
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(buff,wf,1,fp)<1) {
+    if (off<0||(size_t)off+wf>size_geoid) {
         trace(2,"out of range for gsi geoid: i=%d j=%d\n",i,j);
         return 0.0;
     }
+    memcpy(buff,map_geoid+off,wf);
     if (sscanf(buff,"%lf",&v)<1) {
         trace(2,"gsi geoid data format error: i=%d j=%d buff=%s\n",i,j,buff);
         return 0.0;
@@ -153,15 +183,15 @@ static double fgetgsi(FILE *fp, int nlon, int nlat, int i, int j)
     return v;
 }
 /* gsi geoid 2000 1.0x1.5" model ---------------------------------------------*/
-static double geoidh_gsi(const double *pos)
+static double geoidh_gsi(const double *pos, gcell_t *c)
 {
     const double lon0=120.0,lon1=150.0,lat0=20.0,lat1=50.0;
     const double dlon=1.5/60.0,dlat=1.0/60.0;
     const int nlon=1201,nlat=1801;
-    double a,b,y[4];
+    double a,b,*y=c->y;
     int i1,i2,j1,j2;
     
-    if (!fp_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
+    if (!map_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
         trace(2,"out of range for gsi geoid: lat=%.3f lon=%.3f\n",pos[0],pos[1]);
         return 0.0;
     }
@@ -169,16 +199,79 @@ static double geoidh_gsi(const double *pos)
     b=(pos[0]-lat0)/dlat;
     i1=(int)a; a-=i1; i2=i1<nlon-1?i1+1:i1;
     j1=(int)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fgetgsi(fp_geoid,nlon,nlat,i1,j1);
-    y[1]=fgetgsi(fp_geoid,nlon,nlat,i2,j1);
-    y[2]=fgetgsi(fp_geoid,nlon,nlat,i1,j2);
-    y[3]=fgetgsi(fp_geoid,nlon,nlat,i2,j2);
+    if (c->i!=i1||c->j!=j1) {
+        y[0]=fgetgsi(nlon,nlat,i1,j1);
+        y[1]=fgetgsi(nlon,nlat,i2,j1);
+        y[2]=fgetgsi(nlon,nlat,i1,j2);
+        y[3]=fgetgsi(nlon,nlat,i2,j2);
+        c->i=i1; c->j=j1;
+    }
     if (y[0]==999.0||y[1]==999.0||y[2]==999.0||y[3]==999.0) {
         trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
         return 0.0;
     }
     return interpb(y,a,b);
 }
+/* map geoid model file to memory --------------------------------------------*/
+static int mapgeoid(const char *file)
+{
+#ifdef WIN32
+    HANDLE h,hmap;
+    DWORD size;
+    const void *p=NULL;
+    
+    if ((h=CreateFile(file,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,NULL))==INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    if ((size=GetFileSize(h,NULL))!=INVALID_FILE_SIZE&&size>0&&
+        (hmap=CreateFileMapping(h,NULL,PAGE_READONLY,0,0,NULL))) {
+        p=MapViewOfFile(hmap,FILE_MAP_READ,0,0,0);
+        CloseHandle(hmap);
+    }
+    CloseHandle(h);
+    if (!p) return 0;
+    map_geoid=(const unsigned char *)p;
+    size_geoid=(size_t)size;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+    
+    if ((fd=open(file,O_RDONLY))<0) return 0;
+    if (fstat(fd,&st)<0||st.st_size<=0||
+        (p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0))==MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+    close(fd);
+    map_geoid=(const unsigned char *)p;
+    size_geoid=(size_t)st.st_size;
+#endif
+    mem_geoid=0;
+    return 1;
+}
+/* read geoid model file to memory -------------------------------------------*/
+static int readgeoid(const char *file)
+{
+    FILE *fp;
+    unsigned char *buff=NULL;
+    long size;
+    
+    if (!(fp=fopen(file,"rb"))) return 0;
+    if (fseek(fp,0,SEEK_END)==EOF||(size=ftell(fp))<=0||
+        fseek(fp,0,SEEK_SET)==EOF||!(buff=(unsigned char *)malloc(size))||
+        fread(buff,size,1,fp)<1) {
+        free(buff);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    map_geoid=buff;
+    size_geoid=(size_t)size;
+    mem_geoid=1;
+    return 1;
+}
 /* open geoid model file -------------------------------------------------------
 * open geoid model file
 * args   : int    model     I   geoid model type
@@ -195,6 +288,9 @@ static double geoidh_gsi(const double *pos)
 *          Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE    : EGM2008 1.0x1.0"
 *          gsigeome_ver4 : GSI geoid 2000 1.0x1.5" (japanese area)
 *          (byte-order of binary files must be compatible to cpu)
+*          the file is mapped to memory (or read into memory if mapping fails)
+*          once, so geoidh() and geoidh_n() can be called from several threads
+*          without lock while the model is open
 *-----------------------------------------------------------------------------*/
 extern int opengeoid(int model, const char *file)
 {
@@ -209,7 +305,7 @@ extern int opengeoid(int model, const char *file)
         trace(2,"invalid geoid model: model=%d file=%s\n",model,file);
         return 0;
     }
-    if (!(fp_geoid=fopen(file,"rb"))) {
+    if (!mapgeoid(file)&&!readgeoid(file)) {
         trace(2,"geoid model file open error: model=%d file=%s\n",model,file);
         return 0;
     }
@@ -225,19 +321,20 @@ extern void closegeoid(void)
 {
     trace(3,"closegoid:\n");
     
-    if (fp_geoid) fclose(fp_geoid);
-    fp_geoid=NULL;
+    if (map_geoid) {
+        if (mem_geoid) free((void *)map_geoid);
+#ifdef WIN32
+        else UnmapViewOfFile(map_geoid);
+#else
+        else munmap((void *)map_geoid,size_geoid);
+#endif
+    }
+    map_geoid=NULL;
+    size_geoid=0;
     model_geoid=GEOID_EMBEDDED;
 }
-/* geoid height ----------------------------------------------------------------
-* get geoid height from geoid model
-* args   : double *pos      I   geodetic position {lat,lon} (rad)
-* return : geoid height (m) (0.0:error)
-* notes  : to use external geoid model, call function opengeoid() to open
-*          geoid model before calling the function. If the external geoid model
-*          is not open, the function uses embedded geoid model.
-*-----------------------------------------------------------------------------*/
-extern double geoidh(const double *pos)
+/* geoid height with grid cell cache -----------------------------------------*/
+static double geoidhc(const double *pos, gcell_t *c)
 {
     double posd[2],h;
     
@@ -249,10 +346,10 @@ extern double geoidh(const double *pos)
     }
     switch (model_geoid) {
         case GEOID_EMBEDDED   : h=geoidh_emb  (posd); break;
-        case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
-        case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
+        case GEOID_EGM96_M150 : h=geoidh_egm96(posd,c); break;
+        case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid,c); break;
+        case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid,c); break;
+        case GEOID_GSI2000_M15: h=geoidh_gsi  (posd,c); break;
         default: return 0.0;
     }
     if (fabs(h)>200.0) {
@@ -261,6 +358,37 @@ extern double geoidh(const double *pos)
     }
     return h;
 }
+/* geoid height ----------------------------------------------------------------
+* get geoid height from geoid model
+* args   : double *pos      I   geodetic position {lat,lon} (rad)
+* return : geoid height (m) (0.0:error)
+* notes  : to use external geoid model, call function opengeoid() to open
+*          geoid model before calling the function. If the external geoid model
+*          is not open, the function uses embedded geoid model.
+*-----------------------------------------------------------------------------*/
+extern double geoidh(const double *pos)
+{
+    gcell_t c={-1,-1};
+    
+    return geoidhc(pos,&c);
+}
+/* geoid heights of positions --------------------------------------------------
+* get geoid heights of n positions from geoid model
+* args   : double *pos      I   geodetic positions {lat,lon,h} (rad,m)
+*                               (pos[i*3]: position i)
+*          int    n         I   number of positions
+*          double *h        O   geoid heights (m) (0.0:error) (h[i]: position i)
+* return : none
+* notes  : same as geoidh() for each position. grid values of the last cell are
+*          kept and reused for the following positions in the same cell.
+*-----------------------------------------------------------------------------*/
+extern void geoidh_n(const double *pos, int n, double *h)
+{
+    gcell_t c={-1,-1};
+    int i;
+    
+    for (i=0;i<n;i++) h[i]=geoidhc(pos+i*3,&c);
+}
 /*------------------------------------------------------------------------------
 * embedded geoid model
 * notes  : geoid heights are derived from EGM96 (1 x 1 deg grid)
@@ -15,6 +15,11 @@
 *           2013/03/05 1.1 change api readtec()
 *                          fix problem in case of lat>85deg or lat<-85deg
 *           2014/02/22 1.2 fix problem on compiled as C++
+*           2026/10/19 1.3 search tec grid by time index
+*                          share pierce points between tec grids
+*                          allocate tec grids by number of maps in file
+*                          add api iontecs()
+*                          share grid cells between tec grids for earth-fixed
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -24,6 +29,16 @@ static const char rcsid[]="$Id:$";
 #define VAR_NOTEC   SQR(30.0)   /* variance of no tec */
 #define MIN_EL      0.0         /* min elevation angle (rad) */
 #define MIN_HGT     -1000.0     /* min user height (m) */
+#define MAXLAYER    16          /* max layers of shared pierce points */
+
+typedef struct {        /* pierce points of tec grid layers */
+    int n;              /* number of layers */
+    double posp[MAXLAYER][2]; /* pierce point positions {lat,lon} (rad) */
+    double fs[MAXLAYER]; /* slant factors */
+    int grid;           /* grid cells set (0:not set,1:set,-1:out of grid) */
+    int ij[MAXLAYER][2]; /* grid indices of cells {lat,lon} */
+    double ab[MAXLAYER][2]; /* weights in cells {lat,lon} */
+} tecpp_t;
 
 /* get index -----------------------------------------------------------------*/
 static int getindex(double value, const double *range)
@@ -44,11 +59,37 @@ static int dataindex(int i, int j, int k, const int *ndata)
     if (i<0||ndata[0]<=i||j<0||ndata[1]<=j||k<0||ndata[2]<=k) return -1;
     return i+ndata[0]*(j+ndata[1]*k);
 }
+/* reserve tec data of navigation data --------------------------------------*/
+static int reservetec(nav_t *nav, int n)
+{
+    tec_t *nav_tec;
+    
+    if (n<=nav->ntmax) return 1;
+    
+    if (!(nav_tec=(tec_t *)realloc(nav->tec,sizeof(tec_t)*n))) {
+        trace(1,"readionex malloc error ntmax=%d\n",n);
+        return 0;
+    }
+    nav->tec=nav_tec;
+    nav->ntmax=n;
+    return 1;
+}
+/* free tec data of navigation data ------------------------------------------*/
+static void freetec(nav_t *nav)
+{
+    int i;
+    
+    for (i=0;i<nav->nt;i++) {
+        free(nav->tec[i].data);
+        free(nav->tec[i].rms );
+    }
+    free(nav->tec); nav->tec=NULL; nav->nt=nav->ntmax=0;
+}
 /* add tec data to navigation data -------------------------------------------*/
 static tec_t *addtec(const double *lats, const double *lons, const double *hgts,
                      double rb, nav_t *nav)
 {
-    tec_t *p,*nav_tec;
+    tec_t *p;
     gtime_t time0={0};
     int i,n,ndata[3];
     
@@ -59,14 +100,9 @@ static tec_t *addtec(const double *lats, const double *lons, const double *hgts,
     ndata[2]=nitem(hgts);
     if (ndata[0]<=1||ndata[1]<=1||ndata[2]<=0) return NULL;
     
-    if (nav->nt>=nav->ntmax) {
-        nav->ntmax+=256;
-        if (!(nav_tec=(tec_t *)realloc(nav->tec,sizeof(tec_t)*nav->ntmax))) {
-            trace(1,"readionex malloc error ntmax=%d\n",nav->ntmax);
-            free(nav->tec); nav->tec=NULL; nav->nt=nav->ntmax=0;
-            return NULL;
-        }
-        nav->tec=nav_tec;
+    if (nav->nt>=nav->ntmax&&!reservetec(nav,nav->ntmax+256)) {
+        freetec(nav);
+        return NULL;
     }
     p=nav->tec+nav->nt;
     p->time=time0;
@@ -79,14 +115,14 @@ static tec_t *addtec(const double *lats, const double *lons, const double *hgts,
     }
     n=ndata[0]*ndata[1]*ndata[2];
     
-    if (!(p->data=(double *)malloc(sizeof(double)*n))||
-        !(p->rms =(float  *)malloc(sizeof(float )*n))) {
+    p->data=(double *)calloc(n,sizeof(double));
+    p->rms =(float  *)calloc(n,sizeof(float ));
+    
+    if (!p->data||!p->rms) {
+        free(p->data);
+        free(p->rms );
         return NULL;
     }
-    for (i=0;i<n;i++) {
-        p->data[i]=0.0;
-        p->rms [i]=0.0f;
-    }
     nav->nt++;
     return p;
 }
@@ -120,7 +156,8 @@ static void readionexdcb(FILE *fp, double *dcb, double *rms)
 }
 /* read ionex header ---------------------------------------------------------*/
 static double readionexh(FILE *fp, double *lats, double *lons, double *hgts,
-                         double *rb, double *nexp, double *dcb, double *rms)
+                         double *rb, double *nexp, double *dcb, double *rms,
+                         int *nmap)
 {
     double ver=0.0;
     char buff[1024],*label;
@@ -156,6 +193,9 @@ static double readionexh(FILE *fp, double *lats, double *lons, double *hgts,
         else if (strstr(label,"EXPONENT")==label) {
             *nexp=str2num(buff,0,6);
         }
+        else if (strstr(label,"# OF MAPS IN FILE")==label) {
+            *nmap=(int)str2num(buff,0,6);
+        }
         else if (strstr(label,"START OF AUX DATA")==label&&
                  strstr(buff,"DIFFERENTIAL CODE BIASES")) {
             readionexdcb(fp,dcb,rms);
@@ -282,15 +322,14 @@ extern void readtec(const char *file, nav_t *nav, int opt)
     FILE *fp;
     double lats[3]={0},lons[3]={0},hgts[3]={0},rb=0.0,nexp=-1.0;
     double dcb[MAXSAT]={0},rms[MAXSAT]={0};
-    int i,n;
+    int i,n,nmap;
     char *efiles[MAXEXFILE];
     
     trace(3,"readtec : file=%s\n",file);
     
     /* clear of tec grid data option */
-    if (!opt) {
-        free(nav->tec); nav->tec=NULL; nav->nt=nav->ntmax=0;
-    }
+    if (!opt) freetec(nav);
+    
     for (i=0;i<MAXEXFILE;i++) {
         if (!(efiles[i]=(char *)malloc(1024))) {
             for (i--;i>=0;i--) free(efiles[i]);
@@ -306,10 +345,14 @@ extern void readtec(const char *file, nav_t *nav, int opt)
             continue;
         }
         /* read ionex header */
-        if (readionexh(fp,lats,lons,hgts,&rb,&nexp,dcb,rms)<=0.0) {
+        nmap=0;
+        if (readionexh(fp,lats,lons,hgts,&rb,&nexp,dcb,rms,&nmap)<=0.0) {
             trace(2,"ionex file format error %s\n",efiles[i]);
             continue;
         }
+        /* reserve tec grid data for maps in file */
+        if (nmap>0) reservetec(nav,nav->nt+nmap);
+        
         /* read ionex body */
         readionexb(fp,lats,lons,hgts,rb,nexp,nav);
         
@@ -325,15 +368,10 @@ extern void readtec(const char *file, nav_t *nav, int opt)
         nav->cbias[i][0]=CLIGHT*dcb[i]*1E-9; /* ns->m */
     }
 }
-/* interpolate tec grid data -------------------------------------------------*/
-static int interptec(const tec_t *tec, int k, const double *posp, double *value,
-                     double *rms)
+/* grid cell of tec grid data ------------------------------------------------*/
+static int tecgrid(const tec_t *tec, const double *posp, int *ij, double *ab)
 {
-    double dlat,dlon,a,b,d[4]={0},r[4]={0};
-    int i,j,n,index;
-    
-    trace(3,"interptec: k=%d posp=%.2f %.2f\n",k,posp[0]*R2D,posp[1]*R2D);
-    *value=*rms=0.0;
+    double dlat,dlon;
     
     if (tec->lats[2]==0.0||tec->lons[2]==0.0) return 0;
     
@@ -342,10 +380,23 @@ static int interptec(const tec_t *tec, int k, const double *posp, double *value,
     if (tec->lons[2]>0.0) dlon-=floor( dlon/360)*360.0; /*  0<=dlon<360 */
     else                  dlon+=floor(-dlon/360)*360.0; /* -360<dlon<=0 */
     
-    a=dlat/tec->lats[2];
-    b=dlon/tec->lons[2];
-    i=(int)floor(a); a-=i;
-    j=(int)floor(b); b-=j;
+    ab[0]=dlat/tec->lats[2];
+    ab[1]=dlon/tec->lons[2];
+    ij[0]=(int)floor(ab[0]); ab[0]-=ij[0];
+    ij[1]=(int)floor(ab[1]); ab[1]-=ij[1];
+    return 1;
+}
+/* interpolate tec grid data ---------------------------------------------------
+* args   : int    *ij,*ab   I   grid cell by tecgrid()
+*-----------------------------------------------------------------------------*/
+static int interptec(const tec_t *tec, int k, const int *ij, const double *ab,
+                     double *value, double *rms)
+{
+    double a=ab[0],b=ab[1],d[4]={0},r[4]={0};
+    int i=ij[0],j=ij[1],n,index;
+    
+    trace(3,"interptec: k=%d i=%d j=%d\n",k,i,j);
+    *value=*rms=0.0;
     
     /* get gridded tec data */
     for (n=0;n<4;n++) {
@@ -372,37 +423,104 @@ static int interptec(const tec_t *tec, int k, const double *posp, double *value,
     }
     return 1;
 }
-/* ionosphere delay by tec grid data -----------------------------------------*/
-static int iondelay(gtime_t time, const tec_t *tec, const double *pos,
-                    const double *azel, int opt, double *delay, double *var)
+/* ionospheric pierce points of tec grid layers ------------------------------*/
+static void tecppp(const tec_t *tec, const double *pos, const double *azel,
+                   int opt, tecpp_t *pp)
 {
-    const double fact=40.30E16/FREQ1/FREQ1; /* tecu->L1 iono (m) */
-    double fs,posp[3]={0},vtec,rms,hion,rp;
+    double posp[3]={0},hion,rp;
     int i;
     
-    trace(3,"iondelay: time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
-          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
-    
-    *delay=*var=0.0;
+    pp->n=tec->ndata[2]<MAXLAYER?tec->ndata[2]:MAXLAYER;
     
-    for (i=0;i<tec->ndata[2];i++) { /* for a layer */
+    for (i=0;i<pp->n;i++) {
         
         hion=tec->hgts[0]+tec->hgts[2]*i;
         
         /* ionospheric pierce point position */
-        fs=ionppp(pos,azel,tec->rb,hion,posp);
+        pp->fs[i]=ionppp(pos,azel,tec->rb,hion,posp);
         
         if (opt&2) {
             /* modified single layer mapping function (M-SLM) ref [2] */
             rp=tec->rb/(tec->rb+hion)*sin(0.9782*(PI/2.0-azel[1]));
-            fs=1.0/sqrt(1.0-rp*rp);
+            pp->fs[i]=1.0/sqrt(1.0-rp*rp);
+        }
+        pp->posp[i][0]=posp[0];
+        pp->posp[i][1]=posp[1];
+    }
+    /* grid cells shared by tec grids for earth-fixed coordinate */
+    pp->grid=0;
+    if (opt&1) return;
+    
+    for (i=0,pp->grid=1;i<pp->n;i++) {
+        if (!tecgrid(tec,pp->posp[i],pp->ij[i],pp->ab[i])) pp->grid=-1;
+    }
+}
+/* same layers and grid of tec grids -----------------------------------------*/
+static int samelayer(const tec_t *tec1, const tec_t *tec2)
+{
+    int i;
+    
+    for (i=0;i<3;i++) {
+        if (tec1->lats[i]!=tec2->lats[i]||tec1->lons[i]!=tec2->lons[i]) return 0;
+    }
+    return tec1->rb==tec2->rb&&tec1->ndata[2]==tec2->ndata[2]&&
+           tec1->hgts[0]==tec2->hgts[0]&&tec1->hgts[2]==tec2->hgts[2];
+}
+/* ionosphere delay by tec grid data -------------------------------------------
+* args   : tecpp_t *pp      I   pierce points and grid cells of layers
+*                               (NULL: not computed)
+*-----------------------------------------------------------------------------*/
+static int iondelay(gtime_t time, const tec_t *tec, const double *pos,
+                    const double *azel, int opt, const tecpp_t *pp,
+                    double *delay, double *var)
+{
+    const double fact=40.30E16/FREQ1/FREQ1; /* tecu->L1 iono (m) */
+    const double *ab;
+    const int *ij;
+    double fs,posp[3]={0},vtec,rms,hion,rp,abw[2];
+    int i,ijw[2];
+    
+    trace(3,"iondelay: time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
+          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
+    
+    *delay=*var=0.0;
+    
+    for (i=0;i<tec->ndata[2];i++) { /* for a layer */
+        
+        if (pp&&i<pp->n) {
+            fs=pp->fs[i];
+            posp[0]=pp->posp[i][0];
+            posp[1]=pp->posp[i][1];
+        }
+        else {
+            hion=tec->hgts[0]+tec->hgts[2]*i;
+            
+            /* ionospheric pierce point position */
+            fs=ionppp(pos,azel,tec->rb,hion,posp);
+            
+            if (opt&2) {
+                /* modified single layer mapping function (M-SLM) ref [2] */
+                rp=tec->rb/(tec->rb+hion)*sin(0.9782*(PI/2.0-azel[1]));
+                fs=1.0/sqrt(1.0-rp*rp);
+            }
         }
         if (opt&1) {
             /* earth rotation correction (sun-fixed coordinate) */
             posp[1]+=2.0*PI*timediff(time,tec->time)/86400.0;
         }
+        /* grid cell of pierce point */
+        if (pp&&i<pp->n&&pp->grid) {
+            if (pp->grid<0) return 0;
+            ij=pp->ij[i];
+            ab=pp->ab[i];
+        }
+        else {
+            if (!tecgrid(tec,posp,ijw,abw)) return 0;
+            ij=ijw;
+            ab=abw;
+        }
         /* interpolate tec grid data */
-        if (!interptec(tec,i,posp,&vtec,&rms)) return 0;
+        if (!interptec(tec,i,ij,ab,&vtec,&rms)) return 0;
         
         *delay+=fact*fs*vtec;
         *var+=fact*fact*fs*fs*rms*rms;
@@ -411,49 +529,57 @@ static int iondelay(gtime_t time, const tec_t *tec, const double *pos,
     
     return 1;
 }
-/* ionosphere model by tec grid data -------------------------------------------
-* compute ionospheric delay by tec grid data
-* args   : gtime_t time     I   time (gpst)
-*          nav_t  *nav      I   navigation data
-*          double *pos      I   receiver position {lat,lon,h} (rad,m)
-*          double *azel     I   azimuth/elevation angle {az,el} (rad)
-*          int    opt       I   model option
-*                                bit0: 0:earth-fixed,1:sun-fixed
-*                                bit1: 0:single-layer,1:modified single-layer
-*          double *delay    O   ionospheric delay (L1) (m)
-*          double *var      O   ionospheric dealy (L1) variance (m^2)
-* return : status (1:ok,0:error)
-* notes  : before calling the function, read tec grid data by calling readtec()
-*          return ok with delay=0 and var=VAR_NOTEC if el<MIN_EL or h<MIN_HGT
+/* search index of tec grid data -----------------------------------------------
+* search index i of tec grid data as tec[i-1].time<=time<tec[i].time. the index
+* is directly computed for uniform interval of tec grid data or by binary search
+* return : index (0:before first data,nav->nt:after last data)
 *-----------------------------------------------------------------------------*/
-extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
-                  const double *azel, int opt, double *delay, double *var)
+static int tecindex(const nav_t *nav, gtime_t time)
 {
-    double dels[2],vars[2],a,tt;
-    int i,stat[2];
+    const tec_t *tec=nav->tec;
+    double dt;
+    int i,j,k,n=nav->nt;
     
-    trace(3,"iontec  : time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
-          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
-    
-    if (azel[1]<MIN_EL||pos[2]<MIN_HGT) {
-        *delay=0.0;
-        *var=VAR_NOTEC;
-        return 1;
+    if (n>=2&&(dt=timediff(tec[n-1].time,tec[0].time)/(n-1))>0.0&&
+        fabs(timediff(time,tec[0].time))<dt*n) {
+        k=(int)floor(timediff(time,tec[0].time)/dt)+1;
+        
+        for (i=k-1;i<=k+1;i++) {
+            if (i<1||i>=n) continue;
+            if (timediff(tec[i].time,time)>0.0&&
+                timediff(tec[i-1].time,time)<=0.0) return i;
+        }
     }
-    for (i=0;i<nav->nt;i++) {
-        if (timediff(nav->tec[i].time,time)>0.0) break;
+    /* binary search */
+    for (i=0,j=n;i<j;) {
+        k=(i+j)/2;
+        if (timediff(tec[k].time,time)>0.0) j=k; else i=k+1;
     }
+    return i;
+}
+/* ionosphere model by bracketing tec grid data ------------------------------*/
+static int iontecb(gtime_t time, const nav_t *nav, int i, const double *pos,
+                   const double *azel, int opt, double *delay, double *var)
+{
+    tecpp_t pp;
+    double dels[2],vars[2],a,tt;
+    int stat[2];
+    
     if (i==0||i>=nav->nt) {
-        trace(2,"%s: tec grid out of period\n",time_str(time,0));
+        if (TRACEON(2)) trace(2,"%s: tec grid out of period\n",time_str(time,0));
         return 0;
     }
     if ((tt=timediff(nav->tec[i].time,nav->tec[i-1].time))==0.0) {
         trace(2,"tec grid time interval error\n");
         return 0;
     }
+    /* pierce points and grid cells shared by tec grids with the same layers */
+    tecppp(nav->tec+i-1,pos,azel,opt,&pp);
+    
     /* ionospheric delay by tec grid data */
-    stat[0]=iondelay(time,nav->tec+i-1,pos,azel,opt,dels  ,vars  );
-    stat[1]=iondelay(time,nav->tec+i  ,pos,azel,opt,dels+1,vars+1);
+    stat[0]=iondelay(time,nav->tec+i-1,pos,azel,opt,&pp,dels,vars);
+    stat[1]=iondelay(time,nav->tec+i,pos,azel,opt,
+                     samelayer(nav->tec+i-1,nav->tec+i)?&pp:NULL,dels+1,vars+1);
     
     if (!stat[0]&&!stat[1]) {
         trace(2,"%s: tec grid out of area pos=%6.2f %7.2f azel=%6.1f %5.1f\n",
@@ -476,3 +602,70 @@ extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
     trace(3,"iontec  : delay=%5.2f std=%5.2f\n",*delay,sqrt(*var));
     return 1;
 }
+/* ionosphere model by tec grid data -------------------------------------------
+* compute ionospheric delay by tec grid data
+* args   : gtime_t time     I   time (gpst)
+*          nav_t  *nav      I   navigation data
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          double *azel     I   azimuth/elevation angle {az,el} (rad)
+*          int    opt       I   model option
+*                                bit0: 0:earth-fixed,1:sun-fixed
+*                                bit1: 0:single-layer,1:modified single-layer
+*          double *delay    O   ionospheric delay (L1) (m)
+*          double *var      O   ionospheric dealy (L1) variance (m^2)
+* return : status (1:ok,0:error)
+* notes  : before calling the function, read tec grid data by calling readtec()
+*          return ok with delay=0 and var=VAR_NOTEC if el<MIN_EL or h<MIN_HGT
+*-----------------------------------------------------------------------------*/
+extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
+                  const double *azel, int opt, double *delay, double *var)
+{
+    trace(3,"iontec  : time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
+          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
+    
+    if (azel[1]<MIN_EL||pos[2]<MIN_HGT) {
+        *delay=0.0;
+        *var=VAR_NOTEC;
+        return 1;
+    }
+    return iontecb(time,nav,tecindex(nav,time),pos,azel,opt,delay,var);
+}
+/* ionosphere model by tec grid data for satellites ----------------------------
+* compute ionospheric delays of satellites at an epoch by tec grid data
+* args   : gtime_t time     I   time (gpst)
+*          nav_t  *nav      I   navigation data
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          double *azel     I   azimuth/elevation angles {az,el,...} (rad)
+*          int    n         I   number of satellites
+*          int    opt       I   model option (see iontec())
+*          double *delay    O   ionospheric delays (L1) (m)
+*          double *var      O   ionospheric dealy (L1) variances (m^2)
+*          int    *stat     O   status of satellites (1:ok,0:error)
+* return : number of satellites with status ok
+* notes  : same as iontec() for each satellite. the tec grid data bracketing
+*          the epoch are searched once for the satellites. the grid cells of
+*          pierce points are shared by the tec grid data only for earth-fixed
+*          coordinate (opt&1=0) as sun-fixed one is rotated for each data.
+*-----------------------------------------------------------------------------*/
+extern int iontecs(gtime_t time, const nav_t *nav, const double *pos,
+                   const double *azel, int n, int opt, double *delay,
+                   double *var, int *stat)
+{
+    int i,j=-1,m=0;
+    
+    trace(3,"iontecs : time=%s pos=%.1f %.1f n=%d\n",time_str(time,0),
+          pos[0]*R2D,pos[1]*R2D,n);
+    
+    for (i=0;i<n;i++) {
+        if (azel[1+i*2]<MIN_EL||pos[2]<MIN_HGT) {
+            delay[i]=0.0;
+            var[i]=VAR_NOTEC;
+            m+=(stat[i]=1);
+            continue;
+        }
+        if (j<0) j=tecindex(nav,time);
+        
+        m+=(stat[i]=iontecb(time,nav,j,pos,azel+i*2,opt,delay+i,var+i));
+    }
+    return m;
+}
@@ -16,6 +16,7 @@
 *                                misc-rnxopt1,2,pos1-snrmask_r,_b,_L1,_L2,_L5
 *           2014/10/21  1.4  add pos2-bdsarmode
 *           2015/02/20  1.4  add ppp-fixed as pos1-posmode option
+*           2026/10/19  1.5  add file-pcvcachedir
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -41,7 +42,7 @@ static char snrmask_[NFREQ][1024];
 #define EPHOPT  "0:brdc,1:precise,2:brdc+sbas,3:brdc+ssrapc,4:brdc+ssrcom"
 #define NAVOPT  "1:gps+2:sbas+4:glo+8:gal+16:qzs+32:comp"
 #define GAROPT  "0:off,1:on,2:autocal"
-#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea"
+#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea,5:bin"
 #define TSYOPT  "0:gpst,1:utc,2:jst"
 #define TFTOPT  "0:tow,1:hms"
 #define DFTOPT  "0:deg,1:dms"
@@ -160,6 +161,7 @@ opt_t sysopts[]={
     {"file-geexefile",  2,  (void *)&filopt_.geexe,      ""     },
     {"file-solstatfile",2,  (void *)&filopt_.solstat,    ""     },
     {"file-tracefile",  2,  (void *)&filopt_.trace,      ""     },
+    {"file-pcvcachedir",2,  (void *)&filopt_.pcvdir,     ""     },
     
     {"",0,NULL,""} /* terminator */
 };
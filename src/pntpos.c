@@ -16,6 +16,8 @@
 *           2012/12/25 1.3  add variable snr mask
 *           2014/05/26 1.4  support galileo and beidou
 *           2015/03/19 1.5  fix bug on ionosphere correction for GLO and BDS
+*           2026/10/19 1.6  raim fde by leave-one-out downdates of normal matrix
+*                           exclude multiple satellites by raim fde
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -34,6 +36,8 @@ static const char rcsid[]="$Id:$";
 #define ERR_BRDCI   0.5         /* broadcast iono model error factor */
 #define ERR_CBIAS   0.3         /* code bias error std (m) */
 #define REL_HUMI    0.7         /* relative humidity for saastamoinen model */
+#define MAXRAIMEXC  3           /* max number of satellites excluded by raim */
+#define MAXRAIMVAL  3           /* max number of candidates validated by raim */
 
 /* pseudorange measurement error variance ------------------------------------*/
 static double varerr(const prcopt_t *opt, double el, int sys)
@@ -305,75 +309,120 @@ static int valsol(const double *azel, const int *vsat, int n,
     }
     return 1;
 }
-/* estimate receiver position ------------------------------------------------*/
-static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
+/* least square estimation of receiver position ------------------------------*/
+static int lsqpos(const obsd_t *obs, int n, const double *rs, const double *dts,
                   const double *vare, const int *svh, const nav_t *nav,
-                  const prcopt_t *opt, sol_t *sol, double *azel, int *vsat,
-                  double *resp, char *msg)
+                  const prcopt_t *opt, double *x, double *v, double *H,
+                  double *var, double *dx, double *Q, int *nv, int *ns,
+                  double *azel, int *vsat, double *resp, char *msg)
 {
-    double x[NX]={0},dx[NX],Q[NX*NX],*v,*H,*var,sig;
-    int i,j,k,info,stat,nv,ns;
-    
-    trace(3,"estpos  : n=%d\n",n);
-    
-    v=mat(n+4,1); H=mat(NX,n+4); var=mat(n+4,1);
-    
-    for (i=0;i<3;i++) x[i]=sol->rr[i];
+    double sig;
+    int i,j,k,info;
     
     for (i=0;i<MAXITR;i++) {
         
         /* pseudorange residuals */
-        nv=rescode(i,obs,n,rs,dts,vare,svh,nav,x,opt,v,H,var,azel,vsat,resp,
-                   &ns);
+        *nv=rescode(i,obs,n,rs,dts,vare,svh,nav,x,opt,v,H,var,azel,vsat,resp,
+                    ns);
         
-        if (nv<NX) {
-            sprintf(msg,"lack of valid sats ns=%d",nv);
+        if (*nv<NX) {
+            sprintf(msg,"lack of valid sats ns=%d",*nv);
             break;
         }
         /* weight by variance */
-        for (j=0;j<nv;j++) {
+        for (j=0;j<*nv;j++) {
             sig=sqrt(var[j]);
             v[j]/=sig;
             for (k=0;k<NX;k++) H[k+j*NX]/=sig;
         }
         /* least square estimation */
-        if ((info=lsq(H,v,NX,nv,dx,Q))) {
+        if ((info=lsq(H,v,NX,*nv,dx,Q))) {
             sprintf(msg,"lsq error info=%d",info);
             break;
         }
         for (j=0;j<NX;j++) x[j]+=dx[j];
         
-        if (norm(dx,NX)<1E-4) {
-            sol->type=0;
-            sol->time=timeadd(obs[0].time,-x[3]/CLIGHT);
-            sol->dtr[0]=x[3]/CLIGHT; /* receiver clock bias (s) */
-            sol->dtr[1]=x[4]/CLIGHT; /* glo-gps time offset (s) */
-            sol->dtr[2]=x[5]/CLIGHT; /* gal-gps time offset (s) */
-            sol->dtr[3]=x[6]/CLIGHT; /* bds-gps time offset (s) */
-            for (j=0;j<6;j++) sol->rr[j]=j<3?x[j]:0.0;
-            for (j=0;j<3;j++) sol->qr[j]=(float)Q[j+j*NX];
-            sol->qr[3]=(float)Q[1];    /* cov xy */
-            sol->qr[4]=(float)Q[2+NX]; /* cov yz */
-            sol->qr[5]=(float)Q[2];    /* cov zx */
-            sol->ns=(unsigned char)ns;
-            sol->age=sol->ratio=0.0;
-            
-            /* validate solution */
-            if ((stat=valsol(azel,vsat,n,opt,v,nv,NX,msg))) {
-                sol->stat=opt->sateph==EPHOPT_SBAS?SOLQ_SBAS:SOLQ_SINGLE;
-            }
-            free(v); free(H); free(var);
-            
-            return stat;
-        }
+        if (norm(dx,NX)<1E-4) return 1;
     }
     if (i>=MAXITR) sprintf(msg,"iteration divergent i=%d",i);
     
+    return 0;
+}
+/* estimate receiver position ------------------------------------------------*/
+static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
+                  const double *vare, const int *svh, const nav_t *nav,
+                  const prcopt_t *opt, sol_t *sol, double *azel, int *vsat,
+                  double *resp, char *msg)
+{
+    double x[NX]={0},dx[NX],Q[NX*NX],*v,*H,*var;
+    int j,stat=0,nv,ns;
+    
+    trace(3,"estpos  : n=%d\n",n);
+    
+    v=mat(n+4,1); H=mat(NX,n+4); var=mat(n+4,1);
+    
+    for (j=0;j<3;j++) x[j]=sol->rr[j];
+    
+    if (lsqpos(obs,n,rs,dts,vare,svh,nav,opt,x,v,H,var,dx,Q,&nv,&ns,azel,vsat,
+               resp,msg)) {
+        sol->type=0;
+        sol->time=timeadd(obs[0].time,-x[3]/CLIGHT);
+        sol->dtr[0]=x[3]/CLIGHT; /* receiver clock bias (s) */
+        sol->dtr[1]=x[4]/CLIGHT; /* glo-gps time offset (s) */
+        sol->dtr[2]=x[5]/CLIGHT; /* gal-gps time offset (s) */
+        sol->dtr[3]=x[6]/CLIGHT; /* bds-gps time offset (s) */
+        for (j=0;j<6;j++) sol->rr[j]=j<3?x[j]:0.0;
+        for (j=0;j<3;j++) sol->qr[j]=(float)Q[j+j*NX];
+        sol->qr[3]=(float)Q[1];    /* cov xy */
+        sol->qr[4]=(float)Q[2+NX]; /* cov yz */
+        sol->qr[5]=(float)Q[2];    /* cov zx */
+        sol->ns=(unsigned char)ns;
+        sol->age=sol->ratio=0.0;
+        
+        /* validate solution */
+        if ((stat=valsol(azel,vsat,n,opt,v,nv,NX,msg))) {
+            sol->stat=opt->sateph==EPHOPT_SBAS?SOLQ_SBAS:SOLQ_SINGLE;
+        }
+    }
     free(v); free(H); free(var);
     
-    return 0;
+    return stat;
+}
+/* observation data without excluded satellites ------------------------------*/
+static int exclsats(const obsd_t *obs, int n, const double *rs,
+                    const double *dts, const double *vare, const int *svh,
+                    const int *exc, obsd_t *obs_e, double *rs_e, double *dts_e,
+                    double *vare_e, int *svh_e, int *idx)
+{
+    int i,k;
+    
+    for (i=k=0;i<n;i++) {
+        if (exc[i]) continue;
+        obs_e[k]=obs[i];
+        matcpy(rs_e +6*k,rs +6*i,6,1);
+        matcpy(dts_e+2*k,dts+2*i,2,1);
+        vare_e[k]=vare[i];
+        svh_e[k]=svh[i];
+        idx[k++]=i;
+    }
+    return k;
 }
-/* raim fde (failure detection and exclution) -------------------------------*/
+/* raim fde (failure detection and exclution) ----------------------------------
+* raim fde by leave-one-out solutions derived from the converged normal matrix.
+* excluding a satellite is a rank-one downdate of the normal matrix, which
+* gives the post-fit residuals and the chi-square statistic without satellite
+* i as:
+*
+*   p_i = h_i*Q*h_i', dx_i = -Q*h_i'*v_i/(1-p_i), vv_i = v'*v-v_i^2/(1-p_i)
+*
+* the candidates are validated by estpos() in order of the residual rms. if no
+* candidate is valid, the satellite with the minimum vv_i is excluded and the
+* test is repeated for the rest satellites up to MAXRAIMEXC exclusions. an
+* additional exclusion is tried only if ns-nx>=2 after it (nx=NX), and its
+* solution must pass the chi-square test at the reduced dof again. otherwise
+* raim stops at a single exclusion, as a fault can be absorbed by the sparse
+* geometry.
+*-----------------------------------------------------------------------------*/
 static int raim_fde(const obsd_t *obs, int n, const double *rs,
                     const double *dts, const double *vare, const int *svh,
                     const nav_t *nav, const prcopt_t *opt, sol_t *sol,
@@ -382,69 +431,124 @@ static int raim_fde(const obsd_t *obs, int n, const double *rs,
     obsd_t *obs_e;
     sol_t sol_e={{0}};
     char tstr[32],name[16],msg_e[128];
-    double *rs_e,*dts_e,*vare_e,*azel_e,*resp_e,rms_e,rms=100.0;
-    int i,j,k,nvsat,stat=0,*svh_e,*vsat_e,sat=0;
+    double *rs_e,*dts_e,*vare_e,*azel_e,*resp_e,*v,*H,*var,*rms,*vv;
+    double x[NX]={0},dx[NX],Q[NX*NX],Qh[NX],dxi[NX],vv0,p,r,s,tmp;
+    int i,j,k,m,ne,nv,ns,nval,ncand,nexc=0,stat=0,*svh_e,*vsat_e,*idx,*row;
+    int *cand,*exc;
     
-    trace(3,"raim_fde: %s n=%2d\n",time_str(obs[0].time,0),n);
+    if (TRACEON(3)) trace(3,"raim_fde: %s n=%2d\n",time_str(obs[0].time,0),n);
     
     if (!(obs_e=(obsd_t *)malloc(sizeof(obsd_t)*n))) return 0;
     rs_e = mat(6,n); dts_e = mat(2,n); vare_e=mat(1,n); azel_e=zeros(2,n);
-    svh_e=imat(1,n); vsat_e=imat(1,n); resp_e=mat(1,n); 
-    
-    for (i=0;i<n;i++) {
-        
-        /* satellite exclution */
-        for (j=k=0;j<n;j++) {
-            if (j==i) continue;
-            obs_e[k]=obs[j];
-            matcpy(rs_e +6*k,rs +6*j,6,1);
-            matcpy(dts_e+2*k,dts+2*j,2,1);
-            vare_e[k]=vare[j];
-            svh_e[k++]=svh[j];
-        }
-        /* estimate receiver position without a satellite */
-        if (!estpos(obs_e,n-1,rs_e,dts_e,vare_e,svh_e,nav,opt,&sol_e,azel_e,
-                    vsat_e,resp_e,msg_e)) {
-            trace(3,"raim_fde: exsat=%2d (%s)\n",obs[i].sat,msg);
-            continue;
-        }
-        for (j=nvsat=0,rms_e=0.0;j<n-1;j++) {
-            if (!vsat_e[j]) continue;
-            rms_e+=SQR(resp_e[j]);
-            nvsat++;
+    svh_e=imat(1,n); vsat_e=imat(1,n); resp_e=mat(1,n);
+    v=mat(n+4,1); H=mat(NX,n+4); var=mat(n+4,1); rms=mat(n,1); vv=mat(n,1);
+    idx=imat(n,1); row=imat(n,1); cand=imat(n,1); exc=imat(n,1);
+    
+    for (i=0;i<n;i++) exc[i]=0;
+    for (i=0;i<3;i++) x[i]=sol->rr[i];
+    
+    while (!stat) {
+        
+        /* converged solution without excluded satellites */
+        ne=exclsats(obs,n,rs,dts,vare,svh,exc,obs_e,rs_e,dts_e,vare_e,svh_e,
+                    idx);
+        if (!lsqpos(obs_e,ne,rs_e,dts_e,vare_e,svh_e,nav,opt,x,v,H,var,dx,Q,&nv,
+                    &ns,azel_e,vsat_e,resp_e,msg_e)) {
+            trace(3,"raim_fde: nexc=%d (%s)\n",nexc,msg_e);
+            break;
         }
-        if (nvsat<5) {
-            trace(3,"raim_fde: exsat=%2d lack of satellites nvsat=%2d\n",
-                  obs[i].sat,nvsat);
-            continue;
+        /* post-fit residuals and rows of satellites */
+        for (i=0;i<nv;i++) v[i]-=dot(H+i*NX,dx,NX);
+        for (i=m=0;i<ne;i++) {
+            if (vsat_e[i]) row[m++]=i;
         }
-        rms_e=sqrt(rms_e/nvsat);
+        vv0=dot(v,v,nv);
         
-        trace(3,"raim_fde: exsat=%2d rms=%8.3f\n",obs[i].sat,rms_e);
+        /* additional exclusion requires ns-nx>=2 after exclusion */
+        if (nexc>0&&m-1-NX<2) break;
         
-        if (rms_e>rms) continue;
+        /* leave-one-out residuals by rank-one downdate */
+        for (i=ncand=0;i<m&&m>5;i++) {
+            matmul("NN",NX,1,NX,1.0,Q,H+i*NX,0.0,Qh);
+            p=dot(H+i*NX,Qh,NX);
+            
+            if (1.0-p<1E-9) { /* no redundancy */
+                for (j=0;j<NX;j++) dxi[j]=0.0;
+                vv[i]=vv0-SQR(v[i]);
+            }
+            else {
+                for (j=0;j<NX;j++) dxi[j]=-Qh[j]*v[i]/(1.0-p);
+                vv[i]=vv0-SQR(v[i])/(1.0-p);
+            }
+            for (j=0,s=0.0;j<m;j++) {
+                if (j==i) continue;
+                r=(v[j]-dot(H+j*NX,dxi,NX))*sqrt(var[j]);
+                s+=r*r;
+            }
+            rms[i]=sqrt(s/(m-1));
+            
+            trace(3,"raim_fde: exsat=%2d rms=%8.3f vv=%8.3f\n",
+                  obs_e[row[i]].sat,rms[i],vv[i]);
+            
+            if (rms[i]>100.0) continue;
+            
+            /* sort candidates by rms */
+            for (j=ncand++;j>0&&rms[cand[j-1]]>rms[i];j--) cand[j]=cand[j-1];
+            cand[j]=i;
+        }
+        /* validate candidates by estimating position */
+        for (k=nval=0;k<ncand&&nval<MAXRAIMVAL;k++) {
+            i=cand[k];
+            if (nv-1>NX&&vv[i]>chisqr[nv-NX-2]) continue;
+            
+            j=idx[row[i]];
+            exc[j]=1;
+            ne=exclsats(obs,n,rs,dts,vare,svh,exc,obs_e,rs_e,dts_e,vare_e,
+                        svh_e,idx);
+            sol_e=*sol;
+            nval++;
+            
+            if (estpos(obs_e,ne,rs_e,dts_e,vare_e,svh_e,nav,opt,&sol_e,azel_e,
+                       vsat_e,resp_e,msg_e)) {
+                stat=1;
+                break;
+            }
+            trace(3,"raim_fde: exsat=%2d (%s)\n",obs[j].sat,msg_e);
+            exc[j]=0;
+            ne=exclsats(obs,n,rs,dts,vare,svh,exc,obs_e,rs_e,dts_e,vare_e,
+                        svh_e,idx);
+        }
+        if (stat||++nexc>=MAXRAIMEXC||m-2-NX<2) break;
         
+        /* exclude satellite with max normalized residual */
+        for (i=0,j=-1,tmp=1E99;i<m;i++) {
+            if (vv[i]<tmp) {tmp=vv[i]; j=i;}
+        }
+        exc[idx[row[j]]]=1;
+    }
+    if (stat) {
         /* save result */
-        for (j=k=0;j<n;j++) {
-            if (j==i) continue;
-            matcpy(azel+2*j,azel_e+2*k,2,1);
-            vsat[j]=vsat_e[k];
-            resp[j]=resp_e[k++];
+        for (i=0;i<ne;i++) {
+            matcpy(azel+2*idx[i],azel_e+2*i,2,1);
+            vsat[idx[i]]=vsat_e[i];
+            resp[idx[i]]=resp_e[i];
         }
-        stat=1;
         *sol=sol_e;
-        sat=obs[i].sat;
-        rms=rms_e;
-        vsat[i]=0;
         strcpy(msg,msg_e);
-    }
-    if (stat) {
-        time2str(obs[0].time,tstr,2); satno2id(sat,name);
-        trace(2,"%s: %s excluded by raim\n",tstr+11,name);
+        
+        time2str(obs[0].time,tstr,2);
+        for (i=0;i<n;i++) {
+            if (!exc[i]) continue;
+            vsat[i]=0;
+            satno2id(obs[i].sat,name);
+            trace(2,"%s: %s excluded by raim\n",tstr+11,name);
+        }
     }
     free(obs_e);
     free(rs_e ); free(dts_e ); free(vare_e); free(azel_e);
     free(svh_e); free(vsat_e); free(resp_e);
+    free(v); free(H); free(var); free(rms); free(vv);
+    free(idx); free(row); free(cand); free(exc);
     return stat;
 }
 /* doppler residuals ---------------------------------------------------------*/
@@ -548,7 +652,7 @@ extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
     
     if (n<=0) {strcpy(msg,"no observation data"); return 0;}
     
-    trace(3,"pntpos  : tobs=%s n=%d\n",time_str(obs[0].time,3),n);
+    if (TRACEON(3)) trace(3,"pntpos  : tobs=%s n=%d\n",time_str(obs[0].time,3),n);
     
     sol->time=obs[0].time; msg[0]='\0';
     
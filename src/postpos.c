@@ -28,6 +28,14 @@
 *           2015/03/23  1.15 fix bug on ant type replacement by rinex header
 *                            fix bug on combined filter for moving-base mode
 *           2018/01/29  1.16 fix problem on ssr orbit and clock inconsistency
+*           2026/10/19  1.17 support binary solution format (SOLF_BIN)
+*                            release epoch-major precise ephemeris/clock
+*                            read precise clock by time-indexed window
+*                            add api pntposb(),setbatchthr()
+*                            batch single point positioning by threads
+*                            wait for chunks of batch spp by condition
+*                            search epochs by epoch index of obs data
+*                            binary antex cache in directory of file options
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -38,6 +46,8 @@ static const char rcsid[]="$Id: postpos.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $"
 
 #define MAXPRCDAYS  100          /* max days of continuous processing */
 #define MAXINFILE   1000         /* max number of input files */
+#define MAXBATCHTHR 64           /* max number of batch processing threads */
+#define NEPBATCH    128          /* number of epochs in a batch chunk */
 
 /* constants/global variables ------------------------------------------------*/
 
@@ -49,8 +59,8 @@ static sbs_t sbss={0};          /* sbas messages */
 static lex_t lexs={0};          /* lex messages */
 static sta_t stas[MAXRCV];      /* station infomation */
 static int nepoch=0;            /* number of observation epochs */
-static int iobsu =0;            /* current rover observation data index */
-static int iobsr =0;            /* current reference observation data index */
+static int iepu  =0;            /* current rover epoch index */
+static int iepr  =0;            /* current reference epoch index */
 static int isbs  =0;            /* current sbas message index */
 static int ilex  =0;            /* current lex message index */
 static int revs  =0;            /* analysis direction (0:forward,1:backward) */
@@ -67,6 +77,23 @@ static char rtcm_file[1024]=""; /* rtcm data file */
 static char rtcm_path[1024]=""; /* rtcm data path */
 static rtcm_t rtcm;             /* rtcm control struct */
 static FILE *fp_rtcm=NULL;      /* rtcm data file pointer */
+static int nthr_batch=0;        /* number of batch processing threads */
+
+typedef struct {                /* batch single point positioning type */
+    const obs_t *obs;           /* observation data */
+    const nav_t *nav;           /* navigation data */
+    prcopt_t opt;               /* processing options */
+    int *iep;                   /* epoch index of rover epochs */
+    int nep;                    /* number of rover epochs */
+    int nchk;                   /* number of chunks of epochs */
+    int ichk;                   /* next chunk to be processed */
+    int abort;                  /* abort flag */
+    sol_t *sol;                 /* solutions of epochs */
+    unsigned char *stat;        /* solution status of epochs (1:valid) */
+    unsigned char *done;        /* processed flags of chunks */
+    lock_t lock;                /* lock flag */
+    cond_t cond;                /* condition of processed chunks */
+} batch_t;
 
 /* show message and check break ----------------------------------------------*/
 static int checkbrk(const char *format, ...)
@@ -122,6 +149,10 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
     
     if (sopt->posf==SOLF_NMEA) return;
     
+    if (sopt->posf==SOLF_BIN) { /* version header only */
+        outsolhead(fp,sopt);
+        return;
+    }
     if (sopt->outhead) {
         if (!*sopt->prog) {
             fprintf(fp,"%s program   : RTKLIB ver.%s\n",COMMENTH,VER_RTKLIB);
@@ -160,30 +191,19 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
     
     outsolhead(fp,sopt);
 }
-/* search next observation data index ----------------------------------------*/
-static int nextobsf(const obs_t *obs, int *i, int rcv)
+/* reference epoch for rover epoch -------------------------------------------*/
+static int refepoch(gtime_t time, int intpref)
 {
-    double tt;
-    int n;
+    int k;
     
-    for (;*i<obs->n;(*i)++) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i+n<obs->n;n++) {
-        tt=timediff(obs->data[*i+n].time,obs->data[*i].time);
-        if (obs->data[*i+n].rcv!=rcv||tt>DTTOL) break;
-    }
-    return n;
-}
-static int nextobsb(const obs_t *obs, int *i, int rcv)
-{
-    double tt;
-    int n;
+    if (obss.ne[1]<=0) return -1;
     
-    for (;*i>=0;(*i)--) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i-n>=0;n++) {
-        tt=timediff(obs->data[*i-n].time,obs->data[*i].time);
-        if (obs->data[*i-n].rcv!=rcv||tt<-DTTOL) break;
+    if (intpref) { /* first epoch after rover epoch for interpolation */
+        return obsepoch(&obss,2,time,revs?-1:1);
     }
-    return n;
+    /* last epoch before rover epoch (or first one after if none) */
+    if ((k=obsepoch(&obss,2,time,revs?1:-1))>=0) return k;
+    return revs?obss.ne[1]-1:0;
 }
 
 /* input rtcm3 ssr corrections -----------------------------------------------*/
@@ -211,32 +231,28 @@ static void input_ssr(gtime_t time, rtcm_t *rtcm, nav_t *nav, FILE *fp)
 /* input obs data, navigation messages and sbas correction -------------------*/
 static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
 {
+    const obsep_t *epu,*epr;
     gtime_t time={0};
     char path[1024];
-    int i,nu,nr,n=0;
+    int i,n=0;
     
-    trace(3,"infunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",revs,iobsu,iobsr,isbs);
+    trace(3,"infunc  : revs=%d iepu=%d iepr=%d isbs=%d\n",revs,iepu,iepr,isbs);
     
-    if (0<=iobsu&&iobsu<obss.n) {
-        settime((time=obss.data[iobsu].time));
-        if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
-            aborts=1; showmsg("aborted"); return -1;
-        }
+    if (iepu<0||obss.ne[0]<=iepu) return -1;
+    
+    epu=obss.ep[0]+iepu;
+    settime((time=epu->time));
+    if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
+        aborts=1; showmsg("aborted"); return -1;
     }
+    /* rover and reference observation data of epoch */
+    epr=(iepr=refepoch(epu->time,popt->intpref))>=0?obss.ep[1]+iepr:NULL;
+    
+    for (i=0;i<epu->n&&n<MAXOBS*2;i++) obs[n++]=obss.data[epu->i+i];
+    for (i=0;epr&&i<epr->n&&n<MAXOBS*2;i++) obs[n++]=obss.data[epr->i+i];
+    
     if (!revs) { /* input forward data */
-        if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr+=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)>-DTTOL) break;
-        }
-        else {
-            for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i+=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)>DTTOL) break;
-        }
-        nr=nextobsf(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr+i];
-        iobsu+=nu;
+        iepu++;
         
         /* update sbas corrections */
         while (isbs<sbss.n) {
@@ -278,19 +294,7 @@ static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
         }
     }
     else { /* input backward data */
-        if ((nu=nextobsb(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr-=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)<DTTOL) break;
-        }
-        else {
-            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i-=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)<-DTTOL) break;
-        }
-        nr=nextobsb(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu-nu+1+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr-nr+1+i];
-        iobsu-=nu;
+        iepu--;
         
         /* update sbas corrections */
         while (isbs>=0) {
@@ -373,6 +377,165 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
     }
     rtkfree(&rtk);
 }
+/* single point positioning of rover epoch in batch -------------------------*/
+static int batchepoch(batch_t *b, rtk_t *rtk, int i, obsd_t *obs)
+{
+    const obsep_t *ep=b->obs->ep[0]+b->iep[i];
+    const obsd_t *data=b->obs->data+ep->i;
+    int j,n;
+    
+    /* exclude satellites */
+    for (j=n=0;j<ep->n&&n<MAXOBS*2;j++) {
+        if ((satsys(data[j].sat,NULL)&b->opt.navsys)&&
+            b->opt.exsats[data[j].sat-1]!=1) obs[n++]=data[j];
+    }
+    if (n<=0) return 0;
+    
+    return rtkpos(rtk,obs,n,b->nav);
+}
+/* batch processing thread ---------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI batchthread(void *arg)
+#else
+static void *batchthread(void *arg)
+#endif
+{
+    batch_t *b=(batch_t *)arg;
+    sol_t sol0={{0}};
+    rtk_t rtk;
+    obsd_t obs[MAXOBS*2];
+    int i,k,i0,i1;
+    
+    rtkinit(&rtk,&b->opt);
+    
+    for (;;) {
+        lock(&b->lock);
+        k=b->abort?b->nchk:b->ichk++;
+        unlock(&b->lock);
+        if (k>=b->nchk) break;
+        
+        i0=k*NEPBATCH;
+        i1=MIN(i0+NEPBATCH,b->nep);
+        
+        /* initial solution by the previous epoch of the chunk */
+        rtk.sol=sol0;
+        if (i0>0) batchepoch(b,&rtk,i0-1,obs);
+        
+        for (i=i0;i<i1;i++) {
+            b->stat[i]=(unsigned char)batchepoch(b,&rtk,i,obs);
+            b->sol[i]=rtk.sol;
+        }
+        lock(&b->lock);
+        b->done[k]=1;
+        signalcond(&b->cond);
+        unlock(&b->lock);
+    }
+    rtkfree(&rtk);
+    return 0;
+}
+/* batch single point positioning ----------------------------------------------
+* single point positioning of rover observation data in a time range. chunks of
+* epochs are processed in parallel by threads with thread-local workspaces and
+* the solutions are output in time order by outsol()
+* args   : obs_t    *obs    I   observation data (sorted by sortobs())
+*          gtime_t  ts      I   processing start time (ts.time==0: no limit)
+*          gtime_t  te      I   processing end time   (te.time==0: no limit)
+*          double   ti      I   processing interval  (s) (0:all)
+*          nav_t    *nav    I   navigation data
+*          prcopt_t *popt   I   processing options
+*          solopt_t *sopt   I   solution options
+*          int      nthread I   number of threads
+*          FILE     *fp     I   output file pointer
+* return : number of output solutions (-1: aborted or error)
+* notes  : the solution of an epoch starts from the solution of the previous
+*          epoch as procpos(). the first epoch of a chunk starts from the
+*          solution of the previous epoch computed again in the thread.
+*          sbas, lex and rtcm ssr corrections are not updated by the epochs.
+*          solution status output by rtkopenstat() is not supported.
+*-----------------------------------------------------------------------------*/
+extern int pntposb(const obs_t *obs, gtime_t ts, gtime_t te, double ti,
+                   const nav_t *nav, const prcopt_t *popt,
+                   const solopt_t *sopt, int nthread, FILE *fp)
+{
+    batch_t b={0};
+    thread_t thr[MAXBATCHTHR];
+    double rb[3]={0};
+    int i,j,k,n,nthr,nout=0;
+    
+    trace(3,"pntposb : n=%d nthread=%d\n",obs->n,nthread);
+    
+    b.obs=obs;
+    b.nav=nav;
+    b.opt=*popt;
+    b.opt.mode=PMODE_SINGLE;
+    
+    if (!(b.iep=(int *)malloc(sizeof(int)*(obs->ne[0]+1)))) return -1;
+    
+    /* rover epochs in time range */
+    for (i=0;i<obs->ne[0];i++) {
+        if (screent(obs->ep[0][i].time,ts,te,ti)) b.iep[b.nep++]=i;
+    }
+    b.nchk=(b.nep+NEPBATCH-1)/NEPBATCH;
+    
+    if (!(b.sol=(sol_t *)malloc(sizeof(sol_t)*(b.nep+1)))||
+        !(b.stat=(unsigned char *)malloc(b.nep+1))||
+        !(b.done=(unsigned char *)calloc(b.nchk+1,1))) {
+        free(b.iep); free(b.sol); free(b.stat);
+        return -1;
+    }
+    initlock(&b.lock);
+    initcond(&b.cond);
+    
+    nthr=MIN(MIN(nthread,MAXBATCHTHR),b.nchk);
+    
+    for (i=n=0;i<nthr;i++) {
+#ifdef WIN32
+        if (!(thr[i]=CreateThread(NULL,0,batchthread,&b,0,NULL))) break;
+#else
+        if (pthread_create(thr+i,NULL,batchthread,&b)) break;
+#endif
+        n++;
+    }
+    if (n==0) batchthread(&b); /* no thread */
+    
+    /* output solutions of chunks in time order */
+    for (k=0;k<b.nchk;k++) {
+        
+        /* wait for end of chunk */
+        lock(&b.lock);
+        while (!b.done[k]) waitcond(&b.cond,&b.lock);
+        unlock(&b.lock);
+        
+        for (i=k*NEPBATCH,j=-1;i<MIN((k+1)*NEPBATCH,b.nep);i++) {
+            if (!b.stat[i]) continue;
+            outsol(fp,b.sol+i,rb,sopt);
+            nout++;
+            j=i;
+        }
+        if (j>=0) {
+            settime(b.sol[j].time);
+            if (checkbrk("processing : %s Q=%d",time_str(b.sol[j].time,0),
+                         b.sol[j].stat)) {
+                lock(&b.lock);
+                b.abort=1;
+                unlock(&b.lock);
+                showmsg("aborted");
+                break;
+            }
+        }
+    }
+    for (i=0;i<n;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thr[i],INFINITE);
+        CloseHandle(thr[i]);
+#else
+        pthread_join(thr[i],NULL);
+#endif
+    }
+    free(b.iep); free(b.sol); free(b.stat); free(b.done);
+    
+    return b.abort?-1:nout;
+}
 /* validation of combined solutions ------------------------------------------*/
 static int valcomb(const sol_t *solf, const sol_t *solb)
 {
@@ -506,7 +669,7 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     /* read precise clock files */
     for (i=0;i<n;i++) {
         if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
-        readrnxc(infile[i],nav);
+        readpclk(infile[i],nav);
     }
     /* read sbas message files */
     for (i=0;i<n;i++) {
@@ -542,20 +705,12 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
 /* free prec ephemeris and sbas data -----------------------------------------*/
 static void freepreceph(nav_t *nav, sbs_t *sbs, lex_t *lex)
 {
-    int i;
-    
     trace(3,"freepreceph:\n");
     
-    free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;
-    free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;
+    freenav(nav,0x58);
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
     free(sbs->msgs); sbs->msgs=NULL; sbs->n =sbs->nmax =0;
     free(lex->msgs); lex->msgs=NULL; lex->n =lex->nmax =0;
-    for (i=0;i<nav->nt;i++) {
-        free(nav->tec[i].data);
-        free(nav->tec[i].rms );
-    }
-    free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
     
 #ifdef EXTSTEC
     stec_free(nav);
@@ -569,11 +724,12 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
                       const int *index, int n, const prcopt_t *prcopt,
                       obs_t *obs, nav_t *nav, sta_t *sta)
 {
-    int i,j,ind=0,nobs=0,rcv=1;
+    int i,ind=0,nobs=0,rcv=1;
     
-    trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
+    if (TRACEON(3)) trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
     
     obs->data=NULL; obs->n =obs->nmax =0;
+    obs->ep[0]=obs->ep[1]=NULL; obs->ne[0]=obs->ne[1]=0;
     nav->eph =NULL; nav->n =nav->nmax =0;
     nav->geph=NULL; nav->ng=nav->ngmax=0;
     nav->seph=NULL; nav->ns=nav->nsmax=0;
@@ -611,14 +767,10 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     uniqnav(nav);
     
     /* set time span for progress display */
-    if (ts.time==0||te.time==0) {
-        for (i=0;   i<obs->n;i++) if (obs->data[i].rcv==1) break;
-        for (j=obs->n-1;j>=0;j--) if (obs->data[j].rcv==1) break;
-        if (i<j) {
-            if (ts.time==0) ts=obs->data[i].time;
-            if (te.time==0) te=obs->data[j].time;
-            settspan(ts,te);
-        }
+    if ((ts.time==0||te.time==0)&&obs->ne[0]>1) {
+        if (ts.time==0) ts=obs->ep[0][0].time;
+        if (te.time==0) te=obs->ep[0][obs->ne[0]-1].time;
+        settspan(ts,te);
     }
     return 1;
 }
@@ -627,7 +779,7 @@ static void freeobsnav(obs_t *obs, nav_t *nav)
 {
     trace(3,"freeobsnav:\n");
     
-    free(obs->data); obs->data=NULL; obs->n =obs->nmax =0;
+    freeobs(obs);
     free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;
     free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
@@ -639,17 +791,21 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
     obsd_t data[MAXOBS];
     gtime_t ts={0};
     sol_t sol={{0}};
-    int i,j,n=0,m,iobs;
+    const obsep_t *ep;
+    int i,j,k,n=0;
     char msg[128];
     
     trace(3,"avepos: rcv=%d obs.n=%d\n",rcv,obs->n);
     
     for (i=0;i<3;i++) ra[i]=0.0;
     
-    for (iobs=0;(m=nextobsf(obs,&iobs,rcv))>0;iobs+=m) {
+    if (rcv<1||2<rcv) return 0;
+    
+    for (k=0;k<obs->ne[rcv-1];k++) {
+        ep=obs->ep[rcv-1]+k;
         
-        for (i=j=0;i<m&&i<MAXOBS;i++) {
-            data[j]=obs->data[iobs+i];
+        for (i=j=0;i<ep->n&&i<MAXOBS;i++) {
+            data[j]=obs->data[ep->i+i];
             if ((satsys(data[j].sat,NULL)&opt->navsys)&&
                 opt->exsats[data[j].sat-1]!=1) j++;
         }
@@ -752,6 +908,8 @@ static int openses(const prcopt_t *popt, const solopt_t *sopt,
     trace(3,"openses :\n");
     
     /* read satellite antenna parameters */
+    setpcvcache(fopt->pcvdir);
+    
     if (*fopt->satantp&&!(readpcv(fopt->satantp,pcvs))) {
         showmsg("error : no sat ant pcv in %s",fopt->satantp);
         trace(1,"sat antenna pcv read error: %s\n",fopt->satantp);
@@ -800,8 +958,8 @@ static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
     trace(3,"closeses:\n");
     
     /* free antenna parameters */
-    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
-    free(pcvr->pcv); pcvr->pcv=NULL; pcvr->n=pcvr->nmax=0;
+    freepcv(pcvs);
+    freepcv(pcvr);
     
     /* close geoid data */
     closegeoid();
@@ -875,7 +1033,7 @@ static int outhead(const char *outfile, char **infile, int n,
     if (*outfile) {
         createdir(outfile);
         
-        if (!(fp=fopen(outfile,"w"))) {
+        if (!(fp=fopen(outfile,sopt->posf==SOLF_BIN?"wb":"w"))) {
             showmsg("error : open output file %s",outfile);
             return 0;
         }
@@ -888,11 +1046,11 @@ static int outhead(const char *outfile, char **infile, int n,
     return 1;
 }
 /* open output file for append -----------------------------------------------*/
-static FILE *openfile(const char *outfile)
+static FILE *openfile(const char *outfile, const solopt_t *sopt)
 {
     trace(3,"openfile: outfile=%s\n",outfile);
     
-    return !*outfile?stdout:fopen(outfile,"a");
+    return !*outfile?stdout:fopen(outfile,sopt->posf==SOLF_BIN?"ab":"a");
 }
 /* execute processing session ------------------------------------------------*/
 static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
@@ -955,17 +1113,27 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         freeobsnav(&obss,&navs);
         return 0;
     }
-    iobsu=iobsr=isbs=ilex=revs=aborts=0;
+    iepu=iepr=isbs=ilex=revs=aborts=0;
     
-    if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
-        if ((fp=openfile(outfile))) {
+    if (nthr_batch>0&&popt_.mode==PMODE_SINGLE&&sopt->sstat<=0&&
+        sbss.n<=0&&lexs.n<=0&&!*rtcm_file&&popt_.tropopt!=TROPOPT_SBAS) {
+        if ((fp=openfile(outfile,sopt))) {
+            if (pntposb(&obss,ts,te,ti,&navs,&popt_,sopt,nthr_batch,fp)<0) {
+                aborts=1;
+            }
+            fclose(fp);
+        }
+    }
+    else if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
+        if ((fp=openfile(outfile,sopt))) {
             procpos(fp,&popt_,sopt,0); /* forward */
             fclose(fp);
         }
     }
     else if (popt_.soltype==1) {
-        if ((fp=openfile(outfile))) {
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
+        if ((fp=openfile(outfile,sopt))) {
+            revs=1; iepu=obss.ne[0]-1; iepr=obss.ne[1]-1;
+            isbs=sbss.n-1; ilex=lexs.n-1;
             procpos(fp,&popt_,sopt,0); /* backward */
             fclose(fp);
         }
@@ -979,11 +1147,12 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         if (solf&&solb) {
             isolf=isolb=0;
             procpos(NULL,&popt_,sopt,1); /* forward */
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
+            revs=1; iepu=obss.ne[0]-1; iepr=obss.ne[1]-1;
+            isbs=sbss.n-1; ilex=lexs.n-1;
             procpos(NULL,&popt_,sopt,1); /* backward */
             
             /* combine forward/backward solutions */
-            if (!aborts&&(fp=openfile(outfile))) {
+            if (!aborts&&(fp=openfile(outfile,sopt))) {
                 combres(fp,&popt_,sopt);
                 fclose(fp);
             }
@@ -1262,3 +1431,14 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
     
     return stat;
 }
+/* set number of threads of batch processing -----------------------------------
+* set number of threads of batch single point positioning in postpos()
+* args   : int    nthread     I   number of threads (0:off)
+* return : none
+* notes  : batch processing is applied to single point positioning without
+*          sbas, lex and rtcm ssr corrections and solution status output.
+*-----------------------------------------------------------------------------*/
+extern void setbatchthr(int nthread)
+{
+    nthr_batch=nthread<0?0:nthread;
+}
@@ -37,6 +37,17 @@
 *           2014/10/13 1.6  fix bug on P0(a[3]) computation in tide_oload()
 *                           fix bug on m2 computation in tide_pole()
 *           2018/01/29 1.7  fix bug on OTL computation (##128)
+*           2026/10/19 1.8  add timing counters of processing stages
+*                           use troposphere context for mapping functions
+*                           add api tidedispc()
+*                           add epoch correction cache for filter iterations
+*                           add api pppnet()
+*                           wait for epochs of pppnet() by condition
+*                           share ephemerides and sun direction in pppnet()
+*                           no grid rebuilt by site moved in tidedispc()
+*                           add api setpppcorrc()
+*                           share precise clock window and antenna offsets
+*                           in pppnet()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -64,6 +75,11 @@ static const char rcsid[]="$Id:$";
 #define ERR_CBIAS   0.3             /* code bias error std (m) */
 #define REL_HUMI    0.7             /* relative humidity for saastamoinen model */
 
+#define TIDE_TINT   120.0           /* grid interval of tide context (s) */
+#define TIDE_DPOS   100.0           /* site move to reset tide context (m) */
+#define CORR_DPOS   1.0             /* site move to update correction cache (m) */
+#define MAXNETTHR   64              /* max number of network ppp threads */
+
 #define NP(opt)     ((opt)->dynamics?9:3) /* number of pos solution */
 #define IC(s,opt)   (NP(opt)+(s))      /* state index of clocks (s=0:gps,1:glo) */
 #define IT(opt)     (IC(0,opt)+NSYS)   /* state index of tropos */
@@ -72,6 +88,42 @@ static const char rcsid[]="$Id:$";
 #define IB(s,opt)   (NR(opt)+(s)-1)    /* state index of phase bias */
 #define NX(opt)     (IB(MAXSAT,opt)+1) /* number of estimated states */
 
+typedef struct {                    /* correction cache of satellite */
+    int stat;                       /* epoch terms status (0:unset,1:set) */
+    int ipos;                       /* reference position index of site terms */
+    int ionstat;                    /* iono status (0:unset,1:valid,-1:error) */
+    double cbias[3];                /* code biases {P1-P2,P1-C1,P2-C2} (m) */
+    double dants[NFREQ];            /* satellite antenna pcv (m) */
+    double dantr[NFREQ];            /* receiver antenna pco/pcv (m) */
+    double ion,vari;                /* slant iono delay L1 (m) and variance */
+    double mapf[4];                 /* trop mapping {dry,wet,grad-n,grad-e} */
+} corrs_t;
+
+typedef struct {                    /* epoch correction cache */
+    int ipos;                       /* reference position index (0:unset) */
+    double rr[3];                   /* reference site position (ecef) (m) */
+    double pos[3];                  /* reference site position {lat,lon,h} */
+    double zd[2];                   /* a-priori zenith delay and height partial */
+    tropc_t trop;                   /* troposphere context */
+    corrs_t sat[MAXOBS];            /* corrections of satellites */
+} corrc_t;
+
+typedef struct {                    /* network ppp control type */
+    pppsta_t *sta;                  /* stations */
+    int nsta;                       /* number of stations */
+    const nav_t *nav;               /* navigation data with satellite states */
+    const solopt_t *sopt;           /* solution options */
+    obsd_t *obs;                    /* observation data of epoch (nsta x MAXOBS) */
+    int *nobs;                      /* number of observation data of stations */
+    int epoch;                      /* epoch count (-1:end) */
+    int next;                       /* next station to be processed */
+    int ndone;                      /* number of processed stations */
+    lock_t lock;                    /* lock flag */
+    cond_t cond;                    /* condition of epoch/processed stations */
+} pppnet_t;
+
+static double corr_dpos=CORR_DPOS;  /* site move to update correction cache (m) */
+
 /* function prototypes -------------------------------------------------------*/
 #ifdef IERS_MODEL
 extern int dehanttideinel_(double *xsta, int *year, int *mon, int *day,
@@ -339,7 +391,7 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
     int year,mon,day;
 #endif
     
-    trace(3,"tidedisp: tutc=%s\n",time_str(tutc,0));
+    if (TRACEON(3)) trace(3,"tidedisp: tutc=%s\n",time_str(tutc,0));
     
     if (erp) geterp(erp,tutc,erpv);
     
@@ -384,34 +436,136 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
     }
     trace(5,"tidedisp: dr=%.3f %.3f %.3f\n",dr[0],dr[1],dr[2]);
 }
+/* tidal displacement by tide context ------------------------------------------
+* displacements by earth tides interpolated on time grid of tide context
+* args   : gtime_t tutc     I   time in utc
+*          double *rr       I   site position (ecef) (m)
+*          int    opt       I   options (see tidedisp())
+*          double *erp      I   earth rotation parameters (NULL: not used)
+*          double *odisp    I   ocean loading parameters  (NULL: not used)
+*          tidec_t *tide    IO  tide context of the site ({0}: reset)
+*          double *dr       O   displacement by earth tides (ecef) (m)
+* return : none
+* notes  : tidedisp() is evaluated at the grid times (interval TIDE_TINT) around
+*          tutc and at the site position of the context, and the displacement
+*          is linearly interpolated. the context is reset if opt, erp or odisp
+*          are changed. if the site moves more than TIDE_DPOS, tidedisp() is
+*          evaluated once at tutc and the current position, which is used as
+*          the start of the grid interval at the next call.
+*          the interpolation error is bounded by A*w^2*TIDE_TINT^2/8 for the
+*          semi-diurnal terms (A<0.5m, w=1.46E-4rad/s) and the site position
+*          error by 1 m/rad*TIDE_DPOS/RE, which is 0.02mm + 0.02mm.
+*-----------------------------------------------------------------------------*/
+extern void tidedispc(gtime_t tutc, const double *rr, int opt,
+                      const erp_t *erp, const double *odisp, tidec_t *tide,
+                      double *dr)
+{
+    gtime_t t0;
+    double dp[3],a;
+    int i;
+    
+    if (TRACEON(3)) trace(3,"tidedispc: tutc=%s\n",time_str(tutc,0));
+    
+    for (i=0;i<3;i++) dp[i]=rr[i]-tide->rr[i];
+    
+    if (tide->opt!=opt||tide->erp!=erp||tide->odisp!=odisp) {
+        tide->opt=opt;
+        tide->erp=erp;
+        tide->odisp=odisp;
+        for (i=0;i<3;i++) tide->rr[i]=rr[i];
+        tide->n=0;
+    }
+    else if (norm(dp,3)>TIDE_DPOS) {
+        
+        /* site moved: displacement at current position without grid */
+        tidedisp(tutc,rr,opt,erp,odisp,dr);
+        for (i=0;i<3;i++) {
+            tide->rr[i]=rr[i];
+            tide->dr[i]=dr[i];
+        }
+        tide->time[0]=tutc;
+        tide->n=1;
+        return;
+    }
+    /* grid time before tutc */
+    t0=tutc;
+    t0.time-=(time_t)fmod((double)tutc.time,TIDE_TINT);
+    t0.sec=0.0;
+    
+    if (tide->n>=2&&timediff(tutc,tide->time[0])>=0.0&&
+        timediff(tutc,tide->time[1])<=0.0) {
+        ; /* grid values already computed */
+    }
+    else if (tide->n>=2&&timediff(t0,tide->time[1])==0.0) {
+        tide->time[0]=tide->time[1];
+        for (i=0;i<3;i++) tide->dr[i]=tide->dr[i+3];
+        tide->time[1]=timeadd(t0,TIDE_TINT);
+        tidedisp(tide->time[1],tide->rr,opt,erp,odisp,tide->dr+3);
+    }
+    else if (tide->n==1&&timediff(tide->time[0],t0)>=0.0&&
+             timediff(tutc,tide->time[0])>=0.0) {
+        
+        /* grid interval started by displacement at site moved */
+        tide->time[1]=timeadd(t0,TIDE_TINT);
+        tidedisp(tide->time[1],tide->rr,opt,erp,odisp,tide->dr+3);
+        tide->n=2;
+    }
+    else {
+        tide->time[0]=t0;
+        tide->time[1]=timeadd(t0,TIDE_TINT);
+        tidedisp(tide->time[0],tide->rr,opt,erp,odisp,tide->dr  );
+        tidedisp(tide->time[1],tide->rr,opt,erp,odisp,tide->dr+3);
+        tide->n=2;
+    }
+    a=timediff(tutc,tide->time[0])/timediff(tide->time[1],tide->time[0]);
+    
+    for (i=0;i<3;i++) dr[i]=tide->dr[i]*(1.0-a)+tide->dr[i+3]*a;
+    
+    trace(5,"tidedispc: dr=%.3f %.3f %.3f\n",dr[0],dr[1],dr[2]);
+}
+/* eclipsing satellite (block IIA) -------------------------------------------*/
+static int eclipsed(const double *rs, const double *esun, const char *type)
+{
+    double r,ang,cosa;
+    
+    if ((r=norm(rs,3))<=0.0) return 0;
+#if 1
+    /* only block IIA */
+    if (*type&&!strstr(type,"BLOCK IIA")) return 0;
+#endif
+    /* sun-earth-satellite angle */
+    cosa=dot(rs,esun,3)/r;
+    cosa=cosa<-1.0?-1.0:(cosa>1.0?1.0:cosa);
+    ang=acos(cosa);
+    
+    /* test eclipse */
+    return ang>=PI/2.0&&r*sin(ang)<=RE_WGS84;
+}
+/* unit vector of sun direction (ecef) ---------------------------------------*/
+static void sundir(gtime_t time, double *esun)
+{
+    double rsun[3],erpv[5]={0};
+    
+    sunmoonpos(gpst2utc(time),erpv,rsun,NULL,NULL);
+    normv3(rsun,esun);
+}
 /* exclude meas of eclipsing satellite (block IIA) ---------------------------*/
 static void testeclipse(const obsd_t *obs, int n, const nav_t *nav, double *rs)
 {
-    double rsun[3],esun[3],r,ang,erpv[5]={0},cosa;
+    const satsts_t *sats=nav->sats;
+    double esun[3];
     int i,j;
-    const char *type;
     
     trace(3,"testeclipse:\n");
     
-    /* unit vector of sun direction (ecef) */
-    sunmoonpos(gpst2utc(obs[0].time),erpv,rsun,NULL,NULL);
-    normv3(rsun,esun);
+    /* sun direction by satellite states of epoch */
+    if (sats&&timediff(obs[0].time,sats->time)==0.0) {
+        for (i=0;i<3;i++) esun[i]=sats->esun[i];
+    }
+    else sundir(obs[0].time,esun);
     
     for (i=0;i<n;i++) {
-        type=nav->pcvs[obs[i].sat-1].type;
-        
-        if ((r=norm(rs+i*6,3))<=0.0) continue;
-#if 1
-        /* only block IIA */
-        if (*type&&!strstr(type,"BLOCK IIA")) continue;
-#endif
-        /* sun-earth-satellite angle */
-        cosa=dot(rs+i*6,esun,3)/r;
-        cosa=cosa<-1.0?-1.0:(cosa>1.0?1.0:cosa);
-        ang=acos(cosa);
-        
-        /* test eclipse */
-        if (ang<PI/2.0||r*sin(ang)>RE_WGS84) continue;
+        if (!eclipsed(rs+i*6,esun,nav->pcvs[obs[i].sat-1].type)) continue;
         
         trace(2,"eclipsing sat excluded %s sat=%2d\n",time_str(obs[0].time,0),
               obs[i].sat);
@@ -467,8 +621,8 @@ static void initx(rtk_t *rtk, double xi, double var, int i)
 }
 /* dual-frequency iono-free measurements -------------------------------------*/
 static int ifmeas(const obsd_t *obs, const nav_t *nav, const double *azel,
-                  const prcopt_t *opt, const double *dantr, const double *dants,
-                  double phw, double *meas, double *var)
+                  const prcopt_t *opt, const corrs_t *cs, double phw,
+                  double *meas, double *var)
 {
     const double *lam=nav->lam[obs->sat-1];
     double c1,c2,L1,L2,P1,P2,P1_C1,P2_C2,gamma;
@@ -494,8 +648,8 @@ static int ifmeas(const obsd_t *obs, const nav_t *nav, const double *azel,
     L2=obs->L[j]*lam[j];
     P1=obs->P[i];
     P2=obs->P[j];
-    P1_C1=nav->cbias[obs->sat-1][1];
-    P2_C2=nav->cbias[obs->sat-1][2];
+    P1_C1=cs->cbias[1];
+    P2_C2=cs->cbias[2];
     if (opt->sateph==EPHOPT_LEX) {
         P1_C1=nav->lexeph[obs->sat-1].isc[0]*CLIGHT; /* ISC_L1C/A */
     }
@@ -518,8 +672,8 @@ static int ifmeas(const obsd_t *obs, const nav_t *nav, const double *azel,
     }
     /* antenna phase center variation correction */
     for (k=0;k<2;k++) {
-        if (dants) meas[k]-=c1*dants[i]+c2*dants[j];
-        if (dantr) meas[k]-=c1*dantr[i]+c2*dantr[j];
+        meas[k]-=c1*cs->dants[i]+c2*cs->dants[j];
+        meas[k]-=c1*cs->dantr[i]+c2*cs->dantr[j];
     }
     return 1;
 }
@@ -533,6 +687,21 @@ static double gettgd(int sat, const nav_t *nav)
     }
     return 0.0;
 }
+/* code biases of satellite --------------------------------------------------*/
+static void satcbias(const obsd_t *obs, const nav_t *nav, const prcopt_t *opt,
+                     double *cbias)
+{
+    const double *lam=nav->lam[obs->sat-1];
+    int i;
+    
+    for (i=0;i<3;i++) cbias[i]=nav->cbias[obs->sat-1][i];
+    
+    /* P1-P2 dcb by tgd */
+    if (opt->ionoopt!=IONOOPT_IFLC&&lam[0]>0.0&&cbias[0]==0.0&&
+        (satsys(obs->sat,NULL)&(SYS_GPS|SYS_GAL|SYS_QZS))) {
+        cbias[0]=(1.0-SQR(lam[1]/lam[0]))*gettgd(obs->sat,nav);
+    }
+}
 /* slant ionospheric delay ---------------------------------------------------*/
 static int corr_ion(gtime_t time, const nav_t *nav, int sat, const double *pos,
                     const double *azel, int ionoopt, double *ion, double *var,
@@ -568,12 +737,11 @@ static int corr_ion(gtime_t time, const nav_t *nav, int sat, const double *pos,
 }
 /* ionosphere and antenna corrected measurements -----------------------------*/
 static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
-                    const double *azel, const prcopt_t *opt,
-                    const double *dantr, const double *dants, double phw,
-                    double *meas, double *var, int *brk)
+                    const double *azel, const prcopt_t *opt, corrs_t *cs,
+                    double phw, double *meas, double *var, int *brk)
 {
     const double *lam=nav->lam[obs->sat-1];
-    double ion=0.0,L1,P1,PC,P1_P2,P1_C1,vari,gamma;
+    double L1,P1,PC,P1_P2,P1_C1,gamma;
     int i;
     
     trace(4,"corrmeas:\n");
@@ -582,7 +750,7 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
     
     /* iono-free LC */
     if (opt->ionoopt==IONOOPT_IFLC) {
-        return ifmeas(obs,nav,azel,opt,dantr,dants,phw,meas,var);
+        return ifmeas(obs,nav,azel,opt,cs,phw,meas,var);
     }
     if (lam[0]==0.0||obs->L[0]==0.0||obs->P[0]==0.0) return 0;
     
@@ -593,32 +761,32 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
     
     /* dcb correction */
     gamma=SQR(lam[1]/lam[0]); /* f1^2/f2^2 */
-    P1_P2=nav->cbias[obs->sat-1][0];
-    P1_C1=nav->cbias[obs->sat-1][1];
-    if (P1_P2==0.0&&(satsys(obs->sat,NULL)&(SYS_GPS|SYS_GAL|SYS_QZS))) {
-        P1_P2=(1.0-gamma)*gettgd(obs->sat,nav);
-    }
+    P1_P2=cs->cbias[0];
+    P1_C1=cs->cbias[1];
     if (obs->code[0]==CODE_L1C) P1+=P1_C1; /* C1->P1 */
     PC=P1-P1_P2/(1.0-gamma);               /* P1->PC */
     
     /* slant ionospheric delay L1 (m) */
-    if (!corr_ion(obs->time,nav,obs->sat,pos,azel,opt->ionoopt,&ion,&vari,brk)) {
-        
+    if (!cs->ionstat) {
+        cs->ionstat=corr_ion(obs->time,nav,obs->sat,pos,azel,opt->ionoopt,
+                             &cs->ion,&cs->vari,brk)?1:-1;
+    }
+    if (cs->ionstat<0) {
         trace(2,"iono correction error: time=%s sat=%2d ionoopt=%d\n",
               time_str(obs->time,2),obs->sat,opt->ionoopt);
         return 0;
     }
     /* ionosphere and windup corrected phase and code */
-    meas[0]=L1+ion-lam[0]*phw;
-    meas[1]=PC-ion;
+    meas[0]=L1+cs->ion-lam[0]*phw;
+    meas[1]=PC-cs->ion;
     
-    var[0]+=vari;
-    var[1]+=vari+SQR(ERR_CBIAS);
+    var[0]+=cs->vari;
+    var[1]+=cs->vari+SQR(ERR_CBIAS);
     
     /* antenna phase center variation correction */
     for (i=0;i<2;i++) {
-        if (dants) meas[i]-=dants[0];
-        if (dantr) meas[i]-=dantr[0];
+        meas[i]-=cs->dants[0];
+        meas[i]-=cs->dantr[0];
     }
     return 1;
 }
@@ -746,6 +914,7 @@ static void detslp_gf(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 /* temporal update of phase biases -------------------------------------------*/
 static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
+    corrs_t cs,cs0={0};
     double meas[2],var[2],bias[MAXOBS]={0},offset=0.0,pos[3]={0};
     int i,j,k,sat,brk=0;
     
@@ -771,12 +940,14 @@ static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     for (i=k=0;i<n&&i<MAXOBS;i++) {
         sat=obs[i].sat;
         j=IB(sat,&rtk->opt);
-        if (!corrmeas(obs+i,nav,pos,rtk->ssat[sat-1].azel,&rtk->opt,NULL,NULL,
-                      0.0,meas,var,&brk)) continue;
+        cs=cs0;
+        satcbias(obs+i,nav,&rtk->opt,cs.cbias);
+        if (!corrmeas(obs+i,nav,pos,rtk->ssat[sat-1].azel,&rtk->opt,&cs,0.0,
+                      meas,var,&brk)) continue;
         
         if (brk) {
             rtk->ssat[sat-1].slip[0]=1;
-            trace(2,"%s: sat=%2d correction break\n",time_str(obs[i].time,0),sat);
+            if (TRACEON(2)) trace(2,"%s: sat=%2d correction break\n",time_str(obs[i].time,0),sat);
         }
         bias[i]=meas[0]-meas[1];
         if (rtk->x[j]==0.0||
@@ -847,44 +1018,78 @@ static void satantpcv(const double *rs, const double *rr, const pcv_t *pcv,
     
     antmodel_s(pcv,nadir,dant);
 }
-/* precise tropospheric model ------------------------------------------------*/
-static double prectrop(gtime_t time, const double *pos, const double *azel,
-                       const prcopt_t *opt, const double *x, double *dtdx,
-                       double *var)
+/* set site move to update correction cache -------------------------------------
+* set site move to update site terms of epoch correction cache in pppos()
+* args   : double dpos        I   site move to update cache (m)
+*                                 (0.0: site terms updated by filter iterations)
+* return : none
+* notes  : call before positioning. default is CORR_DPOS
+*-----------------------------------------------------------------------------*/
+extern void setpppcorrc(double dpos)
+{
+    trace(3,"setpppcorrc: dpos=%.3f\n",dpos);
+    
+    corr_dpos=dpos;
+}
+/* set reference position of correction cache --------------------------------
+* the zenith delay of a-priori troposphere model is linearized by site height
+* around the reference position. the other site terms are held while the site
+* moves less than CORR_DPOS, which changes the satellite directions by 5E-8 rad
+* and the corrections by less than 0.01 mm.
+*-----------------------------------------------------------------------------*/
+static void setcorrc(gtime_t time, const double *rr, const double *pos,
+                     const prcopt_t *opt, corrc_t *cc)
 {
     const double zazel[]={0.0,PI/2.0};
-    double zhd,m_h,m_w,cotz,grad_n,grad_e;
+    double posh[3];
+    int i;
     
-    /* zenith hydrostatic delay */
-    zhd=tropmodel(time,pos,zazel,0.0);
+    for (i=0;i<3;i++) {
+        cc->rr[i]=rr[i];
+        cc->pos[i]=posh[i]=pos[i];
+    }
+    posh[2]+=1.0;
+    cc->ipos++;
     
-    /* mapping function */
-    m_h=tropmapf(time,pos,azel,&m_w);
+    if (opt->tropopt==TROPOPT_SAAS) {
+        cc->zd[0]=tropmodel(time,pos,zazel,REL_HUMI);
+        cc->zd[1]=tropmodel(time,posh,zazel,REL_HUMI)-cc->zd[0];
+    }
+    else if (opt->tropopt>=TROPOPT_EST) {
+        tropinit(time,pos,&cc->trop);
+        cc->zd[0]=cc->trop.zhd;
+        cc->zd[1]=tropmodel(time,posh,zazel,0.0)-cc->zd[0];
+    }
+}
+/* precise tropospheric model ------------------------------------------------*/
+static double prectrop(const double *mapf, double zhd, const double *azel,
+                       const prcopt_t *opt, const double *x, double *dtdx,
+                       double *var)
+{
+    double m_w=mapf[1];
     
     if ((opt->tropopt==TROPOPT_ESTG||opt->tropopt==TROPOPT_CORG)&&azel[1]>0.0) {
         
         /* m_w=m_0+m_0*cot(el)*(Gn*cos(az)+Ge*sin(az)): ref [6] */
-        cotz=1.0/tan(azel[1]);
-        grad_n=m_w*cotz*cos(azel[0]);
-        grad_e=m_w*cotz*sin(azel[0]);
-        m_w+=grad_n*x[1]+grad_e*x[2];
-        dtdx[1]=grad_n*(x[0]-zhd);
-        dtdx[2]=grad_e*(x[0]-zhd);
+        m_w+=mapf[2]*x[1]+mapf[3]*x[2];
+        dtdx[1]=mapf[2]*(x[0]-zhd);
+        dtdx[2]=mapf[3]*(x[0]-zhd);
     }
     dtdx[0]=m_w;
     *var=SQR(0.01);
-    return m_h*zhd+m_w*(x[0]-zhd);
+    return mapf[0]*zhd+m_w*(x[0]-zhd);
 }
 /* phase and code residuals --------------------------------------------------*/
 static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
                    const double *dts, const double *vare, const int *svh,
-                   const nav_t *nav, const double *x, rtk_t *rtk, double *v,
-                   double *H, double *R, double *azel)
+                   const nav_t *nav, const double *x, rtk_t *rtk,
+                   corrc_t *cc, double *v, double *H, double *R, double *azel)
 {
     prcopt_t *opt=&rtk->opt;
-    double r,rr[3],disp[3],pos[3],e[3],meas[2],dtdx[3],dantr[NFREQ]={0};
-    double dants[NFREQ]={0},var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
-    int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt;
+    corrs_t *cs;
+    double r,rr[3],disp[3],pos[3],e[3],meas[2],dtdx[3],dr[3],dh,zd;
+    double var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
+    int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt,grad;
     
     trace(3,"res_ppp : n=%d nx=%d\n",n,nx);
     
@@ -896,14 +1101,24 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     if (opt->tidecorr) {
         tideopt=opt->tidecorr==1?1:7; /* 1:solid, 2:solid+otl+pole */
         
-        tidedisp(gpst2utc(obs[0].time),rr,tideopt,&nav->erp,opt->odisp[0],
-                 disp);
+        tidedispc(gpst2utc(obs[0].time),rr,tideopt,&nav->erp,opt->odisp[0],
+                  rtk->tidec,disp);
         for (i=0;i<3;i++) rr[i]+=disp[i];
     }
     ecef2pos(rr,pos);
     
+    /* update reference position of correction cache */
+    for (i=0;i<3;i++) dr[i]=rr[i]-cc->rr[i];
+    if (!cc->ipos||norm(dr,3)>corr_dpos) {
+        setcorrc(obs[0].time,rr,pos,opt,cc);
+    }
+    dh=pos[2]-cc->pos[2];
+    zd=cc->zd[0]+cc->zd[1]*dh;
+    grad=opt->tropopt==TROPOPT_ESTG||opt->tropopt==TROPOPT_CORG;
+    
     for (i=0;i<n&&i<MAXOBS;i++) {
         sat=obs[i].sat;
+        cs=cc->sat+i;
         if (!(sys=satsys(sat,NULL))||!rtk->ssat[sat-1].vs) continue;
         
         /* geometric distance/azimuth/elevation angle */
@@ -913,33 +1128,45 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
         /* excluded satellite? */
         if (satexclude(obs[i].sat,svh[i],opt)) continue;
         
+        /* code biases, satellite antenna model and phase windup of epoch */
+        if (!cs->stat) {
+            satcbias(obs+i,nav,opt,cs->cbias);
+            if (opt->posopt[0]) {
+                satantpcv(rs+i*6,rr,nav->pcvs+sat-1,cs->dants);
+            }
+            if (opt->posopt[2]) {
+                windupcorr(rtk->sol.time,rs+i*6,rr,&rtk->ssat[sat-1].phw);
+            }
+            cs->stat=1;
+        }
+        /* receiver antenna model, ionosphere and troposphere mapping at site */
+        if (cs->ipos!=cc->ipos) {
+            antmodel(opt->pcvr,opt->antdel[0],azel+i*2,opt->posopt[1],
+                     cs->dantr);
+            if (opt->tropopt>=TROPOPT_EST) {
+                tropmapfn(&cc->trop,azel+i*2,1,cs->mapf,cs->mapf+1,
+                          grad?cs->mapf+2:NULL);
+            }
+            cs->ionstat=0;
+            cs->ipos=cc->ipos;
+        }
         /* tropospheric delay correction */
         if (opt->tropopt==TROPOPT_SAAS) {
-            dtrp=tropmodel(obs[i].time,pos,azel+i*2,REL_HUMI);
+            dtrp=pos[2]<-100.0||1E4<pos[2]||azel[1+i*2]<=0.0?0.0:
+                 zd/cos(PI/2.0-azel[1+i*2]);
             vart=SQR(ERR_SAAS);
         }
         else if (opt->tropopt==TROPOPT_SBAS) {
             dtrp=sbstropcorr(obs[i].time,pos,azel+i*2,&vart);
         }
         else if (opt->tropopt==TROPOPT_EST||opt->tropopt==TROPOPT_ESTG) {
-            dtrp=prectrop(obs[i].time,pos,azel+i*2,opt,x+IT(opt),dtdx,&vart);
+            dtrp=prectrop(cs->mapf,zd,azel+i*2,opt,x+IT(opt),dtdx,&vart);
         }
         else if (opt->tropopt==TROPOPT_COR||opt->tropopt==TROPOPT_CORG) {
-            dtrp=prectrop(obs[i].time,pos,azel+i*2,opt,x,dtdx,&vart);
-        }
-        /* satellite antenna model */
-        if (opt->posopt[0]) {
-            satantpcv(rs+i*6,rr,nav->pcvs+sat-1,dants);
-        }
-        /* receiver antenna model */
-        antmodel(opt->pcvr,opt->antdel[0],azel+i*2,opt->posopt[1],dantr);
-        
-        /* phase windup correction */
-        if (opt->posopt[2]) {
-            windupcorr(rtk->sol.time,rs+i*6,rr,&rtk->ssat[sat-1].phw);
+            dtrp=prectrop(cs->mapf,zd,azel+i*2,opt,x,dtdx,&vart);
         }
         /* ionosphere and antenna phase corrected measurements */
-        if (!corrmeas(obs+i,nav,pos,azel+i*2,&rtk->opt,dantr,dants,
+        if (!corrmeas(obs+i,nav,pos,azel+i*2,&rtk->opt,cs,
                       rtk->ssat[sat-1].phw,meas,varm,&brk)) {
             continue;
         }
@@ -947,8 +1174,8 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
         r+=-CLIGHT*dts[i*2]+dtrp;
         
         trace(5,"sat=%2d azel=%6.1f %5.1f dtrp=%.3f dantr=%6.3f %6.3f dants=%6.3f %6.3f phw=%6.3f\n",
-              sat,azel[i*2]*R2D,azel[1+i*2]*R2D,dtrp,dantr[0],dantr[1],dants[0],
-              dants[1],rtk->ssat[sat-1].phw);
+              sat,azel[i*2]*R2D,azel[1+i*2]*R2D,dtrp,cs->dantr[0],cs->dantr[1],
+              cs->dants[0],cs->dants[1],rtk->ssat[sat-1].phw);
         
         for (j=0;j<2;j++) { /* for phase and code */
             
@@ -1015,13 +1242,19 @@ extern int pppnx(const prcopt_t *opt)
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
     const prcopt_t *opt=&rtk->opt;
-    double *rs,*dts,*var,*v,*H,*R,*azel,*xp,*Pp;
+    corrc_t *cc;
+    double *rs,*dts,*var,*v,*H,*R,*azel,*xp,*Pp,t;
     int i,nv,info,svh[MAXOBS],stat=SOLQ_SINGLE;
     
     trace(3,"pppos   : nx=%d n=%d\n",rtk->nx,n);
     
     rs=mat(6,n); dts=mat(2,n); var=mat(1,n); azel=zeros(2,n);
     
+    /* correction cache of the epoch shared by filter iterations */
+    if (!(cc=(corrc_t *)calloc(1,sizeof(corrc_t)))) {
+        free(rs); free(dts); free(var); free(azel);
+        return;
+    }
     for (i=0;i<MAXSAT;i++) rtk->ssat[i].fix[0]=0;
     
     /* temporal update of states */
@@ -1030,7 +1263,9 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     trace(4,"x(0)="); tracemat(4,rtk->x,1,NR(opt),13,4);
     
     /* satellite positions and clocks */
+    t=ticktime();
     satposs(obs[0].time,obs,n,nav,rtk->opt.sateph,rs,dts,var,svh);
+    profadd(rtk->prof+PROF_SATPOS,t);
     
     /* exclude measurements of eclipsing satellite */
     if (rtk->opt.posopt[3]) {
@@ -1043,12 +1278,17 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     for (i=0;i<rtk->opt.niter;i++) {
         
         /* phase and code residuals */
-        if ((nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel))<=0) break;
+        t=ticktime();
+        nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,cc,v,H,R,azel);
+        t=profadd(rtk->prof+PROF_ZDRES,t);
+        if (nv<=0) break;
         
         /* measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
+        info=filter(xp,Pp,H,v,R,rtk->nx,nv);
+        profadd(rtk->prof+PROF_FILTER,t);
         
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if (info) {
             trace(2,"ppp filter error %s info=%d\n",time_str(rtk->sol.time,0),
                   info);
             break;
@@ -1059,7 +1299,7 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     if (stat==SOLQ_PPP) {
         /* postfit residuals */
-        res_ppp(1,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel);
+        res_ppp(1,obs,n,rs,dts,var,svh,nav,xp,rtk,cc,v,H,R,azel);
         
         /* update state and covariance matrix */
         matcpy(rtk->x,xp,rtk->nx,1);
@@ -1067,7 +1307,9 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
         
         /* ambiguity resolution in ppp */
         if (opt->modear==ARMODE_PPPAR||opt->modear==ARMODE_PPPAR_ILS) {
+            t=ticktime();
             if (pppamb(rtk,obs,n,nav,azel)) stat=SOLQ_FIX;
+            profadd(rtk->prof+PROF_RESAMB,t);
         }
         /* update solution status */
         rtk->sol.ns=0;
@@ -1096,6 +1338,213 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
             if (rtk->ssat[i].slip[0]&3) rtk->ssat[i].slipc[0]++;
         }
     }
-    free(rs); free(dts); free(var); free(azel);
+    free(rs); free(dts); free(var); free(azel); free(cc);
     free(xp); free(Pp); free(v); free(H); free(R);
 }
+/* observation data of station at epoch --------------------------------------*/
+static int netobs(pppsta_t *sta, gtime_t time, obsd_t *obs)
+{
+    const obs_t *o=sta->obs;
+    int i,n=0,sat;
+    
+    for (i=sta->index;i<o->n;i++) {
+        if (timediff(o->data[i].time,time)>DTTOL) break;
+        sat=o->data[i].sat;
+        
+        /* exclude satellites */
+        if (!(satsys(sat,NULL)&sta->opt.navsys)||sta->opt.exsats[sat-1]==1) {
+            continue;
+        }
+        if (n<MAXOBS) obs[n++]=o->data[i];
+    }
+    sta->index=i;
+    return n;
+}
+/* process station of network ppp -------------------------------------------*/
+static void netsta(pppnet_t *net, int i)
+{
+    pppsta_t *sta=net->sta+i;
+    
+    if (net->nobs[i]<=0||
+        !rtkpos(&sta->rtk,net->obs+i*MAXOBS,net->nobs[i],net->nav)) return;
+    
+    if (sta->fp) {
+        outsol(sta->fp,&sta->rtk.sol,sta->rtk.rb,net->sopt);
+    }
+    if (sta->fp_stat&&sta->statlevel>0) {
+        pppoutsolstat(&sta->rtk,sta->statlevel,sta->fp_stat);
+    }
+    sta->nsol++;
+}
+/* process stations of epoch -------------------------------------------------*/
+static void netepoch(pppnet_t *net)
+{
+    int i;
+    
+    for (;;) {
+        lock(&net->lock);
+        i=net->next<net->nsta?net->next++:-1;
+        unlock(&net->lock);
+        if (i<0) break;
+        
+        netsta(net,i);
+        
+        lock(&net->lock);
+        net->ndone++;
+        signalcond(&net->cond);
+        unlock(&net->lock);
+    }
+}
+/* network ppp thread --------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI netthread(void *arg)
+#else
+static void *netthread(void *arg)
+#endif
+{
+    pppnet_t *net=(pppnet_t *)arg;
+    int epoch=0,e;
+    
+    for (;;) {
+        
+        /* wait for next epoch */
+        lock(&net->lock);
+        while (net->epoch==epoch) waitcond(&net->cond,&net->lock);
+        e=net->epoch;
+        unlock(&net->lock);
+        
+        if (e<0) break;
+        epoch=e;
+        netepoch(net);
+    }
+    return 0;
+}
+/* network precise point positioning -------------------------------------------
+* precise point positioning of multiple stations at common epochs. the station
+* filters are processed by a pool of threads.
+* args   : pppsta_t *sta    IO  stations
+*                               (obs,opt,fp,fp_stat,statlevel: input)
+*          int    nsta      I   number of stations
+*          gtime_t ts       I   processing start time (ts.time==0: no limit)
+*          gtime_t te       I   processing end time   (te.time==0: no limit)
+*          double ti        I   processing interval  (s) (0:all)
+*          nav_t  *nav      I   navigation data
+*          solopt_t *sopt   I   solution options
+*          int    nthread   I   number of threads
+* return : number of processed epochs (-1: error)
+* notes  : only the satellite-side data exact to share are set once per epoch
+*          by satstates() and pephstates(): selected broadcast ephemerides, sun
+*          direction for eclipse test, precise clock window and satellite
+*          antenna offsets in body frame. they are read by the stations without
+*          lock. satellite positions, clocks and antenna offsets in ecef depend
+*          on the signal transmission time at the station and are computed by
+*          each station, so that the solutions are the same as those by
+*          rtkpos() of the stations one by one.
+*          sta->rtk is initialized by sta->opt and freed at the end. solution
+*          status is output to the stream of the station instead of the file by
+*          rtkopenstat().
+*-----------------------------------------------------------------------------*/
+extern int pppnet(pppsta_t *sta, int nsta, gtime_t ts, gtime_t te, double ti,
+                  const nav_t *nav, const solopt_t *sopt, int nthread)
+{
+    pppnet_t net={0};
+    thread_t thr[MAXNETTHR];
+    satsts_t *sats;
+    nav_t *navs;
+    gtime_t time,t;
+    int i,n,nthr,nep=0;
+    
+    trace(3,"pppnet  : nsta=%d nthread=%d\n",nsta,nthread);
+    
+    if (nsta<=0) return 0;
+    
+    sats=(satsts_t *)calloc(1,sizeof(satsts_t));
+    navs=(nav_t *)malloc(sizeof(nav_t));
+    net.obs=(obsd_t *)malloc(sizeof(obsd_t)*nsta*MAXOBS);
+    net.nobs=(int *)calloc(nsta,sizeof(int));
+    
+    if (!sats||!navs||!net.obs||!net.nobs) {
+        free(sats); free(navs); free(net.obs); free(net.nobs);
+        return -1;
+    }
+    *navs=*nav;
+    navs->sats=sats;
+    net.sta=sta;
+    net.nsta=nsta;
+    net.nav=navs;
+    net.sopt=sopt;
+    initlock(&net.lock);
+    initcond(&net.cond);
+    
+    for (i=0;i<nsta;i++) {
+        rtkinit(&sta[i].rtk,&sta[i].opt);
+        sta[i].index=sta[i].nsol=0;
+    }
+    /* start station threads (the calling thread is also used) */
+    nthr=MIN(MIN(nthread,MAXNETTHR+1),nsta)-1;
+    
+    for (i=n=0;i<nthr;i++) {
+#ifdef WIN32
+        if (!(thr[i]=CreateThread(NULL,0,netthread,&net,0,NULL))) break;
+#else
+        if (pthread_create(thr+i,NULL,netthread,&net)) break;
+#endif
+        n++;
+    }
+    for (;;) {
+        
+        /* next epoch of stations */
+        time.time=0; time.sec=0.0;
+        for (i=0;i<nsta;i++) {
+            if (sta[i].index>=sta[i].obs->n) continue;
+            t=sta[i].obs->data[sta[i].index].time;
+            if (time.time==0||timediff(t,time)<0.0) time=t;
+        }
+        if (time.time==0||(te.time&&timediff(time,te)>=DTTOL)) break;
+        
+        for (i=0;i<nsta;i++) {
+            net.nobs[i]=netobs(sta+i,time,net.obs+i*MAXOBS);
+        }
+        if (!screent(time,ts,te,ti)) continue;
+        
+        /* satellite states of epoch */
+        for (i=0;i<nsta;i++) {
+            satstates(time,net.obs+i*MAXOBS,net.nobs[i],nav,sats);
+        }
+        pephstates(time,nav,sats);
+        sundir(time,sats->esun);
+        
+        /* process stations by threads */
+        lock(&net.lock);
+        net.next=net.ndone=0;
+        net.epoch++;
+        signalcond(&net.cond);
+        unlock(&net.lock);
+        
+        netepoch(&net);
+        
+        /* wait for end of stations */
+        lock(&net.lock);
+        while (net.ndone<nsta) waitcond(&net.cond,&net.lock);
+        unlock(&net.lock);
+        nep++;
+    }
+    lock(&net.lock);
+    net.epoch=-1;
+    signalcond(&net.cond);
+    unlock(&net.lock);
+    
+    for (i=0;i<n;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thr[i],INFINITE);
+        CloseHandle(thr[i]);
+#else
+        pthread_join(thr[i],NULL);
+#endif
+    }
+    for (i=0;i<nsta;i++) rtkfree(&sta[i].rtk);
+    
+    freepsat(&sats->clkw.win);
+    free(sats); free(navs); free(net.obs); free(net.nobs);
+    return nep;
+}
@@ -434,7 +434,7 @@ extern int pppamb(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav,
     
     if (n<=0||rtk->opt.ionoopt!=IONOOPT_IFLC||rtk->opt.nf<2) return 0;
     
-    trace(3,"pppamb: time=%s n=%d\n",time_str(obs[0].time,0),n);
+    if (TRACEON(3)) trace(3,"pppamb: time=%s n=%d\n",time_str(obs[0].time,0),n);
     
     elmask=rtk->opt.elmaskar>0.0?rtk->opt.elmaskar:rtk->opt.elmin;
     
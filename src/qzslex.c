@@ -77,7 +77,7 @@ static int decode_lexhealth(const unsigned char *buff, int i, gtime_t tof,
     int j,sat;
     unsigned char health;
     
-    trace(3,"decode_lexhealth: tof=%s\n",time_str(tof,0));
+    if (TRACEON(3)) trace(3,"decode_lexhealth: tof=%s\n",time_str(tof,0));
     
     for (j=0;j<35;j++) {
         health=getbitu(buff,i,5); i+= 5;
@@ -102,7 +102,7 @@ static int decode_lexeph(const unsigned char *buff, int i, gtime_t toe,
     unsigned char health;
     int j,prn,sat;
     
-    trace(3,"decode_lexeph: toe=%s\n",time_str(toe,0));
+    if (TRACEON(3)) trace(3,"decode_lexeph: toe=%s\n",time_str(toe,0));
     
     prn        =getbitu(buff,i, 8);       i+= 8;
     eph.ura    =getbitu(buff,i, 4);       i+= 4;
@@ -157,7 +157,7 @@ static int decode_lexion(const unsigned char *buff, int i, gtime_t tof,
     lexion_t ion={{0}};
     int tow,week;
     
-    trace(3,"decode_lexion: tof=%s\n",time_str(tof,0));
+    if (TRACEON(3)) trace(3,"decode_lexion: tof=%s\n",time_str(tof,0));
     
     tow=getbitu(buff,i,20); i+=20;
     
@@ -549,14 +549,14 @@ extern int lexeph2pos(gtime_t time, int sat, const nav_t *nav, double *rs,
     double t,t2,t3;
     int i;
     
-    trace(3,"lexsatpos: time=%s sat=%2d\n",time_str(time,3),sat);
+    if (TRACEON(3)) trace(3,"lexsatpos: time=%s sat=%2d\n",time_str(time,3),sat);
     
     if (!sat) return 0;
     
     eph=nav->lexeph+sat-1;
     
     if (eph->sat!=sat||eph->toe.time==0) {
-         trace(2,"no lex ephemeris: time=%s sat=%2d\n",time_str(time,0),sat);
+         if (TRACEON(2)) trace(2,"no lex ephemeris: time=%s sat=%2d\n",time_str(time,0),sat);
          return 0;
     }
     if (fabs(t=timediff(time,eph->toe))>LEXEPHMAXAGE) {
@@ -665,7 +665,7 @@ extern int lexioncorr(gtime_t time, const nav_t *nav, const double *pos,
         trace(5,"lexioncorr: F=%8.3f Enm[%d][%d]=%8.3f delay=%8.3f\n",F,n,m,Enm,
               F*Enm*pow(dlat,n)*pow(dlon,m));
     }
-    trace(4,"lexioncorr: time=%s delay=%.3f\n",time_str(time,0),*delay);
+    if (TRACEON(4)) trace(4,"lexioncorr: time=%s delay=%.3f\n",time_str(time,0),*delay);
     
     return 1;
 }
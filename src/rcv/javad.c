@@ -280,7 +280,7 @@ static int decode_RT(raw_t *raw)
     if (raw->tbase>=1) time=utc2gpst(time); /* utc->gpst */
     raw->time=time;
     
-    trace(3,"decode_RT: time=%s\n",time_str(time,3));
+    if (TRACEON(3)) trace(3,"decode_RT: time=%s\n",time_str(time,3));
     
     if (raw->outtype) {
         msg=raw->msgtype+strlen(raw->msgtype);
@@ -342,7 +342,7 @@ static int decode_RD(raw_t *raw)
     raw->time=timeadd(epoch2time(ep),raw->tod*0.001);
     if (raw->tbase>=1) raw->time=utc2gpst(raw->time); /* utc->gpst */
     
-    trace(3,"decode_RD: time=%s\n",time_str(raw->time,3));
+    if (TRACEON(3)) trace(3,"decode_RD: time=%s\n",time_str(raw->time,3));
     
     return 0;
 }
@@ -1642,7 +1642,7 @@ static int decode_TC(raw_t *raw)
         sat=raw->obuf.data[i].sat;
         tt_p=(unsigned short)raw->lockt[sat-1][0];
         
-        trace(4,"%s: sat=%2d tt=%6d->%6d\n",time_str(raw->time,3),sat,tt_p,tt);
+        if (TRACEON(4)) trace(4,"%s: sat=%2d tt=%6d->%6d\n",time_str(raw->time,3),sat,tt_p,tt);
         
         /* loss-of-lock detected by lock-time counter */
         if (tt==0||tt<tt_p) {
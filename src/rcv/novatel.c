@@ -944,7 +944,7 @@ static int decode_galfnavrawpageb(raw_t *raw)
     }
     page=getbitu(buff,0,6);
     
-    trace(3,"%s E%2d FNAV     (%2d) ",time_str(raw->time,0),satid,page);
+    if (TRACEON(3)) trace(3,"%s E%2d FNAV     (%2d) ",time_str(raw->time,0),satid,page);
     traceb(3,buff,27);
     
     return 0;
@@ -983,7 +983,7 @@ static int decode_galinavrawwordb(raw_t *raw)
         tow =getbitu(buff,108,20);
         time=gst2time(week,tow);
     }
-    trace(3,"%s E%2d INAV-%s (%2d) ",time_str(time,0),satid,sig,type);
+    if (TRACEON(3)) trace(3,"%s E%2d INAV-%s (%2d) ",time_str(time,0),satid,sig,type);
     traceb(3,buff,16);
     
     return 0;
@@ -1008,7 +1008,7 @@ static int decode_rawcnavframeb(raw_t *raw)
     for (i=0;i<38;i++) {
         buff[i]=U1(p); p+=1;
     }
-    trace(3,"%s PRN=%3d FRMID=%2d ",time_str(raw->time,0),prn,frmid);
+    if (TRACEON(3)) trace(3,"%s PRN=%3d FRMID=%2d ",time_str(raw->time,0),prn,frmid);
     traceb(3,buff,38);
     
     return 0;
@@ -55,6 +55,7 @@
 *                           fix bug on week handover in decode_trkmeas/trkd5()
 *                           fix bug on prn for geo in decode_cnav()
 *           2017/06/10 1.24 output half-cycle-subtracted flag
+*           2026/10/19 1.25 thread local adr of TRK-MEAS and TRK-TRKD5
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -493,7 +494,7 @@ static int decode_navtime(raw_t *raw)
 /* decode ubx-trk-meas: trace measurement data -------------------------------*/
 static int decode_trkmeas(raw_t *raw)
 {
-    static double adrs[MAXSAT]={0};
+    static THREADLOCAL double adrs[MAXSAT]={0};
     gtime_t time;
     double ts,tr=-1.0,t,tau,utc_gpst,snr,adr,dop;
     int i,j,n=0,nch,sys,prn,sat,qi,frq,flag,lock1,lock2,week;
@@ -614,7 +615,7 @@ static int decode_trkmeas(raw_t *raw)
 /* decode ubx-trkd5: trace measurement data ----------------------------------*/
 static int decode_trkd5(raw_t *raw)
 {
-    static double adrs[MAXSAT]={0};
+    static THREADLOCAL double adrs[MAXSAT]={0};
     gtime_t time;
     double ts,tr=-1.0,t,tau,adr,dop,snr,utc_gpst;
     int i,j,n=0,type,off,len,sys,prn,sat,qi,frq,flag,week;
@@ -650,7 +651,7 @@ static int decode_trkd5(raw_t *raw)
     else if (tr>t+302400.0) week--;
     time=gpst2time(week,tr);
     
-    trace(4,"time=%s\n",time_str(time,0));
+    if (TRACEON(4)) trace(4,"time=%s\n",time_str(time,0));
     
     for (i=0,p=raw->buff+off;p-raw->buff<raw->len-2;i++,p+=len) {
         
@@ -81,6 +81,9 @@
 *           2014/08/29 1.22 fix bug on reading gps "C2" in rinex 2.11 or 2.12
 *           2014/10/20 1.23 recognize "C2" in 2.12 as "C2W" instead of "C2D"
 *           2014/12/07 1.24 add read rinex option -SYS=...
+*           2026/10/19 1.25 set satellite-major precise clock in readrnxc()
+*                           format rinex obs/nav body by fixed-width formatter
+*                           use fmtfix(),fmtint() of rtkcmn.c
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -96,6 +99,7 @@ static const char rcsid[]="$Id:$";
 #define MINFREQ_GLO -7                  /* min frequency number glonass */
 #define MAXFREQ_GLO 13                  /* max frequency number glonass */
 #define NINCOBS     262144              /* inclimental number of obs data */
+#define RNXOBSBUFF  16384               /* rinex obs output buffer size */
 
 static const int navsys[]={             /* satellite systems */
     SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP,0
@@ -672,7 +676,7 @@ static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
             return 0;
         }
     }
-    trace(4,"decode_obsepoch: time=%s flag=%d\n",time_str(*time,3),*flag);
+    if (TRACEON(4)) trace(4,"decode_obsepoch: time=%s flag=%d\n",time_str(*time,3),*flag);
     return n;
 }
 /* decode obs data -----------------------------------------------------------*/
@@ -780,7 +784,7 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
             case 3: obs->SNR[p[i]]=(unsigned char)(val[i]*4.0+0.5);    break;
         }
     }
-    trace(4,"decode_obsdata: time=%s sat=%2d\n",time_str(obs->time,0),obs->sat);
+    if (TRACEON(4)) trace(4,"decode_obsdata: time=%s sat=%2d\n",time_str(obs->time,0),obs->sat);
     return 1;
 }
 /* save slips ----------------------------------------------------------------*/
@@ -1575,6 +1579,8 @@ static void combpclk(nav_t *nav)
 * args   : char *file    I      file (wild-card * expanded)
 *          nav_t *nav    IO     navigation data    (NULL: no input)
 * return : number of precise clock
+* notes  : precise clock is appended and combined, and set to satellite-major
+*          precise clock (nav->pclks) also
 *-----------------------------------------------------------------------------*/
 extern int readrnxc(const char *file, nav_t *nav)
 {
@@ -1592,6 +1598,9 @@ extern int readrnxc(const char *file, nav_t *nav)
     /* expand wild-card */
     n=expath(file,files,MAXEXFILE);
     
+    /* restore precise clock released after reading to append */
+    if (nav->nc<=0&&nav->pclks.n>0) psat2pclk(&nav->pclks,nav);
+    
     /* read rinex clock files */
     for (i=0;i<n;i++) {
         if (readrnxfile(files[i],t,t,0.0,"",1,index++,&type,NULL,nav,NULL)) {
@@ -1607,6 +1616,9 @@ extern int readrnxc(const char *file, nav_t *nav)
     /* unique and combine ephemeris and precise clock */
     combpclk(nav);
     
+    /* set satellite-major precise clock */
+    if (nav->nc>0) pclk2psat(nav->pclk,nav->nc,&nav->pclks);
+    
     return nav->nc;
 }
 /* initialize rinex control ----------------------------------------------------
@@ -1918,12 +1930,63 @@ extern int outrnxobsh(FILE *fp, const rnxopt_t *opt, const nav_t *nav)
     }
     return fprintf(fp,"%-60.60s%-20s\n","","END OF HEADER")!=EOF;
 }
-/* output obs data field -----------------------------------------------------*/
-static void outrnxobsf(FILE *fp, double obs, int lli)
+/* format string as sprintf(p,"%-*s",w,str) ----------------------------------*/
+static char *fmts(char *p, const char *str, int w)
+{
+    for (;*str;w--) *p++=*str++;
+    for (;w>0;w--) *p++=' ';
+    *p='\0';
+    return p;
+}
+/* format obs data field (F14.3,I1,1X) ---------------------------------------*/
+static char *fmtobsf(char *p, double obs, int lli)
 {
-    if (obs==0.0||obs<=-1E9||obs>=1E9) fprintf(fp,"              ");
-    else fprintf(fp,"%14.3f",obs);
-    if (lli<=0) fprintf(fp,"  "); else fprintf(fp,"%1.1d ",lli);
+    if (obs==0.0||obs<=-1E9||obs>=1E9) p=fmts(p,"",14);
+    else p=fmtfix(p,obs,14,3,0);
+    if (lli<=0) p=fmts(p,"",2);
+    else if (lli<10) {*p++=(char)('0'+lli); *p++=' ';}
+    else p+=sprintf(p,"%1.1d ",lli);
+    return p;
+}
+/* format nav data field (1X,D19.12) -------------------------------------------
+* format as sprintf(p," %s.%012.0fE%+03.0f",...) of outnavf() with integer
+* arithmetic. mantissas at rounding ties fall back to sprintf.
+*-----------------------------------------------------------------------------*/
+static char *fmtnavf(char *p, double value)
+{
+    double e=fabs(value)<1E-99?0.0:floor(log10(fabs(value))+1.0);
+    double m=fabs(value)/pow(10.0,e-12.0),r,hi;
+    
+    if (e!=e||fabs(e)>=100.0||!(m<1E13)||m-floor(m)==0.5) {
+        return p+sprintf(p," %s.%012.0fE%+03.0f",value<0.0?"-":" ",m,e);
+    }
+    r=floor(m+0.5);
+    hi=floor(r/1E6);
+    *p++=' ';
+    *p++=value<0.0?'-':' ';
+    *p++='.';
+    p=fmtint(p,(int)hi,6,1);
+    p=fmtint(p,(int)(r-hi*1E6),6,1);
+    *p++='E';
+    *p++=e<0.0?'-':'+';
+    return fmtint(p,(int)fabs(e),2,1);
+}
+/* format nav epoch ------------------------------------------------------------
+* format nav epoch following satellite id as " %04.0f %2.0f %2.0f %2.0f %2.0f
+* %2.0f" (ver3!=0) or " %02d %2.0f %2.0f %2.0f %2.0f %4.1f" (ver3=0)
+*-----------------------------------------------------------------------------*/
+static char *fmtnavep(char *p, const double *ep, int ver3)
+{
+    int i;
+    
+    *p++=' ';
+    if (ver3) p=fmtfix(p,ep[0],4,0,1); else p=fmtint(p,(int)ep[0]%100,2,1);
+    for (i=1;i<5;i++) {
+        *p++=' ';
+        p=fmtfix(p,ep[i],2,0,0);
+    }
+    *p++=' ';
+    return ver3?fmtfix(p,ep[5],2,0,0):fmtfix(p,ep[5],4,1,0);
 }
 /* search obs data index -----------------------------------------------------*/
 static int obsindex(double ver, int sys, const unsigned char *code,
@@ -2001,8 +2064,8 @@ extern int outrnxobsb(FILE *fp, const rnxopt_t *opt, const obsd_t *obs, int n,
 {
     const char *mask;
     double ep[6];
-    char sats[MAXOBS][4]={""};
-    int i,j,k,m,ns,sys,ind[MAXOBS],s[MAXOBS]={0};
+    char sats[MAXOBS][4]={""},buff[RNXOBSBUFF],*p=buff;
+    int i,j,k,m,ns,sys,ind[MAXOBS],s[MAXOBS]={0},stat=1;
     
     trace(3,"outrnxobsb: n=%d\n",n);
     
@@ -2024,60 +2087,84 @@ extern int outrnxobsb(FILE *fp, const rnxopt_t *opt, const obsd_t *obs, int n,
         ind[ns++]=i;
     }
     if (opt->rnxver<=2.99) { /* ver.2 */
-        fprintf(fp," %02d %2.0f %2.0f %2.0f %2.0f%11.7f  %d%3d",
-                (int)ep[0]%100,ep[1],ep[2],ep[3],ep[4],ep[5],flag,ns);
+        p=fmts(p," ",1);
+        p=fmtint(p,(int)ep[0]%100,2,1); p=fmts(p," ",1);
+        p=fmtfix(p,ep[1],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[2],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[3],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[4],2,0,0);
+        p=fmtfix(p,ep[5],11,7,0); p=fmts(p," ",2);
+        p=fmtint(p,flag,1,0);
+        p=fmtint(p,ns,3,0);
         for (i=0;i<ns;i++) {
-            if (i>0&&i%12==0) fprintf(fp,"\n%32s","");
-            fprintf(fp,"%-3s",sats[i]);
+            if (i>0&&i%12==0) p=fmts(fmts(p,"\n",1),"",32);
+            p=fmts(p,sats[i],3);
         }
     }
     else { /* ver.3 */
-        fprintf(fp,"> %04.0f %2.0f %2.0f %2.0f %2.0f%11.7f  %d%3d%21s\n",
-                ep[0],ep[1],ep[2],ep[3],ep[4],ep[5],flag,ns,"");
+        p=fmts(p,"> ",2);
+        p=fmtfix(p,ep[0],4,0,1); p=fmts(p," ",1);
+        p=fmtfix(p,ep[1],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[2],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[3],2,0,0); p=fmts(p," ",1);
+        p=fmtfix(p,ep[4],2,0,0);
+        p=fmtfix(p,ep[5],11,7,0); p=fmts(p," ",2);
+        p=fmtint(p,flag,1,0);
+        p=fmtint(p,ns,3,0);
+        p=fmts(p,"",21); p=fmts(p,"\n",1);
     }
     for (i=0;i<ns;i++) {
         sys=satsys(obs[ind[i]].sat,NULL);
         
+        /* flush output buffer */
+        if (p-buff>RNXOBSBUFF-2*MAXRNXLEN) {
+            if (fwrite(buff,p-buff,1,fp)<1) stat=0;
+            p=buff;
+        }
         if (opt->rnxver<=2.99) { /* ver.2 */
             m=0;
             mask=opt->mask[s[i]];
         }
         else { /* ver.3 */
-            fprintf(fp,"%-3s",sats[i]);
+            p=fmts(p,sats[i],3);
             m=s[i];
             mask=opt->mask[s[i]];
         }
         for (j=0;j<opt->nobs[m];j++) {
             
             if (opt->rnxver<=2.99) { /* ver.2 */
-                if (j%5==0) fprintf(fp,"\n");
+                if (j%5==0) p=fmts(p,"\n",1);
             }
             /* search obs data index */
             if ((k=obsindex(opt->rnxver,sys,obs[ind[i]].code,opt->tobs[m][j],
                             mask))<0) {
-                outrnxobsf(fp,0.0,-1);
+                p=fmtobsf(p,0.0,-1);
                 continue;
             }
             /* output field */
             switch (opt->tobs[m][j][0]) {
                 case 'C':
-                case 'P': outrnxobsf(fp,obs[ind[i]].P[k],-1); break;
-                case 'L': outrnxobsf(fp,obs[ind[i]].L[k],obs[ind[i]].LLI[k]); break;
-                case 'D': outrnxobsf(fp,obs[ind[i]].D[k],-1); break;
-                case 'S': outrnxobsf(fp,obs[ind[i]].SNR[k]*0.25,-1); break;
+                case 'P': p=fmtobsf(p,obs[ind[i]].P[k],-1); break;
+                case 'L': p=fmtobsf(p,obs[ind[i]].L[k],obs[ind[i]].LLI[k]); break;
+                case 'D': p=fmtobsf(p,obs[ind[i]].D[k],-1); break;
+                case 'S': p=fmtobsf(p,obs[ind[i]].SNR[k]*0.25,-1); break;
             }
         }
-        if (opt->rnxver>2.99&&fprintf(fp,"\n")==EOF) return 0;
+        if (opt->rnxver>2.99) p=fmts(p,"\n",1);
     }
-    if (opt->rnxver>2.99) return 1;
+    if (opt->rnxver<=2.99) p=fmts(p,"\n",1);
     
-    return fprintf(fp,"\n")!=EOF;
+    if (fwrite(buff,p-buff,1,fp)<1) stat=0;
+    
+    return stat;
 }
 /* output nav member by rinex nav format -------------------------------------*/
 static void outnavf(FILE *fp, double value)
 {
-    double e=fabs(value)<1E-99?0.0:floor(log10(fabs(value))+1.0);
-    fprintf(fp," %s.%012.0fE%+03.0f",value<0.0?"-":" ",fabs(value)/pow(10.0,e-12.0),e);
+    char buff[64];
+    
+    fmtnavf(buff,value);
+    fputs(buff,fp);
 }
 /* output rinex nav header -----------------------------------------------------
 * output rinex nav file header
@@ -2206,7 +2293,7 @@ extern int outrnxnavb(FILE *fp, const rnxopt_t *opt, const eph_t *eph)
 {
     double ep[6],ttr;
     int week,sys,prn;
-    char code[32],*sep;
+    char code[32],*sep,buff[1024],*p=buff;
     
     trace(3,"outrnxgnavb: sat=%2d\n",eph->sat);
     
@@ -2220,66 +2307,63 @@ extern int outrnxnavb(FILE *fp, const rnxopt_t *opt, const eph_t *eph)
     }
     if (opt->rnxver>2.99||sys==SYS_GAL||sys==SYS_CMP) { /* ver.3 or ver.2 GAL */
         if (!sat2code(eph->sat,code)) return 0;
-        fprintf(fp,"%-3s %04.0f %2.0f %2.0f %2.0f %2.0f %2.0f",code,ep[0],ep[1],
-                ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmts(p,code,3),ep,1);
         sep="    ";
     }
     else if (sys==SYS_QZS) { /* ver.2 or ver.3.02 QZS */
         if (!sat2code(eph->sat,code)) return 0;
-        fprintf(fp,"%-3s %02d %2.0f %2.0f %2.0f %2.0f %4.1f",code,
-                (int)ep[0]%100,ep[1],ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmts(p,code,3),ep,0);
         sep="    ";
     }
     else {
-        fprintf(fp,"%2d %02d %2.0f %2.0f %2.0f %2.0f %4.1f",prn,
-                (int)ep[0]%100,ep[1],ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmtint(p,prn,2,0),ep,0);
         sep="   ";
     }
-    outnavf(fp,eph->f0     );
-    outnavf(fp,eph->f1     );
-    outnavf(fp,eph->f2     );
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,eph->iode   ); /* GPS/QZS: IODE, GAL: IODnav, BDS: AODE */
-    outnavf(fp,eph->crs    );
-    outnavf(fp,eph->deln   );
-    outnavf(fp,eph->M0     );
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,eph->cuc    );
-    outnavf(fp,eph->e      );
-    outnavf(fp,eph->cus    );
-    outnavf(fp,sqrt(eph->A));
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,eph->toes   );
-    outnavf(fp,eph->cic    );
-    outnavf(fp,eph->OMG0   );
-    outnavf(fp,eph->cis    );
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,eph->i0     );
-    outnavf(fp,eph->crc    );
-    outnavf(fp,eph->omg    );
-    outnavf(fp,eph->OMGd   );
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,eph->idot   );
-    outnavf(fp,eph->code   );
-    outnavf(fp,eph->week   ); /* GPS/QZS: GPS week, GAL: GAL week, BDS: BDT week */
-    outnavf(fp,eph->flag   );
-    fprintf(fp,"\n%s",sep  );
-    
-    outnavf(fp,uravalue(eph->sva));
-    outnavf(fp,eph->svh    );
-    outnavf(fp,eph->tgd[0] ); /* GPS/QZS:TGD, GAL:BGD E5a/E1, BDS: TGD1 B1/B3 */
+    p=fmtnavf(p,eph->f0     );
+    p=fmtnavf(p,eph->f1     );
+    p=fmtnavf(p,eph->f2     );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,eph->iode   ); /* GPS/QZS: IODE, GAL: IODnav, BDS: AODE */
+    p=fmtnavf(p,eph->crs    );
+    p=fmtnavf(p,eph->deln   );
+    p=fmtnavf(p,eph->M0     );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,eph->cuc    );
+    p=fmtnavf(p,eph->e      );
+    p=fmtnavf(p,eph->cus    );
+    p=fmtnavf(p,sqrt(eph->A));
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,eph->toes   );
+    p=fmtnavf(p,eph->cic    );
+    p=fmtnavf(p,eph->OMG0   );
+    p=fmtnavf(p,eph->cis    );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,eph->i0     );
+    p=fmtnavf(p,eph->crc    );
+    p=fmtnavf(p,eph->omg    );
+    p=fmtnavf(p,eph->OMGd   );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,eph->idot   );
+    p=fmtnavf(p,eph->code   );
+    p=fmtnavf(p,eph->week   ); /* GPS/QZS: GPS week, GAL: GAL week, BDS: BDT week */
+    p=fmtnavf(p,eph->flag   );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,uravalue(eph->sva));
+    p=fmtnavf(p,eph->svh    );
+    p=fmtnavf(p,eph->tgd[0] ); /* GPS/QZS:TGD, GAL:BGD E5a/E1, BDS: TGD1 B1/B3 */
     if (sys==SYS_GAL||sys==SYS_CMP) {
-        outnavf(fp,eph->tgd[1]); /* GAL:BGD E5b/E1, BDS: TGD2 B2/B3 */
+        p=fmtnavf(p,eph->tgd[1]); /* GAL:BGD E5b/E1, BDS: TGD2 B2/B3 */
     }
     else {
-        outnavf(fp,eph->iodc);   /* GPS/QZS:IODC */
+        p=fmtnavf(p,eph->iodc);   /* GPS/QZS:IODC */
     }
-    fprintf(fp,"\n%s",sep  );
+    p=fmts(fmts(p,"\n",1),sep,0);
     
     if (sys!=SYS_CMP) {
         ttr=time2gpst(eph->ttr,&week);
@@ -2287,18 +2371,20 @@ extern int outrnxnavb(FILE *fp, const rnxopt_t *opt, const eph_t *eph)
     else {
         ttr=time2bdt(gpst2bdt(eph->ttr),&week); /* gpst -> bdt */
     }
-    outnavf(fp,ttr+(week-eph->week)*604800.0);
+    p=fmtnavf(p,ttr+(week-eph->week)*604800.0);
     
     if (sys==SYS_GPS||sys==SYS_QZS) {
-        outnavf(fp,eph->fit);
+        p=fmtnavf(p,eph->fit);
     }
     else if (sys==SYS_CMP) {
-        outnavf(fp,eph->iodc); /* AODC */
+        p=fmtnavf(p,eph->iodc); /* AODC */
     }
     else {
-        outnavf(fp,0.0); /* spare */
+        p=fmtnavf(p,0.0); /* spare */
     }
-    return fprintf(fp,"\n")!=EOF;
+    p=fmts(p,"\n",1);
+    
+    return fwrite(buff,p-buff,1,fp)==1;
 }
 /* output rinex gnav header ----------------------------------------------------
 * output rinex gnav (glonass navigation) file header
@@ -2345,7 +2431,7 @@ extern int outrnxgnavb(FILE *fp, const rnxopt_t *opt, const geph_t *geph)
     gtime_t toe;
     double ep[6],tof;
     int prn;
-    char code[32],*sep;
+    char code[32],*sep,buff[1024],*p=buff;
     
     trace(3,"outrnxgnavb: sat=%2d\n",geph->sat);
     
@@ -2358,39 +2444,39 @@ extern int outrnxgnavb(FILE *fp, const rnxopt_t *opt, const geph_t *geph)
     time2epoch(toe,ep);
     
     if (opt->rnxver<=2.99) { /* ver.2 */
-        fprintf(fp,"%2d %02d %2.0f %2.0f %2.0f %2.0f %4.1f",prn,(int)ep[0]%100,
-                ep[1],ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmtint(p,prn,2,0),ep,0);
         sep="   ";
     }
     else { /* ver.3 */
         if (!sat2code(geph->sat,code)) return 0;
-        fprintf(fp,"%-3s %04.0f %2.0f %2.0f %2.0f %2.0f %2.0f",code,ep[0],ep[1],
-                ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmts(p,code,3),ep,1);
         sep="    ";
     }
-    outnavf(fp,-geph->taun     );
-    outnavf(fp,geph->gamn      );
-    outnavf(fp,tof             );
-    fprintf(fp,"\n%s",sep      );
-    
-    outnavf(fp,geph->pos[0]/1E3);
-    outnavf(fp,geph->vel[0]/1E3);
-    outnavf(fp,geph->acc[0]/1E3);
-    outnavf(fp,geph->svh       );
-    fprintf(fp,"\n%s",sep      );
-    
-    outnavf(fp,geph->pos[1]/1E3);
-    outnavf(fp,geph->vel[1]/1E3);
-    outnavf(fp,geph->acc[1]/1E3);
-    outnavf(fp,geph->frq       );
-    fprintf(fp,"\n%s",sep      );
-    
-    outnavf(fp,geph->pos[2]/1E3);
-    outnavf(fp,geph->vel[2]/1E3);
-    outnavf(fp,geph->acc[2]/1E3);
-    outnavf(fp,geph->age       );
-    
-    return fprintf(fp,"\n")!=EOF;
+    p=fmtnavf(p,-geph->taun     );
+    p=fmtnavf(p,geph->gamn      );
+    p=fmtnavf(p,tof             );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,geph->pos[0]/1E3);
+    p=fmtnavf(p,geph->vel[0]/1E3);
+    p=fmtnavf(p,geph->acc[0]/1E3);
+    p=fmtnavf(p,geph->svh       );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,geph->pos[1]/1E3);
+    p=fmtnavf(p,geph->vel[1]/1E3);
+    p=fmtnavf(p,geph->acc[1]/1E3);
+    p=fmtnavf(p,geph->frq       );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,geph->pos[2]/1E3);
+    p=fmtnavf(p,geph->vel[2]/1E3);
+    p=fmtnavf(p,geph->acc[2]/1E3);
+    p=fmtnavf(p,geph->age       );
+    
+    p=fmts(p,"\n",1);
+    
+    return fwrite(buff,p-buff,1,fp)==1;
 }
 /* output rinex geo nav header -------------------------------------------------
 * output rinex geo nav file header
@@ -2436,7 +2522,7 @@ extern int outrnxhnavb(FILE *fp, const rnxopt_t *opt, const seph_t *seph)
 {
     double ep[6];
     int prn;
-    char code[32],*sep;
+    char code[32],*sep,buff[1024],*p=buff;
     
     trace(3,"outrnxhnavb: sat=%2d\n",seph->sat);
     
@@ -2445,39 +2531,39 @@ extern int outrnxhnavb(FILE *fp, const rnxopt_t *opt, const seph_t *seph)
     time2epoch(seph->t0,ep);
     
     if (opt->rnxver<=2.99) { /* ver.2 */
-        fprintf(fp,"%2d %02d %2.0f %2.0f %2.0f %2.0f %4.1f",prn-100,
-                (int)ep[0]%100,ep[1],ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmtint(p,prn-100,2,0),ep,0);
         sep="   ";
     }
     else { /* ver.3 */
         if (!sat2code(seph->sat,code)) return 0;
-        fprintf(fp,"%-3s %04.0f %2.0f %2.0f %2.0f %2.0f %2.0f",code,ep[0],ep[1],
-                ep[2],ep[3],ep[4],ep[5]);
+        p=fmtnavep(fmts(p,code,3),ep,1);
         sep="    ";
     }
-    outnavf(fp,seph->af0          );
-    outnavf(fp,seph->af1          );
-    outnavf(fp,time2gpst(seph->tof,NULL));
-    fprintf(fp,"\n%s",sep         );
-    
-    outnavf(fp,seph->pos[0]/1E3   );
-    outnavf(fp,seph->vel[0]/1E3   );
-    outnavf(fp,seph->acc[0]/1E3   );
-    outnavf(fp,seph->svh          );
-    fprintf(fp,"\n%s",sep         );
-    
-    outnavf(fp,seph->pos[1]/1E3   );
-    outnavf(fp,seph->vel[1]/1E3   );
-    outnavf(fp,seph->acc[1]/1E3   );
-    outnavf(fp,uravalue(seph->sva));
-    fprintf(fp,"\n%s",sep         );
-    
-    outnavf(fp,seph->pos[2]/1E3   );
-    outnavf(fp,seph->vel[2]/1E3   );
-    outnavf(fp,seph->acc[2]/1E3   );
-    outnavf(fp,0                  );
-    
-    return fprintf(fp,"\n")!=EOF;
+    p=fmtnavf(p,seph->af0          );
+    p=fmtnavf(p,seph->af1          );
+    p=fmtnavf(p,time2gpst(seph->tof,NULL));
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,seph->pos[0]/1E3   );
+    p=fmtnavf(p,seph->vel[0]/1E3   );
+    p=fmtnavf(p,seph->acc[0]/1E3   );
+    p=fmtnavf(p,seph->svh          );
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,seph->pos[1]/1E3   );
+    p=fmtnavf(p,seph->vel[1]/1E3   );
+    p=fmtnavf(p,seph->acc[1]/1E3   );
+    p=fmtnavf(p,uravalue(seph->sva));
+    p=fmts(fmts(p,"\n",1),sep,0);
+    
+    p=fmtnavf(p,seph->pos[2]/1E3   );
+    p=fmtnavf(p,seph->vel[2]/1E3   );
+    p=fmtnavf(p,seph->acc[2]/1E3   );
+    p=fmtnavf(p,0                  );
+    
+    p=fmts(p,"\n",1);
+    
+    return fwrite(buff,p-buff,1,fp)==1;
 }
 /* output rinex galileo nav header ---------------------------------------------
 * output rinex galileo nav file header (2.12)
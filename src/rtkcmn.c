@@ -109,8 +109,22 @@
 *           2018/01/29 1.32 chanage api crc16() -> rtk_crc16()
 *                           chanage api crc32() -> rtk_crc32()
 *                           chanage api crc24q() -> rtk_crc24q()
+*           2026/10/19 1.33 add binary trace with per-thread buffer
+*                           level_trace static -> extern for TRACEON()
+*                           check swap of trace file at interval of thread
+*                           add api ticktime(),profinit(),profadd(),profstat()
+*                           add api freepsat(),newpsat(),peph2psat(),
+*                           pclk2psat(),psat2peph(),psat2pclk()
+*                           add api tropinit(),tropmapfn()
+*                           thread local cache of eci2ecef(),time_str()
+*                           add binary antex cache and index of pcvs_t
+*                           add api freepcv(),setpcvcache()
+*                           add epoch index of receivers by sortobs()
+*                           add api obsepoch()
+*                           add api fmtfix(),fmtint(),waitcondms()
+*                           use snprintf() for path of binary antex cache
 *-----------------------------------------------------------------------------*/
-#define _POSIX_C_SOURCE 199309
+#define _POSIX_C_SOURCE 200112L
 #include <stdarg.h>
 #include <ctype.h>
 #ifndef WIN32
@@ -129,6 +143,12 @@ static const char rcsid[]="$Id: rtkcmn.c,v 1.1 2008/07/17 21:48:06 ttaka Exp tta
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 #define POLYCRC24Q  0x1864CFBu  /* CRC24Q polynomial */
 
+#define PCVBIN_ID   "RTKPCV\0\0" /* binary antex cache id */
+#define PCVBIN_VER  1           /* binary antex cache version */
+#define PCVBIN_EXT  ".bin"      /* binary antex cache file extension */
+
+static char pcvcache_[1024]="";   /* binary antex cache directory ("":no cache) */
+
 const static double gpst0[]={1980,1, 6,0,0,0}; /* gps time reference */
 const static double gst0 []={1999,8,22,0,0,0}; /* galileo system time reference */
 const static double bdt0 []={2006,1, 1,0,0,0}; /* beidou time reference */
@@ -1172,6 +1192,86 @@ extern double str2num(const char *s, int i, int n)
     for (s+=i;*s&&--n>=0;s++) *p++=*s=='d'||*s=='D'?'E':*s; *p='\0';
     return sscanf(str,"%lf",&value)==1?value:0.0;
 }
+/* format fixed-point number ---------------------------------------------------
+* format number as sprintf(p,"%*.*f",w,prec,x) or "%0*.*f" without locale and
+* with integer arithmetic
+* args   : char   *p        I   output buffer
+*          double x         I   number
+*          int    w,prec    I   field width and precision (0-9)
+*          int    zero      I   padding (0:spaces,1:zeros)
+* return : pointer to terminating null of output
+* notes  : zero, values near rounding ties and values out of the range of the
+*          integer arithmetic are formatted by sprintf() to keep output same
+*-----------------------------------------------------------------------------*/
+extern char *fmtfix(char *p, double x, int w, int prec, int zero)
+{
+    static const double pw10[]={
+        1E0,1E1,1E2,1E3,1E4,1E5,1E6,1E7,1E8,1E9
+    };
+    char s[32],*q=s+sizeof(s);
+    double v,r,ip,fp;
+    unsigned long ui,uf;
+    int i,n,neg=x<0.0;
+    
+    v=fabs(x);
+    if (x==0.0||prec<0||prec>9||!(v<4E9)) {
+        return p+sprintf(p,zero?"%0*.*f":"%*.*f",w,prec,x);
+    }
+    v*=pw10[prec];
+    fp=v-floor(v);
+    if (v>=4503599627370496.0||fabs(fp-0.5)<v*1E-15+1E-12) {
+        return p+sprintf(p,zero?"%0*.*f":"%*.*f",w,prec,x);
+    }
+    r=floor(v+0.5);
+    ip=floor(r/pw10[prec]);
+    fp=r-ip*pw10[prec];
+    if (fp<0.0) {ip-=1.0; fp+=pw10[prec];}
+    else if (fp>=pw10[prec]) {ip+=1.0; fp-=pw10[prec];}
+    ui=(unsigned long)ip;
+    uf=(unsigned long)fp;
+    
+    for (i=0;i<prec;i++) {*--q=(char)('0'+uf%10); uf/=10;}
+    if (prec>0) *--q='.';
+    do {*--q=(char)('0'+ui%10); ui/=10;} while (ui);
+    
+    n=(int)(s+sizeof(s)-q)+neg;
+    if (zero) {
+        if (neg) *p++='-';
+        for (;n<w;n++) *p++='0';
+    }
+    else {
+        for (;n<w;n++) *p++=' ';
+        if (neg) *p++='-';
+    }
+    while (q<s+sizeof(s)) *p++=*q++;
+    *p='\0';
+    return p;
+}
+/* format integer --------------------------------------------------------------
+* format integer as sprintf(p,"%*d",w,d) or "%0*d" (zero!=0)
+* return : pointer to terminating null of output
+*-----------------------------------------------------------------------------*/
+extern char *fmtint(char *p, int d, int w, int zero)
+{
+    char s[16],*q=s+sizeof(s);
+    unsigned long u=d<0?(unsigned long)(-(long)d):(unsigned long)d;
+    int n;
+    
+    do {*--q=(char)('0'+u%10); u/=10;} while (u);
+    
+    n=(int)(s+sizeof(s)-q)+(d<0);
+    if (zero) {
+        if (d<0) *p++='-';
+        for (;n<w;n++) *p++='0';
+    }
+    else {
+        for (;n<w;n++) *p++=' ';
+        if (d<0) *p++='-';
+    }
+    while (q<s+sizeof(s)) *p++=*q++;
+    *p='\0';
+    return p;
+}
 /* string to time --------------------------------------------------------------
 * convert substring in string to gtime_t struct
 * args   : char   *s        I   string ("... yyyy mm dd hh mm ss ...")
@@ -1524,10 +1624,11 @@ extern void time2str(gtime_t t, char *s, int n)
 *          int    n         I   number of decimals
 * return : time string
 * notes  : not reentrant, do not use multiple in a function
+*          the buffer of the string is thread local
 *-----------------------------------------------------------------------------*/
 extern char *time_str(gtime_t t, int n)
 {
-    static char buff[64];
+    static THREADLOCAL char buff[64];
     time2str(t,buff,n);
     return buff;
 }
@@ -1584,6 +1685,97 @@ extern unsigned int tickget(void)
 #endif
 #endif /* WIN32 */
 }
+/* get high-resolution tick time -----------------------------------------------
+* get current monotonic tick time with sub-ms resolution
+* args   : none
+* return : current tick time (s)
+*-----------------------------------------------------------------------------*/
+extern double ticktime(void)
+{
+#ifdef WIN32
+    static LARGE_INTEGER freq={{0}};
+    LARGE_INTEGER cnt;
+    
+    if (!freq.QuadPart&&!QueryPerformanceFrequency(&freq)) {
+        return tickget()*1E-3;
+    }
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart/(double)freq.QuadPart;
+#else
+    struct timespec tp={0};
+    struct timeval  tv={0};
+    
+#ifdef CLOCK_MONOTONIC_RAW
+    if (!clock_gettime(CLOCK_MONOTONIC_RAW,&tp)) {
+        return tp.tv_sec+tp.tv_nsec*1E-9;
+    }
+#endif
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+tv.tv_usec*1E-6;
+#endif /* WIN32 */
+}
+/* initialize timing counters --------------------------------------------------
+* initialize timing counters of processing stages
+* args   : prof_t *prof     O   timing counters
+*          int    n         I   number of counters
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void profinit(prof_t *prof, int n)
+{
+    prof_t prof0={0};
+    int i;
+    
+    for (i=0;i<n;i++) prof[i]=prof0;
+}
+/* add sample to timing counter ------------------------------------------------
+* add elapsed time since start tick to timing counter
+* args   : prof_t *prof     IO  timing counter
+*          double t0        I   start tick time by ticktime() (s)
+* return : current tick time (s) (start tick of the next stage)
+* notes  : histogram bins are 1/4 octave wide from 1 us
+*-----------------------------------------------------------------------------*/
+extern double profadd(prof_t *prof, double t0)
+{
+    double t=ticktime(),dt=t-t0;
+    int i;
+    
+    if (dt<0.0) dt=0.0;
+    if (prof->n==0||dt<prof->min) prof->min=dt;
+    if (prof->n==0||dt>prof->max) prof->max=dt;
+    prof->n++;
+    prof->sum+=dt;
+    
+    i=dt<=1E-6?0:(int)(4.0*log(dt*1E6)/log(2.0))+1;
+    prof->hist[i<NPROFBIN?i:NPROFBIN-1]++;
+    return t;
+}
+/* timing counter statistics ---------------------------------------------------
+* get statistics of timing counter
+* args   : prof_t *prof     I   timing counter
+*          double *stat     O   {min,mean,p99,max} (s)
+* return : number of samples
+* notes  : p99 is the upper edge of the histogram bin including 99 percentile
+*          limited to max
+*-----------------------------------------------------------------------------*/
+extern int profstat(const prof_t *prof, double *stat)
+{
+    unsigned int n=0;
+    int i;
+    
+    for (i=0;i<4;i++) stat[i]=0.0;
+    if (prof->n==0) return 0;
+    
+    for (i=0;i<NPROFBIN-1;i++) {
+        if ((n+=prof->hist[i])>=prof->n-prof->n/100) break;
+    }
+    stat[0]=prof->min;
+    stat[1]=prof->sum/prof->n;
+    stat[2]=1E-6*pow(2.0,i/4.0);
+    if (stat[2]>prof->max) stat[2]=prof->max;
+    if (stat[2]<prof->min) stat[2]=prof->min;
+    stat[3]=prof->max;
+    return (int)prof->n;
+}
 /* sleep ms --------------------------------------------------------------------
 * sleep ms
 * args   : int   ms         I   miliseconds to sleep (<0:no sleep)
@@ -1601,6 +1793,32 @@ extern void sleepms(int ms)
     nanosleep(&ts,NULL);
 #endif
 }
+/* wait condition with timeout -------------------------------------------------
+* wait condition signalled or timeout
+* args   : cond_t *cond     I   condition
+*          lock_t *lock     I   lock flag (locked by caller)
+*          int    ms        I   timeout (ms)
+* return : none
+* notes  : the lock is released during wait and locked again on return
+*-----------------------------------------------------------------------------*/
+extern void waitcondms(cond_t *cond, lock_t *lock, int ms)
+{
+#ifdef WIN32
+    SleepConditionVariableCS(cond,lock,ms<0?0:(DWORD)ms);
+#else
+    struct timespec ts;
+    struct timeval tv;
+    
+    gettimeofday(&tv,NULL);
+    ts.tv_sec =tv.tv_sec+ms/1000;
+    ts.tv_nsec=(tv.tv_usec+ms%1000*1000L)*1000L;
+    if (ts.tv_nsec>=1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec-=1000000000L;
+    }
+    pthread_cond_timedwait(cond,lock,&ts);
+#endif
+}
 /* convert degree to deg-min-sec -----------------------------------------------
 * convert degree to degree-minute-second
 * args   : double deg       I   degree
@@ -1904,19 +2122,19 @@ static void nut_iau1980(double t, const double *f, double *dpsi, double *deps)
 *                               (NULL: no output)
 * return : none
 * note   : see ref [3] chap 5
-*          not thread-safe
+*          the last result is cached per thread and reused within 0.01 s
 *-----------------------------------------------------------------------------*/
 extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
 {
     const double ep2000[]={2000,1,1,12,0,0};
-    static gtime_t tutc_;
-    static double U_[9],gmst_;
+    static THREADLOCAL gtime_t tutc_;
+    static THREADLOCAL double U_[9],gmst_;
     gtime_t tgps;
     double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,f[5];
     double R1[9],R2[9],R3[9],R[9],W[9],N[9],P[9],NP[9];
     int i;
     
-    trace(3,"eci2ecef: tutc=%s\n",time_str(tutc,3));
+    if (TRACEON(3)) trace(3,"eci2ecef: tutc=%s\n",time_str(tutc,3));
     
     if (fabs(timediff(tutc,tutc_))<0.01) { /* read cache */
         for (i=0;i<9;i++) U[i]=U_[i];
@@ -2111,6 +2329,267 @@ static int readantex(const char *file, pcvs_t *pcvs)
     
     return 1;
 }
+/* checksum and size of antenna parameter file -------------------------------
+* 4 lanes of word-wise fnv-1a to keep checksum faster than parsing the file
+*-----------------------------------------------------------------------------*/
+static int pcvfilesum(const char *file, unsigned int *sum, unsigned int *size)
+{
+    FILE *fp;
+    unsigned int h[4]={2166136261u,2166136261u,2166136261u,2166136261u},w;
+    unsigned char *buff;
+    int i,j,n;
+    
+    if (!(fp=fopen(file,"rb"))) {
+        trace(2,"antex pcv file open error: %s\n",file);
+        return 0;
+    }
+    if (!(buff=(unsigned char *)malloc(65536))) {
+        fclose(fp);
+        return 0;
+    }
+    *size=0;
+    while ((n=(int)fread(buff,1,65536,fp))>0) {
+        for (i=0;i+16<=n;i+=16) {
+            for (j=0;j<4;j++) {
+                w=buff[i+j*4]|(buff[i+j*4+1]<<8)|(buff[i+j*4+2]<<16)|
+                  ((unsigned int)buff[i+j*4+3]<<24);
+                h[j]=(h[j]^w)*16777619u;
+            }
+        }
+        for (;i<n;i++) h[0]=(h[0]^buff[i])*16777619u;
+        *size+=(unsigned int)n;
+    }
+    free(buff);
+    fclose(fp);
+    for (i=1,*sum=h[0];i<4;i++) *sum=(*sum^h[i])*16777619u;
+    return 1;
+}
+/* read binary antex cache -----------------------------------------------------
+* cache : PCVBIN_ID(8) ver(4) nfreq(4) maxant(4) sum(4) size(4) n(4)
+*         n x { sat(4) ntype(1) type ncode(1) code ts.time ts.sec te.time
+*         te.sec off[NFREQ][3] var[NFREQ][19] (8 bytes each) }
+* ints and doubles are in native byte order and the file checksum and size are
+* those of the antex file the cache was built from
+*-----------------------------------------------------------------------------*/
+static int readpcvbin(const char *file, unsigned int sum, unsigned int size,
+                      pcvs_t *pcvs)
+{
+    FILE *fp;
+    static const pcv_t pcv0={0};
+    pcv_t pcv,*pcvs_pcv;
+    unsigned char *buff,*p,*q;
+    unsigned int head[6];
+    double d[2];
+    long len;
+    int i,j,n;
+    
+    trace(3,"readpcvbin: file=%s\n",file);
+    
+    if (!(fp=fopen(file,"rb"))) return 0;
+    
+    if (fseek(fp,0,SEEK_END)||(len=ftell(fp))<=32||fseek(fp,0,SEEK_SET)||
+        !(buff=(unsigned char *)malloc(len))) {
+        fclose(fp);
+        return 0;
+    }
+    if (fread(buff,1,len,fp)!=(size_t)len) {
+        free(buff); fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    memcpy(head,buff+8,sizeof(head));
+    
+    if (memcmp(buff,PCVBIN_ID,8)||head[0]!=PCVBIN_VER||head[1]!=NFREQ||
+        head[2]!=MAXANT||head[3]!=sum||head[4]!=size||
+        head[5]>(unsigned int)(len/8)) {
+        trace(2,"antex cache mismatch: %s\n",file);
+        free(buff);
+        return 0;
+    }
+    n=(int)head[5];
+    if (pcvs->nmax<pcvs->n+n) {
+        if (!(pcvs_pcv=(pcv_t *)realloc(pcvs->pcv,sizeof(pcv_t)*(pcvs->n+n)))) {
+            trace(1,"readpcvbin: memory allocation error\n");
+            free(buff);
+            return 0;
+        }
+        pcvs->pcv=pcvs_pcv;
+        pcvs->nmax=pcvs->n+n;
+    }
+    for (i=0,p=buff+32,q=buff+len;i<n;i++) {
+        pcv=pcv0;
+        if (q-p<6) break;
+        memcpy(&pcv.sat,p,4); p+=4;
+        if ((j=*p++)>=MAXANT||q-p<j+1) break;
+        memcpy(pcv.type,p,j); p+=j;
+        if ((j=*p++)>=MAXANT||q-p<j) break;
+        memcpy(pcv.code,p,j); p+=j;
+        if (q-p<(int)(sizeof(double)*(4+NFREQ*22))) break;
+        memcpy(d,p,sizeof(d)); p+=sizeof(d);
+        pcv.ts.time=(time_t)d[0]; pcv.ts.sec=d[1];
+        memcpy(d,p,sizeof(d)); p+=sizeof(d);
+        pcv.te.time=(time_t)d[0]; pcv.te.sec=d[1];
+        memcpy(pcv.off,p,sizeof(pcv.off)); p+=sizeof(pcv.off);
+        memcpy(pcv.var,p,sizeof(pcv.var)); p+=sizeof(pcv.var);
+        pcvs->pcv[pcvs->n+i]=pcv;
+    }
+    free(buff);
+    
+    if (i<n||p!=q) {
+        trace(2,"antex cache format error: %s\n",file);
+        return 0;
+    }
+    pcvs->n+=n;
+    return 1;
+}
+/* write binary antex cache --------------------------------------------------*/
+static void writepcvbin(const char *file, unsigned int sum, unsigned int size,
+                        const pcv_t *pcv, int n)
+{
+    FILE *fp;
+    char tmp[1032];
+    unsigned int head[6];
+    unsigned char len[2];
+    double d[4];
+    int i,stat=1;
+    
+    trace(3,"writepcvbin: file=%s n=%d\n",file,n);
+    
+    sprintf(tmp,"%s.tmp",file);
+    if (!(fp=fopen(tmp,"wb"))) {
+        trace(2,"antex cache open error: %s\n",tmp);
+        return;
+    }
+    head[0]=PCVBIN_VER; head[1]=NFREQ; head[2]=MAXANT;
+    head[3]=sum; head[4]=size; head[5]=(unsigned int)n;
+    
+    if (fwrite(PCVBIN_ID,1,8,fp)!=8||fwrite(head,sizeof(head),1,fp)!=1) stat=0;
+    
+    for (i=0;i<n&&stat;i++,pcv++) {
+        len[0]=(unsigned char)strlen(pcv->type);
+        len[1]=(unsigned char)strlen(pcv->code);
+        d[0]=(double)pcv->ts.time; d[1]=pcv->ts.sec;
+        d[2]=(double)pcv->te.time; d[3]=pcv->te.sec;
+        if (fwrite(&pcv->sat,4,1,fp)!=1||
+            fwrite(len  ,1,1,fp)!=1||fwrite(pcv->type,1,len[0],fp)!=len[0]||
+            fwrite(len+1,1,1,fp)!=1||fwrite(pcv->code,1,len[1],fp)!=len[1]||
+            fwrite(d,sizeof(d),1,fp)!=1||
+            fwrite(pcv->off,sizeof(pcv->off),1,fp)!=1||
+            fwrite(pcv->var,sizeof(pcv->var),1,fp)!=1) stat=0;
+    }
+    if (fclose(fp)||!stat) {
+        trace(2,"antex cache write error: %s\n",tmp);
+        remove(tmp);
+        return;
+    }
+    remove(file);
+    if (rename(tmp,file)) {
+        trace(2,"antex cache rename error: %s\n",file);
+        remove(tmp);
+    }
+}
+/* set binary antex cache directory --------------------------------------------
+* set directory of binary antex cache used by readpcv()
+* args   : char   *dir        I   cache directory ("": no cache)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void setpcvcache(const char *dir)
+{
+    trace(3,"setpcvcache: dir=%s\n",dir);
+    
+    strncpy(pcvcache_,dir,sizeof(pcvcache_)-1);
+    pcvcache_[sizeof(pcvcache_)-1]='\0';
+}
+/* read antex file via binary cache ------------------------------------------*/
+static int readantexc(const char *file, pcvs_t *pcvs)
+{
+    char cache[1024];
+    const char *p;
+    unsigned int sum,size;
+    int n;
+    
+    if (!*pcvcache_) return readantex(file,pcvs);
+    
+    if (!pcvfilesum(file,&sum,&size)) return 0;
+    
+    if (!(p=strrchr(file,FILEPATHSEP))) p=file; else p++;
+    
+    n=snprintf(cache,sizeof(cache),"%s%c%s%s",pcvcache_,FILEPATHSEP,p,PCVBIN_EXT);
+    if (n<0||n>=(int)sizeof(cache)) {
+        trace(2,"antex cache path too long: %s\n",file);
+        return readantex(file,pcvs);
+    }
+    n=pcvs->n;
+    
+    if (readpcvbin(cache,sum,size,pcvs)) return 1;
+    
+    if (!readantex(file,pcvs)) return 0;
+    
+    writepcvbin(cache,sum,size,pcvs->pcv+n,pcvs->n-n);
+    return 1;
+}
+/* antenna type key (type and radome separated by a space) -------------------*/
+static int pcvkey(const char *type, char *key)
+{
+    char buff[MAXANT],*p;
+    int n=0;
+    
+    strcpy(buff,type);
+    for (p=strtok(buff," "),*key='\0';p&&n<2;p=strtok(NULL," "),n++) {
+        if (n) strcat(key," ");
+        strcat(key,p);
+    }
+    return n;
+}
+static unsigned int pcvhash(const char *key)
+{
+    unsigned int h=5381;
+    
+    while (*key) h=h*33+(unsigned char)*key++;
+    return h;
+}
+/* index antenna parameters ----------------------------------------------------
+* index : pcvs->index[0..MAXSAT-1]   first data for satellite (index+1)
+*         pcvs->index[MAXSAT+i]       next data for same satellite (index+1)
+*         pcvs->index[MAXSAT+n+h]     hash of antenna type (index+1)
+*-----------------------------------------------------------------------------*/
+static void pcvindex(pcvs_t *pcvs)
+{
+    char key[MAXANT],buff[MAXANT];
+    int i,j,k,*index,*next,*htab,last[MAXSAT],nh;
+    
+    free(pcvs->index); pcvs->index=NULL; pcvs->ni=pcvs->nh=0;
+    
+    if (pcvs->n<=0) return;
+    
+    for (nh=64;nh<pcvs->n*2;nh*=2) ;
+    
+    if (!(index=(int *)calloc(MAXSAT+pcvs->n+nh,sizeof(int)))) {
+        trace(1,"pcvindex: memory allocation error\n");
+        return;
+    }
+    next=index+MAXSAT;
+    htab=next+pcvs->n;
+    
+    for (i=0;i<MAXSAT;i++) last[i]=0;
+    
+    for (i=0;i<pcvs->n;i++) {
+        if ((j=pcvs->pcv[i].sat)>=1&&j<=MAXSAT) {
+            if (last[j-1]) next[last[j-1]-1]=i+1; else index[j-1]=i+1;
+            last[j-1]=i+1;
+        }
+        if (pcvkey(pcvs->pcv[i].type,key)<=0) continue;
+        
+        for (k=pcvhash(key)&(nh-1);htab[k];k=(k+1)&(nh-1)) {
+            pcvkey(pcvs->pcv[htab[k]-1].type,buff);
+            if (!strcmp(buff,key)) break;
+        }
+        if (!htab[k]) htab[k]=i+1; /* keep first one */
+    }
+    pcvs->index=index;
+    pcvs->ni=pcvs->n;
+    pcvs->nh=nh;
+}
 /* read antenna parameters ------------------------------------------------------
 * read antenna parameters
 * args   : char   *file       I   antenna parameter file (antex)
@@ -2120,6 +2599,12 @@ static int readantex(const char *file, pcvs_t *pcvs)
 *          file except for antex is recognized ngs antenna parameters
 *          see reference [3]
 *          only support non-azimuth-depedent parameters
+*          if the cache directory is set by setpcvcache(), antex parameters
+*          are cached to binary file <dir>/<file>.bin keyed by checksum and
+*          size of the antex file. the cache is rebuilt if the antex file
+*          changes. if the cache can not be written, the antex file is parsed
+*          on every call
+*          call freepcv() to free the antenna parameters
 *-----------------------------------------------------------------------------*/
 extern int readpcv(const char *file, pcvs_t *pcvs)
 {
@@ -2132,11 +2617,13 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
     if (!(ext=strrchr(file,'.'))) ext="";
     
     if (!strcmp(ext,".atx")||!strcmp(ext,".ATX")) {
-        stat=readantex(file,pcvs);
+        stat=readantexc(file,pcvs);
     }
     else {
         stat=readngspcv(file,pcvs);
     }
+    pcvindex(pcvs);
+    
     for (i=0;i<pcvs->n;i++) {
         pcv=pcvs->pcv+i;
         trace(4,"sat=%2d type=%20s code=%s off=%8.4f %8.4f %8.4f  %8.4f %8.4f %8.4f\n",
@@ -2145,6 +2632,16 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
     }
     return stat;
 }
+/* free antenna parameters -----------------------------------------------------
+* free antenna parameters and index
+* args   : pcvs_t *pcvs       IO  antenna parameters
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freepcv(pcvs_t *pcvs)
+{
+    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
+    free(pcvs->index); pcvs->index=NULL; pcvs->ni=pcvs->nh=0;
+}
 /* search antenna parameter ----------------------------------------------------
 * read satellite antenna phase center position
 * args   : int    sat         I   satellite number (0: receiver antenna)
@@ -2152,17 +2649,29 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
 *          gtime_t time       I   time to search parameters
 *          pcvs_t *pcvs       IO  antenna parameters
 * return : antenna parameter (NULL: no antenna)
+* notes  : the index built by readpcv() is used if it is up to date. an exact
+*          match of antenna type and radome is preferred to a partial match
 *-----------------------------------------------------------------------------*/
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs)
 {
     pcv_t *pcv;
-    char buff[MAXANT],*types[2],*p;
-    int i,j,n=0;
+    char buff[MAXANT],key[MAXANT],*types[2],*p;
+    int i,j,k,n=0,index=pcvs->index&&pcvs->ni==pcvs->n;
     
     trace(3,"searchpcv: sat=%2d type=%s\n",sat,type);
     
-    if (sat) { /* search satellite antenna */
+    if (sat&&index) { /* search satellite antenna by index */
+        if (sat<1||sat>MAXSAT) return NULL;
+        for (i=pcvs->index[sat-1];i>0;i=pcvs->index[MAXSAT+i-1]) {
+            pcv=pcvs->pcv+i-1;
+            if (pcv->ts.time!=0&&timediff(pcv->ts,time)>0.0) continue;
+            if (pcv->te.time!=0&&timediff(pcv->te,time)<0.0) continue;
+            return pcv;
+        }
+        return NULL;
+    }
+    else if (sat) { /* search satellite antenna */
         for (i=0;i<pcvs->n;i++) {
             pcv=pcvs->pcv+i;
             if (pcv->sat!=sat) continue;
@@ -2172,6 +2681,13 @@ extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
         }
     }
     else {
+        if (index&&pcvkey(type,key)>0) { /* search by index */
+            for (k=pcvhash(key)&(pcvs->nh-1);(i=pcvs->index[MAXSAT+pcvs->n+k]);
+                 k=(k+1)&(pcvs->nh-1)) {
+                pcv=pcvs->pcv+i-1;
+                if (pcvkey(pcv->type,buff)>0&&!strcmp(buff,key)) return pcv;
+            }
+        }
         strcpy(buff,type);
         for (p=strtok(buff," ");p&&n<2;p=strtok(NULL," ")) types[n++]=p;
         if (n<=0) return NULL;
@@ -2526,10 +3042,50 @@ static int cmpobs(const void *p1, const void *p2)
     if (q1->rcv!=q2->rcv) return (int)q1->rcv-(int)q2->rcv;
     return (int)q1->sat-(int)q2->sat;
 }
+/* set epoch index of receivers ----------------------------------------------*/
+static int setobsep(obs_t *obs)
+{
+    obsep_t *ep;
+    int i,j,r,ne[2]={0};
+    
+    obs->ne[0]=obs->ne[1]=0;
+    
+    for (i=0;i<obs->n;i=j) {
+        r=obs->data[i].rcv;
+        for (j=i+1;j<obs->n;j++) {
+            if (obs->data[j].rcv!=r||
+                timediff(obs->data[j].time,obs->data[i].time)>DTTOL) break;
+        }
+        if (1<=r&&r<=2) ne[r-1]++;
+    }
+    for (r=0;r<2;r++) {
+        if (!(ep=(obsep_t *)realloc(obs->ep[r],sizeof(obsep_t)*(ne[r]+1)))) {
+            trace(1,"sortobs: malloc error n=%d\n",ne[r]);
+            return 0;
+        }
+        obs->ep[r]=ep;
+    }
+    for (i=0;i<obs->n;i=j) {
+        r=obs->data[i].rcv;
+        for (j=i+1;j<obs->n;j++) {
+            if (obs->data[j].rcv!=r||
+                timediff(obs->data[j].time,obs->data[i].time)>DTTOL) break;
+        }
+        if (r<1||2<r) continue;
+        ep=obs->ep[r-1]+obs->ne[r-1]++;
+        ep->time=obs->data[i].time;
+        ep->i=i;
+        ep->n=j-i;
+    }
+    return 1;
+}
 /* sort and unique observation data --------------------------------------------
 * sort and unique observation data by time, rcv, sat
 * args   : obs_t *obs    IO     observation data
 * return : number of epochs
+* notes  : the epoch index of rover and base (obs->ne,ep) is also set. the
+*          index is valid until the observation data records are modified.
+*          obs->ep[] should be NULL or allocated ones at the first call.
 *-----------------------------------------------------------------------------*/
 extern int sortobs(obs_t *obs)
 {
@@ -2537,6 +3093,8 @@ extern int sortobs(obs_t *obs)
     
     trace(3,"sortobs: nobs=%d\n",obs->n);
     
+    obs->ne[0]=obs->ne[1]=0;
+    
     if (obs->n<=0) return 0;
     
     qsort(obs->data,obs->n,sizeof(obsd_t),cmpobs);
@@ -2556,8 +3114,40 @@ extern int sortobs(obs_t *obs)
             if (timediff(obs->data[j].time,obs->data[i].time)>DTTOL) break;
         }
     }
+    /* epoch index of receivers */
+    setobsep(obs);
+    
     return n;
 }
+/* search epoch of observation data --------------------------------------------
+* search epoch of receiver by time in epoch index of observation data
+* args   : obs_t   *obs  I      observation data (sorted by sortobs())
+*          int     rcv   I      receiver number (1:rover,2:base)
+*          gtime_t time  I      time
+*          int     dir   I      search direction
+*                               (0:epoch at time,
+*                                1:first epoch at or after time,
+*                               -1:last epoch at or before time)
+* return : epoch index of receiver obs->ep[rcv-1][] (-1:no epoch)
+* notes  : an epoch within DTTOL of time is regarded as the epoch at time
+*-----------------------------------------------------------------------------*/
+extern int obsepoch(const obs_t *obs, int rcv, gtime_t time, int dir)
+{
+    const obsep_t *ep;
+    int i,j,k,n;
+    
+    if (rcv<1||2<rcv||(n=obs->ne[rcv-1])<=0) return -1;
+    ep=obs->ep[rcv-1];
+    
+    /* first epoch after time-DTTOL */
+    for (i=0,j=n;i<j;) {
+        k=(i+j)/2;
+        if (timediff(ep[k].time,time)>-DTTOL) j=k; else i=k+1;
+    }
+    if (dir>0) return i<n?i:-1;
+    if (i<n&&timediff(ep[i].time,time)<=DTTOL) return i;
+    return dir<0?i-1:-1;
+}
 /* screen by time --------------------------------------------------------------
 * screening by time start, time end, and time interval
 * args   : gtime_t time  I      time
@@ -2666,6 +3256,8 @@ extern int savenav(const char *file, const nav_t *nav)
 extern void freeobs(obs_t *obs)
 {
     free(obs->data); obs->data=NULL; obs->n=obs->nmax=0;
+    free(obs->ep[0]); obs->ep[0]=NULL; obs->ne[0]=0;
+    free(obs->ep[1]); obs->ep[1]=NULL; obs->ne[1]=0;
 }
 /* free navigation data ---------------------------------------------------------
 * free memory for navigation data
@@ -2679,28 +3271,591 @@ extern void freeobs(obs_t *obs)
 *-----------------------------------------------------------------------------*/
 extern void freenav(nav_t *nav, int opt)
 {
+    int i;
+    
     if (opt&0x01) {free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;}
     if (opt&0x02) {free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;}
     if (opt&0x04) {free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;}
     if (opt&0x08) {free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;}
+    if (opt&0x08) freepsat(&nav->pephs);
+    if ((opt&0x08)&&nav->pephc) {
+        for (i=0;i<MAXSAT;i++) free(nav->pephc->q[i]);
+        free(nav->pephc->w);
+        free(nav->pephc); nav->pephc=NULL;
+    }
     if (opt&0x10) {free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;}
+    if (opt&0x10) freepsat(&nav->pclks);
+    if ((opt&0x10)&&nav->pclki) {
+        for (i=0;i<nav->pclki->nf;i++) {
+            if (nav->pclki->tmp[i]) remove(nav->pclki->file[i]);
+            free(nav->pclki->file[i]);
+        }
+        free(nav->pclki->file);
+        free(nav->pclki->tmp);
+        free(nav->pclki->run);
+        free(nav->pclki->time);
+        free(nav->pclki->r0);
+        for (i=0;i<nav->pclki->nw;i++) {
+            freepsat(&nav->pclki->w[i]->win);
+            free(nav->pclki->w[i]);
+        }
+        free(nav->pclki->w);
+        free(nav->pclki); nav->pclki=NULL;
+    }
     if (opt&0x20) {free(nav->alm ); nav->alm =NULL; nav->na=nav->namax=0;}
-    if (opt&0x40) {free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;}
+    if (opt&0x40) {
+        for (i=0;i<nav->nt;i++) {
+            free(nav->tec[i].data);
+            free(nav->tec[i].rms );
+        }
+        free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
+    }
+}
+/* free satellite-major precise ephemeris/clock --------------------------------
+* free memory for satellite-major precise ephemeris/clock
+* args   : psat_t *ps    IO     satellite-major precise ephemeris/clock
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freepsat(psat_t *ps)
+{
+    int i;
+    
+    free(ps->time ); ps->time =NULL;
+    free(ps->index); ps->index=NULL;
+    free(ps->val  ); ps->val  =NULL;
+    free(ps->std  ); ps->std  =NULL;
+    ps->n=ps->ns=ps->nv=0;
+    for (i=0;i<MAXSAT;i++) ps->sat[i]=ps->ser[i]=0;
+}
+/* new satellite-major precise ephemeris/clock --------------------------------
+* allocate satellite-major precise ephemeris/clock with zero values
+* args   : psat_t *ps    IO     satellite-major precise ephemeris/clock
+*          int    n      I      number of epochs
+*          int    nv     I      number of values per epoch
+*          unsigned char *mask I satellites with series (mask[sat-1]!=0)
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int newpsat(psat_t *ps, int n, int nv, const unsigned char *mask)
+{
+    int i,ns=0;
+    
+    freepsat(ps);
+    
+    for (i=0;i<MAXSAT;i++) {
+        if (mask[i]) ps->sat[ns++]=i+1;
+    }
+    if (n<=0||
+        !(ps->time =(gtime_t *)malloc(sizeof(gtime_t)*n))||
+        !(ps->index=(int *)malloc(sizeof(int)*n))||
+        !(ps->val=(double *)calloc((size_t)(ns>0?ns:1)*n*nv,sizeof(double)))||
+        !(ps->std=(float  *)calloc((size_t)(ns>0?ns:1)*n*nv,sizeof(float)))) {
+        trace(1,"newpsat malloc error: n=%d ns=%d\n",n,ns);
+        freepsat(ps);
+        return 0;
+    }
+    for (i=0;i<ns;i++) ps->ser[ps->sat[i]-1]=i+1;
+    ps->n=n; ps->ns=ns; ps->nv=nv;
+    return 1;
+}
+/* precise ephemeris to satellite-major precise ephemeris ----------------------
+* convert epoch-major precise ephemeris to satellite-major one, which holds
+* time series of only the satellites with ephemeris
+* args   : peph_t *peph  I      precise ephemeris (sorted and combined)
+*          int    n      I      number of precise ephemeris
+*          psat_t *ps    O      satellite-major precise ephemeris
+* return : status (1:ok,0:error)
+* notes  : velocity and covariance records of sp3 are not converted
+*-----------------------------------------------------------------------------*/
+extern int peph2psat(const peph_t *peph, int n, psat_t *ps)
+{
+    unsigned char mask[MAXSAT]={0};
+    double *val;
+    float *std;
+    int i,j,k,sat;
+    
+    trace(3,"peph2psat: n=%d\n",n);
+    
+    for (i=0;i<n;i++) for (j=0;j<MAXSAT;j++) {
+        if (mask[j]) continue;
+        for (k=0;k<4;k++) if (peph[i].pos[j][k]!=0.0) mask[j]=1;
+    }
+    if (!newpsat(ps,n,4,mask)) return 0;
+    
+    for (i=0;i<n;i++) {
+        ps->time [i]=peph[i].time;
+        ps->index[i]=peph[i].index;
+    }
+    for (k=0;k<ps->ns;k++) {
+        sat=ps->sat[k];
+        val=ps->val+(size_t)k*n*4;
+        std=ps->std+(size_t)k*n*4;
+        for (i=0;i<n;i++) for (j=0;j<4;j++) {
+            val[i*4+j]=peph[i].pos[sat-1][j];
+            std[i*4+j]=peph[i].std[sat-1][j];
+        }
+    }
+    return 1;
+}
+/* precise clock to satellite-major precise clock ------------------------------
+* convert epoch-major precise clock to satellite-major one
+* args   : pclk_t *pclk  I      precise clock (sorted and combined)
+*          int    n      I      number of precise clock
+*          psat_t *ps    O      satellite-major precise clock
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int pclk2psat(const pclk_t *pclk, int n, psat_t *ps)
+{
+    unsigned char mask[MAXSAT]={0};
+    double *val;
+    float *std;
+    int i,j,k,sat;
+    
+    trace(3,"pclk2psat: n=%d\n",n);
+    
+    for (i=0;i<n;i++) for (j=0;j<MAXSAT;j++) {
+        if (pclk[i].clk[j][0]!=0.0) mask[j]=1;
+    }
+    if (!newpsat(ps,n,1,mask)) return 0;
+    
+    for (i=0;i<n;i++) {
+        ps->time [i]=pclk[i].time;
+        ps->index[i]=pclk[i].index;
+    }
+    for (k=0;k<ps->ns;k++) {
+        sat=ps->sat[k];
+        val=ps->val+(size_t)k*n;
+        std=ps->std+(size_t)k*n;
+        for (i=0;i<n;i++) {
+            val[i]=pclk[i].clk[sat-1][0];
+            std[i]=pclk[i].std[sat-1][0];
+        }
+    }
+    return 1;
+}
+/* satellite-major precise ephemeris to precise ephemeris ----------------------
+* expand satellite-major precise ephemeris to epoch-major one of navigation
+* data (nav->peph), e.g. to append ephemeris after the epoch-major one released
+* args   : psat_t *ps    I      satellite-major precise ephemeris
+*          nav_t  *nav   IO     navigation data
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int psat2peph(const psat_t *ps, nav_t *nav)
+{
+    const double *val;
+    const float *std;
+    int i,j,k,sat;
+    
+    trace(3,"psat2peph: n=%d ns=%d\n",ps->n,ps->ns);
+    
+    free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;
+    
+    if (ps->n<=0||ps->nv!=4) return 0;
+    
+    if (!(nav->peph=(peph_t *)calloc(ps->n,sizeof(peph_t)))) {
+        trace(1,"psat2peph malloc error: n=%d\n",ps->n);
+        return 0;
+    }
+    for (i=0;i<ps->n;i++) {
+        nav->peph[i].time =ps->time [i];
+        nav->peph[i].index=ps->index[i];
+    }
+    for (k=0;k<ps->ns;k++) {
+        sat=ps->sat[k];
+        val=ps->val+(size_t)k*ps->n*4;
+        std=ps->std+(size_t)k*ps->n*4;
+        for (i=0;i<ps->n;i++) for (j=0;j<4;j++) {
+            nav->peph[i].pos[sat-1][j]=val[i*4+j];
+            nav->peph[i].std[sat-1][j]=std[i*4+j];
+        }
+    }
+    nav->ne=nav->nemax=ps->n;
+    return 1;
+}
+/* satellite-major precise clock to precise clock ------------------------------
+* expand satellite-major precise clock to epoch-major one of navigation data
+* (nav->pclk)
+* args   : psat_t *ps    I      satellite-major precise clock
+*          nav_t  *nav   IO     navigation data
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int psat2pclk(const psat_t *ps, nav_t *nav)
+{
+    const double *val;
+    const float *std;
+    int i,k,sat;
+    
+    trace(3,"psat2pclk: n=%d ns=%d\n",ps->n,ps->ns);
+    
+    free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;
+    
+    if (ps->n<=0||ps->nv!=1) return 0;
+    
+    if (!(nav->pclk=(pclk_t *)calloc(ps->n,sizeof(pclk_t)))) {
+        trace(1,"psat2pclk malloc error: n=%d\n",ps->n);
+        return 0;
+    }
+    for (i=0;i<ps->n;i++) {
+        nav->pclk[i].time =ps->time [i];
+        nav->pclk[i].index=ps->index[i];
+    }
+    for (k=0;k<ps->ns;k++) {
+        sat=ps->sat[k];
+        val=ps->val+(size_t)k*ps->n;
+        std=ps->std+(size_t)k*ps->n;
+        for (i=0;i<ps->n;i++) {
+            nav->pclk[i].clk[sat-1][0]=val[i];
+            nav->pclk[i].std[sat-1][0]=std[i];
+        }
+    }
+    nav->nc=nav->ncmax=ps->n;
+    return 1;
 }
 /* debug trace functions -----------------------------------------------------*/
+int level_trace=0;              /* level of trace */
+
 #ifdef TRACE
 
+#define TRACE_BUFF  65536       /* size of binary trace buffer per thread */
+#define TRACE_MAXREC 2048       /* max length of binary trace record */
+#define TRACE_NFMT  8192        /* max number of binary trace formats (2^n) */
+#define TRACE_NCACHE 256        /* size of format cache per thread (2^n) */
+#define TRACE_NTHREAD 64        /* max number of threads with trace buffer */
+#define TRACE_MAXARG 32         /* max number of arguments in a format */
+#define TRACE_VER   1           /* binary trace format version */
+#define TRACE_TSWAP 1000        /* interval to check swap of trace file (ms) */
+
+#define TRACE_FMT   1           /* binary trace record: format definition */
+#define TRACE_MSG   2           /* binary trace record: trace() */
+#define TRACE_MSGT  3           /* binary trace record: tracet() */
+#define TRACE_RAW   4           /* binary trace record: without prefix */
+#define TRACE_MAT   5           /* binary trace record: matrix row */
+#define TRACE_INL   0x80        /* binary trace record flag: inline format */
+
+typedef struct {                /* binary trace format type */
+    const char *fmt;            /* format string pointer */
+    char *str;                  /* copy of format string */
+    unsigned int id;            /* format id */
+    char sig[TRACE_MAXARG+1];   /* argument types (i,l,d,D,s,p,n) */
+} tracefmt_t;
+
+typedef struct {                /* binary trace buffer type */
+    unsigned char buff[TRACE_BUFF]; /* record buffer */
+    int n;                      /* number of bytes in buffer */
+    const tracefmt_t *cache[TRACE_NCACHE]; /* format cache */
+    lock_t lock;                /* lock of buffer (after lock_trace) */
+} tracebuf_t;
+
 static FILE *fp_trace=NULL;     /* file pointer of trace */
 static char file_trace[1024];   /* trace file */
-static int level_trace=0;       /* level of trace */
 static unsigned int tick_trace=0; /* tick time at traceopen (ms) */
 static gtime_t time_trace={0};  /* time at traceopen */
 static lock_t lock_trace;       /* lock for trace */
+static int bin_trace=0;         /* binary trace (0:text,1:binary) */
+static tracefmt_t fmt_trace[TRACE_NFMT]; /* binary trace formats */
+static unsigned int nfmt_trace=0; /* number of binary trace formats */
+static tracebuf_t *buf_trace[TRACE_NTHREAD]; /* binary trace buffers */
+static THREADLOCAL unsigned int tick_swap=0; /* last check of swap by thread */
+#ifdef WIN32
+static DWORD key_trace=TLS_OUT_OF_INDEXES; /* tls index of trace buffer */
+#else
+static pthread_key_t key_trace; /* thread key of trace buffer */
+static int key_trace_ena=0;     /* thread key created */
+#endif
 
+/* argument types of format --------------------------------------------------*/
+static void fmtsig(const char *format, char *sig)
+{
+    const char *p;
+    int n=0,lmod;
+    
+    for (p=format;*p&&n<TRACE_MAXARG;p++) {
+        if (*p!='%') continue;
+        if (*++p=='%') continue;
+        while (*p&&strchr("-+ #0",*p)) p++;
+        if (*p=='*') {sig[n++]='i'; p++;} else while (isdigit((int)*p)) p++;
+        if (*p=='.') {
+            p++;
+            if (*p=='*') {if (n<TRACE_MAXARG) sig[n++]='i'; p++;}
+            else while (isdigit((int)*p)) p++;
+        }
+        lmod=*p=='h'||*p=='l'||*p=='L'?*p++:0;
+        if (n>=TRACE_MAXARG) break;
+        if      (*p&&strchr("diouxXc",*p)) sig[n++]=lmod=='l'?'l':'i';
+        else if (*p&&strchr("eEfgG"  ,*p)) sig[n++]=lmod=='L'?'D':'d';
+        else if (*p=='s') sig[n++]='s';
+        else if (*p=='p') sig[n++]='p';
+        else if (*p=='n') sig[n++]='n';
+        else break;
+    }
+    sig[n]='\0';
+}
+/* write binary trace file header --------------------------------------------*/
+static void writetracehead(void)
+{
+    unsigned char buff[TRACE_MAXREC+8];
+    unsigned int i;
+    int len;
+    
+    memcpy(buff,"RTKTRACE",8);
+    buff[8]=TRACE_VER;
+    buff[9]=(unsigned char)sizeof(int);
+    buff[10]=(unsigned char)sizeof(long);
+    buff[11]=(unsigned char)sizeof(void *);
+    memcpy(buff+12,&tick_trace,4);
+    fwrite(buff,16,1,fp_trace);
+    
+    /* format definitions registered before swap */
+    for (i=0;i<TRACE_NFMT;i++) {
+        if (!fmt_trace[i].str) continue;
+        len=(int)strlen(fmt_trace[i].str);
+        if (len>TRACE_MAXREC-9) len=TRACE_MAXREC-9;
+        buff[0]=TRACE_FMT;
+        buff[1]=0;
+        buff[2]=(unsigned char)((len+5)&0xFF);
+        buff[3]=(unsigned char)((len+5)>>8);
+        memcpy(buff+4,&fmt_trace[i].id,4);
+        memcpy(buff+8,fmt_trace[i].str,len);
+        buff[8+len]='\0';
+        fwrite(buff,len+9,1,fp_trace);
+    }
+}
+/* register binary trace format ----------------------------------------------*/
+static const tracefmt_t *regtracefmt(const char *format)
+{
+    tracefmt_t *f=NULL;
+    unsigned char buff[TRACE_MAXREC+8];
+    unsigned int i,h=(unsigned int)(((unsigned long)format>>3)&(TRACE_NFMT-1));
+    int len;
+    
+    lock(&lock_trace);
+    
+    for (i=0;i<TRACE_NFMT;i++,h=(h+1)&(TRACE_NFMT-1)) {
+        if (!fmt_trace[h].str) break;
+        if (fmt_trace[h].fmt==format&&!strcmp(fmt_trace[h].str,format)) {
+            unlock(&lock_trace);
+            return fmt_trace+h;
+        }
+    }
+    if (i<TRACE_NFMT&&nfmt_trace<TRACE_NFMT/2&&
+        (fmt_trace[h].str=(char *)malloc(strlen(format)+1))) {
+        f=fmt_trace+h;
+        strcpy(f->str,format);
+        f->fmt=format;
+        f->id=nfmt_trace++;
+        fmtsig(format,f->sig);
+        
+        /* write format definition prior to records */
+        if (fp_trace) {
+            len=(int)strlen(format);
+            if (len>TRACE_MAXREC-9) len=TRACE_MAXREC-9;
+            buff[0]=TRACE_FMT;
+            buff[1]=0;
+            buff[2]=(unsigned char)((len+5)&0xFF);
+            buff[3]=(unsigned char)((len+5)>>8);
+            memcpy(buff+4,&f->id,4);
+            memcpy(buff+8,format,len);
+            buff[8+len]='\0';
+            fwrite(buff,len+9,1,fp_trace);
+        }
+    }
+    unlock(&lock_trace);
+    return f;
+}
+/* encode binary trace record ------------------------------------------------*/
+static int enctracerec(unsigned char *buff, int type, int level,
+                       const tracefmt_t *f, const char *format,
+                       unsigned int tick, va_list ap)
+{
+    char sig[TRACE_MAXARG+1];
+    const char *s,*q;
+    unsigned char *p=buff+4,*end=buff+TRACE_MAXREC;
+    double d;
+    long l;
+    void *v;
+    int i,n;
+    
+    if (f) {
+        memcpy(p,&f->id,4); p+=4;
+        q=f->sig;
+    }
+    else { /* inline format */
+        type|=TRACE_INL;
+        n=(int)strlen(format);
+        if (n>TRACE_MAXREC/2) n=TRACE_MAXREC/2;
+        memcpy(p,&n,2); p+=2;
+        memcpy(p,format,n); p+=n;
+        *p++='\0';
+        fmtsig(format,sig);
+        q=sig;
+    }
+    if ((type&~TRACE_INL)==TRACE_MSGT) {
+        memcpy(p,&tick,4); p+=4;
+    }
+    for (;*q&&p+16<=end;q++) {
+        switch (*q) {
+            case 'i': i=va_arg(ap,int);    memcpy(p,&i,sizeof(i)); p+=sizeof(i); break;
+            case 'l': l=va_arg(ap,long);   memcpy(p,&l,sizeof(l)); p+=sizeof(l); break;
+            case 'd': d=va_arg(ap,double); memcpy(p,&d,sizeof(d)); p+=sizeof(d); break;
+            case 'D': d=(double)va_arg(ap,long double);
+                      memcpy(p,&d,sizeof(d)); p+=sizeof(d); break;
+            case 'p':
+            case 'n': v=va_arg(ap,void *); memcpy(p,&v,sizeof(v)); p+=sizeof(v); break;
+            case 's':
+                if (!(s=va_arg(ap,const char *))) s="(null)";
+                for (;*s&&p<end-1;) *p++=(unsigned char)*s++;
+                *p++='\0';
+                break;
+        }
+    }
+    buff[0]=(unsigned char)type;
+    buff[1]=(unsigned char)level;
+    buff[2]=(unsigned char)((p-buff-4)&0xFF);
+    buff[3]=(unsigned char)((p-buff-4)>>8);
+    return (int)(p-buff);
+}
+/* write binary trace buffer to file (lock_trace locked) --------------------*/
+static void writetracebuf(tracebuf_t *tb)
+{
+    lock(&tb->lock);
+    if (fp_trace&&tb->n>0) fwrite(tb->buff,tb->n,1,fp_trace);
+    tb->n=0;
+    unlock(&tb->lock);
+}
+/* flush binary trace buffer -------------------------------------------------*/
+static void flushtracebuf(tracebuf_t *tb)
+{
+    lock(&lock_trace);
+    writetracebuf(tb);
+    unlock(&lock_trace);
+}
+/* free binary trace buffer at thread exit -----------------------------------*/
+static void freetracebuf(void *arg)
+{
+    tracebuf_t *tb=(tracebuf_t *)arg;
+    int i;
+    
+    lock(&lock_trace);
+    writetracebuf(tb);
+    for (i=0;i<TRACE_NTHREAD;i++) if (buf_trace[i]==tb) buf_trace[i]=NULL;
+    unlock(&lock_trace);
+    free(tb);
+}
+/* get binary trace buffer of current thread ---------------------------------*/
+static tracebuf_t *gettracebuf(void)
+{
+    tracebuf_t *tb;
+    int i;
+    
+#ifdef WIN32
+    if (key_trace==TLS_OUT_OF_INDEXES) return NULL;
+    if ((tb=(tracebuf_t *)TlsGetValue(key_trace))) return tb;
+#else
+    if (!key_trace_ena) return NULL;
+    if ((tb=(tracebuf_t *)pthread_getspecific(key_trace))) return tb;
+#endif
+    if (!(tb=(tracebuf_t *)calloc(1,sizeof(tracebuf_t)))) return NULL;
+    initlock(&tb->lock);
+    
+    lock(&lock_trace);
+    for (i=0;i<TRACE_NTHREAD;i++) {
+        if (!buf_trace[i]) {buf_trace[i]=tb; break;}
+    }
+    unlock(&lock_trace);
+    
+    if (i>=TRACE_NTHREAD) {
+        free(tb);
+        return NULL;
+    }
+#ifdef WIN32
+    TlsSetValue(key_trace,tb);
+#else
+    pthread_setspecific(key_trace,tb);
+#endif
+    return tb;
+}
+/* add binary trace record to buffer -----------------------------------------*/
+static void addtracerec(tracebuf_t *tb, const unsigned char *buff, int n)
+{
+    if (!tb) { /* no buffer for thread */
+        lock(&lock_trace);
+        if (fp_trace) fwrite(buff,n,1,fp_trace);
+        unlock(&lock_trace);
+        return;
+    }
+    lock(&tb->lock);
+    if (tb->n+n>TRACE_BUFF) { /* flush by lock order of lock_trace,tb->lock */
+        unlock(&tb->lock);
+        flushtracebuf(tb);
+        lock(&tb->lock);
+    }
+    memcpy(tb->buff+tb->n,buff,n);
+    tb->n+=n;
+    unlock(&tb->lock);
+}
+/* output binary trace record ------------------------------------------------*/
+static void tracerec(int type, int level, const char *format, va_list ap)
+{
+    unsigned char buff[TRACE_MAXREC+8];
+    const tracefmt_t *f;
+    tracebuf_t *tb;
+    unsigned int h=(unsigned int)(((unsigned long)format>>3)&(TRACE_NCACHE-1));
+    int n;
+    
+    tb=gettracebuf();
+    
+    /* search format in cache of thread */
+    if (!tb||!(f=tb->cache[h])||f->fmt!=format||strcmp(f->str,format)) {
+        if ((f=regtracefmt(format))&&tb) tb->cache[h]=f;
+    }
+    n=enctracerec(buff,type,level,f,format,
+                  type==TRACE_MSGT?tickget():0,ap);
+    addtracerec(tb,buff,n);
+}
+/* output binary trace record of matrix --------------------------------------*/
+static void tracematrec(const double *A, int n, int m, int p, int q)
+{
+    unsigned char buff[TRACE_MAXREC+8];
+    tracebuf_t *tb=gettracebuf();
+    int i,j,k,l,len,nmax=(TRACE_MAXREC-13)/(int)sizeof(double);
+    
+    for (i=0;i<n;i++) for (j=0;j<m;j+=nmax) {
+        k=m-j<nmax?m-j:nmax;
+        len=9+k*(int)sizeof(double);
+        buff[0]=TRACE_MAT;
+        buff[1]=0;
+        buff[2]=(unsigned char)(len&0xFF);
+        buff[3]=(unsigned char)(len>>8);
+        memcpy(buff+4,&p,4);
+        memcpy(buff+8,&q,4);
+        buff[12]=j+k>=m; /* end of row */
+        for (l=0;l<k;l++) {
+            memcpy(buff+13+l*sizeof(double),A+i+(j+l)*n,sizeof(double));
+        }
+        addtracerec(tb,buff,len+4);
+    }
+}
+/* output trace without prefix -----------------------------------------------*/
+static void tracef(const char *format, ...)
+{
+    va_list ap;
+    
+    va_start(ap,format);
+    if (bin_trace) tracerec(TRACE_RAW,0,format,ap);
+    else vfprintf(fp_trace,format,ap);
+    va_end(ap);
+}
 static void traceswap(void)
 {
-    gtime_t time=utc2gpst(timeget());
+    gtime_t time;
+    unsigned int tick=tickget();
     char path[1024];
+    int i;
+    
+    /* check swap only at interval of thread without lock */
+    if (tick-tick_swap<TRACE_TSWAP) return;
+    tick_swap=tick;
+    
+    time=utc2gpst(timeget());
     
     lock(&lock_trace);
     
@@ -2715,30 +3870,76 @@ static void traceswap(void)
         unlock(&lock_trace);
         return;
     }
+    /* flush binary trace buffers of all threads to previous file */
+    for (i=0;i<TRACE_NTHREAD&&bin_trace;i++) {
+        if (buf_trace[i]) writetracebuf(buf_trace[i]);
+    }
     if (fp_trace) fclose(fp_trace);
     
-    if (!(fp_trace=fopen(path,"w"))) {
+    if (!(fp_trace=fopen(path,bin_trace?"wb":"w"))) {
         fp_trace=stderr;
+        bin_trace=0;
     }
+    else if (bin_trace) writetracehead();
+    
     unlock(&lock_trace);
 }
+/* open debug trace ------------------------------------------------------------
+* open debug trace file
+* args   : char   *file     I   trace file path (with keywords replaced)
+* return : none
+* notes  : a path with extension ".rtb" selects the binary trace. records are
+*          written as format id and raw arguments into per-thread buffers,
+*          which are drained to the file when full, at swap and at
+*          traceclose(). use util/tracedec to convert the file to text.
+*          each thread checks the swap of the trace file every TRACE_TSWAP ms,
+*          so records just after the swap time may be in the previous file.
+*          trace format strings must be static strings.
+*-----------------------------------------------------------------------------*/
 extern void traceopen(const char *file)
 {
     gtime_t time=utc2gpst(timeget());
     char path[1024];
+    const char *p;
     
     reppath(file,path,time,"","");
-    if (!*path||!(fp_trace=fopen(path,"w"))) fp_trace=stderr;
+    bin_trace=(p=strrchr(path,'.'))&&!strcmp(p,".rtb");
+    if (!*path||!(fp_trace=fopen(path,bin_trace?"wb":"w"))) {
+        fp_trace=stderr;
+        bin_trace=0;
+    }
     strcpy(file_trace,file);
     tick_trace=tickget();
     time_trace=time;
     initlock(&lock_trace);
+    
+    if (!bin_trace) return;
+#ifdef WIN32
+    if (key_trace==TLS_OUT_OF_INDEXES) key_trace=TlsAlloc();
+#else
+    if (!key_trace_ena) {
+        key_trace_ena=!pthread_key_create(&key_trace,freetracebuf);
+    }
+#endif
+    writetracehead();
 }
 extern void traceclose(void)
 {
+    int i;
+    
+    if (!fp_trace) return;
+    
+    lock(&lock_trace);
+    
+    /* flush binary trace buffers of threads */
+    for (i=0;i<TRACE_NTHREAD&&bin_trace;i++) {
+        if (buf_trace[i]) writetracebuf(buf_trace[i]);
+    }
     if (fp_trace&&fp_trace!=stderr) fclose(fp_trace);
     fp_trace=NULL;
     file_trace[0]='\0';
+    
+    unlock(&lock_trace);
 }
 extern void tracelevel(int level)
 {
@@ -2754,6 +3955,10 @@ extern void trace(int level, const char *format, ...)
     }
     if (!fp_trace||level>level_trace) return;
     traceswap();
+    if (bin_trace) {
+        va_start(ap,format); tracerec(TRACE_MSG,level,format,ap); va_end(ap);
+        return;
+    }
     fprintf(fp_trace,"%d ",level);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
@@ -2764,6 +3969,10 @@ extern void tracet(int level, const char *format, ...)
     
     if (!fp_trace||level>level_trace) return;
     traceswap();
+    if (bin_trace) {
+        va_start(ap,format); tracerec(TRACE_MSGT,level,format,ap); va_end(ap);
+        return;
+    }
     fprintf(fp_trace,"%d %9.3f: ",level,(tickget()-tick_trace)/1000.0);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
@@ -2771,6 +3980,10 @@ extern void tracet(int level, const char *format, ...)
 extern void tracemat(int level, const double *A, int n, int m, int p, int q)
 {
     if (!fp_trace||level>level_trace) return;
+    if (bin_trace) {
+        tracematrec(A,n,m,p,q);
+        return;
+    }
     matfprint(A,n,m,p,q,fp_trace); fflush(fp_trace);
 }
 extern void traceobs(int level, const obsd_t *obs, int n)
@@ -2782,7 +3995,7 @@ extern void traceobs(int level, const obsd_t *obs, int n)
     for (i=0;i<n;i++) {
         time2str(obs[i].time,str,3);
         satno2id(obs[i].sat,id);
-        fprintf(fp_trace," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
+        tracef(" (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
               i+1,str,id,obs[i].rcv,obs[i].L[0],obs[i].L[1],obs[i].P[0],
               obs[i].P[1],obs[i].LLI[0],obs[i].LLI[1],obs[i].code[0],
               obs[i].code[1],obs[i].SNR[0]*0.25,obs[i].SNR[1]*0.25);
@@ -2799,14 +4012,14 @@ extern void tracenav(int level, const nav_t *nav)
         time2str(nav->eph[i].toe,s1,0);
         time2str(nav->eph[i].ttr,s2,0);
         satno2id(nav->eph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
+        tracef("(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
                 id,s1,s2,nav->eph[i].iode,nav->eph[i].iodc,nav->eph[i].svh);
     }
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
+    tracef("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
             nav->ion_gps[1],nav->ion_gps[2],nav->ion_gps[3]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
+    tracef("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
             nav->ion_gps[5],nav->ion_gps[6],nav->ion_gps[7]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
+    tracef("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
             nav->ion_gal[1],nav->ion_gal[2],nav->ion_gal[3]);
 }
 extern void tracegnav(int level, const nav_t *nav)
@@ -2819,7 +4032,7 @@ extern void tracegnav(int level, const nav_t *nav)
         time2str(nav->geph[i].toe,s1,0);
         time2str(nav->geph[i].tof,s2,0);
         satno2id(nav->geph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
+        tracef("(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
                 id,s1,s2,nav->geph[i].frq,nav->geph[i].svh,nav->geph[i].taun*1E6);
     }
 }
@@ -2833,7 +4046,7 @@ extern void tracehnav(int level, const nav_t *nav)
         time2str(nav->seph[i].t0,s1,0);
         time2str(nav->seph[i].tof,s2,0);
         satno2id(nav->seph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
+        tracef("(%3d) %-3s : %s %s %2d %2d\n",i+1,
                 id,s1,s2,nav->seph[i].svh,nav->seph[i].sva);
     }
 }
@@ -2848,7 +4061,7 @@ extern void tracepeph(int level, const nav_t *nav)
         time2str(nav->peph[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
+            tracef("%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
                     s,nav->peph[i].index,id,
                     nav->peph[i].pos[j][0],nav->peph[i].pos[j][1],
                     nav->peph[i].pos[j][2],nav->peph[i].pos[j][3]*1E9,
@@ -2868,7 +4081,7 @@ extern void tracepclk(int level, const nav_t *nav)
         time2str(nav->pclk[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %6.3f\n",
+            tracef("%-3s %d %-3s %13.3f %6.3f\n",
                     s,nav->pclk[i].index,id,
                     nav->pclk[i].clk[j][0]*1E9,nav->pclk[i].std[j][0]*1E9);
         }
@@ -2878,8 +4091,8 @@ extern void traceb(int level, const unsigned char *p, int n)
 {
     int i;
     if (!fp_trace||level>level_trace) return;
-    for (i=0;i<n;i++) fprintf(fp_trace,"%02X%s",*p++,i%8==7?" ":"");
-    fprintf(fp_trace,"\n");
+    for (i=0;i<n;i++) tracef("%02X%s",*p++,i%8==7?" ":"");
+    tracef("\n");
 }
 #else
 extern void traceopen(const char *file) {}
@@ -3396,8 +4609,8 @@ static double mapf(double el, double a, double b, double c)
     double sinel=sin(el);
     return (1.0+a/(1.0+b/(1.0+c)))/(sinel+(a/(sinel+b/(sinel+c))));
 }
-static double nmf(gtime_t time, const double pos[], const double azel[],
-                  double *mapfw)
+/* NMF coefficients at time and latitude ------------------------------------*/
+static void nmfcoef(gtime_t time, const double pos[], double *ah, double *aw)
 {
     /* ref [5] table 3 */
     /* hydro-ave-a,b,c, hydro-amp-a,b,c, wet-a,b,c at latitude 15,30,45,60,75 */
@@ -3414,15 +4627,9 @@ static double nmf(gtime_t time, const double pos[], const double azel[],
         { 1.4275268E-3, 1.5138625E-3, 1.4572752E-3, 1.5007428E-3, 1.7599082E-3},
         { 4.3472961E-2, 4.6729510E-2, 4.3908931E-2, 4.4626982E-2, 5.4736038E-2}
     };
-    const double aht[]={ 2.53E-5, 5.49E-3, 1.14E-3}; /* height correction */
-    
-    double y,cosy,ah[3],aw[3],dm,el=azel[1],lat=pos[0]*R2D,hgt=pos[2];
+    double y,cosy,lat=pos[0]*R2D;
     int i;
     
-    if (el<=0.0) {
-        if (mapfw) *mapfw=0.0;
-        return 0.0;
-    }
     /* year from doy 28, added half a year for southern latitudes */
     y=(time2doy(time)-28.0)/365.25+(lat<0.0?0.5:0.0);
     
@@ -3433,6 +4640,18 @@ static double nmf(gtime_t time, const double pos[], const double azel[],
         ah[i]=interpc(coef[i  ],lat)-interpc(coef[i+3],lat)*cosy;
         aw[i]=interpc(coef[i+6],lat);
     }
+}
+/* NMF by coefficients -------------------------------------------------------*/
+static double nmf(const double *ah, const double *aw, double hgt, double el,
+                  double *mapfw)
+{
+    const double aht[]={ 2.53E-5, 5.49E-3, 1.14E-3}; /* height correction */
+    double dm;
+    
+    if (el<=0.0) {
+        if (mapfw) *mapfw=0.0;
+        return 0.0;
+    }
     /* ellipsoidal height is used instead of height above sea level */
     dm=(1.0/sin(el)-mapf(el,aht[0],aht[1],aht[2]))*hgt/1E3;
     
@@ -3459,6 +4678,8 @@ extern double tropmapf(gtime_t time, const double pos[], const double azel[],
 #ifdef IERS_MODEL
     const double ep[]={2000,1,1,12,0,0};
     double mjd,lat,lon,hgt,zd,gmfh,gmfw;
+#else
+    double ah[3],aw[3];
 #endif
     trace(4,"tropmapf: pos=%10.6f %11.6f %6.1f azel=%5.1f %4.1f\n",
           pos[0]*R2D,pos[1]*R2D,pos[2],azel[0]*R2D,azel[1]*R2D);
@@ -3480,8 +4701,105 @@ extern double tropmapf(gtime_t time, const double pos[], const double azel[],
     if (mapfw) *mapfw=gmfw;
     return gmfh;
 #else
-    return nmf(time,pos,azel,mapfw); /* NMF */
+    if (azel[1]<=0.0) {
+        if (mapfw) *mapfw=0.0;
+        return 0.0;
+    }
+    nmfcoef(time,pos,ah,aw);
+    
+    return nmf(ah,aw,pos[2],azel[1],mapfw); /* NMF */
+#endif
+}
+/* initialize troposphere context ----------------------------------------------
+* compute site and time dependent terms of troposphere model and mapping
+* function for an epoch
+* args   : gtime_t time     I   time
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          tropc_t *trop    O   troposphere context
+* return : none
+* notes  : trop->zhd is the zenith hydrostatic delay by tropmodel() with
+*          relative humidity 0
+*-----------------------------------------------------------------------------*/
+extern void tropinit(gtime_t time, const double *pos, tropc_t *trop)
+{
+    const double zazel[]={0.0,PI/2.0};
+#ifdef IERS_MODEL
+    const double ep[]={2000,1,1,12,0,0};
 #endif
+    int i;
+    
+    trace(4,"tropinit: pos=%10.6f %11.6f %6.1f\n",pos[0]*R2D,pos[1]*R2D,pos[2]);
+    
+    trop->time=time;
+    for (i=0;i<3;i++) {
+        trop->pos[i]=pos[i];
+        trop->ah[i]=trop->aw[i]=0.0;
+    }
+    trop->mjd=trop->hgt=0.0;
+    trop->zhd=tropmodel(time,pos,zazel,0.0);
+    trop->stat=pos[2]>=-1000.0&&pos[2]<=20000.0;
+    
+    if (!trop->stat) return;
+#ifdef IERS_MODEL
+    trop->mjd=51544.5+(timediff(time,epoch2time(ep)))/86400.0;
+    trop->hgt=pos[2]-geoidh(pos); /* height in m (mean sea level) */
+#else
+    nmfcoef(time,pos,trop->ah,trop->aw);
+#endif
+}
+/* troposphere mapping functions of satellites ---------------------------------
+* compute tropospheric mapping functions and gradient partials for satellites
+* with troposphere context
+* args   : tropc_t *trop    I   troposphere context by tropinit()
+*          double *azel     I   azimuth/elevation angles {az,el} (rad)
+*                               (azel[i*2]: satellite i)
+*          int    n         I   number of satellites
+*          double *mapfh    O   dry mapping functions (NULL: not output)
+*          double *mapfw    O   wet mapping functions (NULL: not output)
+*          double *grad     O   wet mapping function gradient partials
+*                               {mapfw*cot(el)*cos(az),mapfw*cot(el)*sin(az)}
+*                               (0.0: el<=0) (NULL: not output)
+* return : none
+* notes  : mapfh and mapfw are same as tropmapf() at trop->time and trop->pos
+*-----------------------------------------------------------------------------*/
+extern void tropmapfn(const tropc_t *trop, const double *azel, int n,
+                      double *mapfh, double *mapfw, double *grad)
+{
+#ifdef IERS_MODEL
+    double mjd,lat,lon,hgt,zd;
+#endif
+    double h,w,cotz;
+    int i;
+    
+    trace(4,"tropmapfn: n=%d stat=%d\n",n,trop->stat);
+    
+    for (i=0;i<n;i++) {
+        h=w=0.0;
+        if (trop->stat) {
+#ifdef IERS_MODEL
+            mjd=trop->mjd;
+            lat=trop->pos[0];
+            lon=trop->pos[1];
+            hgt=trop->hgt;
+            zd =PI/2.0-azel[i*2+1];
+            
+            /* call GMF */
+            gmf_(&mjd,&lat,&lon,&hgt,&zd,&h,&w);
+#else
+            h=nmf(trop->ah,trop->aw,trop->pos[2],azel[i*2+1],&w);
+#endif
+        }
+        if (mapfh) mapfh[i]=h;
+        if (mapfw) mapfw[i]=w;
+        if (!grad) continue;
+        
+        if (azel[i*2+1]>0.0) {
+            cotz=1.0/tan(azel[i*2+1]);
+            grad[i*2  ]=w*cotz*cos(azel[i*2]);
+            grad[i*2+1]=w*cotz*sin(azel[i*2]);
+        }
+        else grad[i*2]=grad[i*2+1]=0.0;
+    }
 }
 /* interpolate antenna phase center variation --------------------------------*/
 static double interpvar(double ang, const double *var)
@@ -3543,7 +4861,7 @@ static void sunmoonpos_eci(gtime_t tut, double *rsun, double *rmoon)
     const double ep2000[]={2000,1,1,12,0,0};
     double t,f[5],eps,Ms,ls,rs,lm,pm,rm,sine,cose,sinp,cosp,sinl,cosl;
     
-    trace(3,"sunmoonpos_eci: tut=%s\n",time_str(tut,3));
+    if (TRACEON(3)) trace(3,"sunmoonpos_eci: tut=%s\n",time_str(tut,3));
     
     t=timediff(tut,epoch2time(ep2000))/86400.0/36525.0;
     
@@ -3598,7 +4916,7 @@ extern void sunmoonpos(gtime_t tutc, const double *erpv, double *rsun,
     gtime_t tut;
     double rs[3],rm[3],U[9],gmst_;
     
-    trace(3,"sunmoonpos: tutc=%s\n",time_str(tutc,3));
+    if (TRACEON(3)) trace(3,"sunmoonpos: tutc=%s\n",time_str(tutc,3));
     
     tut=timeadd(tutc,erpv[2]); /* utc -> ut1 */
     
@@ -3631,7 +4949,7 @@ extern void windupcorr(gtime_t time, const double *rs, const double *rr,
     double dr[3],ds[3],drs[3],r[3],pos[3],rsun[3],cosp,ph,erpv[5]={0};
     int i;
     
-    trace(4,"windupcorr: time=%s\n",time_str(time,0));
+    if (TRACEON(4)) trace(4,"windupcorr: time=%s\n",time_str(time,0));
     
     /* sun position in ecef */
     sunmoonpos(gpst2utc(time),erpv,rsun,NULL,NULL);
@@ -215,6 +215,8 @@ extern "C" {
 #define MAXSBSURA   8                   /* max URA of SBAS satellite */
 #define MAXBAND     10                  /* max SBAS band of IGP */
 #define MAXNIGP     201                 /* max number of IGP in SBAS band */
+#define NIGPLAT     35                  /* number of IGP latitudes (-85...85) */
+#define NIGPLON     72                  /* number of IGP longitudes (-180...175) */
 #define MAXNGEO     4                   /* max number of GEO satellites */
 #define MAXCOMMENT  10                  /* max number of RINEX comments */
 #define MAXSTRPATH  1024                /* max length of stream path */
@@ -313,6 +315,7 @@ extern "C" {
 #define SOLF_ENU    2                   /* solution format: e/n/u-baseline */
 #define SOLF_NMEA   3                   /* solution format: NMEA-183 */
 #define SOLF_GSIF   4                   /* solution format: GSI-F1/2/3 */
+#define SOLF_BIN    5                   /* solution format: binary record */
 
 #define SOLQ_NONE   0                   /* solution status: no solution */
 #define SOLQ_FIX    1                   /* solution status: fix */
@@ -408,6 +411,23 @@ extern "C" {
 #define STR_MODE_W  0x2                 /* stream mode: write */
 #define STR_MODE_RW 0x3                 /* stream mode: read/write */
 
+#define STRQ_BLOCK   0                  /* output queue policy: block input */
+#define STRQ_DROPOLD 1                  /* output queue policy: drop oldest */
+#define STRQ_DROPNEW 2                  /* output queue policy: drop newest */
+
+#define PROF_RTKPOS  0                  /* timing stage: rtkpos() total */
+#define PROF_PNTPOS  1                  /* timing stage: pntpos() */
+#define PROF_SATPOS  2                  /* timing stage: satposs() */
+#define PROF_ZDRES   3                  /* timing stage: zdres() */
+#define PROF_DDRES   4                  /* timing stage: ddres() */
+#define PROF_FILTER  5                  /* timing stage: filter() */
+#define PROF_RESAMB  6                  /* timing stage: resamb_LAMBDA() */
+#define PROF_VALPOS  7                  /* timing stage: valpos() */
+#define PROF_PPPOS   8                  /* timing stage: pppos() */
+#define PROF_OUTSOL  9                  /* timing stage: solution output */
+#define NPROF        10                 /* number of timing stages */
+#define NPROFBIN     96                 /* number of timing histogram bins */
+
 #define GEOID_EMBEDDED    0             /* geoid model: embedded geoid */
 #define GEOID_EGM96_M150  1             /* geoid model: EGM96 15x15" */
 #define GEOID_EGM2008_M25 2             /* geoid model: EGM2008 2.5x2.5" */
@@ -460,6 +480,11 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define cond_t      CONDITION_VARIABLE
+#define initcond(c) InitializeConditionVariable(c)
+#define waitcond(c,f) SleepConditionVariableCS(c,f,INFINITE)
+#define signalcond(c) WakeAllConditionVariable(c)
+#define THREADLOCAL __declspec(thread) /* thread local storage */
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -467,6 +492,11 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define cond_t      pthread_cond_t
+#define initcond(c) pthread_cond_init(c,NULL)
+#define waitcond(c,f) pthread_cond_wait(c,f)
+#define signalcond(c) pthread_cond_broadcast(c)
+#define THREADLOCAL __thread
 #define FILEPATHSEP '/'
 #endif
 
@@ -488,9 +518,16 @@ typedef struct {        /* observation data record */
     float  D[NFREQ+NEXOBS]; /* observation data doppler frequency (Hz) */
 } obsd_t;
 
+typedef struct {        /* observation data epoch index */
+    gtime_t time;       /* epoch time */
+    int i,n;            /* start index/number of observation data records */
+} obsep_t;
+
 typedef struct {        /* observation data */
     int n,nmax;         /* number of obervation data/allocated */
     obsd_t *data;       /* observation data records */
+    int ne[2];          /* number of epochs of rover/base (by sortobs()) */
+    obsep_t *ep[2];     /* epoch index of rover/base (by sortobs()) */
 } obs_t;
 
 typedef struct {        /* earth rotation parameter data type */
@@ -506,6 +543,15 @@ typedef struct {        /* earth rotation parameter type */
     erpd_t *data;       /* earth rotation parameter data */
 } erp_t;
 
+typedef struct {        /* troposphere context type */
+    gtime_t time;       /* time */
+    double pos[3];      /* receiver position {lat,lon,h} (rad,m) */
+    int stat;           /* status (0:out of range of mapping function) */
+    double zhd;         /* zenith hydrostatic delay (m) */
+    double ah[3],aw[3]; /* NMF hydrostatic/wet coefficients {a,b,c} */
+    double mjd,hgt;     /* GMF mjd (days) and height above msl (m) */
+} tropc_t;
+
 typedef struct {        /* antenna parameter type */
     int sat;            /* satellite number (0:receiver) */
     char type[MAXANT];  /* antenna type */
@@ -519,6 +565,8 @@ typedef struct {        /* antenna parameter type */
 typedef struct {        /* antenna parameters type */
     int n,nmax;         /* number of data/allocated */
     pcv_t *pcv;         /* antenna parameters data */
+    int ni,nh;          /* number of indexed data/size of type hash table */
+    int *index;         /* index by satellite and antenna type */
 } pcvs_t;
 
 typedef struct {        /* almanac type */
@@ -580,6 +628,26 @@ typedef struct {        /* precise ephemeris type */
     float  vco[MAXSAT][3]; /* satellite velocity covariance (m^2) */
 } peph_t;
 
+typedef struct {        /* satellite-major precise ephemeris/clock type */
+    int n;              /* number of epochs */
+    int ns;             /* number of satellite series */
+    int nv;             /* number of values per epoch (4:ephemeris,1:clock) */
+    gtime_t *time;      /* epoch times (GPST) {t0,t1,...} */
+    int *index;         /* ephemeris/clock index of epochs for multiple files */
+    int sat[MAXSAT];    /* satellite numbers of series {sat1,sat2,...} */
+    int ser[MAXSAT];    /* series index+1 of satellites (0:no data) */
+    double *val;        /* values of series (ns x n x nv) (m|s) (0.0:no data) */
+    float  *std;        /* std-devs of series (ns x n x nv) (m|s) */
+} psat_t;
+
+typedef struct {        /* precise ephemeris interpolation cache type */
+    const double *val;  /* ephemeris values of cache (NULL: not built) */
+    int ne;             /* number of ephemeris epochs of cache */
+    gtime_t t0;         /* reference time of rotated positions (GPST) */
+    double *w;          /* barycentric weights of interpolation windows */
+    double *q[MAXSAT];  /* satellite positions rotated to t0 (NULL: no data) */
+} pephc_t;
+
 typedef struct {        /* precise clock type */
     gtime_t time;       /* time (GPST) */
     int index;          /* clock index for multiple files */
@@ -587,6 +655,49 @@ typedef struct {        /* precise clock type */
     float  std[MAXSAT][1]; /* satellite clock std (s) */
 } pclk_t;
 
+typedef struct {        /* record run of precise clock file type */
+    gtime_t time;       /* epoch time (GPST) */
+    int file;           /* file index */
+    long pos;           /* file position of first record */
+} pclkr_t;
+
+typedef struct {        /* window of time-indexed precise clock type */
+    const void *owner;  /* owner thread of window */
+    int ws,we;          /* epoch index range of loaded window [ws,we) */
+    psat_t win;         /* precise clock of loaded window */
+} pclkw_t;
+
+typedef struct {        /* satellite state type */
+    int stat;           /* status (0:unset,1:set) */
+    int ieph;           /* index of selected broadcast ephemeris (-1:none) */
+} satst_t;
+
+typedef struct {        /* satellite states of epoch type */
+    gtime_t time;       /* epoch time (GPST) */
+    double esun[3];     /* unit vector of sun direction (ecef) */
+    satst_t sat[MAXSAT]; /* satellite states */
+    unsigned int clkid; /* id of precise clock of window (0:no window) */
+    pclkw_t clkw;       /* window of time-indexed precise clock around epoch */
+    int pcos[MAXSAT];   /* status of antenna offsets (0:unset,1:set,-1:none) */
+    double pco[MAXSAT][3]; /* iono-free LC antenna offsets in body frame (m) */
+} satsts_t;
+
+typedef struct {        /* time-indexed precise clock type */
+    int nf,nfmax;       /* number of indexed clock files */
+    char **file;        /* clock file paths */
+    int *tmp;           /* temporary uncompressed file flags */
+    int nr,nrmax;       /* number of record runs */
+    pclkr_t *run;       /* record runs sorted by time */
+    int n;              /* number of epochs */
+    gtime_t *time;      /* epoch times (GPST) {t0,t1,...} */
+    int *r0;            /* first record run of epochs (n+1) */
+    unsigned char mask[MAXSAT]; /* satellites with records */
+    unsigned int id;    /* id of epochs (changed by reading files) */
+    int nw,nwmax;       /* number of windows of threads */
+    pclkw_t **w;        /* windows of threads */
+    lock_t lock;        /* lock flag of windows */
+} pclki_t;
+
 typedef struct {        /* SBAS ephemeris type */
     int sat;            /* satellite number */
     gtime_t t0;         /* reference epoch time (GPST) */
@@ -625,6 +736,16 @@ typedef struct {        /* norad two line element type */
     tled_t *data;       /* norad two line element data */
 } tle_t;
 
+typedef struct {        /* TLE propagator type */
+    const tle_t *tle;   /* TLE data */
+    int n;              /* number of TLE data */
+    void *sgp4;         /* SGP4 initialization terms of TLE data */
+    int nh;             /* size of hash tables */
+    int *hname;         /* hash table by satellite name (index+1,0:empty) */
+    int *hsatno;        /* hash table by catalog number (index+1,0:empty) */
+    int *hdesig;        /* hash table by designator (index+1,0:empty) */
+} tlep_t;
+
 typedef struct {        /* TEC grid type */
     gtime_t time;       /* epoch time (GPST) */
     int ndata[3];       /* TEC grid data size {nlat,nlon,nhgt} */
@@ -726,6 +847,13 @@ typedef struct {        /* SBAS ionospheric corrections type */
     sbsigp_t igp[MAXNIGP]; /* ionospheric correction */
 } sbsion_t;
 
+typedef struct {        /* SBAS IGP index type */
+    int n;              /* number of indexed igps */
+    short igp[NIGPLAT*NIGPLON][2]; /* band*MAXNIGP+index+1 of igps at grid */
+                        /* (lat,lon)=(-85+5*(i/NIGPLON),-180+5*(i%NIGPLON)) */
+                        /* in order of band (0:no igp) */
+} sbsigpi_t;
+
 typedef struct {        /* DGPS/GNSS correction type */
     gtime_t t0;         /* correction time */
     double prc;         /* pseudorange correction (PRC) (m) */
@@ -801,6 +929,11 @@ typedef struct {        /* navigation data type */
     seph_t *seph;       /* SBAS ephemeris */
     peph_t *peph;       /* precise ephemeris */
     pclk_t *pclk;       /* precise clock */
+    psat_t pephs;       /* satellite-major precise ephemeris */
+    psat_t pclks;       /* satellite-major precise clock */
+    pclki_t *pclki;     /* time-indexed precise clock (NULL: not used) */
+    pephc_t *pephc;     /* precise ephemeris interpolation cache */
+    const satsts_t *sats; /* satellite states of epoch (NULL: not used) */
     alm_t *alm;         /* almanac data */
     tec_t *tec;         /* tec grid data */
     stec_t *stec;       /* stec grid data */
@@ -824,6 +957,7 @@ typedef struct {        /* navigation data type */
     pcv_t pcvs[MAXSAT]; /* satellite antenna pcv */
     sbssat_t sbssat;    /* SBAS satellite corrections */
     sbsion_t sbsion[MAXBAND+1]; /* SBAS ionosphere corrections */
+    sbsigpi_t sbsigpi;  /* SBAS IGP index of grid */
     dgps_t dgps[MAXSAT]; /* DGPS corrections */
     ssr_t ssr[MAXSAT];  /* SSR corrections */
     lexeph_t lexeph[MAXSAT]; /* LEX ephemeris */
@@ -1053,6 +1187,7 @@ typedef struct {        /* file options type */
     char geexe  [MAXSTRPATH]; /* google earth exec file */
     char solstat[MAXSTRPATH]; /* solution statistics file */
     char trace  [MAXSTRPATH]; /* debug trace file */
+    char pcvdir [MAXSTRPATH]; /* binary antex cache directory ("":no cache) */
 } filopt_t;
 
 typedef struct {        /* RINEX options type */
@@ -1120,6 +1255,23 @@ typedef struct {        /* ambiguity control type */
     double LCv[4];      /* linear combination variance */
 } ambc_t;
 
+typedef struct {        /* timing counter type */
+    unsigned int n;     /* number of samples */
+    double sum;         /* total time (s) */
+    double min,max;     /* min/max time (s) */
+    unsigned int hist[NPROFBIN]; /* histogram (1/4 octave bins from 1 us) */
+} prof_t;
+
+typedef struct {        /* tide context type */
+    int opt;            /* tide options */
+    const erp_t *erp;   /* earth rotation parameters */
+    const double *odisp; /* ocean loading parameters */
+    double rr[3];       /* site position of grid values (ecef) (m) */
+    int n;              /* number of grid values (0:reset) */
+    gtime_t time[2];    /* grid times (utc) */
+    double dr[6];       /* displacements at grid times (ecef) (m) */
+} tidec_t;
+
 typedef struct {        /* RTK control/result type */
     sol_t  sol;         /* RTK solution */
     double rb[6];       /* base position/velocity (ecef) (m|m/s) */
@@ -1133,8 +1285,21 @@ typedef struct {        /* RTK control/result type */
     int neb;            /* bytes in error message buffer */
     char errbuf[MAXERRMSG]; /* error message buffer */
     prcopt_t opt;       /* processing options */
+    prof_t prof[NPROF]; /* timing counters of processing stages */
+    tidec_t tidec[2];   /* tide contexts of rover/base */
 } rtk_t;
 
+typedef struct {        /* network ppp station type */
+    const obs_t *obs;   /* observation data (sorted by time) */
+    prcopt_t opt;       /* processing options */
+    FILE *fp;           /* solution output stream (NULL: no output) */
+    FILE *fp_stat;      /* solution status output stream (NULL: no output) */
+    int statlevel;      /* solution status level (1:states,2:residuals) */
+    int index;          /* current observation data index */
+    int nsol;           /* number of output solutions */
+    rtk_t rtk;          /* rtk control/result */
+} pppsta_t;
+
 typedef struct {        /* receiver raw data control type */
     gtime_t time;       /* message time */
     gtime_t tobs[MAXSAT][NFREQ+NEXOBS]; /* observation data time */
@@ -1197,6 +1362,21 @@ typedef struct {        /* stream converter type */
     rtcm_t out;         /* rtcm output data buffer */
 } strconv_t;
 
+typedef struct {        /* stream server output queue type */
+    int policy;         /* queue policy (STRQ_???) */
+    int size;           /* queue buffer size (bytes) (0:default) */
+    int rp,nq;          /* read pointer and data length in queue (bytes) */
+    unsigned char *buff; /* queue buffer (ring) */
+    unsigned int ndrop; /* dropped bytes */
+    unsigned int lag;   /* output lag (ms) */
+    unsigned int tick;  /* tick of queue serviced or data queued to empty */
+    void *svr;          /* stream server */
+    int idx;            /* output stream index */
+    thread_t thread;    /* output thread */
+    lock_t lock;        /* lock flag */
+    cond_t cond;        /* condition of queued/freed data */
+} strq_t;
+
 typedef struct {        /* stream server type */
     int state;          /* server state (0:stop,1:running) */
     int cycle;          /* server cycle (ms) */
@@ -1210,6 +1390,7 @@ typedef struct {        /* stream server type */
     unsigned int tick;  /* start tick */
     stream_t stream[16]; /* input/output streams */
     strconv_t *conv[16]; /* stream converter */
+    strq_t q[16];       /* output queues */
     thread_t thread;    /* server thread */
     lock_t lock;        /* lock flag */
 } strsvr_t;
@@ -1300,6 +1481,8 @@ extern void matfprint(const double *A, int n, int m, int p, int q, FILE *fp);
 
 /* time and string functions -------------------------------------------------*/
 extern double  str2num(const char *s, int i, int n);
+extern char    *fmtfix(char *p, double x, int w, int prec, int zero);
+extern char    *fmtint(char *p, int d, int w, int zero);
 extern int     str2time(const char *s, int i, int n, gtime_t *t);
 extern void    time2str(gtime_t t, char *str, int n);
 extern gtime_t epoch2time(const double *ep);
@@ -1326,7 +1509,12 @@ extern int read_leaps(const char *file);
 
 extern int adjgpsweek(int week);
 extern unsigned int tickget(void);
+extern double ticktime(void);
+extern void profinit(prof_t *prof, int n);
+extern double profadd(prof_t *prof, double t0);
+extern int  profstat(const prof_t *prof, double *stat);
 extern void sleepms(int ms);
+extern void waitcondms(cond_t *cond, lock_t *lock, int ms);
 
 extern int reppath(const char *path, char *rpath, gtime_t time, const char *rov,
                    const char *base);
@@ -1348,17 +1536,32 @@ extern double dms2deg(const double *dms);
 /* input and output functions ------------------------------------------------*/
 extern void readpos(const char *file, const char *rcv, double *pos);
 extern int  sortobs(obs_t *obs);
+extern int  obsepoch(const obs_t *obs, int rcv, gtime_t time, int dir);
 extern void uniqnav(nav_t *nav);
 extern int  screent(gtime_t time, gtime_t ts, gtime_t te, double tint);
 extern int  readnav(const char *file, nav_t *nav);
 extern int  savenav(const char *file, const nav_t *nav);
 extern void freeobs(obs_t *obs);
 extern void freenav(nav_t *nav, int opt);
+extern int  newpsat(psat_t *ps, int n, int nv, const unsigned char *mask);
+extern int  peph2psat(const peph_t *peph, int n, psat_t *ps);
+extern int  pclk2psat(const pclk_t *pclk, int n, psat_t *ps);
+extern int  psat2peph(const psat_t *ps, nav_t *nav);
+extern int  psat2pclk(const psat_t *ps, nav_t *nav);
+extern void freepsat(psat_t *ps);
 extern int  readblq(const char *file, const char *sta, double *odisp);
 extern int  readerp(const char *file, erp_t *erp);
 extern int  geterp (const erp_t *erp, gtime_t time, double *val);
 
 /* debug trace functions -----------------------------------------------------*/
+extern int level_trace;     /* level of trace */
+
+#ifdef TRACE                /* trace level enabled (skip argument evaluation) */
+#define TRACEON(level)  ((level)<=1||(level)<=level_trace)
+#else
+#define TRACEON(level)  0
+#endif
+
 extern void traceopen(const char *file);
 extern void traceclose(void);
 extern void tracelevel(int level);
@@ -1395,8 +1598,14 @@ extern double tropmodel(gtime_t time, const double *pos, const double *azel,
                         double humi);
 extern double tropmapf(gtime_t time, const double *pos, const double *azel,
                        double *mapfw);
+extern void tropinit(gtime_t time, const double *pos, tropc_t *trop);
+extern void tropmapfn(const tropc_t *trop, const double *azel, int n,
+                      double *mapfh, double *mapfw, double *grad);
 extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
                   const double *azel, int opt, double *delay, double *var);
+extern int iontecs(gtime_t time, const nav_t *nav, const double *pos,
+                   const double *azel, int n, int opt, double *delay,
+                   double *var, int *stat);
 extern void readtec(const char *file, nav_t *nav, int opt);
 extern int ionocorr(gtime_t time, const nav_t *nav, int sat, const double *pos,
                     const double *azel, int ionoopt, double *ion, double *var);
@@ -1414,6 +1623,8 @@ extern void stec_free(nav_t *nav);
 
 /* antenna models ------------------------------------------------------------*/
 extern int  readpcv(const char *file, pcvs_t *pcvs);
+extern void freepcv(pcvs_t *pcvs);
+extern void setpcvcache(const char *dir);
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs);
 extern void antmodel(const pcv_t *pcv, const double *del, const double *azel,
@@ -1425,11 +1636,15 @@ extern void sunmoonpos(gtime_t tutc, const double *erpv, double *rsun,
                        double *rmoon, double *gmst);
 extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
                      const double *odisp, double *dr);
+extern void tidedispc(gtime_t tutc, const double *rr, int opt,
+                      const erp_t *erp, const double *odisp, tidec_t *tide,
+                      double *dr);
 
 /* geiod models --------------------------------------------------------------*/
 extern int opengeoid(int model, const char *file);
 extern void closegeoid(void);
 extern double geoidh(const double *pos);
+extern void geoidh_n(const double *pos, int n, double *h);
 
 /* datum transformation ------------------------------------------------------*/
 extern int loaddatump(const char *file);
@@ -1481,7 +1696,11 @@ extern int  satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
                    int *svh);
 extern void satposs(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                     int sateph, double *rs, double *dts, double *var, int *svh);
+extern int  satstates(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
+                      satsts_t *sats);
+extern void pephstates(gtime_t time, const nav_t *nav, satsts_t *sats);
 extern void readsp3(const char *file, nav_t *nav, int opt);
+extern int  readpclk(const char *file, nav_t *nav);
 extern int  readsap(const char *file, gtime_t time, nav_t *nav);
 extern int  readdcb(const char *file, nav_t *nav);
 extern void alm2pos(gtime_t time, const alm_t *alm, double *rs, double *dts);
@@ -1491,6 +1710,13 @@ extern int tle_name_read(const char *file, tle_t *tle);
 extern int tle_pos(gtime_t time, const char *name, const char *satno,
                    const char *desig, const tle_t *tle, const erp_t *erp,
                    double *rs);
+extern int tle_init(const tle_t *tle, tlep_t *tlep);
+extern void tle_free(tlep_t *tlep);
+extern int tle_index(const char *name, const char *satno, const char *desig,
+                     const tlep_t *tlep);
+extern int tle_posn(const gtime_t *time, int nt, const int *index, int ns,
+                    const tlep_t *tlep, const erp_t *erp, int nthread,
+                    double *rs);
 
 /* receiver raw data functions -----------------------------------------------*/
 extern unsigned int getbitu(const unsigned char *buff, int pos, int len);
@@ -1634,6 +1860,7 @@ extern void strsync  (stream_t *stream1, stream_t *stream2);
 extern int  strstat  (stream_t *stream, char *msg);
 extern void strsum   (stream_t *stream, int *inb, int *inr, int *outb, int *outr);
 extern void strsetopt(const int *opt);
+extern int  strseek    (stream_t *stream, double offset);
 extern gtime_t strgettime(stream_t *stream);
 extern void strsendnmea(stream_t *stream, const double *pos);
 extern void strsendcmd(stream_t *stream, const char *cmd);
@@ -1662,7 +1889,10 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav);
 extern int pppamb(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav,
                   const double *azel);
 extern int pppnx(const prcopt_t *opt);
+extern void setpppcorrc(double dpos);
 extern void pppoutsolstat(rtk_t *rtk, int level, FILE *fp);
+extern int pppnet(pppsta_t *sta, int nsta, gtime_t ts, gtime_t te, double ti,
+                  const nav_t *nav, const solopt_t *sopt, int nthread);
 extern void windupcorr(gtime_t time, const double *rs, const double *rr,
                        double *phw);
 
@@ -1671,6 +1901,10 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
                    const filopt_t *fopt, char **infile, int n, char *outfile,
                    const char *rov, const char *base);
+extern int pntposb(const obs_t *obs, gtime_t ts, gtime_t te, double ti,
+                   const nav_t *nav, const prcopt_t *popt,
+                   const solopt_t *sopt, int nthread, FILE *fp);
+extern void setbatchthr(int nthread);
 
 /* stream server functions ---------------------------------------------------*/
 extern void strsvrinit (strsvr_t *svr, int nout);
@@ -1678,7 +1912,9 @@ extern int  strsvrstart(strsvr_t *svr, int *opts, int *strs, char **paths,
                         strconv_t **conv, const char *cmd,
                         const double *nmeapos);
 extern void strsvrstop (strsvr_t *svr, const char *cmd);
-extern void strsvrstat (strsvr_t *svr, int *stat, int *byte, int *bps, char *msg);
+extern void strsvrstat (strsvr_t *svr, int *stat, int *byte, int *bps, int *lag,
+                        int *drop, char *msg);
+extern void strsvrsetq (strsvr_t *svr, int idx, int policy, int size);
 extern strconv_t *strconvnew(int itype, int otype, const char *msgs, int staid,
                              int stasel, const char *opt);
 extern void strconvfree(strconv_t *conv);
@@ -1700,6 +1936,7 @@ extern void rtksvrunlock(rtksvr_t *svr);
 extern int  rtksvrostat (rtksvr_t *svr, int type, gtime_t *time, int *sat,
                          double *az, double *el, int **snr, int *vsat);
 extern void rtksvrsstat (rtksvr_t *svr, int *sstat, char *msg);
+extern int  rtksvrprof  (rtksvr_t *svr, prof_t *prof, int reset);
 
 /* downloader functions ------------------------------------------------------*/
 extern int dl_readurls(const char *file, char **types, int ntype, url_t *urls,
@@ -1712,6 +1949,7 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
 extern void dl_test(gtime_t ts, gtime_t te, double ti, const url_t *urls,
                     int nurl, char **stas, int nsta, const char *dir,
                     int ncol, int datefmt, FILE *fp);
+extern void dl_setopt(int njob, int nhost, int nretry, const char *state);
 
 /* application defined functions ---------------------------------------------*/
 extern int showmsg(char *format,...);
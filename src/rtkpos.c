@@ -35,6 +35,11 @@
 *           2014/11/08 1.17 fix bug on ar-degradation by unhealthy satellites
 *           2015/03/23 1.18 residuals referenced to reference satellite
 *           2018/01/29 1.19 unfix ambiguity between gps and qzss
+*           2026/10/19 1.20 add timing counters of processing stages
+*                           add $PROF record in solution status
+*                           use troposphere context for mapping functions
+*                           use tide contexts of rover and base
+*                           match satellites of intpres() by index table
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
 #include "rtklib.h"
@@ -58,6 +63,7 @@ static const char rcsid[]="$Id:$";
 #define PRN_HWBIAS  1E-6     /* process noise of h/w bias (m/MHz/sqrt(s)) */
 #define GAP_RESION  120      /* gap to reset ionosphere parameters (epochs) */
 #define MAXACC      30.0     /* max accel for doppler slip detection (m/s^2) */
+#define INT_PROF    60.0     /* interval of timing counters in status (s) */
 
 #define VAR_HOLDAMB 0.001    /* constraint to hold ambiguity (cycle^2) */
 
@@ -103,6 +109,7 @@ static int statlevel=0;          /* rtk status output level (0:off) */
 static FILE *fp_stat=NULL;       /* rtk status file pointer */
 static char file_stat[1024]="";  /* rtk status file original path */
 static gtime_t time_stat={0};    /* rtk status file time */
+static gtime_t time_prof={0};    /* timing counters output time */
 
 /* open solution status file ---------------------------------------------------
 * open solution status file and set output level
@@ -172,6 +179,12 @@ static gtime_t time_stat={0};    /* rtk status file time */
 *          slipc    : cycle-slip count
 *          rejc     : data reject (outlier) count
 *
+*   $PROF,week,tow,stage,n,min,mean,p99,max (output every 60 s)
+*          week/tow : gps week no/time of week (s)
+*          stage    : processing stage (PROF_???)
+*          n        : number of samples
+*          min/mean/p99/max : processing time of stage (ms) (wall-clock)
+*
 *-----------------------------------------------------------------------------*/
 extern int rtkopenstat(const char *file, int level)
 {
@@ -329,6 +342,26 @@ static void outsolstat(rtk_t *rtk)
         }
     }
 }
+/* output timing counters ----------------------------------------------------*/
+static void outprofstat(rtk_t *rtk)
+{
+    double tow,stat[4];
+    int i,week;
+    
+    if (statlevel<=0||!fp_stat||rtk->sol.stat==SOLQ_NONE) return;
+    
+    if (time_prof.time&&fabs(timediff(rtk->sol.time,time_prof))<INT_PROF) {
+        return;
+    }
+    time_prof=rtk->sol.time;
+    tow=time2gpst(rtk->sol.time,&week);
+    
+    for (i=0;i<NPROF;i++) {
+        if (!profstat(rtk->prof+i,stat)) continue;
+        fprintf(fp_stat,"$PROF,%d,%.3f,%d,%u,%.3f,%.3f,%.3f,%.3f\n",week,tow,i,
+                rtk->prof[i].n,stat[0]*1E3,stat[1]*1E3,stat[2]*1E3,stat[3]*1E3);
+    }
+}
 /* save error message --------------------------------------------------------*/
 static void errmsg(rtk_t *rtk, const char *format, ...)
 {
@@ -846,11 +879,11 @@ static void zdres_sat(int base, double r, const obsd_t *obs, const nav_t *nav,
 /* undifferenced phase/code residuals ----------------------------------------*/
 static int zdres(int base, const obsd_t *obs, int n, const double *rs,
                  const double *dts, const int *svh, const nav_t *nav,
-                 const double *rr, const prcopt_t *opt, int index, double *y,
-                 double *e, double *azel)
+                 const double *rr, const prcopt_t *opt, int index,
+                 tidec_t *tide, double *y, double *e, double *azel)
 {
-    double r,rr_[3],pos[3],dant[NFREQ]={0},disp[3];
-    double zhd,zazel[]={0.0,90.0*D2R};
+    tropc_t trop;
+    double r,rr_[3],pos[3],dant[NFREQ]={0},disp[3],m_h;
     int i,nf=NF(opt);
     
     trace(3,"zdres   : n=%d\n",n);
@@ -863,12 +896,15 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     
     /* earth tide correction */
     if (opt->tidecorr) {
-        tidedisp(gpst2utc(obs[0].time),rr_,opt->tidecorr,&nav->erp,
-                 opt->odisp[base],disp);
+        tidedispc(gpst2utc(obs[0].time),rr_,opt->tidecorr,&nav->erp,
+                  opt->odisp[base],tide,disp);
         for (i=0;i<3;i++) rr_[i]+=disp[i];
     }
     ecef2pos(rr_,pos);
     
+    /* troposphere context of the epoch */
+    if (n>0) tropinit(obs[0].time,pos,&trop);
+    
     for (i=0;i<n;i++) {
         /* compute geometric-range and azimuth/elevation angle */
         if ((r=geodist(rs+i*6,rr_,e+i*3))<=0.0) continue;
@@ -881,8 +917,11 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
         r+=-CLIGHT*dts[i*2];
         
         /* troposphere delay model (hydrostatic) */
-        zhd=tropmodel(obs[0].time,pos,zazel,0.0);
-        r+=tropmapf(obs[i].time,pos,azel+i*2,NULL)*zhd;
+        if (obs[i].time.time!=trop.time.time||obs[i].time.sec!=trop.time.sec) {
+            tropinit(obs[i].time,pos,&trop);
+        }
+        tropmapfn(&trop,azel+i*2,1,&m_h,NULL,NULL);
+        r+=m_h*trop.zhd;
         
         /* receiver antenna phase center correction */
         antmodel(opt->pcvr+index,opt->antdel[index],azel+i*2,opt->posopt[1],
@@ -969,25 +1008,18 @@ static int constbl(rtk_t *rtk, const double *x, const double *P, double *v,
     return 1;
 }
 /* precise tropspheric model -------------------------------------------------*/
-static double prectrop(gtime_t time, const double *pos, int r,
+static double prectrop(double m_w, const double *grad, int r,
                        const double *azel, const prcopt_t *opt, const double *x,
                        double *dtdx)
 {
-    double m_w=0.0,cotz,grad_n,grad_e;
     int i=IT(r,opt);
     
-    /* wet mapping function */
-    tropmapf(time,pos,azel,&m_w);
-    
     if (opt->tropopt>=TROPOPT_ESTG&&azel[1]>0.0) {
         
         /* m_w=m_0+m_0*cot(el)*(Gn*cos(az)+Ge*sin(az)): ref [6] */
-        cotz=1.0/tan(azel[1]);
-        grad_n=m_w*cotz*cos(azel[0]);
-        grad_e=m_w*cotz*sin(azel[0]);
-        m_w+=grad_n*x[i+1]+grad_e*x[i+2];
-        dtdx[1]=grad_n*x[i];
-        dtdx[2]=grad_e*x[i];
+        m_w+=grad[0]*x[i+1]+grad[1]*x[i+2];
+        dtdx[1]=grad[0]*x[i];
+        dtdx[2]=grad[1]*x[i];
     }
     else dtdx[1]=dtdx[2]=0.0;
     dtdx[0]=m_w;
@@ -1025,8 +1057,10 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
                  double *H, double *R, int *vflg)
 {
     prcopt_t *opt=&rtk->opt;
+    tropc_t trop[2];
     double bl,dr[3],posu[3],posr[3],didxi=0.0,didxj=0.0,*im;
     double *tropr,*tropu,*dtdxr,*dtdxu,*Ri,*Rj,lami,lamj,fi,fj,df,*Hi=NULL;
+    double *azu,*azr,*mwu,*mwr,*gradu,*gradr;
     int i,j,k,m,f,ff,nv=0,nb[NFREQ*4*2+2]={0},b=0,sysi,sysj,nf=NF(opt);
     
     trace(3,"ddres   : dt=%.1f nx=%d ns=%d\n",dt,rtk->nx,ns);
@@ -1036,18 +1070,31 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     
     Ri=mat(ns*nf*2+2,1); Rj=mat(ns*nf*2+2,1); im=mat(ns,1);
     tropu=mat(ns,1); tropr=mat(ns,1); dtdxu=mat(ns,3); dtdxr=mat(ns,3);
+    azu=mat(2,ns); azr=mat(2,ns); mwu=mat(ns,1); mwr=mat(ns,1);
+    gradu=mat(2,ns); gradr=mat(2,ns);
     
     for (i=0;i<MAXSAT;i++) for (j=0;j<NFREQ;j++) {
         rtk->ssat[i].resp[j]=rtk->ssat[i].resc[j]=0.0;
     }
+    /* wet mapping functions and gradients of rover and base */
+    if (opt->tropopt>=TROPOPT_EST) {
+        for (i=0;i<ns;i++) for (j=0;j<2;j++) {
+            azu[i*2+j]=azel[iu[i]*2+j];
+            azr[i*2+j]=azel[ir[i]*2+j];
+        }
+        tropinit(rtk->sol.time,posu,trop  );
+        tropinit(rtk->sol.time,posr,trop+1);
+        tropmapfn(trop  ,azu,ns,NULL,mwu,gradu);
+        tropmapfn(trop+1,azr,ns,NULL,mwr,gradr);
+    }
     /* compute factors of ionospheric and tropospheric delay */
     for (i=0;i<ns;i++) {
         if (opt->ionoopt>=IONOOPT_EST) {
             im[i]=(ionmapf(posu,azel+iu[i]*2)+ionmapf(posr,azel+ir[i]*2))/2.0;
         }
         if (opt->tropopt>=TROPOPT_EST) {
-            tropu[i]=prectrop(rtk->sol.time,posu,0,azel+iu[i]*2,opt,x,dtdxu+i*3);
-            tropr[i]=prectrop(rtk->sol.time,posr,1,azel+ir[i]*2,opt,x,dtdxr+i*3);
+            tropu[i]=prectrop(mwu[i],gradu+i*2,0,azu+i*2,opt,x,dtdxu+i*3);
+            tropr[i]=prectrop(mwr[i],gradr+i*2,1,azr+i*2,opt,x,dtdxr+i*3);
         }
     }
     for (m=0;m<5;m++) /* m=0:gps/sbs,1:glo,2:gal,3:bds,4:qzs */
@@ -1199,6 +1246,7 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     
     free(Ri); free(Rj); free(im);
     free(tropu); free(tropr); free(dtdxu); free(dtdxr);
+    free(azu); free(azr); free(mwu); free(mwr); free(gradu); free(gradr);
     
     return nv;
 }
@@ -1212,7 +1260,7 @@ static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
     static int nb=0,svh[MAXOBS*2];
     prcopt_t *opt=&rtk->opt;
     double tt=timediff(time,obs[0].time),ttb,*p,*q;
-    int i,j,k,nf=NF(opt);
+    int i,j,k,nf=NF(opt),ib[MAXSAT];
     
     trace(3,"intpres : n=%d tt=%.1f\n",n,tt);
     
@@ -1225,12 +1273,16 @@ static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
     
     satposs(time,obsb,nb,nav,opt->sateph,rs,dts,var,svh);
     
-    if (!zdres(1,obsb,nb,rs,dts,svh,nav,rtk->rb,opt,1,yb,e,azel)) {
+    if (!zdres(1,obsb,nb,rs,dts,svh,nav,rtk->rb,opt,1,rtk->tidec+1,yb,e,
+               azel)) {
         return tt;
     }
+    /* index of satellites in previous reference epoch */
+    for (i=0;i<MAXSAT;i++) ib[i]=-1;
+    for (j=nb-1;j>=0;j--) ib[obsb[j].sat-1]=j;
+    
     for (i=0;i<n;i++) {
-        for (j=0;j<nb;j++) if (obsb[j].sat==obs[i].sat) break;
-        if (j>=nb) continue;
+        if ((j=ib[obs[i].sat-1])<0) continue;
         for (k=0,p=y+i*nf*2,q=yb+j*nf*2;k<nf*2;k++,p++,q++) {
             if (*p==0.0||*q==0.0) *p=0.0; else *p=(ttb*(*p)-tt*(*q))/(ttb-tt);
         }
@@ -1493,9 +1545,9 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
 {
     prcopt_t *opt=&rtk->opt;
     gtime_t time=obs[0].time;
-    double *rs,*dts,*var,*y,*e,*azel,*v,*H,*R,*xp,*Pp,*xa,*bias,dt;
-    int i,j,f,n=nu+nr,ns,ny,nv,sat[MAXSAT],iu[MAXSAT],ir[MAXSAT],niter;
-    int info,vflg[MAXOBS*NFREQ*2+1],svh[MAXOBS*2];
+    double *rs,*dts,*var,*y,*e,*azel,*v,*H,*R,*xp,*Pp,*xa,*bias,dt,t;
+    int i,j,f,n=nu+nr,ns,ny,nv,nb,sat[MAXSAT],iu[MAXSAT],ir[MAXSAT],niter;
+    int ok,info,vflg[MAXOBS*NFREQ*2+1],svh[MAXOBS*2];
     int stat=rtk->opt.mode<=PMODE_DGPS?SOLQ_DGPS:SOLQ_FLOAT;
     int nf=opt->ionoopt==IONOOPT_IFLC?1:opt->nf;
     
@@ -1511,11 +1563,16 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         for (j=0;j<NFREQ;j++) rtk->ssat[i].vsat[j]=rtk->ssat[i].snr[j]=0;
     }
     /* satellite positions/clocks */
+    t=ticktime();
     satposs(time,obs,n,nav,opt->sateph,rs,dts,var,svh);
+    t=profadd(rtk->prof+PROF_SATPOS,t);
     
     /* undifferenced residuals for base station */
-    if (!zdres(1,obs+nu,nr,rs+nu*6,dts+nu*2,svh+nu,nav,rtk->rb,opt,1,
-               y+nu*nf*2,e+nu*3,azel+nu*2)) {
+    ok=zdres(1,obs+nu,nr,rs+nu*6,dts+nu*2,svh+nu,nav,rtk->rb,opt,1,
+             rtk->tidec+1,y+nu*nf*2,e+nu*3,azel+nu*2);
+    profadd(rtk->prof+PROF_ZDRES,t);
+    
+    if (!ok) {
         errmsg(rtk,"initial base station position error\n");
         
         free(rs); free(dts); free(var); free(y); free(e); free(azel);
@@ -1548,33 +1605,49 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
     
     for (i=0;i<niter;i++) {
         /* undifferenced residuals for rover */
-        if (!zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,y,e,azel)) {
+        t=ticktime();
+        ok=zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,rtk->tidec,y,e,azel);
+        t=profadd(rtk->prof+PROF_ZDRES,t);
+        
+        if (!ok) {
             errmsg(rtk,"rover initial position error\n");
             stat=SOLQ_NONE;
             break;
         }
         /* double-differenced residuals and partial derivatives */
-        if ((nv=ddres(rtk,nav,dt,xp,Pp,sat,y,e,azel,iu,ir,ns,v,H,R,vflg))<1) {
+        nv=ddres(rtk,nav,dt,xp,Pp,sat,y,e,azel,iu,ir,ns,v,H,R,vflg);
+        t=profadd(rtk->prof+PROF_DDRES,t);
+        
+        if (nv<1) {
             errmsg(rtk,"no double-differenced residual\n");
             stat=SOLQ_NONE;
             break;
         }
         /* kalman filter measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        info=filter(xp,Pp,H,v,R,rtk->nx,nv);
+        profadd(rtk->prof+PROF_FILTER,t);
+        
+        if (info) {
             errmsg(rtk,"filter error (info=%d)\n",info);
             stat=SOLQ_NONE;
             break;
         }
         trace(4,"x(%d)=",i+1); tracemat(4,xp,1,NR(opt),13,4);
     }
-    if (stat!=SOLQ_NONE&&zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,y,e,azel)) {
+    t=ticktime();
+    
+    if (stat!=SOLQ_NONE&&
+        zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,rtk->tidec,y,e,azel)) {
         
         /* post-fit residuals for float solution */
         nv=ddres(rtk,nav,dt,xp,Pp,sat,y,e,azel,iu,ir,ns,v,NULL,R,vflg);
         
         /* validation of float solution */
-        if (valpos(rtk,v,R,vflg,nv,4.0)) {
+        ok=valpos(rtk,v,R,vflg,nv,4.0);
+        profadd(rtk->prof+PROF_VALPOS,t);
+        
+        if (ok) {
             
             /* update state and covariance matrix */
             matcpy(rtk->x,xp,rtk->nx,1);
@@ -1608,15 +1681,23 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         }
     }
     /* resolve integer ambiguity by LAMBDA */
-    else if (stat!=SOLQ_NONE&&resamb_LAMBDA(rtk,bias,xa)>1) {
+    else if (stat!=SOLQ_NONE) {
+        
+        t=ticktime();
+        nb=resamb_LAMBDA(rtk,bias,xa);
+        t=profadd(rtk->prof+PROF_RESAMB,t);
         
-        if (zdres(0,obs,nu,rs,dts,svh,nav,xa,opt,0,y,e,azel)) {
+        if (nb>1&&zdres(0,obs,nu,rs,dts,svh,nav,xa,opt,0,rtk->tidec,y,e,
+                        azel)) {
             
             /* post-fit reisiduals for fixed solution */
             nv=ddres(rtk,nav,dt,xa,NULL,sat,y,e,azel,iu,ir,ns,v,NULL,R,vflg);
             
             /* validation of fixed solution */
-            if (valpos(rtk,v,R,vflg,nv,4.0)) {
+            ok=valpos(rtk,v,R,vflg,nv,4.0);
+            profadd(rtk->prof+PROF_VALPOS,t);
+            
+            if (ok) {
                 
                 /* hold integer ambiguity */
                 if (++rtk->nfix>=rtk->opt.minfix&&
@@ -1679,6 +1760,7 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     sol_t sol0={{0}};
     ambc_t ambc0={{{0}}};
     ssat_t ssat0={0};
+    tidec_t tidec0={0};
     int i;
     
     trace(3,"rtkinit :\n");
@@ -1699,6 +1781,8 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     }
     for (i=0;i<MAXERRMSG;i++) rtk->errbuf[i]=0;
     rtk->opt=*opt;
+    profinit(rtk->prof,NPROF);
+    rtk->tidec[0]=rtk->tidec[1]=tidec0;
 }
 /* free rtk control ------------------------------------------------------------
 * free memory for rtk control struct
@@ -1715,73 +1799,17 @@ extern void rtkfree(rtk_t *rtk)
     free(rtk->xa); rtk->xa=NULL;
     free(rtk->Pa); rtk->Pa=NULL;
 }
-/* precise positioning ---------------------------------------------------------
-* input observation data and navigation message, compute rover position by 
-* precise positioning
-* args   : rtk_t *rtk       IO  rtk control/result struct
-*            rtk->sol       IO  solution
-*                .time      O   solution time
-*                .rr[]      IO  rover position/velocity
-*                               (I:fixed mode,O:single mode)
-*                .dtr[0]    O   receiver clock bias (s)
-*                .dtr[1]    O   receiver glonass-gps time offset (s)
-*                .Qr[]      O   rover position covarinace
-*                .stat      O   solution status (SOLQ_???)
-*                .ns        O   number of valid satellites
-*                .age       O   age of differential (s)
-*                .ratio     O   ratio factor for ambiguity validation
-*            rtk->rb[]      IO  base station position/velocity
-*                               (I:relative mode,O:moving-base mode)
-*            rtk->nx        I   number of all states
-*            rtk->na        I   number of integer states
-*            rtk->ns        O   number of valid satellite
-*            rtk->tt        O   time difference between current and previous (s)
-*            rtk->x[]       IO  float states pre-filter and post-filter
-*            rtk->P[]       IO  float covariance pre-filter and post-filter
-*            rtk->xa[]      O   fixed states after AR
-*            rtk->Pa[]      O   fixed covariance after AR
-*            rtk->ssat[s]   IO  sat(s+1) status
-*                .sys       O   system (SYS_???)
-*                .az   [r]  O   azimuth angle   (rad) (r=0:rover,1:base)
-*                .el   [r]  O   elevation angle (rad) (r=0:rover,1:base)
-*                .vs   [r]  O   data valid single     (r=0:rover,1:base)
-*                .resp [f]  O   freq(f+1) pseudorange residual (m)
-*                .resc [f]  O   freq(f+1) carrier-phase residual (m)
-*                .vsat [f]  O   freq(f+1) data vaild (0:invalid,1:valid)
-*                .fix  [f]  O   freq(f+1) ambiguity flag
-*                               (0:nodata,1:float,2:fix,3:hold)
-*                .slip [f]  O   freq(f+1) slip flag
-*                               (bit8-7:rcv1 LLI, bit6-5:rcv2 LLI,
-*                                bit2:parity unknown, bit1:slip)
-*                .lock [f]  IO  freq(f+1) carrier lock count
-*                .outc [f]  IO  freq(f+1) carrier outage count
-*                .slipc[f]  IO  freq(f+1) cycle slip count
-*                .rejc [f]  IO  freq(f+1) data reject count
-*                .gf        IO  geometry-free phase (L1-L2) (m)
-*                .gf2       IO  geometry-free phase (L1-L5) (m)
-*            rtk->nfix      IO  number of continuous fixes of ambiguity
-*            rtk->neb       IO  bytes of error message buffer
-*            rtk->errbuf    IO  error message buffer
-*            rtk->tstr      O   time string for debug
-*            rtk->opt       I   processing options
-*          obsd_t *obs      I   observation data for an epoch
-*                               obs[i].rcv=1:rover,2:reference
-*                               sorted by receiver and satellte
-*          int    n         I   number of observation data
-*          nav_t  *nav      I   navigation messages
-* return : status (0:no solution,1:valid solution)
-* notes  : before calling function, base station position rtk->sol.rb[] should
-*          be properly set for relative mode except for moving-baseline
-*-----------------------------------------------------------------------------*/
-extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
+/* precise positioning of an epoch ------------------------------------------*/
+static int procrtk(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
     prcopt_t *opt=&rtk->opt;
     sol_t solb={{0}};
     gtime_t time;
-    int i,nu,nr;
+    double t;
+    int i,nu,nr,stat;
     char msg[128]="";
     
-    trace(3,"rtkpos  : time=%s n=%d\n",time_str(obs[0].time,3),n);
+    if (TRACEON(3)) trace(3,"rtkpos  : time=%s n=%d\n",time_str(obs[0].time,3),n);
     trace(4,"obs=\n"); traceobs(4,obs,n);
     /*trace(5,"nav=\n"); tracenav(5,nav);*/
     
@@ -1796,7 +1824,11 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     time=rtk->sol.time; /* previous epoch */
     
     /* rover position by single point positioning */
-    if (!pntpos(obs,nu,nav,&rtk->opt,&rtk->sol,NULL,rtk->ssat,msg)) {
+    t=ticktime();
+    stat=pntpos(obs,nu,nav,&rtk->opt,&rtk->sol,NULL,rtk->ssat,msg);
+    profadd(rtk->prof+PROF_PNTPOS,t);
+    
+    if (!stat) {
         errmsg(rtk,"point pos error (%s)\n",msg);
         
         if (!rtk->opt.dynamics) {
@@ -1813,7 +1845,9 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     /* precise point positioning */
     if (opt->mode>=PMODE_PPP_KINEMA) {
+        t=ticktime();
         pppos(rtk,obs,nu,nav);
+        profadd(rtk->prof+PROF_PPPOS,t);
         pppoutsolstat(rtk,statlevel,fp_stat);
         return 1;
     }
@@ -1826,7 +1860,11 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     if (opt->mode==PMODE_MOVEB) { /*  moving baseline */
         
         /* estimate position/velocity of base station */
-        if (!pntpos(obs+nu,nr,nav,&rtk->opt,&solb,NULL,NULL,msg)) {
+        t=ticktime();
+        stat=pntpos(obs+nu,nr,nav,&rtk->opt,&solb,NULL,NULL,msg);
+        profadd(rtk->prof+PROF_PNTPOS,t);
+        
+        if (!stat) {
             errmsg(rtk,"base station position error (%s)\n",msg);
             return 0;
         }
@@ -1856,3 +1894,72 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     
     return 1;
 }
+/* precise positioning ---------------------------------------------------------
+* input observation data and navigation message, compute rover position by 
+* precise positioning
+* args   : rtk_t *rtk       IO  rtk control/result struct
+*            rtk->sol       IO  solution
+*                .time      O   solution time
+*                .rr[]      IO  rover position/velocity
+*                               (I:fixed mode,O:single mode)
+*                .dtr[0]    O   receiver clock bias (s)
+*                .dtr[1]    O   receiver glonass-gps time offset (s)
+*                .Qr[]      O   rover position covarinace
+*                .stat      O   solution status (SOLQ_???)
+*                .ns        O   number of valid satellites
+*                .age       O   age of differential (s)
+*                .ratio     O   ratio factor for ambiguity validation
+*            rtk->rb[]      IO  base station position/velocity
+*                               (I:relative mode,O:moving-base mode)
+*            rtk->nx        I   number of all states
+*            rtk->na        I   number of integer states
+*            rtk->ns        O   number of valid satellite
+*            rtk->tt        O   time difference between current and previous (s)
+*            rtk->x[]       IO  float states pre-filter and post-filter
+*            rtk->P[]       IO  float covariance pre-filter and post-filter
+*            rtk->xa[]      O   fixed states after AR
+*            rtk->Pa[]      O   fixed covariance after AR
+*            rtk->ssat[s]   IO  sat(s+1) status
+*                .sys       O   system (SYS_???)
+*                .az   [r]  O   azimuth angle   (rad) (r=0:rover,1:base)
+*                .el   [r]  O   elevation angle (rad) (r=0:rover,1:base)
+*                .vs   [r]  O   data valid single     (r=0:rover,1:base)
+*                .resp [f]  O   freq(f+1) pseudorange residual (m)
+*                .resc [f]  O   freq(f+1) carrier-phase residual (m)
+*                .vsat [f]  O   freq(f+1) data vaild (0:invalid,1:valid)
+*                .fix  [f]  O   freq(f+1) ambiguity flag
+*                               (0:nodata,1:float,2:fix,3:hold)
+*                .slip [f]  O   freq(f+1) slip flag
+*                               (bit8-7:rcv1 LLI, bit6-5:rcv2 LLI,
+*                                bit2:parity unknown, bit1:slip)
+*                .lock [f]  IO  freq(f+1) carrier lock count
+*                .outc [f]  IO  freq(f+1) carrier outage count
+*                .slipc[f]  IO  freq(f+1) cycle slip count
+*                .rejc [f]  IO  freq(f+1) data reject count
+*                .gf        IO  geometry-free phase (L1-L2) (m)
+*                .gf2       IO  geometry-free phase (L1-L5) (m)
+*            rtk->nfix      IO  number of continuous fixes of ambiguity
+*            rtk->neb       IO  bytes of error message buffer
+*            rtk->errbuf    IO  error message buffer
+*            rtk->tstr      O   time string for debug
+*            rtk->opt       I   processing options
+*          obsd_t *obs      I   observation data for an epoch
+*                               obs[i].rcv=1:rover,2:reference
+*                               sorted by receiver and satellte
+*          int    n         I   number of observation data
+*          nav_t  *nav      I   navigation messages
+* return : status (0:no solution,1:valid solution)
+* notes  : before calling function, base station position rtk->sol.rb[] should
+*          be properly set for relative mode except for moving-baseline
+*-----------------------------------------------------------------------------*/
+extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
+{
+    double t=ticktime();
+    int stat;
+    
+    stat=procrtk(rtk,obs,n,nav);
+    
+    profadd(rtk->prof+PROF_RTKPOS,t);
+    outprofstat(rtk);
+    return stat;
+}
@@ -29,6 +29,10 @@
 *                            fix bug on ion/utc parameters input
 *                            fix server-crash with server-cycle > 1000
 *                            add rtkfree() in rtksvrfree()
+*           2026/10/19  1.11 format solution once per distinct output options
+*                            swap satellite-major precise ephemeris/clock
+*                           add api rtksvrprof()
+*                            free epoch index of observation data buffers
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -54,34 +58,59 @@ static void saveoutbuf(rtksvr_t *svr, unsigned char *buff, int n, int index)
     
     rtksvrunlock(svr);
 }
+/* compare solution options for output formatting --------------------------*/
+static int eqsolopt(const solopt_t *opt1, const solopt_t *opt2)
+{
+    return opt1->posf==opt2->posf&&opt1->times==opt2->times&&
+           opt1->timef==opt2->timef&&opt1->timeu==opt2->timeu&&
+           opt1->degf==opt2->degf&&opt1->height==opt2->height&&
+           opt1->geoid==opt2->geoid&&opt1->datum==opt2->datum&&
+           opt1->nmeaintv[0]==opt2->nmeaintv[0]&&
+           opt1->nmeaintv[1]==opt2->nmeaintv[1]&&!strcmp(opt1->sep,opt2->sep);
+}
 /* write solution to output stream -------------------------------------------*/
 static void writesol(rtksvr_t *svr, int index)
 {
     solopt_t solopt=solopt_default;
-    unsigned char buff[1024];
-    int i,n;
+    const solopt_t *opt[3];
+    unsigned char buff[3][1024],buffe[2][1024],*p[3],*q[2];
+    int i,j,n[3],m[2];
     
     tracet(4,"writesol: index=%d\n",index);
     
+    opt[0]=svr->solopt; opt[1]=svr->solopt+1; opt[2]=&solopt;
+    
+    /* format solution once per distinct solution options */
+    for (i=0;i<(svr->moni?3:2);i++) {
+        for (j=0;j<i;j++) if (eqsolopt(opt[i],opt[j])) break;
+        if (j<i) {
+            p[i]=p[j]; n[i]=n[j];
+            if (i<2) {q[i]=q[j]; m[i]=m[j];}
+            continue;
+        }
+        p[i]=buff[i];
+        n[i]=outsols(p[i],&svr->rtk.sol,svr->rtk.rb,opt[i]);
+        if (i<2) {
+            q[i]=buffe[i];
+            m[i]=outsolexs(q[i],&svr->rtk.sol,svr->rtk.ssat,opt[i]);
+        }
+    }
     for (i=0;i<2;i++) {
         /* output solution */
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
+        strwrite(svr->stream+i+3,p[i],n[i]);
         
         /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
+        saveoutbuf(svr,p[i],n[i],i);
         
         /* output extended solution */
-        n=outsolexs(buff,&svr->rtk.sol,svr->rtk.ssat,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
+        strwrite(svr->stream+i+3,q[i],m[i]);
         
         /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
+        saveoutbuf(svr,q[i],m[i],i);
     }
     /* output solution to monitor port */
     if (svr->moni) {
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,&solopt);
-        strwrite(svr->moni,buff,n);
+        strwrite(svr->moni,p[2],n[2]);
     }
     /* save solution buffer */
     if (svr->nsol<MAXSOLBUF) {
@@ -324,6 +353,8 @@ static int decoderaw(rtksvr_t *svr, int index)
 static void decodefile(rtksvr_t *svr, int index)
 {
     nav_t nav={0};
+    psat_t ps;
+    pephc_t *pephc;
     char file[1024];
     int nb;
     
@@ -346,16 +377,19 @@ static void decodefile(rtksvr_t *svr, int index)
         
         /* read sp3 precise ephemeris */
         readsp3(file,&nav,0);
-        if (nav.ne<=0) {
+        if (nav.pephs.n<=0) {
             tracet(1,"sp3 file read error: %s\n",file);
             return;
         }
         /* update precise ephemeris */
         rtksvrlock(svr);
         
-        if (svr->nav.peph) free(svr->nav.peph);
-        svr->nav.ne=svr->nav.nemax=nav.ne;
-        svr->nav.peph=nav.peph;
+        /* swap satellite-major ephemeris and interpolation cache */
+        ps=svr->nav.pephs; svr->nav.pephs=nav.pephs; nav.pephs=ps;
+        pephc=svr->nav.pephc; svr->nav.pephc=nav.pephc; nav.pephc=pephc;
+        
+        /* free old ones */
+        freenav(&nav,0x08);
         svr->ftime[index]=utc2gpst(timeget());
         strcpy(svr->files[index],file);
         
@@ -371,9 +405,12 @@ static void decodefile(rtksvr_t *svr, int index)
         /* update precise clock */
         rtksvrlock(svr);
         
-        if (svr->nav.pclk) free(svr->nav.pclk);
-        svr->nav.nc=svr->nav.ncmax=nav.nc;
-        svr->nav.pclk=nav.pclk;
+        /* swap satellite-major clock */
+        ps=svr->nav.pclks; svr->nav.pclks=nav.pclks; nav.pclks=ps;
+        
+        /* free old one and epoch-major clock */
+        free(svr->nav.pclk); svr->nav.pclk=NULL; svr->nav.nc=svr->nav.ncmax=0;
+        freenav(&nav,0x10);
         svr->ftime[index]=utc2gpst(timeget());
         strcpy(svr->files[index],file);
         
@@ -390,7 +427,7 @@ static void *rtksvrthread(void *arg)
     rtksvr_t *svr=(rtksvr_t *)arg;
     obs_t obs;
     obsd_t data[MAXOBS*2];
-    double tt;
+    double tt,t;
     unsigned int tick,ticknmea,tick1hz;
     unsigned char *p,*q;
     int i,j,n,fobs[3]={0},cycle,cputime;
@@ -452,7 +489,12 @@ static void *rtksvrthread(void *arg)
                 timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
                 
                 /* write solution */
+                t=ticktime();
                 writesol(svr,i);
+                
+                rtksvrlock(svr);
+                profadd(svr->rtk.prof+PROF_OUTSOL,t);
+                rtksvrunlock(svr);
             }
             /* if cpu overload, inclement obs outage counter and break */
             if ((int)(tickget()-tick)>=svr->cycle) {
@@ -550,6 +592,8 @@ extern int rtksvrinit(rtksvr_t *svr)
     svr->nav.ns=NSATSBS*2;
     
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
+        svr->obs[i][j].ep[0]=svr->obs[i][j].ep[1]=NULL;
+        svr->obs[i][j].ne[0]=svr->obs[i][j].ne[1]=0;
         if (!(svr->obs[i][j].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
             tracet(1,"rtksvrinit: malloc error\n");
             return 0;
@@ -578,7 +622,7 @@ extern void rtksvrfree(rtksvr_t *svr)
     free(svr->nav.geph);
     free(svr->nav.seph);
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
-        free(svr->obs[i][j].data);
+        freeobs(&svr->obs[i][j]);
     }
     rtkfree(&svr->rtk);
 }
@@ -894,3 +938,23 @@ extern void rtksvrsstat(rtksvr_t *svr, int *sstat, char *msg)
     }
     rtksvrunlock(svr);
 }
+/* get timing counters ---------------------------------------------------------
+* get timing counters of processing stages
+* args   : rtksvr_t *svr    IO rtk server
+*          prof_t  *prof    O  timing counters (NPROF) (NULL: no output)
+*          int     reset    I  reset counters after copy (0:no,1:yes)
+* return : number of timing counters
+* notes  : stages are indexed by PROF_??? (see rtklib.h)
+*-----------------------------------------------------------------------------*/
+extern int rtksvrprof(rtksvr_t *svr, prof_t *prof, int reset)
+{
+    int i;
+    
+    tracet(4,"rtksvrprof: reset=%d\n",reset);
+    
+    rtksvrlock(svr);
+    for (i=0;i<NPROF&&prof;i++) prof[i]=svr->rtk.prof[i];
+    if (reset) profinit(svr->rtk.prof,NPROF);
+    rtksvrunlock(svr);
+    return NPROF;
+}
@@ -35,6 +35,8 @@
 *           2011/01/15 1.8  use api ionppp()
 *                           add prn mask of qzss for qzss L1SAIF
 *           2018/01/29 1.9  crc24q() -> rtk_crc24q()
+*           2026/10/19 1.10 search igps by index of grid updated by type 18
+*                           thread local cache of sbstropcorr()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -265,10 +267,46 @@ static int decode_sbstype9(const sbsmsg_t *msg, nav_t *nav)
     trace(5,"decode_sbstype9: prn=%d\n",msg->prn);
     return 1;
 }
+/* grid index of igp ---------------------------------------------------------*/
+static int igpgrid(int lat, int lon)
+{
+    if (lat<-85||85<lat||lon<-180||180<=lon||lat%5||lon%5) return -1;
+    return (lat+85)/5*NIGPLON+(lon+180)/5;
+}
+/* add/delete igp to/from index of grid --------------------------------------*/
+static void addigpi(sbsigpi_t *igpi, const sbsigp_t *igp, int band, int index)
+{
+    short *p,code=(short)(band*MAXNIGP+index+1);
+    int i=igpgrid(igp->lat,igp->lon);
+    
+    if (i<0) return;
+    p=igpi->igp[i];
+    
+    if (!p[0]) p[0]=code;
+    else if (!p[1]) {
+        if (p[0]<code) p[1]=code; else {p[1]=p[0]; p[0]=code;}
+    }
+    else return; /* no more than two bands overlap */
+    igpi->n++;
+}
+static void deligpi(sbsigpi_t *igpi, const sbsigp_t *igp, int band, int index)
+{
+    short *p,code=(short)(band*MAXNIGP+index+1);
+    int i=igpgrid(igp->lat,igp->lon);
+    
+    if (i<0) return;
+    p=igpi->igp[i];
+    
+    if      (p[0]==code) {p[0]=p[1]; p[1]=0;}
+    else if (p[1]==code) p[1]=0;
+    else return;
+    igpi->n--;
+}
 /* decode type 18: ionospheric grid point masks ------------------------------*/
-static int decode_sbstype18(const sbsmsg_t *msg, sbsion_t *sbsion)
+static int decode_sbstype18(const sbsmsg_t *msg, nav_t *nav)
 {
     const sbsigpband_t *p;
+    sbsion_t *sbsion=nav->sbsion;
     int i,j,n,m,band=getbitu(msg->msg,18,4);
     
     trace(4,"decode_sbstype18:\n");
@@ -279,12 +317,18 @@ static int decode_sbstype18(const sbsmsg_t *msg, sbsion_t *sbsion)
     
     sbsion[band].iodi=(short)getbitu(msg->msg,22,2);
     
+    /* delete igps of band from index */
+    for (i=0;i<sbsion[band].nigp;i++) {
+        deligpi(&nav->sbsigpi,sbsion[band].igp+i,band,i);
+    }
     for (i=1,n=0;i<=201;i++) {
         if (!getbitu(msg->msg,23+i,1)) continue;
         for (j=0;j<m;j++) {
             if (i<p[j].bits||p[j].bite<i) continue;
             sbsion[band].igp[n].lat=band<=8?p[j].y[i-p[j].bits]:p[j].x;
-            sbsion[band].igp[n++].lon=band<=8?p[j].x:p[j].y[i-p[j].bits];
+            sbsion[band].igp[n  ].lon=band<=8?p[j].x:p[j].y[i-p[j].bits];
+            addigpi(&nav->sbsigpi,sbsion[band].igp+n,band,n);
+            n++;
             break;
         }
     }
@@ -440,7 +484,7 @@ extern int sbsupdatecorr(const sbsmsg_t *msg, nav_t *nav)
         case  6: stat=decode_sbstype6 (msg,&nav->sbssat); break;
         case  7: stat=decode_sbstype7 (msg,&nav->sbssat); break;
         case  9: stat=decode_sbstype9 (msg,nav);          break;
-        case 18: stat=decode_sbstype18(msg,nav ->sbsion); break;
+        case 18: stat=decode_sbstype18(msg,nav);          break;
         case 24: stat=decode_sbstype24(msg,&nav->sbssat); break;
         case 25: stat=decode_sbstype25(msg,&nav->sbssat); break;
         case 26: stat=decode_sbstype26(msg,nav ->sbsion); break;
@@ -598,11 +642,49 @@ extern void sbsoutmsg(FILE *fp, sbsmsg_t *sbsmsg)
     for (i=0;i<29;i++) fprintf(fp,"%02X",sbsmsg->msg[i]);
     fprintf(fp,"\n");
 }
+/* search igps by index of grid ------------------------------------------------
+* select the same igps as the sequential search in order of bands and igps.
+* the sequential search stops at the igp with which all four igps are found,
+* so the igp of each corner is the last one before the stop.
+*-----------------------------------------------------------------------------*/
+static void searchigpi(const sbsion_t *ion, const sbsigpi_t *igpi,
+                       const int *latp, const int *lonp, const sbsigp_t **igp)
+{
+    const sbsigp_t *c[4][2];
+    int i,j,k,g,n[4],code[4][2],stop=0;
+    
+    for (k=0;k<4;k++) {
+        n[k]=0;
+        
+        /* igp of corner already assigned to the preceding corner */
+        for (j=0;j<k;j++) {
+            if (latp[k%2]==latp[j%2]&&lonp[k]==lonp[j]) break;
+        }
+        if (j<k||(g=igpgrid(latp[k%2],lonp[k]))<0) continue;
+        
+        for (i=0;i<2&&igpi->igp[g][i];i++) {
+            j=igpi->igp[g][i]-1;
+            c[k][n[k]]=ion[j/MAXNIGP].igp+j%MAXNIGP;
+            if (c[k][n[k]]->t0.time==0||c[k][n[k]]->give<=0) continue;
+            code[k][n[k]++]=j;
+        }
+    }
+    if (n[0]&&n[1]&&n[2]&&n[3]) {
+        for (k=0;k<4;k++) if (code[k][0]>stop) stop=code[k][0];
+    }
+    else stop=(MAXBAND+1)*MAXNIGP;
+    
+    for (k=0;k<4;k++) {
+        for (i=n[k]-1;i>=0&&code[k][i]>stop;i--) ;
+        igp[k]=i>=0?c[k][i]:NULL;
+    }
+}
 /* search igps ---------------------------------------------------------------*/
-static void searchigp(gtime_t time, const double *pos, const sbsion_t *ion,
+static void searchigp(gtime_t time, const double *pos, const nav_t *nav,
                       const sbsigp_t **igp, double *x, double *y)
 {
-    int i,latp[2],lonp[4];
+    const sbsion_t *ion=nav->sbsion;
+    int i,n,latp[2],lonp[4];
     double lat=pos[0]*R2D,lon=pos[1]*R2D;
     const sbsigp_t *p;
     
@@ -640,6 +722,13 @@ static void searchigp(gtime_t time, const double *pos, const sbsion_t *ion,
         }
     }
     for (i=0;i<4;i++) if (lonp[i]==180) lonp[i]=-180;
+    
+    /* search by index of grid if all igps indexed */
+    for (i=n=0;i<=MAXBAND;i++) n+=ion[i].nigp;
+    if (n==nav->sbsigpi.n) {
+        searchigpi(ion,&nav->sbsigpi,latp,lonp,igp);
+        return;
+    }
     for (i=0;i<=MAXBAND;i++) {
         for (p=ion[i].igp;p<ion[i].igp+ion[i].nigp;p++) {
             if (p->t0.time==0) continue;
@@ -682,7 +771,7 @@ extern int sbsioncorr(gtime_t time, const nav_t *nav, const double *pos,
     fp=ionppp(pos,azel,re,hion,posp);
     
     /* search igps around ipp */
-    searchigp(time,posp,nav->sbsion,igp,&x,&y);
+    searchigp(time,posp,nav,igp,&x,&y);
     
     /* weight of igps */
     if (igp[0]&&igp[1]&&igp[2]&&igp[3]) {
@@ -754,7 +843,7 @@ extern double sbstropcorr(gtime_t time, const double *pos, const double *azel,
                           double *var)
 {
     const double k1=77.604,k2=382000.0,rd=287.054,gm=9.784,g=9.80665;
-    static double pos_[3]={0},zh=0.0,zw=0.0;
+    static THREADLOCAL double pos_[3]={0},zh=0.0,zw=0.0;
     int i;
     double c,met[10],sinel=sin(azel[1]),h=pos[2],m;
     
@@ -809,7 +898,7 @@ static int sbslongcorr(gtime_t time, int sat, const sbssat_t *sbssat,
     /* if sbas satellite without correction, no correction applied */
     if (satsys(sat,NULL)==SYS_SBS) return 1;
     
-    trace(2,"no sbas long-term correction: %s sat=%2d\n",time_str(time,0),sat);
+    if (TRACEON(2)) trace(2,"no sbas long-term correction: %s sat=%2d\n",time_str(time,0),sat);
     return 0;
 }
 /* fast correction -----------------------------------------------------------*/
@@ -840,7 +929,7 @@ static int sbsfastcorr(gtime_t time, int sat, const sbssat_t *sbssat,
               *prc,sqrt(*var),t);
         return 1;
     }
-    trace(2,"no sbas fast correction: %s sat=%2d\n",time_str(time,0),sat);
+    if (TRACEON(2)) trace(2,"no sbas fast correction: %s sat=%2d\n",time_str(time,0),sat);
     return 0;
 }
 /* sbas satellite ephemeris and clock correction -------------------------------
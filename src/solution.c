@@ -39,9 +39,19 @@
 *           2013/09/01  1.12 fix bug on presentation of nmea time tag
 *           2015/02/11  1.13 fix bug on checksum of $GLGSA and $GAGSA
 *                            fix bug on satellite id of $GAGSA
+*           2026/10/19  1.14 use fixed-point formatter for solution output
+*                            add binary solution format (SOLF_BIN)
+*                            read solution files by memory mapped chunks
+*                            use fmtfix(),fmtint() of rtkcmn.c
 *-----------------------------------------------------------------------------*/
 #include <ctype.h>
 #include "rtklib.h"
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 static const char rcsid[]="$Id: solution.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $";
 
@@ -55,6 +65,40 @@ static const char rcsid[]="$Id: solution.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $
 
 #define KNOT2M     0.514444444  /* m/knot */
 
+#define NTHREAD_SOL 8           /* max number of threads to read solutions */
+#define MINCHUNK    1048576     /* min size of a chunk to read in parallel */
+
+#define SOLBIN_SYNC1 0xB3       /* binary solution sync code 1 */
+#define SOLBIN_SYNC2 0x53       /* binary solution sync code 2 ('S') */
+#define SOLBIN_VER   1          /* binary solution format version */
+#define SOLBIN_HEAD  1          /* binary solution record type: header */
+#define SOLBIN_SOL   2          /* binary solution record type: solution */
+#define SOLBIN_LSOL  125        /* binary solution record payload length */
+
+#define U1(p) (*((unsigned char *)(p)))
+static unsigned short U2(unsigned char *p) {unsigned short u; memcpy(&u,p,2); return u;}
+static float          R4(unsigned char *p) {float          r; memcpy(&r,p,4); return r;}
+static double         R8(unsigned char *p) {double         r; memcpy(&r,p,8); return r;}
+static void setU2(unsigned char *p, unsigned short u) {memcpy(p,&u,2);}
+static void setR4(unsigned char *p, float          r) {memcpy(p,&r,4);}
+static void setR8(unsigned char *p, double         r) {memcpy(p,&r,8);}
+
+typedef struct {                /* chunk of solution file */
+    const char *p,*q;           /* chunk start/end pointer */
+    gtime_t ts,te;              /* time span */
+    double tint;                /* time interval (0: all) */
+    int qflag;                  /* quality flag (0: all) */
+    int type;                   /* chunk type (0:solution,1:solution status) */
+    const solopt_t *opt;        /* solution options */
+    solbuf_t solbuf;            /* decoded solutions */
+    solstatbuf_t statbuf;       /* decoded solution status */
+    double rb[3];               /* reference position {x,y,z} (m) */
+    int refpos;                 /* reference position decoded */
+    gtime_t time;               /* time of last decoded solution */
+    int ntime;                  /* number of decoded solutions */
+    int stat;                   /* status (1:ok,0:error,-1:not supported) */
+} solchunk_t;
+
 static const int solq_nmea[]={  /* nmea quality flags to rtklib sol quality */
     /* nmea 0183 v.2.3 quality flags: */
     /*  0=invalid, 1=gps fix (sps), 2=dgps fix, 3=pps fix, 4=rtk, 5=float rtk */
@@ -70,6 +114,41 @@ static const char *opt2sep(const solopt_t *opt)
     else if (!strcmp(opt->sep,"\\t")) return "\t";
     return opt->sep;
 }
+/* string to number -----------------------------------------------------------
+* same as strtod(s,end) for plain decimals [+-]ddd.ddd with up to 15 digits,
+* which are converted exactly by one division. other forms (exponent, hex,
+* inf, nan or long mantissa) fall back to strtod().
+*-----------------------------------------------------------------------------*/
+static double str2dbl(const char *s, char **end)
+{
+    static const double pw10[]={
+        1E0,1E1,1E2,1E3,1E4,1E5,1E6,1E7,1E8,1E9,1E10,1E11,1E12,1E13,1E14,1E15,
+        1E16,1E17,1E18,1E19,1E20,1E21,1E22
+    };
+    const char *p=s;
+    double m=0.0;
+    int neg=0,nd=0,nf=-1,nz=0;
+    
+    while (isspace((int)(unsigned char)*p)) p++;
+    if (*p=='-'||*p=='+') neg=*p++=='-';
+    
+    for (;;p++) {
+        if ('0'<=*p&&*p<='9') {
+            if (nf>=0) nf++;
+            if (nd==0&&*p=='0') {nz++; continue;}
+            if (++nd>15) break;
+            m=m*10.0+(*p-'0');
+        }
+        else if (*p=='.'&&nf<0) nf=0;
+        else break;
+    }
+    if (nd>15||nf>22||nd+nz==0||*p=='e'||*p=='E'||*p=='x'||*p=='X') {
+        return strtod(s,end);
+    }
+    if (end) *end=(char *)p;
+    if (nf>0) m/=pw10[nf];
+    return neg?-m:m;
+}
 /* separate fields -----------------------------------------------------------*/
 static int tonum(char *buff, const char *sep, double *v)
 {
@@ -78,11 +157,31 @@ static int tonum(char *buff, const char *sep, double *v)
     
     for (p=buff,n=0;n<MAXFIELD;p=q+len) {
         if ((q=strstr(p,sep))) *q='\0'; 
-        if (*p) v[n++]=atof(p);
+        if (*p) v[n++]=str2dbl(p,NULL);
         if (!q) break;
     }
     return n;
 }
+/* string to epoch (same as sscanf(buff,"%lf/%lf/%lf %lf:%lf:%lf",...)) ----*/
+static int str2ep(const char *buff, double *v)
+{
+    const char *sep="// ::";
+    char *p=(char *)buff,*q;
+    int i;
+    
+    for (i=0;i<6;i++) {
+        while (isspace((int)(unsigned char)*p)) p++;
+        if (!(('0'<=*p&&*p<='9')||*p=='.'||*p=='-'||*p=='+')) break;
+        v[i]=str2dbl(p,&q);
+        if (q==p||*q=='e'||*q=='E'||*q=='x'||*q=='X') break;
+        if (i==5) return 6;
+        p=q;
+        if (sep[i]==' ') continue;
+        if (*p!=sep[i]) return i+1;
+        p++;
+    }
+    return sscanf(buff,"%lf/%lf/%lf %lf:%lf:%lf",v,v+1,v+2,v+3,v+4,v+5);
+}
 /* sqrt of covariance --------------------------------------------------------*/
 static double sqvar(double covar)
 {
@@ -121,6 +220,28 @@ static void covtosol(const double *P, sol_t *sol)
     sol->qr[4]=(float)P[5]; /* yz or nu */
     sol->qr[5]=(float)P[2]; /* zx or ue */
 }
+/* copy string ---------------------------------------------------------------*/
+static char *fmts(char *p, const char *s)
+{
+    while (*s) *p++=*s++;
+    *p='\0';
+    return p;
+}
+/* time to string (same as time2str()) ---------------------------------------*/
+static char *fmttime(char *p, gtime_t t, int n)
+{
+    double ep[6];
+    
+    if (n<0) n=0; else if (n>12) n=12;
+    if (1.0-t.sec<0.5/pow(10.0,n)) {t.time++; t.sec=0.0;};
+    time2epoch(t,ep);
+    p=fmtint(p,(int)ep[0],4,1); *p++='/';
+    p=fmtint(p,(int)ep[1],2,1); *p++='/';
+    p=fmtint(p,(int)ep[2],2,1); *p++=' ';
+    p=fmtint(p,(int)ep[3],2,1); *p++=':';
+    p=fmtint(p,(int)ep[4],2,1); *p++=':';
+    return fmtfix(p,ep[5],n<=0?2:n+3,n<=0?0:n,1);
+}
 /* decode nmea gprmc: recommended minumum data for gps -----------------------*/
 static int decode_nmearmc(char **val, int n, sol_t *sol)
 {
@@ -267,7 +388,7 @@ static char *decode_soltime(char *buff, const solopt_t *opt, gtime_t *time)
     len=(int)strlen(s);
     
     /* yyyy/mm/dd hh:mm:ss or yyyy mm dd hh:mm:ss */
-    if (sscanf(buff,"%lf/%lf/%lf %lf:%lf:%lf",v,v+1,v+2,v+3,v+4,v+5)>=6) {
+    if (str2ep(buff,v)>=6) {
         if (v[0]<100.0) {
             v[0]+=v[0]<80.0?2000.0:1900.0;
         }
@@ -294,7 +415,7 @@ static char *decode_soltime(char *buff, const solopt_t *opt, gtime_t *time)
     /* wwww ssss */
     for (p=buff,n=0;n<2;p=q+len) {
         if ((q=strstr(p,s))) *q='\0'; 
-        if (*p) v[n++]=atof(p);
+        if (*p) v[n++]=str2dbl(p,NULL);
         if (!q) break;
     }
     if (n>=2&&0.0<=v[0]&&v[0]<=3000.0&&0.0<=v[1]&&v[1]<604800.0) {
@@ -460,7 +581,7 @@ static int decode_solpos(char *buff, const solopt_t *opt, sol_t *sol)
     return 0;
 }
 /* decode reference position -------------------------------------------------*/
-static void decode_refpos(char *buff, const solopt_t *opt, double *rb)
+static int decode_refpos(char *buff, const solopt_t *opt, double *rb)
 {
     double val[MAXFIELD],pos[3];
     int i,n;
@@ -468,7 +589,7 @@ static void decode_refpos(char *buff, const solopt_t *opt, double *rb)
     
     trace(3,"decode_refpos: buff=%s\n",buff);
     
-    if ((n=tonum(buff,sep,val))<3) return;
+    if ((n=tonum(buff,sep,val))<3) return 0;
     
     if (opt->posf==SOLF_XYZ) { /* xyz */
         for (i=0;i<3;i++) rb[i]=val[i];
@@ -485,6 +606,8 @@ static void decode_refpos(char *buff, const solopt_t *opt, double *rb)
         pos[2]=val[6];
         pos2ecef(pos,rb);
     }
+    else return 0;
+    return 1;
 }
 /* decode solution -----------------------------------------------------------*/
 static int decode_sol(char *buff, const solopt_t *opt, sol_t *sol, double *rb)
@@ -568,6 +691,71 @@ static void readsolopt(FILE *fp, solopt_t *opt)
         decode_solopt(buff,opt);
     }
 }
+/* decode binary solution record ---------------------------------------------*/
+static int decode_solbin(unsigned char *buff, int len, sol_t *sol, double *rb)
+{
+    unsigned char *p=buff+6;
+    double rr[3];
+    int i,week;
+    
+    trace(4,"decode_solbin: len=%d\n",len);
+    
+    if (rtk_crc16(buff+2,len+4)!=U2(buff+6+len)) {
+        trace(2,"binary solution crc error: len=%d\n",len);
+        return 0;
+    }
+    if (U1(buff+2)>SOLBIN_VER) {
+        trace(2,"binary solution version error: ver=%d\n",U1(buff+2));
+        return 0;
+    }
+    if (U1(buff+3)!=SOLBIN_SOL||len<SOLBIN_LSOL) return 0;
+    
+    week=U2(p); p+=2;
+    sol->time=gpst2time(week,R8(p)); p+=8;
+    for (i=0;i<6;i++,p+=8) sol->rr[i]=R8(p);
+    for (i=0;i<6;i++,p+=4) sol->qr[i]=R4(p);
+    sol->dtr[0]=R8(p); p+=8;
+    for (i=0;i<3;i++,p+=8) rr[i]=R8(p);
+    sol->type=U1(p); p++;
+    sol->stat=U1(p); p++;
+    sol->ns  =U1(p); p++;
+    sol->age  =R4(p); p+=4;
+    sol->ratio=R4(p);
+    if (norm(rr,3)>0.0) matcpy(rb,rr,3,1);
+    return 1;
+}
+/* input binary solution data ------------------------------------------------*/
+static int inputsolbin(unsigned char data, gtime_t ts, gtime_t te, double tint,
+                       int qflag, const solopt_t *opt, solbuf_t *solbuf)
+{
+    sol_t sol={{0}};
+    int len;
+    
+    solbuf->buff[solbuf->nb++]=data;
+    
+    if (solbuf->nb==2&&data!=SOLBIN_SYNC2) { /* resync as text */
+        solbuf->nb=0;
+        return inputsol(data,ts,te,tint,qflag,opt,solbuf);
+    }
+    if (solbuf->nb<6) return 0;
+    
+    if ((len=U2(solbuf->buff+4))+8>MAXSOLMSG) {
+        trace(2,"binary solution length error: len=%d\n",len);
+        solbuf->nb=0;
+        return 0;
+    }
+    if (solbuf->nb<len+8) return 0;
+    solbuf->nb=0;
+    
+    if (!decode_solbin(solbuf->buff,len,&sol,solbuf->rb)) return 0;
+    
+    solbuf->time=sol.time;
+    
+    if (!screent(sol.time,ts,te,tint)||(qflag&&sol.stat!=qflag)) {
+        return 0;
+    }
+    return addsol(solbuf,&sol);
+}
 /* input solution data from stream ---------------------------------------------
 * input solution data from stream
 * args   : unsigned char data I stream data
@@ -577,6 +765,8 @@ static void readsolopt(FILE *fp, solopt_t *opt)
 *          int    qflag     I  quality flag  (0: all)
 *          solbuf_t *solbuf IO solution buffer
 * return : status (1:solution received,0:no solution,-1:disconnect received)
+* notes  : binary solution records (SOLF_BIN) are detected by the sync code
+*          and decoded regardless of opt->posf
 *-----------------------------------------------------------------------------*/
 extern int inputsol(unsigned char data, gtime_t ts, gtime_t te, double tint,
                     int qflag, const solopt_t *opt, solbuf_t *solbuf)
@@ -588,6 +778,9 @@ extern int inputsol(unsigned char data, gtime_t ts, gtime_t te, double tint,
     
     sol.time=solbuf->time;
     
+    if (solbuf->nb>0&&solbuf->buff[0]==SOLBIN_SYNC1) { /* binary solution */
+        return inputsolbin(data,ts,te,tint,qflag,opt,solbuf);
+    }
     if (data=='$'||(!isprint(data)&&data!='\r'&&data!='\n')) { /* sync header */
         solbuf->nb=0;
     }
@@ -627,6 +820,411 @@ static int readsoldata(FILE *fp, gtime_t ts, gtime_t te, double tint, int qflag,
     }
     return solbuf->n>0;
 }
+/* scan solution status fields -------------------------------------------------
+* same as sscanf(buff,"$SAT%d%lf%s%d%lf%lf%lf%lf%d%d%d%d%d%d%d%d",...) for
+* fields of plain integers and decimals. others fall back to sscanf().
+*-----------------------------------------------------------------------------*/
+static int scan_solstat(const char *buff, int *week, double *tow, char *id,
+                        int *frq, double *val, int *ival)
+{
+    const char *fmt="dfsdffffdddddddd";
+    char *p=(char *)buff+4,*q;
+    double v;
+    int i,n;
+    
+    for (i=0;fmt[i];i++) {
+        while (isspace((int)(unsigned char)*p)) p++;
+        if (!*p) return i;
+        if (fmt[i]=='s') {
+            for (n=0;*p&&!isspace((int)(unsigned char)*p)&&n<31;n++) id[n]=*p++;
+            if (*p&&!isspace((int)(unsigned char)*p)) break;
+            id[n]='\0';
+            continue;
+        }
+        if (!(('0'<=*p&&*p<='9')||*p=='.'||*p=='-'||*p=='+')) break;
+        v=str2dbl(p,&q);
+        if (q==p||(*q&&!isspace((int)(unsigned char)*q))) break;
+        if (fmt[i]=='d') {
+            if (*p=='-'||*p=='+') p++;
+            for (;p<q;p++) if (!isdigit((int)(unsigned char)*p)) break;
+            if (p<q||v<-2147483647.0||v>2147483647.0) break;
+        }
+        p=q;
+        switch (i) {
+            case 0 : *week=(int)v; break;
+            case 1 : *tow=v;       break;
+            case 3 : *frq=(int)v;  break;
+            default: if (i<8) val[i-4]=v; else ival[i-8]=(int)v; break;
+        }
+    }
+    if (!fmt[i]) return i;
+    
+    return sscanf(buff,"$SAT%d%lf%s%d%lf%lf%lf%lf%d%d%d%d%d%d%d%d",week,tow,id,
+                  frq,val,val+1,val+2,val+3,ival,ival+1,ival+2,ival+3,ival+4,
+                  ival+5,ival+6,ival+7);
+}
+/* decode solution status ----------------------------------------------------*/
+static int decode_solstat(char *buff, solstat_t *stat)
+{
+    static const solstat_t stat0={{0}};
+    double tow,val[4];
+    int n,week,sat,frq,ival[8]={0};
+    char id[32]="",*p;
+    
+    trace(4,"decode_solstat: buff=%s\n",buff);
+    
+    if (strstr(buff,"$SAT")!=buff) return 0;
+    
+    for (p=buff;*p;p++) if (*p==',') *p=' ';
+    
+    n=scan_solstat(buff,&week,&tow,id,&frq,val,ival);
+    
+    if (n<15) {
+        trace(2,"invalid format of solution status: %s\n",buff);
+        return 0;
+    }
+    if ((sat=satid2no(id))<=0) {
+        trace(2,"invalid satellite in solution status: %s\n",id);
+        return 0;
+    }
+    *stat=stat0;
+    stat->time=gpst2time(week,tow);
+    stat->sat  =(unsigned char)sat;
+    stat->frq  =(unsigned char)frq;
+    stat->az   =(float)(val[0]*D2R);
+    stat->el   =(float)(val[1]*D2R);
+    stat->resp =(float)val[2];
+    stat->resc =(float)val[3];
+    stat->flag =(unsigned char)((ival[0]<<5)+(ival[3]<<3)+ival[2]);
+    stat->snr  =(unsigned char)(ival[1]*4.0+0.5);
+    stat->lock =(unsigned short)ival[4];
+    stat->outc =(unsigned short)ival[5];
+    stat->slipc=(unsigned short)ival[6];
+    stat->rejc =(unsigned short)ival[7];
+    return 1;
+}
+/* add solution status data --------------------------------------------------*/
+static void addsolstat(solstatbuf_t *statbuf, const solstat_t *stat)
+{
+    solstat_t *statbuf_data;
+    
+    trace(4,"addsolstat:\n");
+    
+    if (statbuf->n>=statbuf->nmax) {
+        statbuf->nmax=statbuf->nmax==0?8192:statbuf->nmax*2;
+        if (!(statbuf_data=(solstat_t *)realloc(statbuf->data,sizeof(solstat_t)*
+                                                statbuf->nmax))) {
+            trace(1,"addsolstat: memory allocation error\n");
+            free(statbuf->data); statbuf->data=NULL; statbuf->n=statbuf->nmax=0;
+            return;
+        }
+        statbuf->data=statbuf_data;
+    }
+    statbuf->data[statbuf->n++]=*stat;
+}
+/* map file to memory --------------------------------------------------------*/
+static char *mapsolfile(const char *file, size_t *size)
+{
+    char *buff;
+#ifdef WIN32
+    FILE *fp;
+    
+    if (!(fp=fopen(file,"rb"))) return NULL;
+    fseek(fp,0,SEEK_END);
+    *size=(size_t)ftell(fp);
+    fseek(fp,0,SEEK_SET);
+    buff=NULL;
+    if (*size==0||!(buff=(char *)malloc(*size))||fread(buff,*size,1,fp)<1) {
+        free(buff);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+#else
+    struct stat st;
+    void *p;
+    int fd;
+    
+    if ((fd=open(file,O_RDONLY))<0) return NULL;
+    if (fstat(fd,&st)<0||st.st_size<=0||
+        (p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0))==MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    buff=(char *)p;
+    *size=(size_t)st.st_size;
+#endif
+    return buff;
+}
+/* unmap file ----------------------------------------------------------------*/
+static void unmapsolfile(char *buff, size_t size)
+{
+#ifdef WIN32
+    free(buff);
+#else
+    munmap(buff,size);
+#endif
+}
+/* decode chunk of solution data ---------------------------------------------*/
+static void decode_solchunk(solchunk_t *chunk)
+{
+    const char *p,*q,*r,*s;
+    char buff[MAXSOLMSG+1],*t;
+    sol_t sol={{0}};
+    int c;
+    
+    for (p=chunk->p;p<chunk->q;p=q+1) {
+        
+        /* partial line at the end of file */
+        if (!(q=(const char *)memchr(p,'\n',chunk->q-p))) {
+            chunk->stat=-1;
+            return;
+        }
+        /* record starts at the last sync header as inputsol() */
+        for (r=s=p;r<q;r++) {
+            c=(unsigned char)*r;
+            if (c=='$'||c==SOLBIN_SYNC1) { /* nmea or binary */
+                chunk->stat=-1;
+                return;
+            }
+            if (!isprint(c)&&c!='\r') s=r;
+        }
+        if (q-s+1>MAXSOLMSG) {
+            chunk->stat=-1;
+            return;
+        }
+        memcpy(buff,s,q-s+1);
+        buff[q-s+1]='\0';
+        
+        if (!strncmp(buff,COMMENTH,1)) { /* reference position */
+            if (!strstr(buff,"ref pos")&&!strstr(buff,"slave pos")) continue;
+            if (!(t=strchr(buff,':'))) continue;
+            if (decode_refpos(t+1,chunk->opt,chunk->rb)) chunk->refpos=1;
+            continue;
+        }
+        if (!decode_solpos(buff,chunk->opt,&sol)) continue;
+        
+        chunk->time=sol.time;
+        chunk->ntime++;
+        
+        if (!screent(sol.time,chunk->ts,chunk->te,chunk->tint)||
+            (chunk->qflag&&sol.stat!=chunk->qflag)) {
+            continue;
+        }
+        if (!addsol(&chunk->solbuf,&sol)) {
+            chunk->stat=0;
+            return;
+        }
+    }
+}
+/* decode chunk of solution status data --------------------------------------*/
+static void decode_solstatchunk(solchunk_t *chunk)
+{
+    solstat_t stat={{0}};
+    const char *p,*q;
+    char buff[MAXSOLMSG+1];
+    
+    for (p=chunk->p;p<chunk->q;p=q) {
+        
+        if (!(q=(const char *)memchr(p,'\n',chunk->q-p))) q=chunk->q; else q++;
+        
+        /* line exceeding the buffer of readsolstatdata() */
+        if (q-p>MAXSOLMSG) {
+            chunk->stat=-1;
+            return;
+        }
+        memcpy(buff,p,q-p);
+        buff[q-p]='\0';
+        
+        /* decode solution status */
+        if (!decode_solstat(buff,&stat)) continue;
+        
+        /* add solution to solution buffer */
+        if (screent(stat.time,chunk->ts,chunk->te,chunk->tint)) {
+            addsolstat(&chunk->statbuf,&stat);
+        }
+    }
+}
+/* solution chunk thread -----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI solchunkthread(void *arg)
+#else
+static void *solchunkthread(void *arg)
+#endif
+{
+    solchunk_t *chunk=(solchunk_t *)arg;
+    
+    if (chunk->type) decode_solstatchunk(chunk);
+    else decode_solchunk(chunk);
+    return 0;
+}
+/* decode chunks of memory mapped file in parallel -----------------------------
+* split file into line-aligned chunks and decode them with threads
+* args   : char   *buff     I   file contents
+*          size_t size      I   file size
+*          solchunk_t *chunk IO chunks (template in chunk[0])
+* return : number of chunks
+*-----------------------------------------------------------------------------*/
+static int decode_chunks(const char *buff, size_t size, solchunk_t *chunk)
+{
+    thread_t thread[NTHREAD_SOL];
+    const char *p=buff,*q;
+    int i,n,stat[NTHREAD_SOL]={0};
+    
+    n=(int)(size/MINCHUNK)+1;
+    if (n>NTHREAD_SOL) n=NTHREAD_SOL;
+    
+    for (i=0;i<n;i++) {
+        if (i>0) chunk[i]=chunk[0];
+        if (i==n-1) q=buff+size;
+        else if ((q=buff+size/n*(i+1))<p) q=p;
+        else if (!(q=(const char *)memchr(q,'\n',buff+size-q))) q=buff+size;
+        else q++;
+        chunk[i].p=p;
+        chunk[i].q=q;
+        initsolbuf(&chunk[i].solbuf,0,0);
+        chunk[i].statbuf.n=chunk[i].statbuf.nmax=0;
+        chunk[i].statbuf.data=NULL;
+        p=q;
+    }
+    for (i=1;i<n;i++) {
+#ifdef WIN32
+        stat[i]=(thread[i]=CreateThread(NULL,0,solchunkthread,chunk+i,0,NULL))!=NULL;
+#else
+        stat[i]=!pthread_create(thread+i,NULL,solchunkthread,chunk+i);
+#endif
+    }
+    solchunkthread(chunk);
+    
+    for (i=1;i<n;i++) {
+        if (!stat[i]) {
+            solchunkthread(chunk+i);
+            continue;
+        }
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    return n;
+}
+/* read solution data by memory mapped chunks ----------------------------------
+* read solution data from file in parallel
+* args   : see readsoldata()
+* return : status (1:ok,0:no data or error,-1:not supported by the chunk reader)
+* notes  : nmea, binary or truncated files are left to readsoldata()
+*-----------------------------------------------------------------------------*/
+static int readsolmap(const char *file, gtime_t ts, gtime_t te, double tint,
+                      int qflag, const solopt_t *opt, solbuf_t *solbuf)
+{
+    solchunk_t chunk[NTHREAD_SOL]={{0}};
+    sol_t *solbuf_data;
+    char *buff;
+    size_t size;
+    int i,n,m,stat=1;
+    
+    trace(3,"readsolmap: file=%s\n",file);
+    
+    if (opt->posf==SOLF_NMEA||solbuf->nb>0||solbuf->cyclic) return -1;
+    
+    if (!(buff=mapsolfile(file,&size))) return -1;
+    
+    chunk[0].ts=ts;
+    chunk[0].te=te;
+    chunk[0].tint=tint;
+    chunk[0].qflag=qflag;
+    chunk[0].opt=opt;
+    chunk[0].stat=1;
+    matcpy(chunk[0].rb,solbuf->rb,3,1);
+    
+    n=decode_chunks(buff,size,chunk);
+    
+    unmapsolfile(buff,size);
+    
+    for (i=0;i<n;i++) {
+        if (chunk[i].stat<=0) stat=chunk[i].stat;
+        if (stat<0) break;
+    }
+    /* merge chunks in file order */
+    for (i=0,m=solbuf->n;i<n&&stat>0;i++) m+=chunk[i].solbuf.n;
+    if (stat>0&&m>solbuf->nmax) {
+        if (!(solbuf_data=(sol_t *)realloc(solbuf->data,sizeof(sol_t)*m))) {
+            trace(1,"readsolmap: memory allocation error\n");
+            stat=0;
+        }
+        else {
+            solbuf->data=solbuf_data;
+            solbuf->nmax=m;
+        }
+    }
+    for (i=0;i<n;i++) {
+        if (stat>0) {
+            if (chunk[i].solbuf.n>0) {
+                memcpy(solbuf->data+solbuf->n,chunk[i].solbuf.data,
+                       sizeof(sol_t)*chunk[i].solbuf.n);
+                solbuf->n+=chunk[i].solbuf.n;
+            }
+            if (chunk[i].ntime>0) solbuf->time=chunk[i].time;
+            if (chunk[i].refpos) matcpy(solbuf->rb,chunk[i].rb,3,1);
+        }
+        freesolbuf(&chunk[i].solbuf);
+    }
+    return stat<=0?stat:solbuf->n>0;
+}
+/* read solution status data by memory mapped chunks ------------------------*/
+static int readsolstatmap(const char *file, gtime_t ts, gtime_t te, double tint,
+                          solstatbuf_t *statbuf)
+{
+    solchunk_t chunk[NTHREAD_SOL]={{0}};
+    solstat_t *statbuf_data;
+    char *buff;
+    size_t size;
+    int i,n,m,stat=1;
+    
+    trace(3,"readsolstatmap: file=%s\n",file);
+    
+    if (!(buff=mapsolfile(file,&size))) return -1;
+    
+    chunk[0].ts=ts;
+    chunk[0].te=te;
+    chunk[0].tint=tint;
+    chunk[0].type=1;
+    chunk[0].stat=1;
+    
+    n=decode_chunks(buff,size,chunk);
+    
+    unmapsolfile(buff,size);
+    
+    for (i=0;i<n;i++) {
+        if (chunk[i].stat<=0) stat=chunk[i].stat;
+        if (stat<0) break;
+    }
+    /* merge chunks in file order */
+    for (i=0,m=statbuf->n;i<n&&stat>0;i++) m+=chunk[i].statbuf.n;
+    if (stat>0&&m>statbuf->nmax) {
+        if (!(statbuf_data=(solstat_t *)realloc(statbuf->data,
+                                                sizeof(solstat_t)*m))) {
+            trace(1,"readsolstatmap: memory allocation error\n");
+            stat=0;
+        }
+        else {
+            statbuf->data=statbuf_data;
+            statbuf->nmax=m;
+        }
+    }
+    for (i=0;i<n;i++) {
+        if (stat>0&&chunk[i].statbuf.n>0) {
+            memcpy(statbuf->data+statbuf->n,chunk[i].statbuf.data,
+                   sizeof(solstat_t)*chunk[i].statbuf.n);
+            statbuf->n+=chunk[i].statbuf.n;
+        }
+        freesolstatbuf(&chunk[i].statbuf);
+    }
+    return stat<=0?stat:statbuf->n>0;
+}
 /* compare solution data -----------------------------------------------------*/
 static int cmpsol(const void *p1, const void *p2)
 {
@@ -638,6 +1236,7 @@ static int cmpsol(const void *p1, const void *p2)
 static int sort_solbuf(solbuf_t *solbuf)
 {
     sol_t *solbuf_data;
+    int i;
     
     trace(4,"sort_solbuf: n=%d\n",solbuf->n);
     
@@ -649,7 +1248,14 @@ static int sort_solbuf(solbuf_t *solbuf)
         return 0;
     }
     solbuf->data=solbuf_data;
-    qsort(solbuf->data,solbuf->n,sizeof(sol_t),cmpsol);
+    
+    /* skip sort if already in time order */
+    for (i=1;i<solbuf->n;i++) {
+        if (cmpsol(solbuf->data+i-1,solbuf->data+i)>0) break;
+    }
+    if (i<solbuf->n) {
+        qsort(solbuf->data,solbuf->n,sizeof(sol_t),cmpsol);
+    }
     solbuf->nmax=solbuf->n;
     solbuf->start=0;
     solbuf->end=solbuf->n-1;
@@ -671,7 +1277,7 @@ extern int readsolt(char *files[], int nfile, gtime_t ts, gtime_t te,
 {
     FILE *fp;
     solopt_t opt=solopt_default;
-    int i;
+    int i,stat;
     
     trace(3,"readsolt: nfile=%d\n",nfile);
     
@@ -687,7 +1293,8 @@ extern int readsolt(char *files[], int nfile, gtime_t ts, gtime_t te,
         rewind(fp);
         
         /* read solution data */
-        if (!readsoldata(fp,ts,te,tint,qflag,&opt,solbuf)) {
+        if (!(stat=readsolmap(files[i],ts,te,tint,qflag,&opt,solbuf))||
+            (stat<0&&!readsoldata(fp,ts,te,tint,qflag,&opt,solbuf))) {
             trace(1,"readsolt: no solution in %s\n",files[i]);
         }
         fclose(fp);
@@ -811,6 +1418,7 @@ static int cmpsolstat(const void *p1, const void *p2)
 static int sort_solstat(solstatbuf_t *statbuf)
 {
     solstat_t *statbuf_data;
+    int i;
     
     trace(4,"sort_solstat: n=%d\n",statbuf->n);
     
@@ -822,71 +1430,17 @@ static int sort_solstat(solstatbuf_t *statbuf)
         return 0;
     }
     statbuf->data=statbuf_data;
-    qsort(statbuf->data,statbuf->n,sizeof(solstat_t),cmpsolstat);
-    statbuf->nmax=statbuf->n;
-    return 1;
-}
-/* decode solution status ----------------------------------------------------*/
-static int decode_solstat(char *buff, solstat_t *stat)
-{
-    static const solstat_t stat0={{0}};
-    double tow,az,el,resp,resc;
-    int n,week,sat,frq,vsat,snr,fix,slip,lock,outc,slipc,rejc;
-    char id[32]="",*p;
-    
-    trace(4,"decode_solstat: buff=%s\n",buff);
-    
-    if (strstr(buff,"$SAT")!=buff) return 0;
-    
-    for (p=buff;*p;p++) if (*p==',') *p=' ';
     
-    n=sscanf(buff,"$SAT%d%lf%s%d%lf%lf%lf%lf%d%d%d%d%d%d%d%d",
-             &week,&tow,id,&frq,&az,&el,&resp,&resc,&vsat,&snr,&fix,&slip,
-             &lock,&outc,&slipc,&rejc);
-    
-    if (n<15) {
-        trace(2,"invalid format of solution status: %s\n",buff);
-        return 0;
+    /* skip sort if already in time order */
+    for (i=1;i<statbuf->n;i++) {
+        if (cmpsolstat(statbuf->data+i-1,statbuf->data+i)>0) break;
     }
-    if ((sat=satid2no(id))<=0) {
-        trace(2,"invalid satellite in solution status: %s\n",id);
-        return 0;
+    if (i<statbuf->n) {
+        qsort(statbuf->data,statbuf->n,sizeof(solstat_t),cmpsolstat);
     }
-    *stat=stat0;
-    stat->time=gpst2time(week,tow);
-    stat->sat  =(unsigned char)sat;
-    stat->frq  =(unsigned char)frq;
-    stat->az   =(float)(az*D2R);
-    stat->el   =(float)(el*D2R);
-    stat->resp =(float)resp;
-    stat->resc =(float)resc;
-    stat->flag =(unsigned char)((vsat<<5)+(slip<<3)+fix);
-    stat->snr  =(unsigned char)(snr*4.0+0.5);
-    stat->lock =(unsigned short)lock;
-    stat->outc =(unsigned short)outc;
-    stat->slipc=(unsigned short)slipc;
-    stat->rejc =(unsigned short)rejc;
+    statbuf->nmax=statbuf->n;
     return 1;
 }
-/* add solution status data --------------------------------------------------*/
-static void addsolstat(solstatbuf_t *statbuf, const solstat_t *stat)
-{
-    solstat_t *statbuf_data;
-    
-    trace(4,"addsolstat:\n");
-    
-    if (statbuf->n>=statbuf->nmax) {
-        statbuf->nmax=statbuf->nmax==0?8192:statbuf->nmax*2;
-        if (!(statbuf_data=(solstat_t *)realloc(statbuf->data,sizeof(solstat_t)*
-                                                statbuf->nmax))) {
-            trace(1,"addsolstat: memory allocation error\n");
-            free(statbuf->data); statbuf->data=NULL; statbuf->n=statbuf->nmax=0;
-            return;
-        }
-        statbuf->data=statbuf_data;
-    }
-    statbuf->data[statbuf->n++]=*stat;
-}
 /* read solution status data -------------------------------------------------*/
 static int readsolstatdata(FILE *fp, gtime_t ts, gtime_t te, double tint,
                            solstatbuf_t *statbuf)
@@ -923,7 +1477,7 @@ extern int readsolstatt(char *files[], int nfile, gtime_t ts, gtime_t te,
 {
     FILE *fp;
     char path[1024];
-    int i;
+    int i,stat;
     
     trace(3,"readsolstatt: nfile=%d\n",nfile);
     
@@ -932,6 +1486,12 @@ extern int readsolstatt(char *files[], int nfile, gtime_t ts, gtime_t te,
     
     for (i=0;i<nfile;i++) {
         sprintf(path,"%s.stat",files[i]);
+        
+        /* read solution status data by memory mapped chunks */
+        if ((stat=readsolstatmap(path,ts,te,tint,statbuf))>=0) {
+            if (!stat) trace(1,"readsolt: no solution in %s\n",path);
+            continue;
+        }
         if (!(fp=fopen(path,"r"))) {
             trace(1,"readsolstatt: file open error %s\n",path);
             continue;
@@ -952,27 +1512,48 @@ extern int readsolstat(char *files[], int nfile, solstatbuf_t *statbuf)
     
     return readsolstatt(files,nfile,time,time,0.0,statbuf);
 }
+/* output solution quality, std-devs, age and ratio --------------------------*/
+static char *outqual(char *p, const char *sep, const sol_t *sol,
+                     const double *std)
+{
+    int i;
+    
+    p=fmts(p,sep); p=fmtint(p,sol->stat,3,0);
+    p=fmts(p,sep); p=fmtint(p,sol->ns,3,0);
+    for (i=0;i<6;i++) {
+        p=fmts(p,sep); p=fmtfix(p,std[i],8,4,0);
+    }
+    p=fmts(p,sep); p=fmtfix(p,sol->age,6,2,0);
+    p=fmts(p,sep); p=fmtfix(p,sol->ratio,6,1,0);
+    *p++='\n'; *p='\0';
+    return p;
+}
 /* output solution as the form of x/y/z-ecef ---------------------------------*/
 static int outecef(unsigned char *buff, const char *s, const sol_t *sol,
                    const solopt_t *opt)
 {
+    double std[6];
     const char *sep=opt2sep(opt);
     char *p=(char *)buff;
+    int i;
     
     trace(3,"outecef:\n");
     
-    p+=sprintf(p,"%s%s%14.4f%s%14.4f%s%14.4f%s%3d%s%3d%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%6.2f%s%6.1f\n",
-               s,sep,sol->rr[0],sep,sol->rr[1],sep,sol->rr[2],sep,sol->stat,sep,
-               sol->ns,sep,SQRT(sol->qr[0]),sep,SQRT(sol->qr[1]),sep,SQRT(sol->qr[2]),
-               sep,sqvar(sol->qr[3]),sep,sqvar(sol->qr[4]),sep,sqvar(sol->qr[5]),
-               sep,sol->age,sep,sol->ratio);
+    std[0]=SQRT(sol->qr[0]); std[1]=SQRT(sol->qr[1]); std[2]=SQRT(sol->qr[2]);
+    std[3]=sqvar(sol->qr[3]); std[4]=sqvar(sol->qr[4]); std[5]=sqvar(sol->qr[5]);
+    
+    p=fmts(p,s);
+    for (i=0;i<3;i++) {
+        p=fmts(p,sep); p=fmtfix(p,sol->rr[i],14,4,0);
+    }
+    p=outqual(p,sep,sol,std);
     return p-(char *)buff;
 }
 /* output solution as the form of lat/lon/height -----------------------------*/
 static int outpos(unsigned char *buff, const char *s, const sol_t *sol,
                   const solopt_t *opt)
 {
-    double pos[3],dms1[3],dms2[3],P[9],Q[9];
+    double pos[3],dms1[3],dms2[3],P[9],Q[9],std[6];
     const char *sep=opt2sep(opt);
     char *p=(char *)buff;
     
@@ -984,25 +1565,32 @@ static int outpos(unsigned char *buff, const char *s, const sol_t *sol,
     if (opt->height==1) { /* geodetic height */
         pos[2]-=geoidh(pos);
     }
+    p=fmts(p,s);
     if (opt->degf) {
         deg2dms(pos[0]*R2D,dms1);
         deg2dms(pos[1]*R2D,dms2);
-        p+=sprintf(p,"%s%s%4.0f%s%02.0f%s%08.5f%s%4.0f%s%02.0f%s%08.5f",s,sep,
-                   dms1[0],sep,dms1[1],sep,dms1[2],sep,dms2[0],sep,dms2[1],sep,
-                   dms2[2]);
-    }
-    else p+=sprintf(p,"%s%s%14.9f%s%14.9f",s,sep,pos[0]*R2D,sep,pos[1]*R2D);
-    p+=sprintf(p,"%s%10.4f%s%3d%s%3d%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%6.2f%s%6.1f\n",
-               sep,pos[2],sep,sol->stat,sep,sol->ns,sep,SQRT(Q[4]),sep,
-               SQRT(Q[0]),sep,SQRT(Q[8]),sep,sqvar(Q[1]),sep,sqvar(Q[2]),
-               sep,sqvar(Q[5]),sep,sol->age,sep,sol->ratio);
+        p=fmts(p,sep); p=fmtfix(p,dms1[0],4,0,0);
+        p=fmts(p,sep); p=fmtfix(p,dms1[1],2,0,1);
+        p=fmts(p,sep); p=fmtfix(p,dms1[2],8,5,1);
+        p=fmts(p,sep); p=fmtfix(p,dms2[0],4,0,0);
+        p=fmts(p,sep); p=fmtfix(p,dms2[1],2,0,1);
+        p=fmts(p,sep); p=fmtfix(p,dms2[2],8,5,1);
+    }
+    else {
+        p=fmts(p,sep); p=fmtfix(p,pos[0]*R2D,14,9,0);
+        p=fmts(p,sep); p=fmtfix(p,pos[1]*R2D,14,9,0);
+    }
+    p=fmts(p,sep); p=fmtfix(p,pos[2],10,4,0);
+    std[0]=SQRT(Q[4]); std[1]=SQRT(Q[0]); std[2]=SQRT(Q[8]);
+    std[3]=sqvar(Q[1]); std[4]=sqvar(Q[2]); std[5]=sqvar(Q[5]);
+    p=outqual(p,sep,sol,std);
     return p-(char *)buff;
 }
 /* output solution as the form of e/n/u-baseline -----------------------------*/
 static int outenu(unsigned char *buff, const char *s, const sol_t *sol,
                   const double *rb, const solopt_t *opt)
 {
-    double pos[3],rr[3],enu[3],P[9],Q[9];
+    double pos[3],rr[3],enu[3],P[9],Q[9],std[6];
     int i;
     const char *sep=opt2sep(opt);
     char *p=(char *)buff;
@@ -1014,12 +1602,45 @@ static int outenu(unsigned char *buff, const char *s, const sol_t *sol,
     soltocov(sol,P);
     covenu(pos,P,Q);
     ecef2enu(pos,rr,enu);
-    p+=sprintf(p,"%s%s%14.4f%s%14.4f%s%14.4f%s%3d%s%3d%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%8.4f%s%6.2f%s%6.1f\n",
-               s,sep,enu[0],sep,enu[1],sep,enu[2],sep,sol->stat,sep,sol->ns,sep,
-               SQRT(Q[0]),sep,SQRT(Q[4]),sep,SQRT(Q[8]),sep,sqvar(Q[1]),
-               sep,sqvar(Q[5]),sep,sqvar(Q[2]),sep,sol->age,sep,sol->ratio);
+    p=fmts(p,s);
+    for (i=0;i<3;i++) {
+        p=fmts(p,sep); p=fmtfix(p,enu[i],14,4,0);
+    }
+    std[0]=SQRT(Q[0]); std[1]=SQRT(Q[4]); std[2]=SQRT(Q[8]);
+    std[3]=sqvar(Q[1]); std[4]=sqvar(Q[5]); std[5]=sqvar(Q[2]);
+    p=outqual(p,sep,sol,std);
     return p-(char *)buff;
 }
+/* output solution as binary record ------------------------------------------*/
+static int outsolbin(unsigned char *buff, const sol_t *sol, const double *rb)
+{
+    unsigned char *p=buff+6;
+    double tow;
+    int i,week;
+    
+    trace(3,"outsolbin:\n");
+    
+    tow=time2gpst(sol->time,&week);
+    setU2(p,(unsigned short)week); p+=2;
+    setR8(p,tow); p+=8;
+    for (i=0;i<6;i++,p+=8) setR8(p,sol->rr[i]);
+    for (i=0;i<6;i++,p+=4) setR4(p,sol->qr[i]);
+    setR8(p,sol->dtr[0]); p+=8;
+    for (i=0;i<3;i++,p+=8) setR8(p,rb?rb[i]:0.0);
+    *p++=sol->type;
+    *p++=sol->stat;
+    *p++=sol->ns;
+    setR4(p,sol->age  ); p+=4;
+    setR4(p,sol->ratio); p+=4;
+    
+    buff[0]=SOLBIN_SYNC1;
+    buff[1]=SOLBIN_SYNC2;
+    buff[2]=SOLBIN_VER;
+    buff[3]=SOLBIN_SOL;
+    setU2(buff+4,(unsigned short)(p-buff-6));
+    setU2(p,rtk_crc16(buff+2,(int)(p-buff-2)));
+    return (int)(p-buff)+2;
+}
 /* output solution in the form of nmea RMC sentence --------------------------*/
 extern int outnmea_rmc(unsigned char *buff, const sol_t *sol)
 {
@@ -1050,11 +1671,20 @@ extern int outnmea_rmc(unsigned char *buff, const sol_t *sol)
     else dir=dirp;
     deg2dms(fabs(pos[0])*R2D,dms1);
     deg2dms(fabs(pos[1])*R2D,dms2);
-    p+=sprintf(p,"$GPRMC,%02.0f%02.0f%05.2f,A,%02.0f%010.7f,%s,%03.0f%010.7f,%s,%4.2f,%4.2f,%02.0f%02.0f%02d,%.1f,%s,%s",
-               ep[3],ep[4],ep[5],dms1[0],dms1[1]+dms1[2]/60.0,pos[0]>=0?"N":"S",
-               dms2[0],dms2[1]+dms2[2]/60.0,pos[1]>=0?"E":"W",vel/KNOT2M,dir,
-               ep[2],ep[1],(int)ep[0]%100,amag,emag,
-               sol->stat==SOLQ_DGPS||sol->stat==SOLQ_FLOAT||sol->stat==SOLQ_FIX?"D":"A");
+    p=fmts(p,"$GPRMC,");
+    p=fmtfix(p,ep[3],2,0,1); p=fmtfix(p,ep[4],2,0,1); p=fmtfix(p,ep[5],5,2,1);
+    p=fmts(p,",A,");
+    p=fmtfix(p,dms1[0],2,0,1); p=fmtfix(p,dms1[1]+dms1[2]/60.0,10,7,1);
+    p=fmts(p,pos[0]>=0?",N,":",S,");
+    p=fmtfix(p,dms2[0],3,0,1); p=fmtfix(p,dms2[1]+dms2[2]/60.0,10,7,1);
+    p=fmts(p,pos[1]>=0?",E,":",W,");
+    p=fmtfix(p,vel/KNOT2M,4,2,0); *p++=',';
+    p=fmtfix(p,dir,4,2,0); *p++=',';
+    p=fmtfix(p,ep[2],2,0,1); p=fmtfix(p,ep[1],2,0,1); p=fmtint(p,(int)ep[0]%100,2,1);
+    *p++=',';
+    p=fmtfix(p,amag,0,1,0); *p++=',';
+    p=fmts(p,emag); *p++=',';
+    p=fmts(p,sol->stat==SOLQ_DGPS||sol->stat==SOLQ_FLOAT||sol->stat==SOLQ_FIX?"D":"A");
     for (q=(char *)buff+1,sum=0;*q;q++) sum^=*q; /* check-sum */
     p+=sprintf(p,"*%02X%c%c",sum,0x0D,0x0A);
     return p-(char *)buff;
@@ -1084,10 +1714,19 @@ extern int outnmea_gga(unsigned char *buff, const sol_t *sol)
     h=geoidh(pos);
     deg2dms(fabs(pos[0])*R2D,dms1);
     deg2dms(fabs(pos[1])*R2D,dms2);
-    p+=sprintf(p,"$GPGGA,%02.0f%02.0f%05.2f,%02.0f%010.7f,%s,%03.0f%010.7f,%s,%d,%02d,%.1f,%.3f,M,%.3f,M,%.1f,",
-               ep[3],ep[4],ep[5],dms1[0],dms1[1]+dms1[2]/60.0,pos[0]>=0?"N":"S",
-               dms2[0],dms2[1]+dms2[2]/60.0,pos[1]>=0?"E":"W",solq,
-               sol->ns,dop,pos[2]-h,h,sol->age);
+    p=fmts(p,"$GPGGA,");
+    p=fmtfix(p,ep[3],2,0,1); p=fmtfix(p,ep[4],2,0,1); p=fmtfix(p,ep[5],5,2,1);
+    *p++=',';
+    p=fmtfix(p,dms1[0],2,0,1); p=fmtfix(p,dms1[1]+dms1[2]/60.0,10,7,1);
+    p=fmts(p,pos[0]>=0?",N,":",S,");
+    p=fmtfix(p,dms2[0],3,0,1); p=fmtfix(p,dms2[1]+dms2[2]/60.0,10,7,1);
+    p=fmts(p,pos[1]>=0?",E,":",W,");
+    p=fmtint(p,solq,0,0); *p++=',';
+    p=fmtint(p,sol->ns,2,1); *p++=',';
+    p=fmtfix(p,dop,0,1,0); *p++=',';
+    p=fmtfix(p,pos[2]-h,0,3,0); p=fmts(p,",M,");
+    p=fmtfix(p,h,0,3,0); p=fmts(p,",M,");
+    p=fmtfix(p,sol->age,0,1,0); p=fmts(p,",");
     for (q=(char *)buff+1,sum=0;*q;q++) sum^=*q; /* check-sum */
     p+=sprintf(p,"*%02X%c%c",sum,0x0D,0x0A);
     return p-(char *)buff;
@@ -1121,8 +1760,8 @@ extern int outnmea_gsa(unsigned char *buff, const sol_t *sol,
         s=p;
         p+=sprintf(p,"$GPGSA,A,%d",sol->stat<=0?1:3);
         for (i=0;i<12;i++) {
-            if (i<nsat) p+=sprintf(p,",%02d",prn[i]);
-            else        p+=sprintf(p,",");
+            *p++=',';
+            if (i<nsat) p=fmtint(p,prn[i],2,1); else *p='\0';
         }
         dops(nsat,azel,0.0,dop);
         p+=sprintf(p,",%3.1f,%3.1f,%3.1f,1",dop[1],dop[2],dop[3]);
@@ -1140,8 +1779,8 @@ extern int outnmea_gsa(unsigned char *buff, const sol_t *sol,
         s=p;
         p+=sprintf(p,"$GLGSA,A,%d",sol->stat<=0?1:3);
         for (i=0;i<12;i++) {
-            if (i<nsat) p+=sprintf(p,",%02d",prn[i]+64);
-            else        p+=sprintf(p,",");
+            *p++=',';
+            if (i<nsat) p=fmtint(p,prn[i]+64,2,1); else *p='\0';
         }
         dops(nsat,azel,0.0,dop);
         p+=sprintf(p,",%3.1f,%3.1f,%3.1f,2",dop[1],dop[2],dop[3]);
@@ -1159,8 +1798,8 @@ extern int outnmea_gsa(unsigned char *buff, const sol_t *sol,
         s=p;
         p+=sprintf(p,"$GAGSA,A,%d",sol->stat<=0?1:3);
         for (i=0;i<12;i++) {
-            if (i<nsat) p+=sprintf(p,",%02d",prn[i]);
-            else        p+=sprintf(p,",");
+            *p++=',';
+            if (i<nsat) p=fmtint(p,prn[i],2,1); else *p='\0';
         }
         dops(nsat,azel,0.0,dop);
         p+=sprintf(p,",%3.1f,%3.1f,%3.1f,3",dop[1],dop[2],dop[3]);
@@ -1203,9 +1842,12 @@ extern int outnmea_gsv(unsigned char *buff, const sol_t *sol,
                 az =ssat[sats[k]-1].azel[0]*R2D; if (az<0.0) az+=360.0;
                 el =ssat[sats[k]-1].azel[1]*R2D;
                 snr=ssat[sats[k]-1].snr[0]*0.25;
-                p+=sprintf(p,",%02d,%02.0f,%03.0f,%02.0f",prn,el,az,snr);
+                *p++=','; p=fmtint(p,prn,2,1);
+                *p++=','; p=fmtfix(p,el,2,0,1);
+                *p++=','; p=fmtfix(p,az,3,0,1);
+                *p++=','; p=fmtfix(p,snr,2,0,1);
             }
-            else p+=sprintf(p,",,,,");
+            else p=fmts(p,",,,,");
         }
         p+=sprintf(p,",1"); /* L1C/A */
         for (q=s+1,sum=0;*q;q++) sum^=*q; /* check-sum */
@@ -1228,9 +1870,12 @@ extern int outnmea_gsv(unsigned char *buff, const sol_t *sol,
                 az =ssat[sats[k]-1].azel[0]*R2D; if (az<0.0) az+=360.0;
                 el =ssat[sats[k]-1].azel[1]*R2D;
                 snr=ssat[sats[k]-1].snr[0]*0.25;
-                p+=sprintf(p,",%02d,%02.0f,%03.0f,%02.0f",prn,el,az,snr);
+                *p++=','; p=fmtint(p,prn,2,1);
+                *p++=','; p=fmtfix(p,el,2,0,1);
+                *p++=','; p=fmtfix(p,az,3,0,1);
+                *p++=','; p=fmtfix(p,snr,2,0,1);
             }
-            else p+=sprintf(p,",,,,");
+            else p=fmts(p,",,,,");
         }
         p+=sprintf(p,",1"); /* L1C/A */
         for (q=s+1,sum=0;*q;q++) sum^=*q; /* check-sum */
@@ -1253,9 +1898,12 @@ extern int outnmea_gsv(unsigned char *buff, const sol_t *sol,
                 az =ssat[sats[k]-1].azel[0]*R2D; if (az<0.0) az+=360.0;
                 el =ssat[sats[k]-1].azel[1]*R2D;
                 snr=ssat[sats[k]-1].snr[0]*0.25;
-                p+=sprintf(p,",%02d,%02.0f,%03.0f,%02.0f",prn,el,az,snr);
+                *p++=','; p=fmtint(p,prn,2,1);
+                *p++=','; p=fmtfix(p,el,2,0,1);
+                *p++=','; p=fmtfix(p,az,3,0,1);
+                *p++=','; p=fmtfix(p,snr,2,0,1);
             }
-            else p+=sprintf(p,",,,,");
+            else p=fmts(p,",,,,");
         }
         p+=sprintf(p,",7"); /* L1BC */
         for (q=s+1,sum=0;*q;q++) sum^=*q; /* check-sum */
@@ -1353,6 +2001,16 @@ extern int outsolheads(unsigned char *buff, const solopt_t *opt)
     
     if (opt->posf==SOLF_NMEA) return 0;
     
+    if (opt->posf==SOLF_BIN) { /* binary format version header */
+        p+=sprintf(p+6,"RTKLIB ver.%s",VER_RTKLIB)+6;
+        buff[0]=SOLBIN_SYNC1;
+        buff[1]=SOLBIN_SYNC2;
+        buff[2]=SOLBIN_VER;
+        buff[3]=SOLBIN_HEAD;
+        setU2(buff+4,(unsigned short)(p-(char *)buff-6));
+        setU2((unsigned char *)p,rtk_crc16(buff+2,(int)(p-(char *)buff-2)));
+        return (int)(p-(char *)buff)+2;
+    }
     if (opt->outhead) {
         p+=sprintf(p,"%s (",COMMENTH);
         if      (opt->posf==SOLF_XYZ) p+=sprintf(p,"x/y/z-ecef=WGS84");
@@ -1405,7 +2063,7 @@ extern int outsols(unsigned char *buff, const sol_t *sol, const double *rb,
     double gpst;
     int week,timeu;
     const char *sep=opt2sep(opt);
-    char s[64];
+    char s[64],*q;
     unsigned char *p=buff;
     
     trace(3,"outsols :\n");
@@ -1417,20 +2075,24 @@ extern int outsols(unsigned char *buff, const sol_t *sol, const double *rb,
     if (sol->stat<=SOLQ_NONE||(opt->posf==SOLF_ENU&&norm(rb,3)<=0.0)) {
         return 0;
     }
+    if (opt->posf==SOLF_BIN) return outsolbin(buff,sol,rb);
+    
     timeu=opt->timeu<0?0:(opt->timeu>20?20:opt->timeu);
     
     time=sol->time;
     if (opt->times>=TIMES_UTC) time=gpst2utc(time);
     if (opt->times==TIMES_JST) time=timeadd(time,9*3600.0);
     
-    if (opt->timef) time2str(time,s,timeu);
+    if (opt->timef) fmttime(s,time,timeu);
     else {
         gpst=time2gpst(time,&week);
         if (86400*7-gpst<0.5/pow(10.0,timeu)) {
             week++;
             gpst=0.0;
         }
-        sprintf(s,"%4d%s%*.*f",week,sep,6+(timeu<=0?0:timeu+1),timeu,gpst);
+        q=fmtint(s,week,4,0);
+        q=fmts(q,sep);
+        fmtfix(q,gpst,6+(timeu<=0?0:timeu+1),timeu,0);
     }
     switch (opt->posf) {
         case SOLF_LLH:  p+=outpos (p,s,sol,opt);   break;
@@ -43,6 +43,12 @@
 *           2014/06/21 1.14 add general hex message rcv command by !HEX ...
 *           2014/10/16 1.15 support stdin/stdou for input/output from/to file
 *           2014/11/08 1.16 fix getconfig error (87) with bluetooth device
+*           2026/10/19 1.17 add buffered asynchronous file write mode (::B)
+*                           check file swap by precomputed deadline
+*           2026/10/19 1.18 replay time-tag file by memory mapped index
+*                           add max speed replay mode (::xmax)
+*                           add api strseek()
+*                           slave streams follow seek of master stream
 *-----------------------------------------------------------------------------*/
 #include <ctype.h>
 #include "rtklib.h"
@@ -51,6 +57,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #define __USE_MISC
 #include <errno.h>
 #include <termios.h>
@@ -70,6 +77,11 @@ static const char rcsid[]="$Id$";
 #define TIMETAGH_LEN        64          /* time tag file header length */
 #define MAXCLI              32          /* max client connection for tcp svr */
 #define MAXSTATMSG          32          /* max length of status message */
+#define FILE_FLUSH_POLL     10          /* async file flush poll cycle (ms) */
+#define FILE_FLUSH_INTV     1000        /* async file flush interval (ms) */
+#define FILE_FLUSH_SIZE     65536       /* async file flush size (bytes) */
+#define TIMETAG_HEAD        (TIMETAGH_LEN+sizeof(gtime_t)) /* time tag header */
+#define TIMETAG_REC         (sizeof(unsigned int)+sizeof(size_t)) /* record */
 
 #define NTRIP_AGENT         "RTKLIB/" VER_RTKLIB
 #define NTRIP_CLI_PORT      2101        /* default ntrip-client connection port */
@@ -112,6 +124,11 @@ typedef struct {            /* serial control type */
 #endif
 } serial_t;
 
+typedef struct {            /* file write buffer type */
+    unsigned char *data;    /* data buffer */
+    int n,nmax;             /* data length and buffer size (bytes) */
+} wbuff_t;
+
 typedef struct {            /* file control type */
     FILE *fp;               /* file pointer */
     FILE *fp_tag;           /* file pointer of tag file */
@@ -130,8 +147,22 @@ typedef struct {            /* file control type */
     unsigned int fpos;      /* current file position */
     double start;           /* start offset (s) */
     double speed;           /* replay speed (time factor) */
+    int drain;              /* replay at max speed (0:off,1:on) */
+    unsigned char *tag;     /* time tag records (mapped) */
+    size_t tag_size;        /* time tag file size (bytes) */
+    int tag_n,tag_i;        /* number of and index of next time tag record */
+    unsigned int nseek;     /* seek count of master followed (slave) */
     double swapintv;        /* swap interval (hr) (0: no swap) */
-    lock_t lock;            /* lock flag */
+    unsigned int tick_swap; /* tick of next swap check */
+    size_t wpos,wpos_tmp;   /* write file positions {file,temporary file} */
+    int async;              /* async write (0:off,1:on,2:thread running) */
+    int flush_intv;         /* async flush interval (ms) */
+    int flush_size;         /* async flush size (bytes) */
+    wbuff_t wbuf[3];        /* write buffers {file,tag,tag_tmp} */
+    wbuff_t fbuf[3];        /* flush buffers {file,tag,tag_tmp} */
+    thread_t thread;        /* async flush thread */
+    lock_t lock;            /* lock flag for write buffers */
+    lock_t lock_io;         /* lock flag for file i/o of async flush */
 } file_t;
 
 typedef struct {            /* tcp control type */
@@ -193,6 +224,7 @@ static int buffsize =32768; /* receive/send buffer size (bytes) */
 static char localdir[1024]=""; /* local directory for ftp/http */
 static char proxyaddr[256]=""; /* http/ntrip/ftp proxy address */
 static unsigned int tick_master=0; /* time tick master for replay */
+static unsigned int nseek_master=0; /* seek count of master for replay */
 static int fswapmargin=30;  /* file swap margin (s) */
 
 /* read/write serial buffer --------------------------------------------------*/
@@ -438,6 +470,88 @@ static int stateserial(serial_t *serial)
 {
     return !serial?0:(serial->error?-1:2);
 }
+/* map time tag file --------------------------------------------------------*/
+static void maptag(file_t *file, const char *tagpath)
+{
+#ifdef WIN32
+    FILE *fp;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+#endif
+    file->tag=NULL;
+    file->tag_size=0;
+    file->tag_n=file->tag_i=0;
+#ifdef WIN32
+    if (!(fp=fopen(tagpath,"rb"))) return;
+    fseek(fp,0,SEEK_END);
+    file->tag_size=(size_t)ftell(fp);
+    fseek(fp,0,SEEK_SET);
+    if (file->tag_size<=TIMETAG_HEAD||
+        !(file->tag=(unsigned char *)malloc(file->tag_size))||
+        fread(file->tag,file->tag_size,1,fp)<1) {
+        free(file->tag); file->tag=NULL;
+        fclose(fp);
+        return;
+    }
+    fclose(fp);
+#else
+    if ((fd=open(tagpath,O_RDONLY))<0) return;
+    if (fstat(fd,&st)<0||(size_t)st.st_size<=TIMETAG_HEAD||
+        (p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0))==MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    close(fd);
+    file->tag=(unsigned char *)p;
+    file->tag_size=(size_t)st.st_size;
+#endif
+    file->tag_n=(int)((file->tag_size-TIMETAG_HEAD)/TIMETAG_REC);
+    
+    tracet(4,"maptag: path=%s n=%d\n",tagpath,file->tag_n);
+}
+/* unmap time tag file -------------------------------------------------------*/
+static void unmaptag(file_t *file)
+{
+    if (!file->tag) return;
+#ifdef WIN32
+    free(file->tag);
+#else
+    munmap(file->tag,file->tag_size);
+#endif
+    file->tag=NULL;
+    file->tag_size=0;
+    file->tag_n=file->tag_i=0;
+}
+/* get time tag record -------------------------------------------------------*/
+static void gettag(const file_t *file, int i, unsigned int *tick, size_t *fpos)
+{
+    const unsigned char *p=file->tag+TIMETAG_HEAD+TIMETAG_REC*i;
+    
+    memcpy(tick,p,sizeof(*tick));
+    memcpy(fpos,p+sizeof(*tick),sizeof(*fpos));
+}
+/* search time tag record ------------------------------------------------------
+* search first time tag record after tick t (binary search)
+* args   : file_t *file     I   file control
+*          int    i0        I   first index to search
+*          unsigned int t   I   tick (ms)
+* return : index of first record with tick > t (tag_n: no record)
+*-----------------------------------------------------------------------------*/
+static int searchtag(const file_t *file, int i0, unsigned int t)
+{
+    unsigned int tick;
+    size_t fpos;
+    int i,j,k;
+    
+    for (i=i0,j=file->tag_n;i<j;) {
+        k=i+(j-i)/2;
+        gettag(file,k,&tick,&fpos);
+        if ((int)(tick-t)<1) i=k+1; else j=k;
+    }
+    return i;
+}
 /* open file -----------------------------------------------------------------*/
 static int openfile_(file_t *file, gtime_t time, char *msg)
 {    
@@ -445,11 +559,12 @@ static int openfile_(file_t *file, gtime_t time, char *msg)
     char *rw,tagpath[MAXSTRPATH+4]="";
     char tagh[TIMETAGH_LEN+1]="";
     
-    tracet(3,"openfile_: path=%s time=%s\n",file->path,time_str(time,0));
+    if (TRACEON(3)) tracet(3,"openfile_: path=%s time=%s\n",file->path,time_str(time,0));
     
     file->time=utc2gpst(timeget());
     file->tick=file->tick_f=tickget();
     file->fpos=0;
+    file->wpos=0;
     
     /* use stdin or stdout if file path is null */
     if (!*file->path) {
@@ -494,6 +609,9 @@ static int openfile_(file_t *file, gtime_t time, char *msg)
             }
             /* adust time to read playback file */
             timeset(file->time);
+            
+            /* map time tag records */
+            maptag(file,tagpath);
         }
         else {
             sprintf(tagh,"TIMETAG RTKLIB %s",VER_RTKLIB);
@@ -524,15 +642,169 @@ static void closefile_(file_t *file)
     if (file->fp_tmp) fclose(file->fp_tmp);
     if (file->fp_tag_tmp) fclose(file->fp_tag_tmp);
     file->fp=file->fp_tag=file->fp_tmp=file->fp_tag_tmp=NULL;
+    unmaptag(file);
+}
+/* seek replay file to time tag record at or after tick ---------------------*/
+static int seektag(file_t *file, unsigned int t)
+{
+    unsigned int tick=0;
+    size_t fpos=0;
+    int i;
+    
+    i=searchtag(file,0,t-1);
+    if (i>0) gettag(file,i-1,&tick,&fpos);
+    
+    if (fseek(file->fp,(long)fpos,SEEK_SET)) return 0;
+    file->fpos=(unsigned int)fpos;
+    file->tag_i=i;
+    return 1;
+}
+/* seek replay file by time tag ---------------------------------------------*/
+static int seekfile(file_t *file, double offset)
+{
+    tracet(3,"seekfile: offset=%.3f\n",offset);
+    
+    if (!file->tag||offset<0.0) return 0;
+    
+    if (!seektag(file,(unsigned int)(offset*1000.0))) return 0;
+    file->start=offset;
+    file->tick=tickget();
+    if (!file->repmode) {
+        tick_master=(unsigned int)(offset*1000.0);
+        nseek_master++;
+    }
+    return 1;
+}
+/* write buffers to files ----------------------------------------------------*/
+static void writewbuff(file_t *file, wbuff_t *wb)
+{
+    if (wb[0].n>0) {
+        if (file->fp    ) fwrite(wb[0].data,1,wb[0].n,file->fp    );
+        if (file->fp_tmp) fwrite(wb[0].data,1,wb[0].n,file->fp_tmp);
+    }
+    if (wb[1].n>0&&file->fp_tag    ) fwrite(wb[1].data,1,wb[1].n,file->fp_tag    );
+    if (wb[2].n>0&&file->fp_tag_tmp) fwrite(wb[2].data,1,wb[2].n,file->fp_tag_tmp);
+    
+    if (wb[0].n>0) {
+        if (file->fp    ) fflush(file->fp    );
+        if (file->fp_tmp) fflush(file->fp_tmp);
+    }
+    if (wb[1].n>0&&file->fp_tag    ) fflush(file->fp_tag    );
+    if (wb[2].n>0&&file->fp_tag_tmp) fflush(file->fp_tag_tmp);
+    
+    wb[0].n=wb[1].n=wb[2].n=0;
+}
+/* put data to write buffer --------------------------------------------------*/
+static int putwbuff(wbuff_t *wb, const void *data, int n)
+{
+    unsigned char *p;
+    int nmax;
+    
+    if (wb->n+n>wb->nmax) {
+        nmax=wb->nmax*2>wb->n+n?wb->nmax*2:wb->n+n;
+        if (!(p=(unsigned char *)realloc(wb->data,nmax))) return 0;
+        wb->data=p;
+        wb->nmax=nmax;
+    }
+    memcpy(wb->data+wb->n,data,n);
+    wb->n+=n;
+    return 1;
+}
+/* flush write buffers to files ----------------------------------------------*/
+static void flushfile(file_t *file)
+{
+    wbuff_t wb;
+    int i;
+    
+    lock(&file->lock_io);
+    
+    /* swap write buffers and flush buffers */
+    lock(&file->lock);
+    for (i=0;i<3;i++) {
+        wb=file->wbuf[i]; file->wbuf[i]=file->fbuf[i]; file->fbuf[i]=wb;
+    }
+    unlock(&file->lock);
+    
+    writewbuff(file,file->fbuf);
+    
+    unlock(&file->lock_io);
+}
+/* async file flush thread ---------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI flushthread(void *arg)
+#else
+static void *flushthread(void *arg)
+#endif
+{
+    file_t *file=(file_t *)arg;
+    unsigned int tick=tickget();
+    
+    tracet(3,"flushthread:\n");
+    
+    while (file->async==2) {
+        sleepms(FILE_FLUSH_POLL);
+        
+        if ((int)(tickget()-tick)<file->flush_intv&&
+            file->wbuf[0].n<file->flush_size) continue;
+        
+        flushfile(file);
+        tick=tickget();
+    }
+    return 0;
+}
+/* start async file flush thread ---------------------------------------------*/
+static int startflush(file_t *file)
+{
+    int i;
+    
+    for (i=0;i<3;i++) {
+        file->wbuf[i].n=file->fbuf[i].n=0;
+        file->wbuf[i].nmax=file->fbuf[i].nmax=i==0?file->flush_size*2:4096;
+        file->wbuf[i].data=(unsigned char *)malloc(file->wbuf[i].nmax);
+        file->fbuf[i].data=(unsigned char *)malloc(file->fbuf[i].nmax);
+        if (!file->wbuf[i].data||!file->fbuf[i].data) return 0;
+    }
+    file->async=2;
+#ifdef WIN32
+    if (!(file->thread=CreateThread(NULL,0,flushthread,file,0,NULL))) {
+#else
+    if (pthread_create(&file->thread,NULL,flushthread,file)) {
+#endif
+        file->async=1;
+        return 0;
+    }
+    return 1;
 }
-/* open file (path=filepath[::T[::+<off>][::x<speed>]][::S=swapintv]) --------*/
+/* stop async file flush thread ----------------------------------------------*/
+static void stopflush(file_t *file)
+{
+    int i;
+    
+    if (file->async==2) {
+        file->async=1;
+#ifdef WIN32
+        WaitForSingleObject(file->thread,10000);
+        CloseHandle(file->thread);
+#else
+        pthread_join(file->thread,NULL);
+#endif
+        writewbuff(file,file->wbuf);
+    }
+    for (i=0;i<3;i++) {
+        free(file->wbuf[i].data); file->wbuf[i].data=NULL;
+        free(file->fbuf[i].data); file->fbuf[i].data=NULL;
+    }
+}
+/* open file (path=filepath[::T[::+<off>][::x<speed>|::xmax]][::S=swapintv] -*/
+/*            [::B[=intv[:size]]])                                            */
 static file_t *openfile(const char *path, int mode, char *msg)
 {
     file_t *file;
     gtime_t time,time0={0};
     double speed=0.0,start=0.0,swapintv=0.0;
     char *p;
-    int timetag=0;
+    int i,timetag=0,drain=0,async=0,flush_intv=FILE_FLUSH_INTV;
+    int flush_size=FILE_FLUSH_SIZE;
     
     tracet(3,"openfile: path=%s mode=%d\n",path,mode);
     
@@ -542,11 +814,19 @@ static file_t *openfile(const char *path, int mode, char *msg)
     for (p=(char *)path;(p=strstr(p,"::"));p+=2) { /* file options */
         if      (*(p+2)=='T') timetag=1;
         else if (*(p+2)=='+') sscanf(p+2,"+%lf",&start);
+        else if (!strncmp(p+2,"xmax",4)) drain=1;
         else if (*(p+2)=='x') sscanf(p+2,"x%lf",&speed);
         else if (*(p+2)=='S') sscanf(p+2,"S=%lf",&swapintv);
+        else if (*(p+2)=='B') {
+            async=1;
+            sscanf(p+2,"B=%d:%d",&flush_intv,&flush_size);
+        }
     }
     if (start<=0.0) start=0.0;
     if (swapintv<=0.0) swapintv=0.0;
+    if (flush_intv<=0) flush_intv=FILE_FLUSH_INTV;
+    if (flush_size<=0) flush_size=FILE_FLUSH_SIZE;
+    if (!(mode&STR_MODE_W)||(mode&STR_MODE_R)) async=0;
     
     if (!(file=(file_t *)malloc(sizeof(file_t)))) return NULL;
     
@@ -562,8 +842,23 @@ static file_t *openfile(const char *path, int mode, char *msg)
     file->tick=file->tick_f=file->fpos=0;
     file->start=start;
     file->speed=speed;
+    file->drain=drain;
+    file->tag=NULL;
+    file->tag_size=0;
+    file->tag_n=file->tag_i=0;
+    file->nseek=0;
     file->swapintv=swapintv;
+    file->tick_swap=0;
+    file->wpos=file->wpos_tmp=0;
+    file->async=async;
+    file->flush_intv=flush_intv;
+    file->flush_size=flush_size;
+    for (i=0;i<3;i++) {
+        file->wbuf[i].data=file->fbuf[i].data=NULL;
+        file->wbuf[i].n=file->wbuf[i].nmax=file->fbuf[i].n=file->fbuf[i].nmax=0;
+    }
     initlock(&file->lock);
+    initlock(&file->lock_io);
     
     time=utc2gpst(timeget());
     
@@ -572,6 +867,19 @@ static file_t *openfile(const char *path, int mode, char *msg)
         free(file);
         return NULL;
     }
+    /* seek to replay start offset */
+    if (file->tag&&file->start>0.0) seekfile(file,file->start);
+    
+    /* start async flush thread */
+    if (file->async&&!startflush(file)) {
+        sprintf(msg,"file flush thread error: %.*s",MAXSTRMSG-32,
+                file->openpath);
+        tracet(1,"openfile: %s\n",msg);
+        stopflush(file);
+        closefile_(file);
+        free(file);
+        return NULL;
+    }
     return file;
 }
 /* close file ----------------------------------------------------------------*/
@@ -580,6 +888,7 @@ static void closefile(file_t *file)
     tracet(3,"closefile: fp=%d\n",file->fp);
     
     if (!file) return;
+    if (file->async) stopflush(file);
     closefile_(file);
     free(file);
 }
@@ -588,7 +897,7 @@ static void swapfile(file_t *file, gtime_t time, char *msg)
 {
     char openpath[MAXSTRPATH];
     
-    tracet(3,"swapfile: fp=%d time=%s\n",file->fp,time_str(time,0));
+    if (TRACEON(3)) tracet(3,"swapfile: fp=%d time=%s\n",file->fp,time_str(time,0));
     
     /* return if old swap file open */
     if (file->fp_tmp||file->fp_tag_tmp) return;
@@ -603,6 +912,7 @@ static void swapfile(file_t *file, gtime_t time, char *msg)
     /* save file pointer to temporary pointer */
     file->fp_tmp=file->fp;
     file->fp_tag_tmp=file->fp_tag;
+    file->wpos_tmp=file->wpos;
     
     /* open new swap file */
     openfile_(file,time,msg);
@@ -627,7 +937,8 @@ static int readfile(file_t *file, unsigned char *buff, int nmax, char *msg)
     struct timeval tv={0};
     fd_set rs;
     unsigned int nr=0,t,tick;
-    size_t fpos;
+    size_t fpos,fpos_end;
+    int i;
     
     tracet(4,"readfile: fp=%d nmax=%d\n",file->fp,nmax);
     
@@ -644,23 +955,54 @@ static int readfile(file_t *file, unsigned char *buff, int nmax, char *msg)
         return 0;
 #endif
     }
-    if (file->fp_tag) {
+    /* follow seek of master stream */
+    if (file->tag&&file->repmode&&file->nseek!=nseek_master) {
+        seektag(file,(unsigned int)(tick_master+file->offset));
+        file->nseek=nseek_master;
+    }
+    if (file->tag&&file->drain) { /* max speed */
+        t=file->repmode?(unsigned int)(tick_master+file->offset):0;
+        
+        for (i=file->tag_i,fpos_end=file->fpos;i<file->tag_n;i++) {
+            gettag(file,i,&tick,&fpos);
+            if (file->repmode&&(int)(tick-t)>0) break;
+            
+            if (fpos-file->fpos>(size_t)nmax) { /* larger than buffer */
+                if (i==file->tag_i) fpos_end=file->fpos+nmax;
+                break;
+            }
+            fpos_end=fpos;
+            file->tag_i=i+1;
+            if (!file->repmode) tick_master=tick;
+            sprintf(msg,"T%+.1fs",(int)tick<0?0.0:(int)tick/1000.0);
+        }
+        if (file->tag_i>=file->tag_n&&fpos_end==file->fpos) {
+            fseek(file->fp,0,SEEK_END);
+            sprintf(msg,"end");
+        }
+        nmax=(int)(fpos_end-file->fpos);
+    }
+    else if (file->tag) {
         if (file->repmode) { /* slave */
             t=(unsigned int)(tick_master+file->offset);
         }
         else { /* master */
             t=(unsigned int)((tickget()-file->tick)*file->speed+file->start*1000.0);
         }
-        for (;;) { /* seek file position */
-            if (fread(&tick,sizeof(tick),1,file->fp_tag)<1||
-                fread(&fpos,sizeof(fpos),1,file->fp_tag)<1) {
-                fseek(file->fp,0,SEEK_END);
-                sprintf(msg,"end");
-                break;
-            }
-            if (file->repmode||file->speed>0.0) {
-                if ((int)(tick-t)<1) continue;
-            }
+        /* skip records before the replay time */
+        if (file->repmode||file->speed>0.0) {
+            file->tag_i=searchtag(file,file->tag_i,t);
+        }
+        if (file->tag_i>=file->tag_n) {
+            fseek(file->fp,0,SEEK_END);
+            sprintf(msg,"end");
+        }
+        else {
+            gettag(file,file->tag_i,&tick,&fpos);
+            
+            /* step forward except for real-time replay */
+            if (!file->repmode&&file->speed<=0.0) file->tag_i++;
+            
             if (!file->repmode) tick_master=tick;
             
             sprintf(msg,"T%+.1fs",(int)tick<0?0.0:(int)tick/1000.0);
@@ -671,13 +1013,12 @@ static int readfile(file_t *file, unsigned char *buff, int nmax, char *msg)
                return 0;
             }
             nmax=(int)(fpos-file->fpos);
-            
-            if (file->repmode||file->speed>0.0) {
-                fseek(file->fp_tag,-(long)(sizeof(tick)+sizeof(fpos)),SEEK_CUR);
-            }
-            break;
         }
     }
+    else if (file->fp_tag) { /* no time tag record */
+        fseek(file->fp,0,SEEK_END);
+        sprintf(msg,"end");
+    }
     if (nmax>0) {
         nr=fread(buff,1,nmax,file->fp);
         file->fpos+=nr;
@@ -686,62 +1027,135 @@ static int readfile(file_t *file, unsigned char *buff, int nmax, char *msg)
     tracet(5,"readfile: fp=%d nr=%d fpos=%d\n",file->fp,nr,file->fpos);
     return (int)nr;
 }
-/* write file ----------------------------------------------------------------*/
+/* set next tick to check file swap -----------------------------------------*/
+static void setswaptick(file_t *file, gtime_t wtime, unsigned int tick)
+{
+    double intv=file->swapintv*3600.0,tow,t1,t2,t3;
+    int week;
+    
+    tow=time2gpst(wtime,&week);
+    
+    /* time to next open/close of swap file or week start (s) */
+    t1=(floor((tow+fswapmargin)/intv)+1.0)*intv-fswapmargin-tow;
+    t2=(floor((tow-fswapmargin)/intv)+1.0)*intv+fswapmargin-tow;
+    t3=604800.0-tow;
+    if (t2<t1) t1=t2;
+    if (t3<t1) t1=t3;
+    
+    file->tick_swap=tick+(unsigned int)(t1*1000.0);
+}
+/* swap writing file ---------------------------------------------------------*/
+static void swapwrite(file_t *file, gtime_t wtime, char *msg)
+{
+    int week1,week2;
+    double tow1,tow2,intv=file->swapintv*3600.0;
+    
+    tow1=time2gpst(file->wtime,&week1);
+    tow2=time2gpst(wtime,&week2);
+    tow2+=604800.0*(week2-week1);
+    
+    /* flush pending data to current files */
+    if (file->async==2) {
+        lock(&file->lock_io);
+        lock(&file->lock);
+        writewbuff(file,file->wbuf);
+        unlock(&file->lock);
+    }
+    /* open new swap file */
+    if (floor((tow1+fswapmargin)/intv)<floor((tow2+fswapmargin)/intv)) {
+        swapfile(file,timeadd(wtime,fswapmargin),msg);
+    }
+    /* close old swap file */
+    if (floor((tow1-fswapmargin)/intv)<floor((tow2-fswapmargin)/intv)) {
+        swapclose(file);
+    }
+    if (file->async==2) {
+        unlock(&file->lock_io);
+    }
+}
+/* write file ------------------------------------------------------------------
+* notes  : durability of written data depends on the write mode:
+*            sync  (default): data and time-tags are passed to the OS by
+*                  fflush() in each write. they survive a crash of the
+*                  process but not of the OS or power loss (no fsync()).
+*            async (::B[=intv[:size]]): data and time-tags are buffered in
+*                  memory and passed to the OS by a flush thread every intv
+*                  ms (default 1000) or when size bytes (default 65536) are
+*                  buffered. on a crash of the process, up to intv ms or
+*                  size bytes of data may be lost. pending data are always
+*                  flushed before swapping or closing the file.
+*-----------------------------------------------------------------------------*/
 static int writefile(file_t *file, unsigned char *buff, int n, char *msg)
 {
     gtime_t wtime;
-    unsigned int ns,tick=tickget();
-    int week1,week2;
-    double tow1,tow2,intv;
-    size_t fpos,fpos_tmp;
+    unsigned int ns,tick=tickget(),ttag;
+    size_t fpos,fpos_tmp=0;
     
     tracet(3,"writefile: fp=%d n=%d\n",file->fp,n);
     
     if (!file) return 0;
     
-    wtime=utc2gpst(timeget()); /* write time in gpst */
-    
-    /* swap writing file */
-    if (file->swapintv>0.0&&file->wtime.time!=0) {
-        intv=file->swapintv*3600.0;
-        tow1=time2gpst(file->wtime,&week1);
-        tow2=time2gpst(wtime,&week2);
-        tow2+=604800.0*(week2-week1);
+    /* swap writing file at precomputed tick */
+    if (file->swapintv>0.0&&
+        (file->wtime.time==0||(int)(tick-file->tick_swap)>=0)) {
         
-        /* open new swap file */
-        if (floor((tow1+fswapmargin)/intv)<floor((tow2+fswapmargin)/intv)) {
-            swapfile(file,timeadd(wtime,fswapmargin),msg);
-        }
-        /* close old swap file */
-        if (floor((tow1-fswapmargin)/intv)<floor((tow2-fswapmargin)/intv)) {
-            swapclose(file);
-        }
+        wtime=utc2gpst(timeget()); /* write time in gpst */
+        
+        if (file->wtime.time!=0) swapwrite(file,wtime,msg);
+        file->wtime=wtime;
+        setswaptick(file,wtime,tick);
     }
     if (!file->fp) return 0;
     
+    ttag=tick-file->tick;
+    
+    if (file->async==2) { /* async write */
+        lock(&file->lock);
+        if (!putwbuff(file->wbuf,buff,n)) {
+            unlock(&file->lock);
+            return 0;
+        }
+        ns=(unsigned int)n;
+        fpos=file->wpos+=ns;
+        if (file->fp_tmp) fpos_tmp=file->wpos_tmp+=ns;
+        if (file->fp_tag) {
+            putwbuff(file->wbuf+1,&ttag,sizeof(ttag));
+            putwbuff(file->wbuf+1,&fpos,sizeof(fpos));
+            if (file->fp_tag_tmp) {
+                putwbuff(file->wbuf+2,&ttag,sizeof(ttag));
+                putwbuff(file->wbuf+2,&fpos_tmp,sizeof(fpos_tmp));
+            }
+        }
+        n=file->wbuf[0].n;
+        unlock(&file->lock);
+        
+        /* flush buffers if flush thread is behind */
+        if (n>=file->flush_size*2) flushfile(file);
+        
+        tracet(5,"writefile: fp=%d ns=%d tick=%5d fpos=%d\n",file->fp,ns,ttag,
+               fpos);
+        return (int)ns;
+    }
     ns=fwrite(buff,1,n,file->fp);
-    fpos=ftell(file->fp);
+    fpos=file->wpos+=ns;
     fflush(file->fp);
-    file->wtime=wtime;
     
     if (file->fp_tmp) {
-        fwrite(buff,1,n,file->fp_tmp);
-        fpos_tmp=ftell(file->fp_tmp);
+        fpos_tmp=file->wpos_tmp+=fwrite(buff,1,n,file->fp_tmp);
         fflush(file->fp_tmp);
     }
     if (file->fp_tag) {
-        tick-=file->tick;
-        fwrite(&tick,1,sizeof(tick),file->fp_tag);
+        fwrite(&ttag,1,sizeof(ttag),file->fp_tag);
         fwrite(&fpos,1,sizeof(fpos),file->fp_tag);
         fflush(file->fp_tag);
         
         if (file->fp_tag_tmp) {
-            fwrite(&tick,1,sizeof(tick),file->fp_tag_tmp);
+            fwrite(&ttag,1,sizeof(ttag),file->fp_tag_tmp);
             fwrite(&fpos_tmp,1,sizeof(fpos_tmp),file->fp_tag_tmp);
             fflush(file->fp_tag_tmp);
         }
     }
-    tracet(5,"writefile: fp=%d ns=%d tick=%5d fpos=%d\n",file->fp,ns,tick,fpos);
+    tracet(5,"writefile: fp=%d ns=%d tick=%5d fpos=%d\n",file->fp,ns,ttag,fpos);
     
     return (int)ns;
 }
@@ -752,6 +1166,8 @@ static void syncfile(file_t *file1, file_t *file2)
     file1->repmode=0;
     file2->repmode=1;
     file2->offset=(int)(file1->tick_f-file2->tick_f);
+    file2->nseek=nseek_master;
+    if (file1->drain) file2->drain=1;
 }
 /* decode tcp/ntrip path (path=[user[:passwd]@]addr[:port][/mntpnt[:str]]) ---*/
 static void decodetcppath(const char *path, char *addr, char *port, char *user,
@@ -1823,11 +2239,15 @@ extern void strinit(stream_t *stream)
 *                    parity= parity       (n|o|e)
 *                    stopb = stop bits    (1|2)
 *                    fctr  = flow control (off|rts)
-*   STR_FILE     file_path[::T][::+start][::xseppd][::S=swap]
+*   STR_FILE     file_path[::T][::+start][::xseppd][::S=swap][::B[=intv[:size]]]
 *                    ::T   = enable time tag
 *                    start = replay start offset (s)
-*                    speed = replay speed factor
+*                    speed = replay speed factor (max: max speed without
+*                            wait, data of synced files are kept in time order)
 *                    swap  = output swap interval (hr) (0: no swap)
+*                    ::B   = enable async write by flush thread (output)
+*                    intv  = async flush interval (ms) (default: 1000)
+*                    size  = async flush size (bytes) (default: 65536)
 *   STR_TCPSVR   :port
 *   STR_TCPCLI   address:port
 *   STR_NTRIPSVR user[:passwd]@address[:port]/moutpoint[:string]
@@ -2132,6 +2552,31 @@ extern void strsetproxy(const char *addr)
     
     strcpy(proxyaddr,addr);
 }
+/* seek stream ------------------------------------------------------------------
+* seek replay position of file stream with time tag
+* args   : stream_t *stream IO  stream
+*          double offset    I   time offset from start of replay file (s)
+* return : status (0:error,1:ok)
+* notes  : the position is searched in the time tag index by binary search.
+*          slave streams synced by strsync() follow the master stream. they
+*          are moved to the seek time of the master at the next read, forward
+*          or backward, also in max speed replay mode (::xmax).
+*-----------------------------------------------------------------------------*/
+extern int strseek(stream_t *stream, double offset)
+{
+    file_t *file;
+    int stat;
+    
+    tracet(3,"strseek: offset=%.3f\n",offset);
+    
+    if (stream->type!=STR_FILE||!(stream->mode&STR_MODE_R)||
+        !(file=(file_t *)stream->port)) return 0;
+    
+    strlock(stream);
+    stat=seekfile(file,offset);
+    strunlock(stream);
+    return stat;
+}
 /* get stream time -------------------------------------------------------------
 * get stream time
 * args   : stream_t *stream I   stream
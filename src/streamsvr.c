@@ -13,11 +13,17 @@
 *                           suppress warnings
 *           2013/05/08 1.4  fix bug on 1 s offset for javad -> rtcm conversion
 *           2014/10/16 1.5  support input from stdout
+*           2026/10/19 1.6  add per-output queues serviced by output threads
+*                           add api strsvrsetq()
+*                           change api strsvrstat()
+*                           wait for output queues by condition
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
 static const char rcsid[]="$Id$";
 
+#define QUEUE_SIZE_DEF  16      /* default output queue size (x buffsize) */
+
 /* test observation data message ---------------------------------------------*/
 static int is_obsmsg(int msg)
 {
@@ -352,6 +358,173 @@ static void strconv(stream_t *str, strconv_t *conv, unsigned char *buff, int n)
     write_nav_cycle(str,conv);
     write_sta_cycle(str,conv);
 }
+/* put data to output queue -------------------------------------------------*/
+static void putqueue(strsvr_t *svr, strq_t *q, const unsigned char *buff,
+                     int n)
+{
+    int i,m,wp;
+    
+    lock(&q->lock);
+    
+    if (n>q->size) { /* data larger than queue */
+        if (q->policy==STRQ_DROPNEW) {
+            q->ndrop+=n;
+            unlock(&q->lock);
+            return;
+        }
+        if (q->policy==STRQ_DROPOLD) {
+            q->ndrop+=n-q->size;
+            buff+=n-q->size;
+            n=q->size;
+        }
+    }
+    while (n>0) {
+        if (q->nq+n>q->size) {
+            if (q->policy==STRQ_DROPNEW) {
+                q->ndrop+=n-(q->size-q->nq);
+                n=q->size-q->nq;
+            }
+            else if (q->policy==STRQ_DROPOLD) {
+                m=q->nq+n-q->size;
+                q->rp=(q->rp+m)%q->size;
+                q->nq-=m;
+                q->ndrop+=m;
+            }
+        }
+        if (q->nq==0) q->tick=tickget();
+        signalcond(&q->cond);
+        
+        /* copy data to ring buffer */
+        m=q->size-q->nq<n?q->size-q->nq:n;
+        wp=(q->rp+q->nq)%q->size;
+        i=q->size-wp<m?q->size-wp:m;
+        memcpy(q->buff+wp,buff,i);
+        if (m>i) memcpy(q->buff,buff+i,m-i);
+        q->nq+=m; buff+=m; n-=m;
+        
+        if (n<=0||q->policy!=STRQ_BLOCK) break;
+        
+        /* wait for output thread to free queue */
+        while (q->nq>=q->size&&svr->state) waitcond(&q->cond,&q->lock);
+        if (!svr->state) break;
+    }
+    unlock(&q->lock);
+}
+/* get data from output queue ------------------------------------------------*/
+static int getqueue(strq_t *q, unsigned char *buff, int nmax)
+{
+    int i,n;
+    
+    lock(&q->lock);
+    n=q->nq<nmax?q->nq:nmax;
+    i=q->size-q->rp<n?q->size-q->rp:n;
+    memcpy(buff,q->buff+q->rp,i);
+    if (n>i) memcpy(buff+i,q->buff,n-i);
+    q->rp=(q->rp+n)%q->size;
+    q->nq-=n;
+    q->tick=tickget();
+    if (n>0) signalcond(&q->cond);
+    unlock(&q->lock);
+    return n;
+}
+/* write data to output stream -----------------------------------------------*/
+static void writeout(strsvr_t *svr, int i, unsigned char *buff, int n)
+{
+    if (svr->conv[i-1]) {
+        strconv(svr->stream+i,svr->conv[i-1],buff,n);
+    }
+    else if (n>0) {
+        strwrite(svr->stream+i,buff,n);
+    }
+}
+/* output stream thread ------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI strsvroutthread(void *arg)
+#else
+static void *strsvroutthread(void *arg)
+#endif
+{
+    strq_t *q=(strq_t *)arg;
+    strsvr_t *svr=(strsvr_t *)q->svr;
+    unsigned char *buff;
+    int n;
+    
+    tracet(3,"strsvroutthread: idx=%d\n",q->idx);
+    
+    if (!(buff=(unsigned char *)malloc(svr->buffsize))) return 0;
+    
+    while (svr->state) {
+        
+        /* wait for data queued or server cycle */
+        lock(&q->lock);
+        if (q->nq<=0&&svr->state) waitcondms(&q->cond,&q->lock,svr->cycle);
+        unlock(&q->lock);
+        
+        n=getqueue(q,buff,svr->buffsize);
+        writeout(svr,q->idx,buff,n);
+    }
+    /* flush remaining data in queue */
+    while ((n=getqueue(q,buff,svr->buffsize))>0) {
+        writeout(svr,q->idx,buff,n);
+    }
+    free(buff);
+    return 0;
+}
+/* start output stream threads -----------------------------------------------*/
+static int startoutthreads(strsvr_t *svr)
+{
+    strq_t *q;
+    int i;
+    
+    for (i=1;i<svr->nstr;i++) {
+        q=svr->q+i;
+        q->size=q->size>0?q->size:svr->buffsize*QUEUE_SIZE_DEF;
+        q->rp=q->nq=0;
+        q->ndrop=q->lag=0;
+        q->tick=tickget();
+        q->svr=svr;
+        q->idx=i;
+        if (!(q->buff=(unsigned char *)malloc(q->size))) return i-1;
+#ifdef WIN32
+        if (!(q->thread=CreateThread(NULL,0,strsvroutthread,q,0,NULL))) {
+#else
+        if (pthread_create(&q->thread,NULL,strsvroutthread,q)) {
+#endif
+            free(q->buff); q->buff=NULL;
+            return i-1;
+        }
+    }
+    return i-1;
+}
+/* wake threads waiting on output queues ------------------------------------*/
+static void wakequeues(strsvr_t *svr)
+{
+    int i;
+    
+    for (i=1;i<svr->nstr;i++) {
+        lock(&svr->q[i].lock);
+        signalcond(&svr->q[i].cond);
+        unlock(&svr->q[i].lock);
+    }
+}
+/* stop output stream threads ------------------------------------------------*/
+static void stopoutthreads(strsvr_t *svr, int nout)
+{
+    int i;
+    
+    wakequeues(svr);
+    
+    for (i=1;i<=nout;i++) {
+#ifdef WIN32
+        WaitForSingleObject(svr->q[i].thread,10000);
+        CloseHandle(svr->q[i].thread);
+#else
+        pthread_join(svr->q[i].thread,NULL);
+#endif
+        free(svr->q[i].buff); svr->q[i].buff=NULL;
+        svr->q[i].nq=0;
+    }
+}
 /* stearm server thread ------------------------------------------------------*/
 #ifdef WIN32
 static DWORD WINAPI strsvrthread(void *arg)
@@ -361,7 +534,7 @@ static void *strsvrthread(void *arg)
 {
     strsvr_t *svr=(strsvr_t *)arg;
     unsigned int tick,ticknmea;
-    int i,n;
+    int i,n,m,nout;
     
     tracet(3,"strsvrthread:\n");
     
@@ -369,20 +542,20 @@ static void *strsvrthread(void *arg)
     svr->tick=tickget();
     ticknmea=svr->tick-1000;
     
+    /* start output stream threads */
+    if ((nout=startoutthreads(svr))<svr->nstr-1) {
+        tracet(1,"strsvrthread: output thread start error\n");
+        svr->state=0;
+    }
     while (svr->state) {
         tick=tickget();
         
         /* read data from input stream */
         n=strread(svr->stream,svr->buff,svr->buffsize);
         
-        /* write data to output streams */
-        for (i=1;i<svr->nstr;i++) {
-            if (svr->conv[i-1]) {
-                strconv(svr->stream+i,svr->conv[i-1],svr->buff,n);
-            }
-            else {
-                strwrite(svr->stream+i,svr->buff,n);
-            }
+        /* put data to output queues */
+        for (i=1;i<svr->nstr&&n>0;i++) {
+            putqueue(svr,svr->q+i,svr->buff,n);
         }
         /* write nmea messages to input stream */
         if (svr->nmeacycle>0&&(int)(tick-ticknmea)>=svr->nmeacycle) {
@@ -390,13 +563,18 @@ static void *strsvrthread(void *arg)
             ticknmea=tick;
         }
         lock(&svr->lock);
-        for (i=0;i<n&&svr->npb<svr->buffsize;i++) {
-            svr->pbuf[svr->npb++]=svr->buff[i];
+        m=svr->buffsize-svr->npb<n?svr->buffsize-svr->npb:n;
+        if (m>0) {
+            memcpy(svr->pbuf+svr->npb,svr->buff,m);
+            svr->npb+=m;
         }
         unlock(&svr->lock);
         
         sleepms(svr->cycle-(int)(tickget()-tick));
     }
+    svr->state=0;
+    stopoutthreads(svr,nout);
+    
     for (i=0;i<svr->nstr;i++) strclose(svr->stream+i);
     svr->npb=0;
     free(svr->buff); svr->buff=NULL;
@@ -426,10 +604,44 @@ extern void strsvrinit(strsvr_t *svr, int nout)
     svr->tick=0;
     for (i=0;i<nout+1&&i<16;i++) strinit(svr->stream+i);
     svr->nstr=i;
-    for (i=0;i<16;i++) svr->conv[i]=NULL;
+    for (i=0;i<16;i++) {
+        svr->conv[i]=NULL;
+        svr->q[i].policy=STRQ_BLOCK;
+        svr->q[i].size=0;
+        svr->q[i].rp=svr->q[i].nq=0;
+        svr->q[i].buff=NULL;
+        svr->q[i].ndrop=svr->q[i].lag=svr->q[i].tick=0;
+        svr->q[i].svr=svr;
+        svr->q[i].idx=i;
+        initlock(&svr->q[i].lock);
+        initcond(&svr->q[i].cond);
+    }
     svr->thread=0;
     initlock(&svr->lock);
 }
+/* set output queue options ----------------------------------------------------
+* set output queue policy and size of stream server (call before strsvrstart())
+* args   : strsvr_t *svr    IO  stream sever struct
+*          int    idx       I   output stream index (1:output 1,2:output 2,...)
+*          int    policy    I   queue policy if the queue is full
+*                                 STRQ_BLOCK  : wait to be output (block input)
+*                                 STRQ_DROPOLD: drop oldest data in queue
+*                                 STRQ_DROPNEW: drop newest input data
+*          int    size      I   queue buffer size (bytes) (0:default)
+* return : none
+* notes  : each output stream is written by its own thread from the queue.
+*          a slow output with STRQ_BLOCK stalls the input and so the other
+*          outputs if the queue is full. the default is STRQ_BLOCK with the
+*          size of 16 x buffsize.
+*-----------------------------------------------------------------------------*/
+extern void strsvrsetq(strsvr_t *svr, int idx, int policy, int size)
+{
+    tracet(3,"strsvrsetq: idx=%d policy=%d size=%d\n",idx,policy,size);
+    
+    if (idx<1||idx>=16||svr->state) return;
+    svr->q[idx].policy=policy;
+    svr->q[idx].size=size<0?0:size;
+}
 /* start stream server ---------------------------------------------------------
 * start stream server
 * args   : strsvr_t *svr    IO  stream sever struct
@@ -528,6 +740,7 @@ extern void strsvrstop(strsvr_t *svr, const char *cmd)
     if (cmd) strsendcmd(svr->stream,cmd);
     
     svr->state=0;
+    wakequeues(svr);
     
 #ifdef WIN32
     WaitForSingleObject(svr->thread,10000);
@@ -542,22 +755,37 @@ extern void strsvrstop(strsvr_t *svr, const char *cmd)
 *          int    *stat     O   stream status
 *          int    *byte     O   bytes received/sent
 *          int    *bps      O   bitrate received/sent
+*          int    *lag      O   output lag: time since data pending in the
+*                               output queue was last serviced (ms) (NULL: no)
+*          int    *drop     O   bytes dropped by output queue (NULL: no)
 *          char   *msg      O   messages
 * return : none
+* notes  : lag[0] and drop[0] (input stream) are always 0
 *-----------------------------------------------------------------------------*/
-extern void strsvrstat(strsvr_t *svr, int *stat, int *byte, int *bps, char *msg)
+extern void strsvrstat(strsvr_t *svr, int *stat, int *byte, int *bps, int *lag,
+                       int *drop, char *msg)
 {
     char s[MAXSTRMSG]="",*p=msg;
+    unsigned int tick=tickget();
     int i;
     
     tracet(4,"strsvrstat:\n");
     
     for (i=0;i<svr->nstr;i++) {
+        if (lag ) lag [i]=0;
+        if (drop) drop[i]=0;
         if (i==0) {
             strsum(svr->stream,byte,bps,NULL,NULL);
             stat[i]=strstat(svr->stream,s);
         }
         else {
+            /* queue status before stream status locked by output */
+            lock(&svr->q[i].lock);
+            svr->q[i].lag=svr->q[i].nq>0?tick-svr->q[i].tick:0;
+            if (lag ) lag [i]=(int)svr->q[i].lag;
+            if (drop) drop[i]=(int)svr->q[i].ndrop;
+            unlock(&svr->q[i].lock);
+            
             strsum(svr->stream+i,NULL,NULL,byte+i,bps+i);
             stat[i]=strstat(svr->stream+i,s);
         }
@@ -14,9 +14,15 @@
 * history : 2012/11/01 1.0  new
 *           2013/01/25 1.1  fix bug on binary search
 *           2014/08/26 1.2  fix bug on tle_pos() to get tle by satid or desig
+*           2026/10/19 1.3  separate SGP4 initialization from propagation
+*                           added api:
+*                               tle_init(),tle_free(),tle_index(),tle_posn()
+*                           select newest satellite for the same names
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
+#define NTHREAD_TLE 8           /* max number of threads for tle_posn() */
+
 /* SGP4 model propagator by STR#3 (ref [1] sec.6,11) -------------------------*/
 
 #define DE2RA       0.174532925E-1
@@ -39,20 +45,24 @@
 #define QOMS2T      1.88027916E-9       /* = pow((QO-SO)*AE/XKMPER,4.0) */
 #define S           1.01222928          /* = AE*(1.0+SO/XKMPER) */
 
-static void SGP4_STR3(double tsince, const tled_t *data, double *rs)
+typedef struct {        /* SGP4 initialization terms type */
+    double xnodeo,omegao,xmo,eo,xincl,bstar,cosio,sinio,x3thm1,x1mth2,x7thm1;
+    double xnodp,aodp,eta,c1,c4,c5,xmdot,omgdot,xnodot,omgcof,xmcof,xnodcf;
+    double t2cof,xlcof,aycof,delmo,sinmo,d2,d3,d4,t3cof,t4cof,t5cof;
+    int isimp;
+} sgp4_t;
+
+/* SGP4 initialization by STR#3 ----------------------------------------------*/
+static void SGP4_init(const tled_t *data, sgp4_t *p)
 {
     double xnodeo,omegao,xmo,eo,xincl,xno,xndt2o,xndd6o,bstar;
     double a1,cosio,theta2,x3thm1,eosq,betao2,betao,del1,ao,delo,xnodp,aodp,s4;
     double qoms24,perige,pinvsq,tsi,eta,etasq,eeta,psisq,coef,coef1,c1,c2,c3,c4;
     double c5,sinio,a3ovk2,x1mth2,theta4,xmdot,x1m5th,omgdot,xhdot1,xnodot;
     double omgcof,xmcof,xnodcf,t2cof,xlcof,aycof,delmo,sinmo,x7thm1,c1sq,d2,d3;
-    double d4,t3cof,t4cof,t5cof,xmdf,omgadf,xnoddf,omega,xmp,tsq,xnode,delomg;
-    double delm,tcube,tfour,a,e,xl,beta,xn,axn,xll,aynl,xlt,ayn,capu,sinepw;
-    double cosepw,epw,ecose,esine,elsq,pl,r,rdot,rfdot,betal,cosu,sinu,u,sin2u;
-    double cos2u,rk,uk,xnodek,xinck,rdotk,rfdotk,sinuk,cosuk,sinik,cosik,sinnok;
-    double cosnok,xmx,xmy,ux,uy,uz,vx,vy,vz,x,y,z,xdot,ydot,zdot;
-    double temp,temp1,temp2,temp3,temp4,temp5,temp6,tempa,tempe,templ;
-    int i,isimp;
+    double d4,t3cof,t4cof,t5cof;
+    double temp,temp1,temp2,temp3;
+    int isimp;
     
     xnodeo=data->OMG*DE2RA;
     omegao=data->omg*DE2RA;
@@ -156,6 +166,34 @@ static void SGP4_STR3(double tsince, const tled_t *data, double *rs)
     else {
         d2=d3=d4=t3cof=t4cof=t5cof=0.0;
     }
+    p->xnodeo=xnodeo; p->omegao=omegao; p->xmo=xmo; p->eo=eo; p->xincl=xincl;
+    p->bstar=bstar; p->cosio=cosio; p->sinio=sinio; p->x3thm1=x3thm1;
+    p->x1mth2=x1mth2; p->x7thm1=x7thm1; p->xnodp=xnodp; p->aodp=aodp;
+    p->eta=eta; p->c1=c1; p->c4=c4; p->c5=c5; p->xmdot=xmdot; p->omgdot=omgdot;
+    p->xnodot=xnodot; p->omgcof=omgcof; p->xmcof=xmcof; p->xnodcf=xnodcf;
+    p->t2cof=t2cof; p->xlcof=xlcof; p->aycof=aycof; p->delmo=delmo;
+    p->sinmo=sinmo; p->d2=d2; p->d3=d3; p->d4=d4; p->t3cof=t3cof;
+    p->t4cof=t4cof; p->t5cof=t5cof; p->isimp=isimp;
+}
+/* SGP4 propagation by STR#3 with initialization terms -----------------------*/
+static void SGP4_prop(double tsince, const sgp4_t *p, double *rs)
+{
+    double xnodeo=p->xnodeo,omegao=p->omegao,xmo=p->xmo,eo=p->eo;
+    double xincl=p->xincl,bstar=p->bstar,cosio=p->cosio,sinio=p->sinio;
+    double x3thm1=p->x3thm1,x1mth2=p->x1mth2,x7thm1=p->x7thm1,xnodp=p->xnodp;
+    double aodp=p->aodp,eta=p->eta,c1=p->c1,c4=p->c4,c5=p->c5,xmdot=p->xmdot;
+    double omgdot=p->omgdot,xnodot=p->xnodot,omgcof=p->omgcof,xmcof=p->xmcof;
+    double xnodcf=p->xnodcf,t2cof=p->t2cof,xlcof=p->xlcof,aycof=p->aycof;
+    double delmo=p->delmo,sinmo=p->sinmo,d2=p->d2,d3=p->d3,d4=p->d4;
+    double t3cof=p->t3cof,t4cof=p->t4cof,t5cof=p->t5cof;
+    double xmdf,omgadf,xnoddf,omega,xmp,tsq,xnode,delomg;
+    double delm,tcube,tfour,a,e,xl,beta,xn,axn,xll,aynl,xlt,ayn,capu,sinepw;
+    double cosepw,epw,ecose,esine,elsq,pl,r,rdot,rfdot,betal,cosu,sinu,u,sin2u;
+    double cos2u,rk,uk,xnodek,xinck,rdotk,rfdotk,sinuk,cosuk,sinik,cosik,sinnok;
+    double cosnok,xmx,xmy,ux,uy,uz,vx,vy,vz,x,y,z,xdot,ydot,zdot;
+    double temp,temp1,temp2,temp3,temp4,temp5,temp6,tempa,tempe,templ;
+    int i,isimp=p->isimp;
+    
     /* update for secular gravity and atmospheric drag */
     xmdf=xmo+xmdot*tsince;
     omgadf=omegao+omgdot*tsince;
@@ -268,6 +306,14 @@ static void SGP4_STR3(double tsince, const tled_t *data, double *rs)
     rs[4]=ydot*XKMPER/AE*XMNPDA/86400.0*1E3;
     rs[5]=zdot*XKMPER/AE*XMNPDA/86400.0*1E3;
 }
+/* SGP4 initialization and propagation by STR#3 ------------------------------*/
+static void SGP4_STR3(double tsince, const tled_t *data, double *rs)
+{
+    sgp4_t p;
+    
+    SGP4_init(data,&p);
+    SGP4_prop(tsince,&p,rs);
+}
 /* drop spaces at string tail ------------------------------------------------*/
 static void chop(char *buff)
 {
@@ -368,11 +414,20 @@ static int add_data(tle_t *tle, const tled_t *data)
     tle->data[tle->n++]=*data;
     return 1;
 }
-/* compare TLE data by satellite name ----------------------------------------*/
+/* compare TLE data by satellite name ------------------------------------------
+* TLE data with the same name are sorted by descending catalog number and epoch
+* to select the newest satellite for the name deterministically
+*-----------------------------------------------------------------------------*/
 static int cmp_tle_data(const void *p1, const void *p2)
 {
     const tled_t *q1=(const tled_t *)p1,*q2=(const tled_t *)p2;
-    return strcmp(q1->name,q2->name);
+    double tt;
+    int stat;
+    
+    if ((stat=strcmp(q1->name,q2->name))) return stat;
+    if ((stat=strcmp(q2->satno,q1->satno))) return stat;
+    tt=timediff(q2->epoch,q1->epoch);
+    return tt<0.0?-1:(tt>0.0?1:0);
 }
 /* read TLE file ---------------------------------------------------------------
 * read NORAD TLE (two line element) data file (ref [2],[3])
@@ -383,6 +438,9 @@ static int cmp_tle_data(const void *p1, const void *p2)
 *          the file should be in a two line (only TLE) or three line (satellite
 *          name + TLE) format.
 *          the characters after # in a line are treated as comments.
+*          if TLE data have the same satellite name, the one with the largest
+*          catalog number (latest epoch for the same number) is selected by
+*          tle_pos() and tle_index().
 *-----------------------------------------------------------------------------*/
 extern int tle_read(const char *file, tle_t *tle)
 {
@@ -487,6 +545,42 @@ extern int tle_name_read(const char *file, tle_t *tle)
     if (tle->n>0) qsort(tle->data,tle->n,sizeof(tled_t),cmp_tle_data);
     return 1;
 }
+/* TEME to ECEF rotation matrices --------------------------------------------*/
+static gtime_t tle_rot(gtime_t time, const erp_t *erp, double *R3, double *W)
+{
+    gtime_t tutc;
+    double gmst,R1[9]={0},R2[9]={0},erpv[5]={0};
+    int i;
+    
+    tutc=gpst2utc(time);
+    
+    /* erp values */
+    if (erp) geterp(erp,time,erpv);
+    
+    /* GMST (rad) */
+    gmst=utc2gmst(tutc,erpv[2]);
+    
+    /* TEME (true equator, mean eqinox) -> ECEF (ref [2] IID, Appendix C) */
+    for (i=0;i<9;i++) R3[i]=0.0;
+    R1[0]=1.0; R1[4]=R1[8]=cos(-erpv[1]); R1[7]=sin(-erpv[1]); R1[5]=-R1[7];
+    R2[4]=1.0; R2[0]=R2[8]=cos(-erpv[0]); R2[2]=sin(-erpv[0]); R2[6]=-R2[2];
+    R3[8]=1.0; R3[0]=R3[4]=cos(gmst); R3[3]=sin(gmst); R3[1]=-R3[3];
+    matmul("NN",3,3,3,1.0,R1,R2,0.0,W);
+    return tutc;
+}
+/* TEME to ECEF position and velocity ----------------------------------------*/
+static void tle_ecef(const double *R3, const double *W, const double *rs_tle,
+                     double *rs)
+{
+    double rs_pef[6];
+    
+    matmul("NN",3,1,3,1.0,R3,rs_tle  ,0.0,rs_pef  );
+    matmul("NN",3,1,3,1.0,R3,rs_tle+3,0.0,rs_pef+3);
+    rs_pef[3]+=OMGE*rs_pef[1];
+    rs_pef[4]-=OMGE*rs_pef[0];
+    matmul("NN",3,1,3,1.0,W,rs_pef  ,0.0,rs  );
+    matmul("NN",3,1,3,1.0,W,rs_pef+3,0.0,rs+3);
+}
 /* satellite position and velocity with TLE data -------------------------------
 * compute satellite position and velocity in ECEF with TLE data
 * args   : gtime_t time     I   time (GPST)
@@ -505,17 +599,17 @@ extern int tle_pos(gtime_t time, const char *name, const char *satno,
                    double *rs)
 {
     gtime_t tutc;
-    double tsince,rs_tle[6],rs_pef[6],gmst;
-    double R1[9]={0},R2[9]={0},R3[9]={0},W[9],erpv[5]={0};
+    double tsince,rs_tle[6],R3[9],W[9];
     int i=0,j,k,stat=1;
     
-    /* binary search by satellite name */
+    /* binary search by satellite name (first one of the same names) */
     if (*name) {
         for (i=j=0,k=tle->n-1;j<=k;) {
             i=(j+k)/2;
             if (!(stat=strcmp(name,tle->data[i].name))) break;
             if (stat<0) k=i-1; else j=i+1;
         }
+        while (!stat&&i>0&&!strcmp(name,tle->data[i-1].name)) i--;
     }
     /* serial search by catalog no or international designator */
     if (stat&&(*satno||*desig)) {
@@ -529,7 +623,8 @@ extern int tle_pos(gtime_t time, const char *name, const char *satno,
         trace(3,"no tle data: name=%s satno=%s desig=%s\n",name,satno,desig);
         return 0;
     }
-    tutc=gpst2utc(time);
+    /* TEME to ECEF rotation */
+    tutc=tle_rot(time,erp,R3,W);
     
     /* time since epoch (min) */
     tsince=timediff(tutc,tle->data[i].epoch)/60.0;
@@ -537,22 +632,251 @@ extern int tle_pos(gtime_t time, const char *name, const char *satno,
     /* SGP4 model propagator by STR#3 */
     SGP4_STR3(tsince,tle->data+i,rs_tle);
     
-    /* erp values */
-    if (erp) geterp(erp,time,erpv);
+    tle_ecef(R3,W,rs_tle,rs);
+    return 1;
+}
+/* hash of string ------------------------------------------------------------*/
+static unsigned int tle_hash(const char *str)
+{
+    unsigned int h=5381;
     
-    /* GMST (rad) */
-    gmst=utc2gmst(tutc,erpv[2]);
+    for (;*str;str++) h=h*33+(unsigned char)*str;
+    return h;
+}
+/* key of TLE data (0:name,1:catalog number,2:designator) --------------------*/
+static const char *tle_key(const tled_t *data, int type)
+{
+    return type==0?data->name:(type==1?data->satno:data->desig);
+}
+/* add TLE data index to hash table ------------------------------------------*/
+static void tle_hadd(int *htab, int nh, const tle_t *tle, int i, int type)
+{
+    const char *key=tle_key(tle->data+i,type);
+    unsigned int j;
     
-    /* TEME (true equator, mean eqinox) -> ECEF (ref [2] IID, Appendix C) */
-    R1[0]=1.0; R1[4]=R1[8]=cos(-erpv[1]); R1[7]=sin(-erpv[1]); R1[5]=-R1[7];
-    R2[4]=1.0; R2[0]=R2[8]=cos(-erpv[0]); R2[2]=sin(-erpv[0]); R2[6]=-R2[2];
-    R3[8]=1.0; R3[0]=R3[4]=cos(gmst); R3[3]=sin(gmst); R3[1]=-R3[3];
-    matmul("NN",3,1,3,1.0,R3,rs_tle  ,0.0,rs_pef  );
-    matmul("NN",3,1,3,1.0,R3,rs_tle+3,0.0,rs_pef+3);
-    rs_pef[3]+=OMGE*rs_pef[1];
-    rs_pef[4]-=OMGE*rs_pef[0];
-    matmul("NN",3,3,3,1.0,R1,R2,0.0,W);
-    matmul("NN",3,1,3,1.0,W,rs_pef  ,0.0,rs  );
-    matmul("NN",3,1,3,1.0,W,rs_pef+3,0.0,rs+3);
+    for (j=tle_hash(key)&(nh-1);htab[j];j=(j+1)&(nh-1)) {
+        
+        /* keep first TLE data for the key */
+        if (!strcmp(tle_key(tle->data+htab[j]-1,type),key)) return;
+    }
+    htab[j]=i+1;
+}
+/* search TLE data index in hash table ---------------------------------------*/
+static int tle_hsearch(const int *htab, int nh, const tle_t *tle,
+                       const char *key, int type)
+{
+    unsigned int j;
+    
+    for (j=tle_hash(key)&(nh-1);htab[j];j=(j+1)&(nh-1)) {
+        if (!strcmp(tle_key(tle->data+htab[j]-1,type),key)) {
+            return htab[j]-1;
+        }
+    }
+    return -1;
+}
+/* initialize TLE propagator ---------------------------------------------------
+* initialize TLE propagator with TLE data
+* args   : tle_t  *tle      I   TLE data
+*          tlep_t *tlep     O   TLE propagator
+* return : status (1:ok,0:memory allocation error)
+* notes  : the propagator keeps SGP4 initialization terms of all TLE data and
+*          hash indices by satellite name, catalog number and international
+*          designator. it refers tle->data, so call the function again after
+*          tle_read() or tle_name_read() changes the TLE data.
+*          call tle_free() to free the propagator.
+*-----------------------------------------------------------------------------*/
+extern int tle_init(const tle_t *tle, tlep_t *tlep)
+{
+    sgp4_t *sgp4;
+    int i,nh;
+    
+    trace(3,"tle_init: n=%d\n",tle->n);
+    
+    tlep->tle=tle;
+    tlep->n=0;
+    tlep->sgp4=NULL;
+    tlep->nh=0;
+    tlep->hname=tlep->hsatno=tlep->hdesig=NULL;
+    
+    if (tle->n<=0) return 1;
+    
+    for (nh=64;nh<tle->n*2;nh*=2) ;
+    
+    if (!(sgp4=(sgp4_t *)malloc(sizeof(sgp4_t)*tle->n))||
+        !(tlep->hname =(int *)calloc(nh,sizeof(int)))||
+        !(tlep->hsatno=(int *)calloc(nh,sizeof(int)))||
+        !(tlep->hdesig=(int *)calloc(nh,sizeof(int)))) {
+        trace(1,"tle_init: malloc error n=%d\n",tle->n);
+        tlep->sgp4=sgp4;
+        tle_free(tlep);
+        return 0;
+    }
+    for (i=0;i<tle->n;i++) {
+        SGP4_init(tle->data+i,sgp4+i);
+        tle_hadd(tlep->hname ,nh,tle,i,0);
+        tle_hadd(tlep->hsatno,nh,tle,i,1);
+        tle_hadd(tlep->hdesig,nh,tle,i,2);
+    }
+    tlep->sgp4=sgp4;
+    tlep->n=tle->n;
+    tlep->nh=nh;
     return 1;
 }
+/* free TLE propagator ---------------------------------------------------------
+* free TLE propagator
+* args   : tlep_t *tlep     IO  TLE propagator
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void tle_free(tlep_t *tlep)
+{
+    free(tlep->sgp4  ); tlep->sgp4=NULL;
+    free(tlep->hname ); tlep->hname =NULL;
+    free(tlep->hsatno); tlep->hsatno=NULL;
+    free(tlep->hdesig); tlep->hdesig=NULL;
+    tlep->n=tlep->nh=0;
+}
+/* search TLE data -------------------------------------------------------------
+* search TLE data index by hash indices of TLE propagator
+* args   : char   *name     I   satellite name           ("": not specified)
+*          char   *satno    I   satellite catalog number ("": not specified)
+*          char   *desig    I   international designaor  ("": not specified)
+*          tlep_t *tlep     I   TLE propagator
+* return : TLE data index (-1: no data)
+* notes  : the search order is same as tle_pos(). if several TLE data have the
+*          same key, the first one in tle->data is selected.
+*-----------------------------------------------------------------------------*/
+extern int tle_index(const char *name, const char *satno, const char *desig,
+                     const tlep_t *tlep)
+{
+    int i=-1,j;
+    
+    if (tlep->nh<=0) return -1;
+    
+    if (*name) {
+        i=tle_hsearch(tlep->hname,tlep->nh,tlep->tle,name,0);
+    }
+    /* first data matching catalog number or international designator */
+    if (i<0&&(*satno||*desig)) {
+        i=tle_hsearch(tlep->hsatno,tlep->nh,tlep->tle,satno,1);
+        j=tle_hsearch(tlep->hdesig,tlep->nh,tlep->tle,desig,2);
+        if (i<0||(j>=0&&j<i)) i=j;
+    }
+    if (i<0) {
+        trace(3,"no tle data: name=%s satno=%s desig=%s\n",name,satno,desig);
+    }
+    return i;
+}
+/* propagate satellites for an epoch range -----------------------------------*/
+static int tle_posr(const gtime_t *time, int nt, const int *index, int ns,
+                    const tlep_t *tlep, const erp_t *erp, double *rs)
+{
+    const sgp4_t *sgp4=(const sgp4_t *)tlep->sgp4;
+    gtime_t tutc;
+    double rs_tle[6],R3[9],W[9],*r;
+    int i,j,k,n=0;
+    
+    for (i=0;i<nt;i++) {
+        tutc=tle_rot(time[i],erp,R3,W);
+        
+        for (j=0;j<ns;j++) {
+            r=rs+(i*ns+j)*6;
+            if (index[j]<0||index[j]>=tlep->n) {
+                for (k=0;k<6;k++) r[k]=0.0;
+                continue;
+            }
+            SGP4_prop(timediff(tutc,tlep->tle->data[index[j]].epoch)/60.0,
+                      sgp4+index[j],rs_tle);
+            tle_ecef(R3,W,rs_tle,r);
+            n++;
+        }
+    }
+    return n;
+}
+/* batch propagation thread --------------------------------------------------*/
+typedef struct {
+    const gtime_t *time;
+    int nt;
+    const int *index;
+    int ns;
+    const tlep_t *tlep;
+    const erp_t *erp;
+    double *rs;
+    int n;
+} tlepos_t;
+
+#ifdef WIN32
+static DWORD WINAPI tleposthread(void *arg)
+#else
+static void *tleposthread(void *arg)
+#endif
+{
+    tlepos_t *p=(tlepos_t *)arg;
+    
+    p->n=tle_posr(p->time,p->nt,p->index,p->ns,p->tlep,p->erp,p->rs);
+    return 0;
+}
+/* satellite positions and velocities with TLE propagator ----------------------
+* compute positions and velocities of satellites at epochs with TLE propagator
+* args   : gtime_t *time    I   times (GPST) (time[i]: epoch i)
+*          int    nt        I   number of epochs
+*          int    *index    I   TLE data indices by tle_index() (-1: skip)
+*          int    ns        I   number of satellites
+*          tlep_t *tlep     I   TLE propagator
+*          erp_t  *erp      I   EOP data (NULL: not used)
+*          int    nthread   I   number of threads (0,1: no thread)
+*          double *rs       O   sat positions/velocities {x,y,z,vx,vy,vz}
+*                               (m,m/s) (rs[(i*ns+j)*6]: epoch i, satellite j)
+* return : number of computed positions
+* notes  : same as tle_pos() for each epoch and satellite. the TEME to ECEF
+*          rotation is computed once per epoch and epochs are divided among
+*          threads. rs of skipped satellites are set to 0.
+*-----------------------------------------------------------------------------*/
+extern int tle_posn(const gtime_t *time, int nt, const int *index, int ns,
+                    const tlep_t *tlep, const erp_t *erp, int nthread,
+                    double *rs)
+{
+    thread_t thread[NTHREAD_TLE];
+    tlepos_t p[NTHREAD_TLE];
+    int i,n=0,m,stat[NTHREAD_TLE]={0};
+    
+    trace(3,"tle_posn: nt=%d ns=%d nthread=%d\n",nt,ns,nthread);
+    
+    if (nthread>NTHREAD_TLE) nthread=NTHREAD_TLE;
+    if (nthread>nt) nthread=nt;
+    if (nthread<=1) return tle_posr(time,nt,index,ns,tlep,erp,rs);
+    
+    for (i=0;i<nthread;i++) {
+        m=nt*i/nthread;
+        p[i].time=time+m;
+        p[i].nt=nt*(i+1)/nthread-m;
+        p[i].index=index;
+        p[i].ns=ns;
+        p[i].tlep=tlep;
+        p[i].erp=erp;
+        p[i].rs=rs+m*ns*6;
+        p[i].n=0;
+    }
+    for (i=1;i<nthread;i++) {
+#ifdef WIN32
+        stat[i]=(thread[i]=CreateThread(NULL,0,tleposthread,p+i,0,NULL))!=NULL;
+#else
+        stat[i]=!pthread_create(thread+i,NULL,tleposthread,p+i);
+#endif
+    }
+    tleposthread(p);
+    
+    for (i=1;i<nthread;i++) {
+        if (!stat[i]) {
+            tleposthread(p+i);
+            continue;
+        }
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    for (i=0;i<nthread;i++) n+=p[i].n;
+    return n;
+}
@@ -140,11 +140,48 @@ void utest4(void)
     
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* tropinit(), tropmapfn() */
+void utest5(void)
+{
+    double e1[]={2007,1,16,6,0,0};
+    double pos1[]={ 35*D2R, 140*D2R,   100.0};
+    double pos2[]={-80*D2R,-170*D2R,  1000.0};
+    double pos3[]={ 10*D2R,  30*D2R, 30000.0};
+    double azel[]={60*D2R,75*D2R, 190*D2R,3*D2R, 350*D2R,60*D2R, 0*D2R,90*D2R,
+                   10*D2R,-5*D2R};
+    double zazel[]={0.0,90*D2R},*pos[3],mapfh[5],mapfw[5],grad[10],mapfd,mapw;
+    gtime_t t1=epoch2time(e1);
+    tropc_t trop;
+    int i,j;
+    
+    pos[0]=pos1; pos[1]=pos2; pos[2]=pos3;
+    
+    for (i=0;i<3;i++) {
+        tropinit(t1,pos[i],&trop);
+            assert(trop.zhd==tropmodel(t1,pos[i],zazel,0.0));
+        
+        tropmapfn(&trop,azel,5,mapfh,mapfw,grad);
+        
+        for (j=0;j<5;j++) {
+            mapfd=tropmapf(t1,pos[i],azel+j*2,&mapw);
+                assert(mapfh[j]==mapfd);
+                assert(mapfw[j]==mapw);
+            if (azel[j*2+1]<=0.0) {
+                assert(grad[j*2]==0.0&&grad[j*2+1]==0.0);
+                continue;
+            }
+                assert(fabs(grad[j*2  ]-mapw/tan(azel[j*2+1])*cos(azel[j*2]))<1e-12);
+                assert(fabs(grad[j*2+1]-mapw/tan(azel[j*2+1])*sin(azel[j*2]))<1e-12);
+        }
+    }
+    printf("%s utest5 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
     return 0;
 }
@@ -2,6 +2,7 @@
 * rtklib unit test driver : coordinates functions
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include "../../src/rtklib.h"
@@ -85,10 +86,72 @@ void utest3(void)
 
     printf("%s utset3 : OK\n",__FILE__);
 }
+/* eci2ecef() cache by threads */
+#define NTHR 4
+static double U0[NTHR][2][9],gmst0[NTHR][2];
+static int nerr[NTHR];
+
+static gtime_t ecitime(int k, int j)
+{
+    double ep[]={2010,6,7,0,0,0};
+    return timeadd(epoch2time(ep),k*3600.0+j*30.0);
+}
+#ifdef WIN32
+static DWORD WINAPI ecithread(void *arg)
+#else
+static void *ecithread(void *arg)
+#endif
+{
+    double erpv[5]={0},U[9],gmst;
+    int i,j,k=*(int *)arg;
+    
+    for (i=0;i<2000;i++) {
+        j=i%2;
+        eci2ecef(ecitime(k,j),erpv,U,&gmst);
+        if (memcmp(U,U0[k][j],sizeof(U))||gmst!=gmst0[k][j]) nerr[k]++;
+    }
+    return 0;
+}
+void utest4(void)
+{
+    double erpv[5]={0},U[9],gmst;
+    int i,j,k[NTHR];
+#ifdef WIN32
+    HANDLE thread[NTHR];
+#else
+    pthread_t thread[NTHR];
+#endif
+    for (i=0;i<NTHR;i++) for (j=0;j<2;j++) {
+        eci2ecef(ecitime(i,j),erpv,U0[i][j],&gmst0[i][j]);
+    }
+    /* cached result within 0.01 s */
+    eci2ecef(timeadd(ecitime(NTHR-1,1),0.005),erpv,U,&gmst);
+        assert(!memcmp(U,U0[NTHR-1][1],sizeof(U))&&gmst==gmst0[NTHR-1][1]);
+    
+    for (i=0;i<NTHR;i++) {
+        k[i]=i;
+#ifdef WIN32
+        thread[i]=CreateThread(NULL,0,ecithread,k+i,0,NULL);
+#else
+        pthread_create(thread+i,NULL,ecithread,k+i);
+#endif
+    }
+    for (i=0;i<NTHR;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+        assert(nerr[i]==0);
+    }
+    printf("%s utset4 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
+    utest4();
     return 0;
 }
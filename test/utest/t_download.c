@@ -0,0 +1,228 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : downloader function
+*-----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 199309
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../../src/rtklib.h"
+
+extern int showmsg(char *format, ...) {return 0;}
+
+static char *stas[]={"sta1","sta2","sta3","sta4"};
+
+/* generate local mirror tree */
+static void genmirror(gtime_t ts, int n)
+{
+    FILE *fp;
+    char path[1024],cmd[2048];
+    int i,j;
+    
+    for (i=0;i<n;i++) {
+        reppath("dl_mirror/%Y/%n",path,timeadd(ts,86400.0*i),"","");
+        sprintf(cmd,"mkdir -p %s",path);
+        assert(!system(cmd));
+        
+        for (j=0;j<3;j++) {
+            if (i==1&&j==2) continue; /* missing file */
+            reppath("dl_mirror/%Y/%n/",path,timeadd(ts,86400.0*i),"","");
+            sprintf(path+strlen(path),"%s%%n0.%%yo",stas[j]);
+            reppath(path,path,timeadd(ts,86400.0*i),"","");
+            assert((fp=fopen(path,"w")));
+            fprintf(fp,"%s %d\n",stas[j],i);
+            fclose(fp);
+        }
+        reppath("dl_mirror/%Y/%n/brdc%n0.%yn",path,timeadd(ts,86400.0*i),"","");
+        assert((fp=fopen(path,"w")));
+        fprintf(fp,"brdc %d\n",i);
+        fclose(fp);
+        sprintf(cmd,"gzip -f %s",path);
+        assert(!system(cmd));
+    }
+}
+/* compare file contents */
+static int cmpfile(const char *file, const char *str)
+{
+    FILE *fp;
+    char buff[256]="";
+    
+    if (!(fp=fopen(file,"r"))) return 0;
+    if (!fgets(buff,sizeof(buff),fp)) *buff='\0';
+    fclose(fp);
+    return !strcmp(buff,str);
+}
+/* dl_exec() with local mirror */
+void utest1(void)
+{
+    double ep[]={2014,1,1,0,0,0};
+    gtime_t ts=epoch2time(ep),te=timeadd(ts,86400.0*2.0);
+    url_t urls[2]={
+        {"OBS" ,"file://dl_mirror/%Y/%n/%s%n0.%yo"   ,"dl_local/%Y/%n",0.0},
+        {"NAV" ,"file://dl_mirror/%Y/%n/brdc%n0.%yn.gz","dl_local/%Y/%n",0.0}
+    };
+    char msg[1024],path[1024],str[64];
+    int i,j;
+    
+    system("rm -rf dl_mirror dl_local dl_state.txt");
+    genmirror(ts,3);
+    
+    dl_setopt(4,2,1,"dl_state.txt");
+    
+    assert(dl_exec(ts,te,86400.0,0,0,urls,2,stas,3,"","","","",0,msg,stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=11 No_File=1 Skip=0 Error=0"));
+    
+    for (i=0;i<3;i++) {
+        for (j=0;j<3;j++) {
+            reppath("dl_local/%Y/%n/",path,timeadd(ts,86400.0*i),"","");
+            sprintf(path+strlen(path),"%s%%n0.%%yo",stas[j]);
+            reppath(path,path,timeadd(ts,86400.0*i),"","");
+            sprintf(str,"%s %d\n",stas[j],i);
+            assert(i==1&&j==2?!cmpfile(path,str):cmpfile(path,str));
+        }
+        reppath("dl_local/%Y/%n/brdc%n0.%yn",path,timeadd(ts,86400.0*i),"","");
+        sprintf(str,"brdc %d\n",i);
+        assert(cmpfile(path,str)); /* uncompressed */
+        strcat(path,".gz");
+        assert(!cmpfile(path,""));
+    }
+    /* resume by state file */
+    system("rm -rf dl_local");
+    assert(dl_exec(ts,te,86400.0,0,0,urls,2,stas,3,"","","","",0,msg,stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=0 No_File=1 Skip=11 Error=0"));
+    
+    /* force download ignoring state file */
+    assert(dl_exec(ts,te,86400.0,0,0,urls,2,stas,3,"","","","",DLOPT_FORCE,msg,
+                   stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=11 No_File=1 Skip=0 Error=0"));
+    
+    /* serial download without state file */
+    dl_setopt(1,0,0,"");
+    assert(dl_exec(ts,te,86400.0,0,0,urls,2,stas,3,"","","","",DLOPT_FORCE|
+                   DLOPT_KEEPCMP,msg,stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=11 No_File=1 Skip=0 Error=0"));
+    
+    system("rm -rf dl_mirror dl_local dl_state.txt");
+    
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* serve mirror files of fifo and count concurrent readers per host */
+static int nfifo[2];
+
+static void *fifothread(void *arg)
+{
+    char path[256];
+    int i,j,k,n,fd[2][4],served=0;
+    
+    for (i=0;i<2;i++) for (j=0;j<4;j++) fd[i][j]=-1;
+    
+    while (served<8) {
+        for (k=n=0;k<2;k++) {
+            for (i=0;i<2;i++) for (j=0;j<4;j++) {
+                if (fd[i][j]!=-1) continue;
+                sprintf(path,"dl_fifo%d/%s.txt",i+1,stas[j]);
+                fd[i][j]=open(path,O_WRONLY|O_NONBLOCK);
+            }
+            for (i=0;i<2;i++) {
+                for (j=n=0;j<4;j++) if (fd[i][j]>=0) n++;
+                if (n>nfifo[i]) nfifo[i]=n;
+            }
+            if (!k) sleepms(200); /* wait for other downloads */
+        }
+        for (i=n=0;i<2;i++) for (j=0;j<4;j++) {
+            if (fd[i][j]<0) continue;
+            assert(write(fd[i][j],"fifo\n",5)==5);
+            close(fd[i][j]);
+            fd[i][j]=-2; /* served */
+            served++; n++;
+        }
+        if (!n) sleepms(1);
+    }
+    return NULL;
+}
+/* dl_exec() with per-host limit of concurrent downloads */
+void utest2(void)
+{
+    double ep[]={2014,1,1,0,0,0};
+    gtime_t ts=epoch2time(ep);
+    url_t urls[2]={
+        {"OBS1","file://dl_fifo1/%s.txt","dl_local",0.0},
+        {"OBS2","file://dl_fifo2/%s.txt","dl_local",0.0}
+    };
+    pthread_t thread;
+    char msg[1024];
+    int i,nhost;
+    
+    for (i=0;i<2;i++) {
+        nhost=i==0?2:0;
+        system("rm -rf dl_fifo1 dl_fifo2 dl_local");
+        system("mkdir -p dl_fifo1 dl_fifo2");
+        system("cd dl_fifo1 && mkfifo sta1.txt sta2.txt sta3.txt sta4.txt");
+        system("cd dl_fifo2 && mkfifo sta1.txt sta2.txt sta3.txt sta4.txt");
+        nfifo[0]=nfifo[1]=0;
+        assert(!pthread_create(&thread,NULL,fifothread,NULL));
+        
+        dl_setopt(4,nhost,0,"");
+        assert(dl_exec(ts,ts,86400.0,0,0,urls,2,stas,4,"","","","",
+                       DLOPT_FORCE,msg,stdout));
+        pthread_join(thread,NULL);
+        printf("%s nhost=%d concurrent=%d,%d\n",msg,nhost,nfifo[0],nfifo[1]);
+        assert(strstr(msg,"OK=8 No_File=0 Skip=0 Error=0"));
+        
+        if (nhost>0) assert(nfifo[0]==nhost&&nfifo[1]==nhost);
+        else assert(nfifo[0]>2||nfifo[1]>2);
+    }
+    system("rm -rf dl_fifo1 dl_fifo2 dl_local");
+    
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* dl_exec() with retry on download error */
+void utest3(void)
+{
+    double ep[]={2014,1,1,0,0,0};
+    gtime_t ts=epoch2time(ep);
+    url_t urls[1]={
+        {"OBS" ,"file://dl_mirror/%Y/%n/%s%n0.%yo","dl_local/%Y/%n",0.0}
+    };
+    char msg[1024];
+    unsigned int tick;
+    
+    system("rm -rf dl_mirror dl_local");
+    genmirror(ts,1);
+    
+    /* error by directory at local path without retry */
+    system("mkdir -p dl_local/2014/001/sta10010.14o");
+    dl_setopt(1,0,0,"");
+    assert(dl_exec(ts,ts,86400.0,0,0,urls,1,stas,1,"","","","",DLOPT_FORCE,msg,
+                   stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=0 No_File=0 Skip=0 Error=1"));
+    
+    /* ok by retry after backoff */
+    system("mkdir -p dl_local/2014/001/sta10010.14o");
+    dl_setopt(1,0,1,"");
+    tick=tickget();
+    assert(dl_exec(ts,ts,86400.0,0,0,urls,1,stas,1,"","","","",DLOPT_FORCE,msg,
+                   stdout));
+    printf("%s\n",msg);
+    assert(strstr(msg,"OK=1 No_File=0 Skip=0 Error=0"));
+    assert((int)(tickget()-tick)>=2000); /* backoff (ms) */
+    assert(cmpfile("dl_local/2014/001/sta10010.14o","sta1 0\n"));
+    
+    system("rm -rf dl_mirror dl_local");
+    
+    printf("%s utest3 : OK\n",__FILE__);
+}
+int main(int argc, char **argv)
+{
+    utest1();
+    utest2();
+    utest3();
+    return 0;
+}
@@ -49,9 +49,10 @@ void utest2(void)
     sat=satno(SYS_GLO,13);
     
     readsp3(file1,&nav,0);
-        assert(nav.ne<=0);
+        assert(nav.pephs.n<=0);
     readsp3(file2,&nav,0);
-        assert(nav.ne>0);
+        assert(nav.pephs.n>0);
+    psat2peph(&nav.pephs,&nav);
     
     for (i=0;i<nav.ne;i++) {
         tow=time2gpst(nav.peph[i].time,&week);
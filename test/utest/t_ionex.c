@@ -223,11 +223,45 @@ void utest4(void)
     
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* iontecs() */
+void utest5(void)
+{
+    char *file3="../data/sp3/igrg33*0.10i";
+    nav_t nav={0};
+    gtime_t time1;
+    double ep1[]={2010,12, 3,23,30, 0};
+    double pos[3]={35*D2R,139*D2R,0},azel[16],delay[8],var[8],delay1,var1;
+    int i,j,n,opt,stat[8],stat1;
+    
+    time1=epoch2time(ep1);
+    readtec(file3,&nav,0);
+    
+    for (i=0;i<8;i++) {
+        azel[i*2  ]=i*45.0*D2R;
+        azel[i*2+1]=(i*12.0-5.0)*D2R;
+    }
+    for (opt=0;opt<4;opt++) for (i=0;i<=86400*3;i+=1800) {
+        n=iontecs(timeadd(time1,i),&nav,pos,azel,8,opt,delay,var,stat);
+        for (j=0;j<8;j++) {
+            stat1=iontec(timeadd(time1,i),&nav,pos,azel+j*2,opt,&delay1,&var1);
+                assert(stat[j]==stat1);
+            if (!stat1) continue;
+                assert(delay[j]==delay1&&var[j]==var1);
+            n--;
+        }
+            assert(n==0);
+    }
+    freenav(&nav,0x40);
+        assert(nav.nt==0&&nav.tec==NULL);
+    
+    printf("%s utest5 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
     return 0;
 }
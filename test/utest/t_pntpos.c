@@ -0,0 +1,212 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : single point positioning functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/rtklib.h"
+
+#define SQR(x)      ((x)*(x))
+
+extern int showmsg(char *format, ...) {return 0;}
+extern void settspan(gtime_t ts, gtime_t te) {}
+extern void settime(gtime_t time) {}
+
+static char *file="../data/rinex/brdc1820.10n";
+static const double rr0[]={-3957198.431,3310198.621,3737713.474}; /* TSKB */
+
+/* broadcast group delay ----------------------------------------------------*/
+static double tgd(const nav_t *nav, int sat)
+{
+    int i;
+    
+    for (i=0;i<nav->n;i++) {
+        if (nav->eph[i].sat==sat) return nav->eph[i].tgd[0];
+    }
+    return 0.0;
+}
+/* simulate pseudoranges of gps satellites ----------------------------------*/
+static int simobs(gtime_t time, const nav_t *nav, double elmin, obsd_t *obs)
+{
+    obsd_t data={{0}};
+    double rs[6],dts[2],var,pos[3],e[3],azel[2],r;
+    int i,j,n,svh;
+    
+    ecef2pos(rr0,pos);
+    
+    for (i=n=0;i<MAXSAT&&n<MAXOBS;i++) {
+        if (satsys(i+1,NULL)!=SYS_GPS) continue;
+        data.time=time;
+        data.sat=i+1;
+        data.rcv=1;
+        data.code[0]=CODE_L1C;
+        data.P[0]=2E7;
+        for (j=0;j<2;j++) { /* signal transmission time */
+            satposs(time,&data,1,nav,EPHOPT_BRDC,rs,dts,&var,&svh);
+            if (norm(rs,3)<=0.0||svh) break;
+            r=geodist(rs,rr0,e);
+            if (satazel(pos,e,azel)<elmin) break;
+            data.P[0]=r-CLIGHT*dts[0]+ionmodel(time,nav->ion_gps,pos,azel)+
+                      tropmodel(time,pos,azel,0.7)+CLIGHT*tgd(nav,i+1);
+        }
+        if (j<2) continue;
+        obs[n++]=data;
+    }
+    return n;
+}
+/* pntpos() */
+void utest1(void)
+{
+    static nav_t nav={0};
+    obsd_t obs[MAXOBS];
+    prcopt_t opt=prcopt_default;
+    sol_t sol={{0}};
+    double ep[]={2010,7,1,0,0,0},err;
+    char msg[128];
+    int i,n,stat;
+    
+    stat=readrnx(file,1,"",NULL,&nav,NULL);
+        assert(stat==1);
+    uniqnav(&nav);
+    opt.ionoopt=IONOOPT_BRDC;
+    opt.tropopt=TROPOPT_SAAS;
+    
+    for (i=0;i<86400;i+=900) {
+        n=simobs(timeadd(epoch2time(ep),i),&nav,15.0*D2R,obs);
+        stat=pntpos(obs,n,&nav,&opt,&sol,NULL,NULL,msg);
+        if (n<5) {
+            assert(!stat);
+            continue;
+        }
+        err=sqrt(SQR(sol.rr[0]-rr0[0])+SQR(sol.rr[1]-rr0[1])+
+                 SQR(sol.rr[2]-rr0[2]));
+        assert(stat&&sol.ns==n);
+        assert(err<1.0);
+    }
+    freenav(&nav,0xFF);
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* pntpos() raim fde with injected faults */
+void utest2(void)
+{
+    static nav_t nav={0};
+    obsd_t obs[MAXOBS];
+    prcopt_t opt=prcopt_default;
+    sol_t sol={{0}},sol0={{0}};
+    double ep[]={2010,7,1,0,0,0},err,errmax;
+    char msg[128];
+    int i,j,k,n,nf,stat,nacc,nexc;
+    
+    stat=readrnx(file,1,"",NULL,&nav,NULL);
+        assert(stat==1);
+    uniqnav(&nav);
+    opt.ionoopt=IONOOPT_BRDC;
+    opt.tropopt=TROPOPT_SAAS;
+    opt.elmin=5.0*D2R;
+    opt.posopt[4]=1; /* raim fde */
+    
+    for (nf=1;nf<=3;nf++) {
+        nacc=nexc=0; errmax=0.0;
+        for (i=0;i<86400;i+=300) {
+            n=simobs(timeadd(epoch2time(ep),i),&nav,5.0*D2R,obs);
+            if (n<10) continue;
+            if (!pntpos(obs,n,&nav,&opt,&sol0,NULL,NULL,msg)) continue;
+            
+            /* inject pseudorange faults of 100-700 m */
+            for (j=0;j<nf;j++) {
+                k=i/300;
+                obs[(k*5+j*3)%n].P[0]+=100.0+(k%7)*50.0*(j+1);
+            }
+            if (!pntpos(obs,n,&nav,&opt,&sol,NULL,NULL,msg)) continue;
+            
+            err=sqrt(SQR(sol.rr[0]-sol0.rr[0])+SQR(sol.rr[1]-sol0.rr[1])+
+                     SQR(sol.rr[2]-sol0.rr[2]));
+            if (err>errmax) errmax=err;
+            if (sol.ns<n-1) nexc++;
+            nacc++;
+        }
+        printf("faults=%d accepted=%3d multi-excluded=%3d max error=%6.2f m\n",
+               nf,nacc,nexc,errmax);
+        assert(nacc>0&&(nf<2||nexc>0));
+        assert(errmax<10.0);
+    }
+    freenav(&nav,0xFF);
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* pntposb() */
+void utest3(void)
+{
+    static nav_t nav={0};
+    obs_t obs={0};
+    obsd_t data[MAXOBS];
+    prcopt_t opt=prcopt_default;
+    solopt_t sopt=solopt_default;
+    rtk_t rtk;
+    gtime_t t0={0};
+    FILE *fp[2];
+    double ep[]={2010,7,1,0,0,0},rb[3]={0};
+    char buff[2][1024];
+    int i,j,k,n,nout,nthr[]={1,4},stat;
+    
+    stat=readrnx(file,1,"",NULL,&nav,NULL);
+        assert(stat==1);
+    uniqnav(&nav);
+    opt.ionoopt=IONOOPT_BRDC;
+    opt.tropopt=TROPOPT_SAAS;
+    opt.posopt[4]=1; /* raim fde */
+    
+    /* simulated observation data of a day with noise and faults */
+    obs.data=(obsd_t *)malloc(sizeof(obsd_t)*2880*MAXOBS);
+        assert(obs.data);
+    for (i=0;i<2880;i++) {
+        n=simobs(timeadd(epoch2time(ep),i*30.0),&nav,15.0*D2R,data);
+        for (j=0;j<n;j++) {
+            data[j].P[0]+=sin(i*0.37+data[j].sat)*2.0;
+            if (i%17==0&&j==i%n) data[j].P[0]+=200.0;
+            obs.data[obs.n++]=data[j];
+        }
+    }
+    sortobs(&obs);
+        assert(obs.ne[0]==2880);
+    
+    /* reference solutions by rtkpos() epoch by epoch */
+    fp[0]=tmpfile();
+        assert(fp[0]);
+    rtkinit(&rtk,&opt);
+    for (i=n=0;i<obs.ne[0];i++) {
+        if (!rtkpos(&rtk,obs.data+obs.ep[0][i].i,obs.ep[0][i].n,&nav)) continue;
+        outsol(fp[0],&rtk.sol,rb,&sopt);
+        n++;
+    }
+    rtkfree(&rtk);
+        assert(n>2800);
+    
+    for (k=0;k<2;k++) {
+        fp[1]=tmpfile();
+            assert(fp[1]);
+        nout=pntposb(&obs,t0,t0,0.0,&nav,&opt,&sopt,nthr[k],fp[1]);
+            assert(nout==n);
+        rewind(fp[0]);
+        rewind(fp[1]);
+        for (i=0;fgets(buff[0],sizeof(buff[0]),fp[0]);i++) {
+            assert(fgets(buff[1],sizeof(buff[1]),fp[1]));
+            assert(!strcmp(buff[0],buff[1]));
+        }
+        assert(i==n&&!fgets(buff[1],sizeof(buff[1]),fp[1]));
+        fclose(fp[1]);
+        printf("nthread=%d nout=%d\n",nthr[k],nout);
+    }
+    fclose(fp[0]);
+    freeobs(&obs);
+    freenav(&nav,0xFF);
+    printf("%s utest3 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    utest3();
+    return 0;
+}
@@ -2,6 +2,7 @@
 * rtklib unit test driver : ppp functions
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include "../../src/rtklib.h"
@@ -71,10 +72,218 @@ void utest3(void)
     }
     printf("%s utset3 : OK\n",__FILE__);
 }
+/* tidedispc() */
+void utest4(void)
+{
+    double ep1[]={2010,6,7,0,0,0};
+    double rr[]={-3957198.431,3310198.621,3737713.474}; /* TSKB */
+    double rs[3],dr1[3],dr2[3],vel[]={0.0,30.0,1.0};
+    tidec_t tide={0};
+    gtime_t time;
+    int i,j,k;
+    
+    for (i=0;i<86400;i+=37) {
+        time=timeadd(epoch2time(ep1),i+0.5);
+        tidedisp(time,rr,1,NULL,NULL,dr1);
+        tidedispc(time,rr,1,NULL,NULL,&tide,dr2);
+        for (j=0;j<3;j++) {
+            assert(fabs(dr1[j]-dr2[j])<5E-5);
+        }
+    }
+    /* moving site (30 m/s: moved every epoch, 1 m/s: every 3 epochs) */
+    for (k=1;k<3;k++) {
+        memset(&tide,0,sizeof(tide));
+        for (i=0;i<86400;i+=37) {
+            time=timeadd(epoch2time(ep1),i+0.5);
+            for (j=0;j<3;j++) rs[j]=rr[j]+vel[k]*i*(j==1?1.0:0.0);
+            tidedisp(time,rs,1,NULL,NULL,dr1);
+            tidedispc(time,rs,1,NULL,NULL,&tide,dr2);
+            for (j=0;j<3;j++) {
+                if (k==1&&i>0) assert(dr1[j]==dr2[j]);
+                else assert(fabs(dr1[j]-dr2[j])<5E-5);
+            }
+        }
+    }
+    printf("%s utset4 : OK\n",__FILE__);
+}
+/* compare contents of files */
+static int cmpfile(FILE *fp1, FILE *fp2)
+{
+    char buff1[4096],buff2[4096];
+    int n=0;
+    
+    rewind(fp1);
+    rewind(fp2);
+    while (fgets(buff1,sizeof(buff1),fp1)) {
+        if (!fgets(buff2,sizeof(buff2),fp2)||strcmp(buff1,buff2)) return -1;
+        n++;
+    }
+    return fgets(buff2,sizeof(buff2),fp2)?-1:n;
+}
+/* pppnet() */
+void utest5(void)
+{
+    char *file[]={
+        "../data/rinex/07590920.05o","../data/rinex/30400920.05o",
+        "../data/rinex/07590920.05o","../data/rinex/07590920.05n",
+        "../data/rinex/30400920.05n"
+    };
+    static obs_t obs[3];
+    static nav_t nav={0};
+    static pppsta_t sta[3];
+    obsd_t data[MAXOBS];
+    prcopt_t opt=prcopt_default;
+    solopt_t sopt=solopt_default;
+    rtk_t rtk;
+    gtime_t t0={0};
+    FILE *fp[3],*fp_stat[3];
+    int i,j,k,n,nep,nsol[3];
+    
+    for (i=0;i<3;i++) {
+        readrnxt(file[i],1,t0,t0,0.0,"",obs+i,NULL,NULL);
+            assert(obs[i].n>0);
+        sortobs(obs+i);
+    }
+    for (i=3;i<5;i++) {
+        readrnxt(file[i],1,t0,t0,0.0,"",NULL,&nav,NULL);
+    }
+    uniqnav(&nav);
+        assert(nav.n>0);
+    opt.mode=PMODE_PPP_KINEMA;
+    opt.nf=2;
+    opt.ionoopt=IONOOPT_IFLC;
+    opt.tropopt=TROPOPT_EST;
+    opt.tidecorr=1;
+    opt.elmin=10.0*D2R;
+    
+    /* reference solutions by rtkpos() of each station */
+    for (i=0;i<3;i++) {
+        fp[i]=tmpfile(); fp_stat[i]=tmpfile();
+            assert(fp[i]&&fp_stat[i]);
+        rtkinit(&rtk,&opt);
+        for (j=nsol[i]=0;j<obs[i].n;j=k) {
+            for (k=j,n=0;k<obs[i].n;k++) {
+                if (timediff(obs[i].data[k].time,obs[i].data[j].time)>DTTOL) {
+                    break;
+                }
+                if (n<MAXOBS) data[n++]=obs[i].data[k];
+            }
+            if (!rtkpos(&rtk,data,n,&nav)) continue;
+            outsol(fp[i],&rtk.sol,rtk.rb,&sopt);
+            pppoutsolstat(&rtk,1,fp_stat[i]);
+            nsol[i]++;
+        }
+        rtkfree(&rtk);
+            assert(nsol[i]>100);
+    }
+    /* network ppp of stations by threads */
+    for (i=0;i<3;i++) {
+        memset(sta+i,0,sizeof(pppsta_t));
+        sta[i].obs=obs+i;
+        sta[i].opt=opt;
+        sta[i].fp=tmpfile();
+        sta[i].fp_stat=tmpfile();
+        sta[i].statlevel=1;
+            assert(sta[i].fp&&sta[i].fp_stat);
+    }
+    nep=pppnet(sta,3,t0,t0,0.0,&nav,&sopt,3);
+        assert(nep>=nsol[0]);
+    
+    for (i=0;i<3;i++) {
+        printf("station %d: nsol=%d %d\n",i,nsol[i],sta[i].nsol);
+        assert(sta[i].nsol==nsol[i]);
+        assert(cmpfile(fp[i],sta[i].fp)==nsol[i]);
+        assert(cmpfile(fp_stat[i],sta[i].fp_stat)>0);
+        fclose(fp[i]); fclose(fp_stat[i]);
+        fclose(sta[i].fp); fclose(sta[i].fp_stat);
+        freeobs(obs+i);
+    }
+    freenav(&nav,0xFF);
+    printf("%s utest5 : OK\n",__FILE__);
+}
+/* solutions of station by rtkpos() */
+static int pppsols(const obs_t *obs, const nav_t *nav, const prcopt_t *opt,
+                   sol_t *sol, int nmax)
+{
+    obsd_t data[MAXOBS];
+    rtk_t rtk;
+    int i,j,n,ns=0;
+    
+    rtkinit(&rtk,opt);
+    for (i=0;i<obs->n&&ns<nmax;i=j) {
+        for (j=i,n=0;j<obs->n;j++) {
+            if (timediff(obs->data[j].time,obs->data[i].time)>DTTOL) break;
+            if (n<MAXOBS) data[n++]=obs->data[j];
+        }
+        if (!rtkpos(&rtk,data,n,nav)) continue;
+        sol[ns++]=rtk.sol;
+    }
+    rtkfree(&rtk);
+    return ns;
+}
+/* pppos() with and without epoch correction cache */
+#define NSOLC   1000            /* max number of solutions */
+
+void utest6(void)
+{
+    char *file[]={
+        "../data/rinex/07590920.05o","../data/rinex/07590920.05n"
+    };
+    const int tropopt[]={TROPOPT_SAAS,TROPOPT_EST,TROPOPT_ESTG}; /* cached */
+    const int ionoopt[]={IONOOPT_BRDC,IONOOPT_IFLC};
+    static sol_t sol1[NSOLC],sol2[NSOLC];
+    static obs_t obs;
+    static nav_t nav={0};
+    prcopt_t opt=prcopt_default;
+    gtime_t t0={0};
+    double dr[3],drmax;
+    int i,j,k,m,ns1,ns2;
+    
+    readrnxt(file[0],1,t0,t0,0.0,"",&obs,NULL,NULL);
+        assert(obs.n>0);
+    sortobs(&obs);
+    readrnxt(file[1],1,t0,t0,0.0,"",NULL,&nav,NULL);
+    uniqnav(&nav);
+        assert(nav.n>0);
+    opt.mode=PMODE_PPP_STATIC;
+    opt.nf=2;
+    opt.tidecorr=1;
+    opt.elmin=10.0*D2R;
+    opt.niter=3;
+    
+    /* site terms of cache held while site moves less than 1 m in iterations */
+    for (i=0;i<3;i++) for (j=0;j<2;j++) {
+        opt.tropopt=tropopt[i];
+        opt.ionoopt=ionoopt[j];
+        
+        setpppcorrc(1.0);
+        ns1=pppsols(&obs,&nav,&opt,sol1,NSOLC);
+        setpppcorrc(0.0);
+        ns2=pppsols(&obs,&nav,&opt,sol2,NSOLC);
+            assert(ns1>100&&ns1==ns2);
+        
+        for (k=0,drmax=0.0;k<ns1;k++) {
+            assert(fabs(timediff(sol1[k].time,sol2[k].time))<1E-9);
+            assert(sol1[k].stat==sol2[k].stat&&sol1[k].ns==sol2[k].ns);
+            for (m=0;m<3;m++) dr[m]=sol1[k].rr[m]-sol2[k].rr[m];
+            if (norm(dr,3)>drmax) drmax=norm(dr,3);
+        }
+        printf("tropopt=%d ionoopt=%d drmax=%.2E\n",opt.tropopt,opt.ionoopt,
+               drmax);
+        assert(drmax<1E-5);
+    }
+    setpppcorrc(1.0);
+    freeobs(&obs);
+    freenav(&nav,0xFF);
+    printf("%s utest6 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
+    utest4();
+    utest5();
+    utest6();
     return 0;
 }
@@ -2,7 +2,11 @@
 * rtklib unit test driver : precise ephemeris function
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
+#include <pthread.h>
 #include "../../src/rtklib.h"
 
 static void dumpeph(peph_t *peph, int n)
@@ -42,16 +46,19 @@ void utest1(void)
     
     printf("file=%s\n",file1);
     readsp3(file1,&nav,0);
-        assert(nav.ne==0);
+        assert(nav.pephs.n==0);
     
     printf("file=%s\n",file2);
     readsp3(file2,&nav,0);
-        assert(nav.ne==96);
+        assert(nav.pephs.n==96&&nav.ne==0);
+    psat2peph(&nav.pephs,&nav);
     dumpeph(nav.peph,nav.ne);
+    free(nav.peph); nav.peph=NULL; nav.ne=nav.nemax=0;
     
     printf("file=%s\n",file3);
     readsp3(file3,&nav,0);
-        assert(nav.ne==192);
+        assert(nav.pephs.n==192&&nav.ne==0);
+    psat2peph(&nav.pephs,&nav);
     dumpeph(nav.peph,nav.ne);
     
     printf("%s utest1 : OK\n",__FILE__);
@@ -129,7 +136,7 @@ void utest4(void)
     time=epoch2time(ep);
     
     readsp3(file1,&nav,0);
-        assert(nav.ne>0);
+        assert(nav.pephs.n>0);
     readrnxc(file2,&nav);
         assert(nav.nc>0);
     stat=peph2pos(time,0,&nav,0,rs,dts,&var);
@@ -172,7 +179,7 @@ void utest5(void)
     time=epoch2time(ep);
     
     readsp3(file1,&nav,0);
-        assert(nav.ne>0);
+        assert(nav.pephs.n>0);
     readrnxc(file2,&nav);
         assert(nav.nc>0);
     stat=readpcv(file3,&pcvs);
@@ -198,6 +205,443 @@ void utest5(void)
     fclose(fp);
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* peph2pos() with and without interpolation cache */
+void utest6(void)
+{
+    char *file1="../data/sp3/igs1590*.sp3"; /* 2010/7/1 */
+    nav_t nav={0};
+    pephc_t *pephc;
+    int i,j,n=0,sat,stat1,stat2;
+    double ep[]={2010,7,1,0,0,0};
+    double rs1[6],dts1[2],rs2[6],dts2[2],var1,var2,dr=0.0,dv=0.0;
+    gtime_t t,time;
+    
+    time=epoch2time(ep);
+    
+    readsp3(file1,&nav,0);
+        assert(nav.pephs.n>0&&nav.pephc);
+    
+    for (sat=1;sat<=MAXSAT;sat++) {
+        for (i=0;i<86400*2;i+=97) {
+            t=timeadd(time,(double)i);
+            
+            /* cached (barycentric) and neville's interpolation */
+            stat1=peph2pos(t,sat,&nav,0,rs1,dts1,&var1);
+            pephc=nav.pephc; nav.pephc=NULL;
+            stat2=peph2pos(t,sat,&nav,0,rs2,dts2,&var2);
+            nav.pephc=pephc;
+                assert(stat1==stat2);
+            if (!stat1) continue;
+            for (j=0;j<3;j++) {
+                if (fabs(rs1[j  ]-rs2[j  ])>dr) dr=fabs(rs1[j  ]-rs2[j  ]);
+                if (fabs(rs1[j+3]-rs2[j+3])>dv) dv=fabs(rs1[j+3]-rs2[j+3]);
+            }
+            /* clock differs by relativistic correction with velocity */
+                assert(fabs(dts1[0]-dts2[0])<1E-12&&var1==var2);
+            n++;
+        }
+    }
+    printf("n=%d dr=%.3e dv=%.3e\n",n,dr,dv);
+        assert(n>0&&dr<1E-6&&dv<1E-3);
+    
+    freenav(&nav,0xFF);
+    printf("%s utest6 : OK\n",__FILE__);
+}
+/* append epoch-major precise ephemeris of file */
+static void appendpeph(nav_t *nav, const char *file, int index)
+{
+    nav_t nav1={0};
+    int i;
+    
+    readsp3(file,&nav1,0);
+    assert(psat2peph(&nav1.pephs,&nav1));
+    assert((nav->peph=(peph_t *)realloc(nav->peph,
+                                        sizeof(peph_t)*(nav->ne+nav1.ne))));
+    for (i=0;i<nav1.ne;i++) {
+        nav->peph[nav->ne]=nav1.peph[i];
+        nav->peph[nav->ne++].index=index;
+    }
+    nav->nemax=nav->ne;
+    freenav(&nav1,0xFF);
+}
+/* peph2pos() with precise ephemeris merged for each file */
+void utest7(void)
+{
+    char *file1="../data/sp3/igs15904.sp3";
+    char *file2="../data/sp3/igs1590*.sp3";
+    char *file3="../data/sp3/igs15905.sp3";
+    nav_t nav1={0},nav2={0};
+    int i,j,n=0,sat,stat1,stat2;
+    double ep[]={2010,7,1,0,0,0};
+    double rs1[6],dts1[2],rs2[6],dts2[2],var1,var2;
+    gtime_t t,time;
+    
+    time=epoch2time(ep);
+    
+    /* merged for each file with appended one */
+    readsp3(file1,&nav1,0);
+    readsp3(file2,&nav1,0);
+        assert(nav1.pephs.n==192&&nav1.ne==0&&!nav1.peph);
+    
+    /* converted at once from epoch-major precise ephemeris */
+    appendpeph(&nav2,file1,0);
+    appendpeph(&nav2,file1,1);
+    appendpeph(&nav2,file3,2);
+        assert(nav2.ne==288);
+    readsp3("../data/sp3/nofile.sp3",&nav2,0);
+        assert(nav2.pephs.n==192&&nav2.ne==0);
+    
+        assert(nav1.pephs.ns==nav2.pephs.ns);
+    for (i=0;i<nav1.pephs.n;i++) {
+        assert(timediff(nav1.pephs.time[i],nav2.pephs.time[i])==0.0);
+    }
+    for (i=0;i<nav1.pephs.n*nav1.pephs.ns*4;i++) {
+        assert(nav1.pephs.val[i]==nav2.pephs.val[i]);
+        assert(nav1.pephs.std[i]==nav2.pephs.std[i]);
+    }
+    for (sat=1;sat<=MAXSAT;sat++) {
+        for (i=0;i<86400*2;i+=97) {
+            t=timeadd(time,(double)i);
+            stat1=peph2pos(t,sat,&nav1,0,rs1,dts1,&var1);
+            stat2=peph2pos(t,sat,&nav2,0,rs2,dts2,&var2);
+                assert(stat1==stat2);
+            if (!stat1) continue;
+            for (j=0;j<6;j++) assert(rs1[j]==rs2[j]);
+                assert(dts1[0]==dts2[0]&&var1==var2);
+            n++;
+        }
+    }
+    printf("n=%d\n",n);
+        assert(n>0);
+    
+    freenav(&nav1,0xFF);
+    freenav(&nav2,0xFF);
+    printf("%s utest7 : OK\n",__FILE__);
+}
+/* write rinex clock file of epochs (30 s) */
+static void writeclk(const char *file, int e1, int e2, double bias)
+{
+    FILE *fp,*fq;
+    double ep0[]={2010,7,1,0,0,0},ep[6];
+    char buff[1024],id[8];
+    int i,j;
+    
+    assert((fp=fopen("../data/sp3/igs15904.clk","r"))&&(fq=fopen(file,"w")));
+    while (fgets(buff,sizeof(buff),fp)) {
+        fputs(buff,fq);
+        if (strstr(buff,"END OF HEADER")) break;
+    }
+    fclose(fp);
+    for (i=e1;i<e2;i++) {
+        time2epoch(timeadd(epoch2time(ep0),i*30.0),ep);
+        for (j=1;j<=32;j++) {
+            if ((i/100+j)%17==0) continue; /* outage */
+            satno2id(j,id);
+            fprintf(fq,"AS %-4s %04.0f %02.0f %02.0f %02.0f %02.0f %9.6f  2 "
+                    "%21.12E%21.12E\n",id,ep[0],ep[1],ep[2],ep[3],ep[4],ep[5],
+                    1E-4*sin(j+i*1E-3)+bias,1E-11*(1+j%5));
+        }
+    }
+    fclose(fq);
+}
+/* peph2pos() by threads with time-indexed precise clock */
+#define NTHR    4               /* number of threads */
+#define NEP     2880            /* number of epochs (30 s) */
+
+static nav_t navc;
+static double dtsc[NEP][MAXSAT];
+
+static void *pclkthread(void *arg)
+{
+    gtime_t t;
+    double ep[]={2010,7,1,0,0,0},rs[6],dts[2],var;
+    int i,k=*(int *)arg,sat;
+    
+    sleepms(100); /* wait for other threads started */
+    
+    /* chunks of 3 hr interleaved by threads */
+    for (i=0;i<NEP;i++) {
+        if ((i/360)%NTHR!=k) continue;
+        t=timeadd(epoch2time(ep),i*30.0);
+        for (sat=1;sat<=MAXSAT;sat++) {
+            if (!peph2pos(t,sat,&navc,0,rs,dts,&var)) continue;
+            dtsc[i][sat-1]=dts[0];
+        }
+    }
+    return NULL;
+}
+void utest8(void)
+{
+    char *file1="../data/sp3/igs1590*.sp3"; /* 2010/7/1 */
+    char *file2="t_preceph_clk*.clk";
+    nav_t nav={0};
+    pthread_t thread[NTHR];
+    int i,j,n=0,sat,stat1,stat2,k[NTHR];
+    double ep[]={2010,7,1,0,0,0};
+    double rs1[6],dts1[2],rs2[6],dts2[2],var1,var2;
+    gtime_t t,time;
+    
+    time=epoch2time(ep);
+    
+    /* clock files overlapped for 2 hr (later file precedes) */
+    writeclk("t_preceph_clk1.clk",0,1560,0.0);
+    writeclk("t_preceph_clk2.clk",1320,NEP,1E-9);
+    
+    readsp3(file1,&nav,0);
+    readsp3(file1,&navc,0);
+    readrnxc(file2,&nav);
+        assert(nav.pclks.n==NEP);
+        assert(readpclk(file2,&navc)==NEP);
+    
+    /* readrnxc() and readpclk() */
+    for (i=0;i<NEP;i++) {
+        t=timeadd(time,i*30.0);
+        for (sat=1;sat<=MAXSAT;sat++) {
+            stat1=peph2pos(t,sat,&nav ,0,rs1,dts1,&var1);
+            stat2=peph2pos(t,sat,&navc,0,rs2,dts2,&var2);
+                assert(stat1==stat2);
+            if (!stat1) continue;
+            for (j=0;j<6;j++) assert(rs1[j]==rs2[j]);
+                assert(dts1[0]==dts2[0]&&dts1[1]==dts2[1]&&var1==var2);
+            n++;
+        }
+    }
+        assert(n>0);
+    
+    /* readpclk() by threads with windows of threads */
+    for (i=0;i<NTHR;i++) {
+        k[i]=i;
+        assert(!pthread_create(thread+i,NULL,pclkthread,k+i));
+    }
+    for (i=0;i<NTHR;i++) pthread_join(thread[i],NULL);
+    
+    for (i=0;i<NEP;i++) {
+        t=timeadd(time,i*30.0);
+        for (sat=1;sat<=MAXSAT;sat++) {
+            if (!peph2pos(t,sat,&nav,0,rs1,dts1,&var1)) continue;
+                assert(dts1[0]==dtsc[i][sat-1]);
+        }
+    }
+    printf("n=%d nw=%d\n",n,navc.pclki->nw);
+        assert(navc.pclki->nw==NTHR+1);
+    
+    freenav(&nav ,0xFF);
+    freenav(&navc,0xFF);
+    remove("t_preceph_clk1.clk");
+    remove("t_preceph_clk2.clk");
+    printf("%s utest8 : OK\n",__FILE__);
+}
+/* write antex file with receiver antenna partially matching another one moved
+   ahead of the others (up: phase center offset up of L1 of moved one) */
+static void writeatx(const char *file, const char *up)
+{
+    FILE *fp,*fq;
+    char buff[1024],start[1024]="";
+    int i,blk=0;
+    
+    assert((fq=fopen(file,"w")));
+    for (i=0;i<2;i++) {
+        assert((fp=fopen("../../data/igs05.atx","r")));
+        while (fgets(buff,sizeof(buff),fp)) {
+            if (!i) fputs(buff,fq);
+            if (strstr(buff,"END OF HEADER")) break;
+        }
+        while (fgets(buff,sizeof(buff),fp)) {
+            if (i) {
+                fputs(buff,fq);
+                continue;
+            }
+            if (strstr(buff,"START OF ANTENNA")) strcpy(start,buff);
+            if (strstr(buff,"TYPE / SERIAL NO")&&
+                !strncmp(buff,"AOAD/M_TA_NGS ",14)) {
+                fputs(start,fq);
+                blk=1;
+            }
+            if (!blk) continue;
+            if (blk==1&&strstr(buff,"NORTH / EAST / UP")) {
+                memcpy(buff+25,up,5);
+                blk=2;
+            }
+            fputs(buff,fq);
+            if (strstr(buff,"END OF ANTENNA")) break;
+        }
+        fclose(fp);
+    }
+    fclose(fq);
+}
+/* compare antenna parameters */
+static void cmppcvs(const pcvs_t *pcvs1, const pcvs_t *pcvs2)
+{
+    const pcv_t *p,*q;
+    int i;
+    
+    assert(pcvs1->n==pcvs2->n);
+    for (i=0;i<pcvs1->n;i++) {
+        p=pcvs1->pcv+i;
+        q=pcvs2->pcv+i;
+        assert(p->sat==q->sat&&!strcmp(p->type,q->type)&&
+               !strcmp(p->code,q->code));
+        assert(timediff(p->ts,q->ts)==0.0&&timediff(p->te,q->te)==0.0);
+        assert(!memcmp(p->off,q->off,sizeof(p->off)));
+        assert(!memcmp(p->var,q->var,sizeof(p->var)));
+    }
+}
+/* antenna type and radome */
+static void typekey(const char *type, char *key)
+{
+    char ant[MAXANT]="",radome[MAXANT]="";
+    
+    sscanf(type,"%s %s",ant,radome);
+    sprintf(key,"%s %s",ant,radome);
+}
+/* readpcv() with binary antex cache and searchpcv() by index */
+void utest9(void)
+{
+    char *file="t_preceph_pcv.atx",*cache="./t_preceph_pcv.atx.bin";
+    char key1[MAXANT],key2[MAXANT];
+    double ep[]={2008,3,1,0,0,0},var=-1.0;
+    pcvs_t pcvs1={0},pcvs2={0},pcvs3={0},pcvsl;
+    pcv_t *pcv;
+    gtime_t time;
+    FILE *fp;
+    int i,j;
+    
+    writeatx(file,"91.24");
+    remove(cache);
+    
+    setpcvcache("");
+    assert(readpcv(file,&pcvs1));
+    assert(!(fp=fopen(cache,"rb")));
+    
+    /* cache built and read */
+    setpcvcache(".");
+    assert(readpcv(file,&pcvs2));
+    assert((fp=fopen(cache,"rb")));
+    fclose(fp);
+    cmppcvs(&pcvs1,&pcvs2);
+    freepcv(&pcvs2);
+    assert(readpcv(file,&pcvs2));
+    cmppcvs(&pcvs1,&pcvs2);
+    freepcv(&pcvs2);
+    
+    /* cache read without antex parsed (last pcv modified in cache) */
+    assert((fp=fopen(cache,"r+b")));
+    fseek(fp,-(long)sizeof(double),SEEK_END);
+    fwrite(&var,sizeof(double),1,fp);
+    fclose(fp);
+    assert(readpcv(file,&pcvs2));
+    assert(pcvs2.n==pcvs1.n&&pcvs2.pcv[pcvs2.n-1].var[NFREQ-1][18]==-1.0);
+    freepcv(&pcvs2);
+    
+    /* cache rebuilt by checksum of antex modified with same size */
+    writeatx(file,"91.34");
+    assert(readpcv(file,&pcvs2));
+    setpcvcache("");
+    assert(readpcv(file,&pcvs3));
+    cmppcvs(&pcvs3,&pcvs2);
+    assert(fabs(pcvs1.pcv[0].off[0][2]-0.09124)<1E-9);
+    assert(fabs(pcvs2.pcv[0].off[0][2]-0.09134)<1E-9);
+    assert(pcvs2.pcv[pcvs2.n-1].var[NFREQ-1][18]!=-1.0);
+    freepcv(&pcvs2);
+    freepcv(&pcvs3);
+    
+    /* linear search without index */
+    pcvsl=pcvs1;
+    pcvsl.index=NULL;
+    
+    time=epoch2time(ep);
+    for (i=0;i<MAXSAT;i++) {
+        assert(searchpcv(i+1,"",time,&pcvs1)==searchpcv(i+1,"",time,&pcvsl));
+    }
+    /* exact receiver match first even if partial match ahead */
+    assert((pcv=searchpcv(0,"AOAD/M_T NONE",time,&pcvsl)));
+    assert(!strncmp(pcv->type,"AOAD/M_TA_NGS ",14));
+    assert((pcv=searchpcv(0,"AOAD/M_T NONE",time,&pcvs1)));
+    assert(!strncmp(pcv->type,"AOAD/M_T ",9));
+    assert(searchpcv(0,"AOAD/M_T SCIS",time,&pcvs1)==
+           searchpcv(0,"AOAD/M_T SCIS",time,&pcvsl));
+    assert(!searchpcv(0,"XXXXXXXX NONE",time,&pcvs1));
+    
+    /* first receiver antenna of same type and radome */
+    for (i=0;i<pcvs1.n;i++) {
+        if (pcvs1.pcv[i].sat) continue;
+        typekey(pcvs1.pcv[i].type,key1);
+        for (j=0;j<i;j++) {
+            typekey(pcvs1.pcv[j].type,key2);
+            if (!pcvs1.pcv[j].sat&&!strcmp(key1,key2)) break;
+        }
+        assert(searchpcv(0,key1,time,&pcvs1)==pcvs1.pcv+j);
+    }
+    freepcv(&pcvs1);
+    remove(file);
+    remove(cache);
+    printf("%s utest9 : OK\n",__FILE__);
+}
+/* peph2pos() with precise ephemeris states of epoch */
+void utest10(void)
+{
+    char *file1="../data/sp3/igs1590*.sp3"; /* 2010/7/1 */
+    char *file2="t_preceph_clk*.clk";
+    static double rss[NEP/10][MAXSAT][6],dtss[NEP/10][MAXSAT][2];
+    static double vars[NEP/10][MAXSAT];
+    static satsts_t sats;
+    static nav_t nav={0};
+    nav_t navs;
+    double ep[]={2010,7,1,0,0,0},rs[6],dts[2],var;
+    gtime_t t,time;
+    int i,j,sat,n=0;
+    
+    time=epoch2time(ep);
+    writeclk("t_preceph_clk1.clk",0,1560,0.0);
+    writeclk("t_preceph_clk2.clk",1320,NEP,1E-9);
+    
+    readsp3(file1,&nav,0);
+        assert(readpclk(file2,&nav)==NEP);
+        assert(readsap("../../data/igs05.atx",time,&nav));
+    for (i=0;i<MAXSAT;i++) {
+        nav.lam[i][0]=CLIGHT/FREQ1;
+        nav.lam[i][1]=CLIGHT/FREQ2;
+    }
+    navs=nav;
+    navs.sats=&sats;
+    
+    /* stations at epochs every 5 min with shared window of epoch */
+    for (i=0;i<NEP/10;i++) {
+        t=timeadd(time,i*300.0);
+        pephstates(t,&nav,&sats);
+        t=timeadd(t,-0.075);
+        for (sat=1;sat<=MAXSAT;sat++) {
+            if (!peph2pos(t,sat,&navs,1,rss[i][sat-1],dtss[i][sat-1],
+                          &vars[i][sat-1])) {
+                dtss[i][sat-1][0]=-1.0;
+            }
+        }
+    }
+        assert(sats.clkid==nav.pclki->id&&nav.pclki->nw==0);
+    
+    /* same as peph2pos() with window of thread */
+    for (i=0;i<NEP/10;i++) {
+        t=timeadd(timeadd(time,i*300.0),-0.075);
+        for (sat=1;sat<=MAXSAT;sat++) {
+            if (!peph2pos(t,sat,&nav,1,rs,dts,&var)) {
+                assert(dtss[i][sat-1][0]==-1.0);
+                continue;
+            }
+            for (j=0;j<6;j++) assert(rs[j]==rss[i][sat-1][j]);
+                assert(dts[0]==dtss[i][sat-1][0]&&dts[1]==dtss[i][sat-1][1]);
+                assert(var==vars[i][sat-1]);
+            n++;
+        }
+    }
+    printf("n=%d nw=%d\n",n,nav.pclki->nw);
+        assert(n>0&&nav.pclki->nw==1);
+    
+    freepsat(&sats.clkw.win);
+    freenav(&nav,0xFF);
+    remove("t_preceph_clk1.clk");
+    remove("t_preceph_clk2.clk");
+    printf("%s utest10 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
@@ -205,5 +649,10 @@ int main(int argc, char **argv)
     utest3();
     utest4();
     utest5();
+    utest6();
+    utest7();
+    utest8();
+    utest9();
+    utest10();
     return 0;
 }
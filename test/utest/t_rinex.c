@@ -204,6 +204,112 @@ void utest6(void)
     }
     printf("%s utest6 : OK\n",__FILE__);
 }
+/* outrnxobsb(), outrnxnavb() fixed-width fields */
+void utest7(void)
+{
+    double ep[6]={2005,4,2,1,2,0.0},x,e;
+    char buff[1024],str[1024],*p;
+    rnxopt_t opt={{0}};
+    obsd_t obs={{0}};
+    eph_t eph={0};
+    FILE *fp;
+    int i;
+    
+    opt.rnxver=3.02; opt.navsys=SYS_GPS;
+    opt.nobs[0]=1; strcpy(opt.tobs[0][0],"L1C");
+    memset(opt.mask[0],'1',63);
+    obs.sat=1; obs.code[0]=CODE_L1C;
+    eph.sat=1; eph.A=1.0;
+    
+    for (i=0;i<4000;i++) {
+        x=(i%2?-1.0:1.0)*pow(10.0,i%23-12)*(1.0+i*0.618034);
+        if (i%7==0) x=floor(x*2000.0+0.5)/2000.0; /* near rounding tie */
+        ep[5]=fmod(i*0.1234567891,60.0);
+        obs.time=eph.toc=epoch2time(ep);
+        obs.L[0]=x; obs.LLI[0]=i%4;
+        eph.f0=x; eph.f1=-x*1E-3; eph.f2=i%5?x*1E5:0.0;
+        
+        fp=tmpfile();
+        assert(outrnxobsb(fp,&opt,&obs,1,0));
+        assert(outrnxnavb(fp,&opt,&eph));
+        rewind(fp);
+        
+        time2epoch(obs.time,ep);
+        assert(fgets(buff,sizeof(buff),fp));
+        sprintf(str,"> %04.0f %2.0f %2.0f %2.0f %2.0f%11.7f  %d%3d%21s\n",
+                ep[0],ep[1],ep[2],ep[3],ep[4],ep[5],0,1,"");
+        assert(!strcmp(buff,str));
+        assert(fgets(buff,sizeof(buff),fp));
+        p=str+sprintf(str,"G 1");
+        if (x==0.0||fabs(x)>=1E9) p+=sprintf(p,"%14s","");
+        else p+=sprintf(p,"%14.3f",x);
+        if (i%4) p+=sprintf(p,"%1.1d \n",i%4); else sprintf(p,"  \n");
+        assert(!strcmp(buff,str));
+        
+        assert(fgets(buff,sizeof(buff),fp));
+        p=str+sprintf(str,"%-3s %04.0f %2.0f %2.0f %2.0f %2.0f %2.0f","G 1",
+                      ep[0],ep[1],ep[2],ep[3],ep[4],ep[5]);
+        x=eph.f0;
+        e=fabs(x)<1E-99?0.0:floor(log10(fabs(x))+1.0);
+        p+=sprintf(p," %s.%012.0fE%+03.0f",x<0.0?"-":" ",fabs(x)/pow(10.0,e-12.0),e);
+        x=eph.f1;
+        e=fabs(x)<1E-99?0.0:floor(log10(fabs(x))+1.0);
+        p+=sprintf(p," %s.%012.0fE%+03.0f",x<0.0?"-":" ",fabs(x)/pow(10.0,e-12.0),e);
+        x=eph.f2;
+        e=fabs(x)<1E-99?0.0:floor(log10(fabs(x))+1.0);
+        p+=sprintf(p," %s.%012.0fE%+03.0f",x<0.0?"-":" ",fabs(x)/pow(10.0,e-12.0),e);
+        sprintf(p,"\n");
+        assert(!strcmp(buff,str));
+        fclose(fp);
+    }
+    printf("%s utest7 : OK\n",__FILE__);
+}
+/* sortobs(), obsepoch() */
+void utest8(void)
+{
+    char file1[]="../data/rinex/07590920.05o";
+    char file2[]="../data/rinex/30400920.05o";
+    obs_t obs={0};
+    gtime_t t;
+    int i,j,k,r,n,ne;
+    
+    assert(readrnx(file1,1,"",&obs,NULL,NULL)>0);
+    assert(readrnx(file2,2,"",&obs,NULL,NULL)>0);
+    ne=sortobs(&obs);
+    assert(ne>0&&obs.ne[0]>0&&obs.ne[1]>0);
+    
+    for (r=0;r<2;r++) {
+        for (i=n=0;i<obs.ne[r];i++) {
+            for (j=0;j<obs.ep[r][i].n;j++) {
+                k=obs.ep[r][i].i+j;
+                assert(obs.data[k].rcv==r+1);
+                assert(fabs(timediff(obs.data[k].time,obs.ep[r][i].time))<=DTTOL);
+            }
+            if (i>0) assert(timediff(obs.ep[r][i].time,obs.ep[r][i-1].time)>DTTOL);
+            n+=obs.ep[r][i].n;
+        }
+        for (i=0;i<obs.n;i++) if (obs.data[i].rcv==r+1) n--;
+        assert(n==0);
+        
+        for (i=0;i<obs.ne[r];i++) {
+            t=obs.ep[r][i].time;
+            assert(obsepoch(&obs,r+1,t,0)==i);
+            assert(obsepoch(&obs,r+1,timeadd(t, 1.0),-1)==i);
+            assert(obsepoch(&obs,r+1,timeadd(t,-1.0), 1)==i);
+            assert(obsepoch(&obs,r+1,timeadd(t, 1.0), 0)<0);
+        }
+        t=obs.ep[r][0].time;
+        assert(obsepoch(&obs,r+1,timeadd(t,-1.0),-1)<0);
+        t=obs.ep[r][obs.ne[r]-1].time;
+        assert(obsepoch(&obs,r+1,timeadd(t,1.0),1)<0);
+    }
+    assert(obsepoch(&obs,3,t,0)<0);
+    
+    freeobs(&obs);
+    assert(!obs.ep[0]&&!obs.ep[1]&&obs.ne[0]==0&&obs.ne[1]==0);
+    
+    printf("%s utest8 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
@@ -212,5 +318,7 @@ int main(int argc, char **argv)
     utest4();
     utest5();
     utest6();
+    utest7();
+    utest8();
     return 0;
 }
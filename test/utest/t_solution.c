@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : solution functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/rtklib.h"
+
+#define NSOL    1000            /* number of solutions */
+#define NSOLL   30000           /* number of solutions of large file */
+#define NSTAT   3000            /* number of epochs of large status file */
+
+static const double rr0[]={-3957198.431,3310198.621,3737713.474}; /* TSKB */
+
+/* solution of epoch */
+static void gensol(int i, sol_t *sol)
+{
+    int j;
+    
+    memset(sol,0,sizeof(sol_t));
+    sol->time=gpst2time(1800,3600.0+i*0.5);
+    for (j=0;j<3;j++) {
+        sol->rr[j  ]=rr0[j]+sin(i*0.01+j)*12.345678;
+        sol->rr[j+3]=cos(i*0.02+j)*0.1234;
+        sol->qr[j  ]=(float)(1E-4*(1+(i+j)%9));
+        sol->qr[j+3]=(float)(1E-5*((i+j)%5-2));
+    }
+    sol->dtr[0]=1E-7*(i%13);
+    sol->type=0;
+    sol->stat=(unsigned char)(1+i%6);
+    sol->ns=(unsigned char)(5+i%8);
+    sol->age=(float)((i%10)*0.5);
+    sol->ratio=(float)((i%7)*1.5);
+}
+/* write solutions to file */
+static int writesol(const char *file, const solopt_t *opt, int *pos)
+{
+    unsigned char buff[MAXSOLMSG+1];
+    sol_t sol;
+    FILE *fp;
+    int i,n,m;
+    
+    assert((fp=fopen(file,"wb")));
+    n=outsolheads(buff,opt);
+    fwrite(buff,1,n,fp);
+    for (i=0;i<NSOL;i++) {
+        if (pos) pos[i]=n;
+        gensol(i,&sol);
+        m=outsols(buff,&sol,rr0,opt);
+        fwrite(buff,1,m,fp);
+        n+=m;
+    }
+    fclose(fp);
+    return n;
+}
+/* binary solution format */
+void utest1(void)
+{
+    char *file1="t_solution_1.pos",*file2="t_solution_2.pos";
+    solopt_t opt=solopt_default;
+    solbuf_t sol1={0},sol2={0};
+    sol_t sol,*s1,*s2;
+    gtime_t t0={0};
+    FILE *fp;
+    int i,j,pos[NSOL];
+    
+    opt.posf=SOLF_XYZ;
+    writesol(file1,&opt,NULL);
+    opt.posf=SOLF_BIN;
+    writesol(file2,&opt,pos);
+    
+    assert(readsolt(&file1,1,t0,t0,0.0,0,&sol1));
+    assert(readsolt(&file2,1,t0,t0,0.0,0,&sol2));
+    assert(sol1.n==NSOL&&sol2.n==NSOL);
+    
+    for (i=0;i<NSOL;i++) {
+        gensol(i,&sol);
+        s1=sol1.data+i;
+        s2=sol2.data+i;
+        
+        /* binary: lossless except covariances in single precision */
+        assert(timediff(s2->time,sol.time)==0.0);
+        for (j=0;j<6;j++) assert(s2->rr[j]==sol.rr[j]&&s2->qr[j]==sol.qr[j]);
+        assert(s2->dtr[0]==sol.dtr[0]);
+        assert(s2->stat==sol.stat&&s2->ns==sol.ns&&s2->type==sol.type);
+        assert(s2->age==sol.age&&s2->ratio==sol.ratio);
+        
+        /* text: same solutions within output precision */
+        assert(fabs(timediff(s1->time,s2->time))<1E-3);
+        for (j=0;j<3;j++) {
+            assert(fabs(s1->rr[j]-s2->rr[j])<=5.1E-5);
+            assert(fabs(sqrt(fabs(s1->qr[j]))-sqrt(fabs(s2->qr[j])))<=5.1E-5);
+        }
+        assert(s1->stat==s2->stat&&s1->ns==s2->ns);
+        assert(s1->age==s2->age&&s1->ratio==s2->ratio);
+    }
+    freesolbuf(&sol2);
+    
+    /* corrupted record rejected by crc-16 */
+    assert((fp=fopen(file2,"r+b")));
+    fseek(fp,pos[100]+20,SEEK_SET);
+    i=fgetc(fp);
+    fseek(fp,pos[100]+20,SEEK_SET);
+    fputc(i^0x01,fp);
+    fclose(fp);
+    
+    assert(readsolt(&file2,1,t0,t0,0.0,0,&sol2));
+    assert(sol2.n==NSOL-1);
+    for (i=0;i<NSOL-1;i++) {
+        assert(timediff(sol2.data[i].time,sol1.data[i<100?i:i+1].time)==0.0);
+    }
+    freesolbuf(&sol1);
+    freesolbuf(&sol2);
+    remove(file1);
+    remove(file2);
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* write line longer than the chunk reader accepts (stdio reader is used) */
+static void writelong(FILE *fp)
+{
+    int i;
+    
+    for (i=0;i<MAXSOLMSG+10;i++) fputc('%',fp);
+    fputc('\n',fp);
+}
+/* write large solution file */
+static void writesoll(const char *file, int lng)
+{
+    unsigned char buff[MAXSOLMSG+1];
+    solopt_t opt=solopt_default;
+    sol_t sol;
+    FILE *fp;
+    int i;
+    
+    assert((fp=fopen(file,"wb")));
+    if (lng) writelong(fp);
+    fwrite(buff,1,outsolheads(buff,&opt),fp);
+    for (i=0;i<NSOLL;i++) {
+        gensol(i,&sol);
+        fwrite(buff,1,outsols(buff,&sol,rr0,&opt),fp);
+    }
+    fclose(fp);
+}
+/* write large solution status file */
+static void writestatl(const char *file, int lng)
+{
+    char id[32];
+    double tow;
+    int i,j,week;
+    FILE *fp;
+    
+    assert((fp=fopen(file,"wb")));
+    if (lng) writelong(fp);
+    for (i=0;i<NSTAT;i++) {
+        tow=time2gpst(gpst2time(1800,3600.0+i*30.0),&week);
+        fprintf(fp,"$POS,%d,%.3f,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",week,tow,
+                6,rr0[0],rr0[1],rr0[2],0.01,0.01,0.01);
+        fprintf(fp,"$CLK,%d,%.3f,%d,%d,%.3f,%.3f,%.3f,%.3f\n",week,tow,6,1,
+                12.345,0.0,0.0,0.0);
+        for (j=0;j<10+i%3;j++) {
+            satno2id(j*3+1,id);
+            fprintf(fp,"$SAT,%d,%.3f,%s,%d,%.1f,%.1f,%.4f,%.4f,%d,%.0f,%d,%d,%d,"
+                    "%d,%d,%d\n",week,tow,id,1+j%2,(i*7+j*31)%3600*0.1,
+                    (i+j*5)%900*0.1,sin(i+j)*1.2345,cos(i+j)*0.01234,1,
+                    40.0+j,j%2,0,i+j,j%3,i%5,j%4);
+        }
+    }
+    fclose(fp);
+}
+/* memory mapped chunk readers */
+void utest2(void)
+{
+    char *file1="t_solution_3.pos",*file2="t_solution_4.pos";
+    char path1[64],path2[64];
+    solbuf_t sol1={0},sol2={0};
+    solstatbuf_t stat1={0},stat2={0};
+    solstat_t *s1,*s2;
+    gtime_t t0={0};
+    int i,j;
+    
+    /* file1: chunk reader, file2: stdio reader */
+    writesoll(file1,0);
+    writesoll(file2,1);
+    sprintf(path1,"%s.stat",file1);
+    sprintf(path2,"%s.stat",file2);
+    writestatl(path1,0);
+    writestatl(path2,1);
+    
+    assert(readsolt(&file1,1,t0,t0,0.0,0,&sol1));
+    assert(readsolt(&file2,1,t0,t0,0.0,0,&sol2));
+    assert(sol1.n==NSOLL&&sol2.n==NSOLL);
+    for (i=0;i<NSOLL;i++) {
+        assert(timediff(sol1.data[i].time,sol2.data[i].time)==0.0);
+        for (j=0;j<6;j++) {
+            assert(sol1.data[i].rr[j]==sol2.data[i].rr[j]);
+            assert(sol1.data[i].qr[j]==sol2.data[i].qr[j]);
+        }
+        assert(sol1.data[i].stat==sol2.data[i].stat);
+        assert(sol1.data[i].ns==sol2.data[i].ns);
+        assert(sol1.data[i].age==sol2.data[i].age);
+        assert(sol1.data[i].ratio==sol2.data[i].ratio);
+    }
+    assert(readsolstatt(&file1,1,t0,t0,0.0,&stat1));
+    assert(readsolstatt(&file2,1,t0,t0,0.0,&stat2));
+    assert(stat1.n==stat2.n&&stat1.n==NSTAT*11);
+    for (i=0;i<stat1.n;i++) {
+        s1=stat1.data+i;
+        s2=stat2.data+i;
+        assert(timediff(s1->time,s2->time)==0.0);
+        assert(s1->sat==s2->sat&&s1->frq==s2->frq);
+        assert(s1->az==s2->az&&s1->el==s2->el);
+        assert(s1->resp==s2->resp&&s1->resc==s2->resc);
+        assert(s1->flag==s2->flag&&s1->snr==s2->snr);
+        assert(s1->lock==s2->lock&&s1->outc==s2->outc);
+        assert(s1->slipc==s2->slipc&&s1->rejc==s2->rejc);
+    }
+    printf("nsol=%d nstat=%d\n",sol1.n,stat1.n);
+    freesolbuf(&sol1);
+    freesolbuf(&sol2);
+    freesolstatbuf(&stat1);
+    freesolstatbuf(&stat2);
+    remove(file1); remove(path1);
+    remove(file2); remove(path2);
+    printf("%s utest2 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    return 0;
+}
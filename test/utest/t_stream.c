@@ -0,0 +1,211 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : stream functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../../src/rtklib.h"
+
+#define NBLK    10              /* number of data blocks */
+#define LBLK    10              /* length of data block (bytes) */
+#define NSVR    (1<<19)         /* length of stream server input (bytes) */
+#define NQUE    16384           /* size of stream server output queue (bytes) */
+
+/* write replay file with time tags (block k at tick k*1000) */
+static void writetagfile(const char *file)
+{
+    gtime_t time={0};
+    unsigned int tick;
+    size_t fpos;
+    char path[256],tagh[64]={0};
+    unsigned char buff[LBLK];
+    FILE *fp,*fp_tag;
+    int i,k;
+    
+    sprintf(path,"%s.tag",file);
+    assert((fp=fopen(file,"wb"))&&(fp_tag=fopen(path,"wb")));
+    
+    strcpy(tagh,"TIMETAG RTKLIB 2.4.2");
+    fwrite(tagh,1,sizeof(tagh),fp_tag);
+    fwrite(&time,1,sizeof(time),fp_tag);
+    for (k=0;k<NBLK;k++) {
+        for (i=0;i<LBLK;i++) buff[i]=(unsigned char)k;
+        fwrite(buff,1,LBLK,fp);
+        tick=(unsigned int)(k*1000);
+        fpos=(size_t)(LBLK*(k+1));
+        fwrite(&tick,1,sizeof(tick),fp_tag);
+        fwrite(&fpos,1,sizeof(fpos),fp_tag);
+    }
+    fclose(fp);
+    fclose(fp_tag);
+}
+/* remove replay file */
+static void removetagfile(const char *file)
+{
+    char path[256];
+    sprintf(path,"%s.tag",file);
+    remove(file);
+    remove(path);
+}
+/* read first byte of stream (-1: no data) */
+static int readfirst(stream_t *stream, int n)
+{
+    unsigned char buff[NBLK*LBLK];
+    return strread(stream,buff,n)>0?buff[0]:-1;
+}
+/* strseek() with slave stream synced by strsync() */
+static void testseek(const char *opt)
+{
+    stream_t s1,s2;
+    char path1[256],path2[256];
+    int i;
+    
+    sprintf(path1,"t_stream_1.bin%s",opt);
+    sprintf(path2,"t_stream_2.bin%s",opt);
+    strinit(&s1);
+    strinit(&s2);
+    assert(stropen(&s1,STR_FILE,STR_MODE_R,path1));
+    assert(stropen(&s2,STR_FILE,STR_MODE_R,path2));
+    strsync(&s1,&s2);
+    
+    for (i=0;i<5;i++) assert(readfirst(&s1,LBLK+1)==i);
+    assert(readfirst(&s2,NBLK*LBLK)==0);
+    
+    /* backward seek */
+    assert(strseek(&s1,1.0));
+    assert(readfirst(&s1,LBLK+1)==1);
+    assert(readfirst(&s2,NBLK*LBLK)==1);
+    
+    /* forward seek */
+    assert(strseek(&s1,8.0));
+    assert(readfirst(&s1,LBLK+1)==8);
+    assert(readfirst(&s2,NBLK*LBLK)==8);
+    
+    strclose(&s1);
+    strclose(&s2);
+}
+/* strseek() */
+void utest1(void)
+{
+    writetagfile("t_stream_1.bin");
+    writetagfile("t_stream_2.bin");
+    
+    testseek("::T");
+    testseek("::T::xmax");
+    
+    removetagfile("t_stream_1.bin");
+    removetagfile("t_stream_2.bin");
+    
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* read output of stream server from fifo (slow: 1024 bytes per 50 ms) */
+static unsigned char indata[NSVR],fifodata[NSVR];
+static int fifofd,nfifo,slow;
+
+static void *fifothread(void *arg)
+{
+    int n;
+    
+    fcntl(fifofd,F_SETFL,0); /* blocking read */
+    while (nfifo<NSVR) {
+        if ((n=read(fifofd,fifodata+nfifo,slow?1024:NSVR-nfifo))<=0) break;
+        nfifo+=n;
+        if (slow) sleepms(50);
+    }
+    return NULL;
+}
+/* stream server with a slow fifo output and a file output */
+static void testsvr(int policy)
+{
+    strsvr_t svr;
+    strconv_t *conv[]={NULL,NULL};
+    pthread_t thread;
+    char *paths[]={"t_stream_in.bin","t_stream_fifo","t_stream_out.bin"};
+    int strs[]={STR_FILE,STR_FILE,STR_FILE};
+    int opts[]={10000,10000,2000,4096,1,0,30};
+    int i,stat[3],byte[3],bps[3],lag[3],drop[3],lagmax=0;
+    char msg[MAXSTRMSG*4];
+    FILE *fp;
+    
+    remove(paths[1]);
+    assert(!mkfifo(paths[1],0600));
+    assert((fifofd=open(paths[1],O_RDONLY|O_NONBLOCK))>=0);
+    nfifo=0;
+    slow=1;
+    
+    strsvrinit(&svr,2);
+    strsvrsetq(&svr,1,policy,NQUE);
+    assert(strsvrstart(&svr,opts,strs,paths,conv,NULL,NULL));
+    assert(!pthread_create(&thread,NULL,fifothread,NULL));
+    
+    /* input with the slow output */
+    for (i=0;i<8;i++) {
+        sleepms(120);
+        strsvrstat(&svr,stat,byte,bps,lag,drop,msg);
+        if (lag[1]>lagmax) lagmax=lag[1];
+    }
+    printf("policy=%d in=%6d out=%6d lag=%4d drop=%6d\n",policy,byte[0],
+           byte[2],lagmax,drop[1]);
+    assert(lagmax>=100);
+    if (policy==STRQ_BLOCK) { /* slow output blocks input and other output */
+        assert(byte[0]<NSVR&&byte[2]<NSVR&&drop[1]==0);
+    }
+    else { /* slow output drops data without blocking */
+        assert(byte[0]==NSVR&&byte[2]==NSVR&&drop[1]>0);
+    }
+    /* read the rest of output */
+    slow=0;
+    for (i=0;i<500;i++) {
+        strsvrstat(&svr,stat,byte,bps,lag,drop,msg);
+        if (byte[0]>=NSVR&&byte[2]>=NSVR&&lag[1]==0) break;
+        sleepms(10);
+    }
+    strsvrstop(&svr,NULL);
+    pthread_join(thread,NULL);
+    close(fifofd);
+    
+    assert(byte[0]==NSVR&&byte[2]==NSVR);
+    assert(nfifo+drop[1]==NSVR);
+    if (policy==STRQ_BLOCK) {
+        assert(!memcmp(fifodata,indata,NSVR));
+    }
+    else if (policy==STRQ_DROPOLD) { /* newest data kept */
+        assert(!memcmp(fifodata+nfifo-NQUE,indata+NSVR-NQUE,NQUE));
+    }
+    else { /* oldest data kept */
+        assert(!memcmp(fifodata,indata,NQUE));
+    }
+    assert((fp=fopen(paths[2],"rb")));
+    assert(fread(fifodata,1,NSVR,fp)==NSVR);
+    assert(!memcmp(fifodata,indata,NSVR));
+    fclose(fp);
+    remove(paths[1]);
+    remove(paths[2]);
+}
+/* stream server output queues */
+void utest2(void)
+{
+    FILE *fp;
+    int i;
+    
+    for (i=0;i<NSVR;i++) indata[i]=(unsigned char)(i*7+i/251);
+    assert((fp=fopen("t_stream_in.bin","wb")));
+    fwrite(indata,1,NSVR,fp);
+    fclose(fp);
+    
+    testsvr(STRQ_BLOCK);
+    testsvr(STRQ_DROPOLD);
+    testsvr(STRQ_DROPNEW);
+    
+    remove("t_stream_in.bin");
+    printf("%s utest2 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    return 0;
+}
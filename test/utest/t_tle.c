@@ -138,11 +138,64 @@ static void utest3(void)
     }
     fprintf(OUT,"%s utest3 : OK\n",__FILE__);
 }
+/* tle_posn() ----------------------------------------------------------------*/
+static void utest4(void)
+{
+    const char *file1="../data/tle/TLE_GNSS_20121101.txt";
+    const char *file2="../data/tle/igs17127.erp";
+    const double ep[6]={2012,10,31,0,0,0};
+    erp_t erp={0};
+    tle_t tle={0};
+    tlep_t tlep;
+    gtime_t time[96];
+    double rs1[6],*rs2;
+    int i,j,k,n,stat,index[MAXSAT];
+    char sat[32];
+    
+    stat=readerp(file2,&erp);
+        assert(stat);
+    
+    stat=tle_read(file1,&tle);
+        assert(stat);
+    
+    stat=tle_init(&tle,&tlep);
+        assert(stat);
+    
+    for (i=0;i<MAXSAT;i++) {
+        satno2id(i+1,sat);
+        index[i]=tle_index(sat,"","",&tlep);
+    }
+    /* R17 labeled to both COSMOS 2419 (28915) and 2478 (37938) */
+    i=index[satno(SYS_GLO,17)-1];
+        assert(i>=0&&!strcmp(tle.data[i].satno,"37938"));
+    
+    for (i=0;i<96;i++) time[i]=timeadd(epoch2time(ep),900.0*i);
+    
+    rs2=mat(6,96*MAXSAT);
+    
+    for (k=1;k<=4;k+=3) {
+        n=tle_posn(time,96,index,MAXSAT,&tlep,&erp,k,rs2);
+            assert(n>0);
+        
+        for (i=0;i<96;i++) for (j=0;j<MAXSAT;j++) {
+            if (index[j]<0) continue;
+            satno2id(j+1,sat);
+            stat=tle_pos(time[i],sat,"","",&tle,&erp,rs1);
+                assert(stat);
+                assert(!memcmp(rs1,rs2+(i*MAXSAT+j)*6,sizeof(rs1)));
+        }
+    }
+    free(rs2);
+    tle_free(&tlep);
+    
+    fprintf(OUT,"%s utest4 : OK\n",__FILE__);
+}
 /* main ----------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
     utest1();
     utest2();
     utest3();
+    utest4();
     return 0;
 }
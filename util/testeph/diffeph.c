@@ -178,7 +178,7 @@ int main(int argc, char **argv)
         if (!(ext=strrchr(files[i],'.'))) ext="";
         if (!strcmp(ext,".sp3")||!strcmp(ext,".SP3")||
            !strcmp(ext,".eph")||!strcmp(ext,".EPH")) {
-           if (nav.ne>0) {
+           if (nav.pephs.n>0) {
                readsp3(files[i],&nav2); /* second precise ephemeris */
            }
            else {
@@ -0,0 +1,258 @@
+/*------------------------------------------------------------------------------
+* tracedec.c : binary debug trace decoder
+*
+*          Copyright (C) 2026 by T.TAKASU, All rights reserved.
+*
+* description : convert binary debug trace file (*.rtb) written by traceopen()
+*               to the text trace identical to the text trace file
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/19  1.0 new
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define PROGNAME    "tracedec"          /* program name */
+#define MAXARG      32                  /* max number of arguments in a format */
+#define MAXREC      65536               /* max length of record */
+
+#define TRACE_FMT   1                   /* record: format definition */
+#define TRACE_MSG   2                   /* record: trace() */
+#define TRACE_MSGT  3                   /* record: tracet() */
+#define TRACE_RAW   4                   /* record: without prefix */
+#define TRACE_MAT   5                   /* record: matrix row */
+#define TRACE_INL   0x80                /* record flag: inline format */
+
+static const char *help[]={
+    "",
+    " usage: tracedec [-o outfile] [-l level] file.rtb",
+    "",
+    " options:",
+    "  -o outfile   output text trace file [stdout]",
+    "  -l level     max trace level to output [all]",
+    ""
+};
+static char **fmts=NULL;                /* format strings by id */
+static int nfmt=0,nfmtmax=0;            /* number of formats */
+
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* add format definition -----------------------------------------------------*/
+static int addfmt(unsigned int id, const char *str)
+{
+    char **p;
+    int n;
+    
+    if ((int)id>=nfmtmax) {
+        n=nfmtmax<=0?1024:nfmtmax*2;
+        while (n<=(int)id) n*=2;
+        if (!(p=(char **)realloc(fmts,sizeof(char *)*n))) return 0;
+        memset(p+nfmtmax,0,sizeof(char *)*(n-nfmtmax));
+        fmts=p; nfmtmax=n;
+    }
+    free(fmts[id]);
+    if (!(fmts[id]=(char *)malloc(strlen(str)+1))) return 0;
+    strcpy(fmts[id],str);
+    if ((int)id>=nfmt) nfmt=id+1;
+    return 1;
+}
+/* output formatted arguments ------------------------------------------------*/
+static void outfmt(FILE *fp, const char *format, const unsigned char *p,
+                   const unsigned char *end, int size_int, int size_long,
+                   int size_ptr)
+{
+    const char *q,*s;
+    char spec[64];
+    int i,n,narg=0,nstar,star[2],ival,lmod,len;
+    long lval;
+    double dval;
+    void *pval;
+    
+    for (q=format;*q;q++) {
+        if (*q!='%') {fputc(*q,fp); continue;}
+        if (q[1]=='%') {fputc('%',fp); q++; continue;}
+        
+        /* parse conversion spec as fmtsig() in rtkcmn.c */
+        s=q++;
+        nstar=0;
+        while (*q&&strchr("-+ #0",*q)) q++;
+        if (*q=='*') {nstar++; q++;} else while (isdigit((int)*q)) q++;
+        if (*q=='.') {
+            q++;
+            if (*q=='*') {nstar++; q++;} else while (isdigit((int)*q)) q++;
+        }
+        lmod=*q=='h'||*q=='l'||*q=='L'?*q++:0;
+        if (!*q||!strchr("diouxXceEfgGspn",*q)||narg+nstar+1>MAXARG||
+            (len=(int)(q-s+1))>=(int)sizeof(spec)) {
+            fputs(s,fp);
+            return;
+        }
+        for (i=0;i<nstar;i++) {
+            if (p+size_int>end) {fputs(s,fp); return;}
+            memcpy(&star[i],p,sizeof(int)); p+=size_int;
+        }
+        narg+=nstar+1;
+        
+        /* strip long double modifier (stored as double) */
+        for (i=n=0;i<len;i++) if (s[i]!='L') spec[n++]=s[i];
+        spec[n]='\0';
+        
+        if (strchr("diouxXc",*q)) {
+            if (lmod=='l') {
+                if (p+size_long>end) {fputs(s,fp); return;}
+                memcpy(&lval,p,sizeof(long)); p+=size_long;
+                if      (nstar==0) fprintf(fp,spec,lval);
+                else if (nstar==1) fprintf(fp,spec,star[0],lval);
+                else               fprintf(fp,spec,star[0],star[1],lval);
+            }
+            else {
+                if (p+size_int>end) {fputs(s,fp); return;}
+                memcpy(&ival,p,sizeof(int)); p+=size_int;
+                if      (nstar==0) fprintf(fp,spec,ival);
+                else if (nstar==1) fprintf(fp,spec,star[0],ival);
+                else               fprintf(fp,spec,star[0],star[1],ival);
+            }
+        }
+        else if (strchr("eEfgG",*q)) {
+            if (p+sizeof(double)>end) {fputs(s,fp); return;}
+            memcpy(&dval,p,sizeof(double)); p+=sizeof(double);
+            if      (nstar==0) fprintf(fp,spec,dval);
+            else if (nstar==1) fprintf(fp,spec,star[0],dval);
+            else               fprintf(fp,spec,star[0],star[1],dval);
+        }
+        else if (*q=='s') {
+            for (n=0;p+n<end&&p[n];n++) ;
+            if (p+n>=end) {fputs(s,fp); return;}
+            if      (nstar==0) fprintf(fp,spec,(const char *)p);
+            else if (nstar==1) fprintf(fp,spec,star[0],(const char *)p);
+            else               fprintf(fp,spec,star[0],star[1],(const char *)p);
+            p+=n+1;
+        }
+        else { /* p or n */
+            if (p+size_ptr>end) {fputs(s,fp); return;}
+            memcpy(&pval,p,sizeof(void *)); p+=size_ptr;
+            if (*q=='p') fprintf(fp,spec,pval);
+        }
+    }
+}
+/* decode binary trace file --------------------------------------------------*/
+static int decode(FILE *fp, FILE *ofp, int maxlevel)
+{
+    static unsigned char buff[MAXREC+1];
+    const unsigned char *p,*end;
+    const char *format;
+    unsigned char head[16];
+    unsigned int id,tick,tick0;
+    double val;
+    int type,level,len,n,w,prec;
+    
+    if (fread(head,16,1,fp)<1||memcmp(head,"RTKTRACE",8)) {
+        fprintf(stderr,"not binary trace file\n");
+        return 0;
+    }
+    if (head[9]!=sizeof(int)||head[10]!=sizeof(long)||head[11]!=sizeof(void *)) {
+        fprintf(stderr,"type size mismatch: int=%d long=%d ptr=%d\n",head[9],
+                head[10],head[11]);
+        return 0;
+    }
+    memcpy(&tick0,head+12,4);
+    
+    while (fread(head,4,1,fp)==1) {
+        type =head[0];
+        level=head[1];
+        len  =head[2]|(head[3]<<8);
+        if (fread(buff,len,1,fp)<1&&len>0) {
+            fprintf(stderr,"truncated record\n");
+            break;
+        }
+        buff[len]='\0';
+        p=buff; end=buff+len;
+        
+        if (type==TRACE_FMT) {
+            if (len<5) continue;
+            memcpy(&id,p,4);
+            addfmt(id,(const char *)p+4);
+            continue;
+        }
+        if (type==TRACE_MAT) {
+            if (len<9||(maxlevel>=0&&level>maxlevel)) continue;
+            memcpy(&w,p,4);
+            memcpy(&prec,p+4,4);
+            for (p+=9;p+sizeof(double)<=end;p+=sizeof(double)) {
+                memcpy(&val,p,sizeof(double));
+                fprintf(ofp," %*.*f",w,prec,val);
+            }
+            if (buff[8]) fprintf(ofp,"\n");
+            continue;
+        }
+        if (type&TRACE_INL) {
+            if (len<3) continue;
+            n=p[0]|(p[1]<<8);
+            if (n+3>len) continue;
+            format=(const char *)p+2;
+            p+=n+3;
+        }
+        else {
+            if (len<4) continue;
+            memcpy(&id,p,4); p+=4;
+            if ((int)id>=nfmt||!fmts[id]) {
+                fprintf(stderr,"undefined format id=%u\n",id);
+                continue;
+            }
+            format=fmts[id];
+        }
+        type&=~TRACE_INL;
+        tick=0;
+        if (type==TRACE_MSGT) {
+            if (p+4>end) continue;
+            memcpy(&tick,p,4); p+=4;
+        }
+        if (maxlevel>=0&&level>maxlevel) continue;
+        
+        if (type==TRACE_MSG) {
+            fprintf(ofp,"%d ",level);
+        }
+        else if (type==TRACE_MSGT) {
+            fprintf(ofp,"%d %9.3f: ",level,(tick-tick0)/1000.0);
+        }
+        outfmt(ofp,format,p,end,sizeof(int),sizeof(long),sizeof(void *));
+    }
+    return 1;
+}
+/* tracedec main -------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    FILE *fp,*ofp=stdout;
+    char *infile="",*outfile="";
+    int i,level=-1,stat;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-l")&&i+1<argc) level=atoi(argv[++i]);
+        else if (*argv[i]=='-') printhelp();
+        else infile=argv[i];
+    }
+    if (!*infile) printhelp();
+    
+    if (!(fp=fopen(infile,"rb"))) {
+        fprintf(stderr,"file open error: %s\n",infile);
+        return -1;
+    }
+    if (*outfile&&!(ofp=fopen(outfile,"w"))) {
+        fprintf(stderr,"file open error: %s\n",outfile);
+        fclose(fp);
+        return -1;
+    }
+    stat=decode(fp,ofp,level);
+    
+    fclose(fp);
+    if (ofp!=stdout) fclose(ofp);
+    return stat?0:-1;
+}